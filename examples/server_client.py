@@ -0,0 +1,78 @@
+"""Client for the planarity server mode.
+
+Start the server with
+
+    planarity -serve -threads 4 /tmp/planarity.sock
+
+and run this script to send it a batch of graphs.  Each message is a
+length followed by that many bytes of 32-bit big-endian integers.
+"""
+import socket
+import struct
+import sys
+import threading
+
+OK, NOTOK, NONEMBEDDABLE = 1, 0, -1
+
+
+def request(command, n, edges):
+    """Encode a request to run command ('p', 'o', '2', '3' or '4')."""
+    words = [ord(command), n, len(edges)]
+    for u, v in edges:
+        words.extend((u, v))
+    return struct.pack('>%di' % (len(words) + 1), 4 * len(words), *words)
+
+
+def receive(sock, size):
+    data = b''
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise EOFError('server closed the connection')
+        data += chunk
+    return data
+
+
+def response(sock, n):
+    """Decode a response as (result, rotation), where rotation is a list
+    of the neighbors of each vertex, or None."""
+    length, = struct.unpack('>i', receive(sock, 4))
+    words = struct.unpack('>%di' % (length // 4), receive(sock, length))
+    if len(words) == 1:
+        return words[0], None
+    offsets, neighbors = words[1:n + 2], words[n + 2:]
+    return words[0], [list(neighbors[offsets[i]:offsets[i + 1]])
+                      for i in range(n)]
+
+
+def solve(path, graphs, command='p'):
+    """Send all graphs (pairs of n and an edge list) in one batch and
+    return their responses in order.
+
+    The requests are sent by another thread while the responses are
+    read, since the server stops reading when the client stops reading.
+    """
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(path)
+        data = b''.join(request(command, n, e) for n, e in graphs)
+        sender = threading.Thread(target=sock.sendall, args=(data,))
+        sender.start()
+        try:
+            return [response(sock, n) for n, e in graphs]
+        finally:
+            sender.join()
+
+
+def stop(path):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(path)
+        sock.sendall(request('q', 0, []))
+        return response(sock, 0)
+
+
+if __name__ == '__main__':
+    path = sys.argv[1] if len(sys.argv) > 1 else '/tmp/planarity.sock'
+    k5 = [(u, v) for u in range(5) for v in range(u + 1, 5)]
+    k4 = [(u, v) for u in range(4) for v in range(u + 1, 4)]
+    for result, rotation in solve(path, [(5, k5), (4, k4)]):
+        print('planar' if result == OK else 'not planar', rotation)
@@ -1,5 +1,5 @@
 from __future__ import absolute_import
-from .planarity import PGraph
+from .planarity import PGraph, ResultCache, read_embedding
 from .planarity_functions import *
 from .planarity_networkx import *
 #from .tests.test import run as test
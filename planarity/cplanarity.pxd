@@ -1,7 +1,10 @@
 """Interface for Boyer's (C) planarity algorithms."""
 cdef extern from "src/graphStructures.h":
     ctypedef struct baseGraphStructure:
-        pass
+        int N
+        int M
+        int internalFlags
+        int embedFlags
     ctypedef baseGraphStructure * graphP
 
     ctypedef struct edgeRec:
@@ -17,29 +20,107 @@ cdef extern from "src/graphStructures.h":
     cdef int gp_GetPrevArc(graphP theGraph, int v)
     cdef int gp_GetNextArc(graphP theGraph, int v)
     cdef int gp_GetDirection(graphP theGraph, int v)
+    cdef int FLAGS_OBSTRUCTIONFOUND
+
+cdef extern from "src/stack.h":
+    ctypedef struct stack:
+        pass
+    ctypedef stack * stackP
+
+    cdef stackP sp_New(int capacity)
+    cdef void sp_Free(stackP *pStack)
+    cdef int sp_GetCurrentSize(stackP theStack)
 
 cdef extern from "src/appconst.h":
     cdef int OK, NOTOK, NULL 
 
 cdef extern from "src/graph.h":
-    cdef int WRITE_ADJLIST
+    cdef int WRITE_ADJLIST, WRITE_EMBEDDING
+    cdef int TRICOMP_BOND, TRICOMP_POLYGON, TRICOMP_RIGID
 
 cdef extern from "src/graphStructures.h":
     cdef int EMBEDFLAGS_PLANAR, NONEMBEDDABLE, EMBEDFLAGS_DRAWPLANAR
+    cdef int EMBEDFLAGS_MAXIMALPLANARSUBGRAPH, EMBEDFLAGS_SEARCHFORK5
+    cdef int EMBEDFLAGS_PROJECTIVEPLANAR, EMBEDFLAGS_TOROIDAL
+    cdef int EMBEDFLAGS_DRAWSTRAIGHT
     cdef int EDGEFLAG_DIRECTION_INONLY, EDGEFLAG_DIRECTION_OUTONLY  
 
     cdef graphP gp_New()
+    cdef graphP gp_DupGraph(graphP theGraph)
     cdef void gp_Free(graphP *pGraph)
     cdef int gp_InitGraph(graphP theGraph, int N)
+    cdef int gp_EnsureArcCapacity(graphP theGraph, int requiredArcCapacity)
     cdef int gp_AddEdge(graphP theGraph, int u, int ulink, int v, int vlink)
-    cdef int gp_Embed(graphP theGraph, int embedFlags)
+    cdef int gp_AddEdgesFromArray(graphP theGraph, int numEdges, int *edgeArray, int *duplicates) nogil
+    cdef int gp_AddEdgesFromCompressed(graphP theGraph, int *indptr, int *indices, int minorIsRow) nogil
+    cdef int gp_Embed(graphP theGraph, int embedFlags) nogil
+    cdef int gp_Read(graphP theGraph, char *FileName) nogil
     cdef int gp_Write(graphP theGraph, char *FileName, int Mode)
-    cdef void gp_SortVertices(graphP theGraph)
+    cdef void gp_SortVertices(graphP theGraph) nogil
+    cdef int gp_GetEdgeArray(graphP theGraph, int *edgeArray) nogil
+    cdef int gp_GetRotationSystem(graphP theGraph, int *offsets, int *neighbors) nogil
+    cdef int gp_GetFaces(graphP theEmbedding, int *arcFaces, int *faceOffsets, int *faceArcs) nogil
+    cdef int gp_CreateDualGraph(graphP theEmbedding, graphP theDual, int *arcDualArcs, int *dualArcArcs) nogil
+    cdef int gp_GetSharedFaces(graphP theEmbedding, int numPairs, int *pairs, int *sharedFaces) nogil
+    cdef int gp_GetTriconnectedComponents(graphP theGraph, int *compTypes, int *compOffsets,
+                                          int *compEdges, int *virtualEdges) nogil
+    cdef int gp_PlanarSeparator(graphP theEmbedding, int *sides) nogil
+    cdef int gp_PlanarPartition(graphP theEmbedding, int k, int *parts) nogil
+    cdef int gp_IsNeighbor(graphP theGraph, int u, int v)
+    cdef int gp_GetArcCapacity(graphP theGraph)
+    cdef int gp_TryAddEdgePlanar(graphP theEmbedding, int u, int v, stackP addedEdges) nogil
+    cdef int gp_RollbackAddedEdges(graphP theEmbedding, stackP addedEdges, int checkpoint) nogil
+    cdef void gp_ClearEmbedState(graphP theEmbedding)
+
+
+cdef extern from "src/resultCache.h":
+    ctypedef struct resultCacheKey:
+        pass
+    ctypedef resultCacheKey * resultCacheKeyP
+    ctypedef struct resultCache:
+        int capacity
+        int size
+        unsigned long long hits
+        unsigned long long misses
+    ctypedef resultCache * resultCacheP
+
+    cdef resultCacheP rc_New(int capacity)
+    cdef void rc_Free(resultCacheP *pCache)
+    cdef resultCacheKeyP rc_NewKey(graphP theGraph, int embedFlags)
+    cdef void rc_FreeKey(resultCacheKeyP *pKey)
+    cdef int rc_Lookup(resultCacheP theCache, resultCacheKeyP theKey, int *pResult, graphP certificate)
+    cdef int rc_Store(resultCacheP theCache, resultCacheKeyP *pKey, int result, graphP certificate)
 
 
 cdef extern from "src/graphDrawPlanar.h":
     cdef int gp_DrawPlanar_RenderToString(graphP theEmbedding, char **pRenditionString);
     cdef int gp_AttachDrawPlanar(graphP theGraph)
+    cdef int gp_DetachDrawPlanar(graphP theGraph)
+    cdef int gp_DrawPlanar_GetArrays(graphP theEmbedding,
+                                     int *vertexPos, int *vertexStart, int *vertexEnd,
+                                     int *edgePos, int *edgeStart, int *edgeEnd) nogil
+
+
+cdef extern from "src/graphDrawStraight.h":
+    cdef int gp_AttachDrawStraight(graphP theGraph)
+    cdef int gp_DrawStraight_GetArrays(graphP theEmbedding,
+                                       int *vertexX, int *vertexY) nogil
+
+
+cdef extern from "src/graphMaxPlanarSubgraph.h":
+    cdef int gp_AttachMaxPlanarSubgraph(graphP theGraph)
+    cdef int gp_DetachMaxPlanarSubgraph(graphP theGraph)
+    cdef int gp_GetRejectedEdges(graphP theGraph, int *edgePairs)
+    cdef int gp_RetryRejectedEdges(graphP theGraph) nogil
+
+
+cdef extern from "src/graphK5Search.h":
+    cdef int gp_AttachK5Search(graphP theGraph)
+    cdef int gp_FoundK5Homeomorph(graphP theGraph)
+
+
+cdef extern from "src/graphSurfaceEmbed.h":
+    cdef int gp_AttachSurfaceEmbed(graphP theGraph)
 
 
 cdef extern from "src/graphDrawPlanar.private.h":
@@ -1,18 +1,263 @@
 #!python
 #cython: embedsignature=True
+#cython: freethreading_compatible=True
+#cython: subinterpreters_compatible=own_gil
 """
 Wrapper for Boyer's (C) planarity algorithms.
+
+The module does not need the GIL and can be imported in subinterpreters
+with their own GIL.  The C library keeps all state in the graph, so
+separate PGraph objects can be used in parallel; each PGraph serializes
+its own methods with a lock.
 """
+cimport cython
 from planarity cimport cplanarity
-from libc.stdlib cimport free
+from libc.stdlib cimport free, calloc
+from cpython cimport array
+import array
+import itertools
 import warnings
 
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+cdef array.array _new_int_array(Py_ssize_t size):
+    return array.clone(array.array('i'), size, zero=False)
+
+
+cdef object _as_ndarray(array.array a, shape=None):
+    # Wrap the buffer without copying when NumPy is available.
+    if numpy is None:
+        return a
+    result = numpy.frombuffer(a, dtype=numpy.intc)
+    if shape is not None:
+        result = result.reshape(shape)
+    return result
+
+
+cdef int _dense_size(array.array labels, bint exact) except -2:
+    # Return n if the labels are exactly 0..n-1, otherwise -1.
+    # If exact is false, labels may be missing and n is the largest plus one.
+    cdef Py_ssize_t i, size = len(labels)
+    cdef int *flat = labels.data.as_ints
+    cdef int label, n = 0, count = 0
+    cdef char *present
+    for i in range(size):
+        if flat[i] < 0:
+            return -1
+        if flat[i] >= n:
+            n = flat[i] + 1
+    if not exact:
+        return n
+    present = <char *> calloc(n if n > 0 else 1, 1)
+    if present == NULL:
+        raise MemoryError()
+    for i in range(size):
+        label = flat[i]
+        if not present[label]:
+            present[label] = 1
+            count += 1
+    free(present)
+    return n if count == n else -1
+
+
+cdef bint _labels_in_order(array.array labels):
+    # Return True if the labels are 0..n-1 in that order.
+    cdef Py_ssize_t i, size = len(labels)
+    cdef int *flat = labels.data.as_ints
+    for i in range(size):
+        if flat[i] != i:
+            return False
+    return True
+
+
+cdef object _int_array(labels):
+    # Return labels as an int array, or None if they are not all integers.
+    # bool is a subclass of int, but True and False are not node numbers.
+    # Typed memoryviews are avoided, their support code has process-wide
+    # state that is not safe with subinterpreters.
+    cdef array.array result
+    cdef Py_ssize_t i
+    if numpy is not None and isinstance(labels, numpy.ndarray):
+        if labels.dtype.kind not in 'iu':
+            return None
+        if labels.size and (labels.min() < 0 or labels.max() > 0x7FFFFFFF):
+            return None
+        result = array.array('i')
+        result.frombytes(numpy.ascontiguousarray(labels, dtype=numpy.intc).tobytes())
+        return result
+    labels = list(labels)
+    try:
+        result = array.array('i', labels)
+    except (TypeError, OverflowError):
+        return None
+    for i in range(len(result)):
+        if result.data.as_ints[i] <= 1 and type(labels[i]) is bool:
+            return None
+    return result
+
+
+cdef object _dense_edges(graph, dense):
+    # Return (n, flat edge array) if the nodes of graph are the integers
+    # 0..n-1, or (-1, None) if the node mapping dictionaries are needed.
+    # Without dense=True, listed nodes must be in the order 0..n-1, since
+    # the mapping would keep another order.  With dense=True they may be
+    # in any order and missing labels 0..n-1 become isolated nodes.
+    if hasattr(graph,'nodes'):
+        nodes = _int_array(graph.nodes())
+        if nodes is None:
+            return -1, None
+        n = _dense_size(nodes, False) if dense else \
+            (len(nodes) if _labels_in_order(nodes) else -1)
+        if n < 0:
+            return -1, None
+        flat = _int_array(itertools.chain.from_iterable(
+            (u, v) for u, v in graph.edges()))
+    elif hasattr(graph,'keys'):
+        nodes = _int_array(graph.keys())
+        if nodes is None:
+            return -1, None
+        n = _dense_size(nodes, False) if dense else \
+            (len(nodes) if _labels_in_order(nodes) else -1)
+        if n < 0:
+            return -1, None
+        # as in the general case, skip neighbors listed earlier as nodes
+        flat = array.array('i')
+        done = bytearray(n)
+        try:
+            for node, adj in graph.items():
+                for nbr in adj:
+                    if not done[nbr]:
+                        flat.append(node)
+                        flat.append(nbr)
+                done[node] = 1
+        except (TypeError, IndexError, OverflowError):
+            return -1, None
+    else:
+        if numpy is not None and isinstance(graph, numpy.ndarray):
+            if graph.ndim != 2 or graph.shape[1] != 2:
+                return -1, None
+            flat = _int_array(graph)
+        else:
+            try:
+                flat = _int_array(itertools.chain.from_iterable(
+                    (u, v) for u, v in graph))
+            except (TypeError, ValueError):
+                return -1, None
+        if flat is None:
+            return -1, None
+        n = _dense_size(flat, not dense)
+        if n < 0:
+            return -1, None
+    if flat is None:
+        return -1, None
+    return n, flat
+
+
+cdef class ResultCache:
+    """Bounded least recently used cache of planarity results.
+
+    Pass a ResultCache to PGraph to reuse the result (and the embedding
+    or Kuratowski subgraph) of an earlier graph with the same edges on
+    the same vertices, in any order.  Graphs are compared exactly, so a
+    relabeled graph is a different entry.  A cache can be shared between
+    threads.
+    """
+    cdef cplanarity.resultCacheP cache
+    cdef cython.pymutex lock
+
+    def __cinit__(self, int capacity=1024):
+        if capacity < 0:
+            raise ValueError("planarity: cache capacity must not be negative.")
+        self.cache = cplanarity.rc_New(capacity)
+        if self.cache == NULL:
+            raise MemoryError()
+
+
+    def __dealloc__(self):
+        cplanarity.rc_Free(&self.cache)
+
+
+    def __len__(self):
+        with self.lock:
+            return self.cache.size
+
+
+    @property
+    def capacity(self):
+        return self.cache.capacity
+
+
+    @property
+    def hits(self):
+        with self.lock:
+            return self.cache.hits
+
+
+    @property
+    def misses(self):
+        with self.lock:
+            return self.cache.misses
+
+
 cdef class PGraph:
     cdef cplanarity.graphP theGraph
     cdef dict nodemap
     cdef dict reverse_nodemap
     cdef int embedding 
-    def __init__(self,graph):
+    cdef ResultCache cache
+    cdef cplanarity.stackP added_edges
+    cdef bint edited
+    cdef cython.pymutex lock
+    def __init__(self,graph,dense=None,ResultCache cache=None):
+        """Create a graph from a NetworkX graph, an adjacency dict, an
+        edge list or a SciPy sparse adjacency matrix.
+
+        For a sparse matrix, node i is row and column i, and each stored
+        nonzero entry above the diagonal is an edge.
+
+        If the nodes are the integers 0..n-1, in that order for a graph or
+        dict (dense=None detects this), or dense=True declares the nodes
+        to be integers from 0, in any order, no node mapping dictionaries
+        are built and the edges are passed to C in one array; node i is
+        vertex i+1, nodes() is 0..n-1 and parallel edges are detected in
+        C.  bool labels are never taken as integers.  dense=False always
+        maps nodes.
+
+        If a ResultCache is given, planarity results are looked up in and
+        added to it.
+        """
+        with self.lock:
+            self.cache = cache
+            cplanarity.gp_Free(&self.theGraph)
+            cplanarity.sp_Free(&self.added_edges)
+            self.edited = False
+            self._build(graph, dense)
+
+
+    cdef _build(self, graph, dense):
+        if hasattr(graph,'tocsr') and hasattr(graph,'format'):
+            # SciPy sparse matrix or array
+            self.nodemap = None
+            self.reverse_nodemap = None
+            self._init_from_sparse(graph)
+            self.embedding=cplanarity.NOTOK
+            return
+        n = -1
+        if dense is None or dense:
+            n, flat = _dense_edges(graph, dense)
+            if n < 0 and dense:
+                raise ValueError("planarity: nodes are not integers 0..n-1.")
+        if n >= 0:
+            self.nodemap = None
+            self.reverse_nodemap = None
+            self._init_graph(n, len(flat) // 2)
+            self._add_edge_buffer(flat)
+            self.embedding=cplanarity.NOTOK
+            return
         # guess input type
         if hasattr(graph,'nodes'):
             # NetworkX graph
@@ -38,11 +283,7 @@ cdef class PGraph:
         n=len(nodes)
         self.nodemap=dict(zip(nodes,range(1,n+1)))
         self.reverse_nodemap=dict(zip(range(1,n+1),nodes))
-        self.theGraph = cplanarity.gp_New()
-        cdef int status
-        status = cplanarity.gp_InitGraph(self.theGraph, n)
-        if status != cplanarity.OK:
-            raise RuntimeError("planarity: failed to initialize graph")
+        self._init_graph(n, len(edges))
         # add the edges and check return
         seen = set()
         for u,v in edges:
@@ -59,18 +300,121 @@ cdef class PGraph:
         self.embedding=cplanarity.NOTOK
 
 
+    cdef _init_graph(self, int n, Py_ssize_t m):
+        # Make room for all m edges, not just the default 3n, so that every
+        # edge given is in the graph
+        self.theGraph = cplanarity.gp_New()
+        if self.theGraph == NULL:
+            raise MemoryError()
+        if m > 3*n and cplanarity.gp_EnsureArcCapacity(self.theGraph, 2*m) != cplanarity.OK:
+            cplanarity.gp_Free(&self.theGraph)
+            raise RuntimeError("planarity: failed to initialize graph")
+        status = cplanarity.gp_InitGraph(self.theGraph, n)
+        if status != cplanarity.OK:
+            raise RuntimeError("planarity: failed to initialize graph")
+
+
+    cdef _init_from_sparse(self, matrix):
+        if len(matrix.shape) != 2 or matrix.shape[0] != matrix.shape[1]:
+            raise ValueError("planarity: adjacency matrix is not square.")
+        if matrix.format not in ('csr', 'csc'):
+            matrix = matrix.tocsr()
+        if not matrix.has_canonical_format or not matrix.data.all():
+            matrix = matrix.copy()
+            matrix.sum_duplicates()
+            matrix.eliminate_zeros()
+        cdef array.array indptr = _int_array(matrix.indptr)
+        cdef array.array indices = _int_array(matrix.indices)
+        cdef int minorIsRow = matrix.format == 'csc'
+        cdef int status
+        if indptr is None or indices is None:
+            raise ValueError("planarity: adjacency matrix is too large.")
+        self._init_graph(matrix.shape[0], matrix.nnz)
+        with nogil:
+            status = cplanarity.gp_AddEdgesFromCompressed(self.theGraph,
+                        indptr.data.as_ints, indices.data.as_ints,
+                        minorIsRow)
+        if status != cplanarity.OK:
+            cplanarity.gp_Free(&self.theGraph)
+            raise RuntimeError("planarity: failed adding edge.")
+
+
+    cdef _add_edge_buffer(self, array.array flat):
+        cdef int m = len(flat) // 2
+        cdef array.array duplicates = _new_int_array(m)
+        cdef int count
+        with nogil:
+            count = cplanarity.gp_AddEdgesFromArray(self.theGraph, m,
+                                                    flat.data.as_ints,
+                                                    duplicates.data.as_ints)
+        if count < 0:
+            cplanarity.gp_Free(&self.theGraph)
+            raise RuntimeError("planarity: failed adding edge.")
+        for k in duplicates[:count]:
+            warnings.warn('ignoring parallel edge %s-%s'%(flat[2*k],flat[2*k+1]))
+
+
+    cdef object _label(self, int v):
+        if self.reverse_nodemap is None:
+            return v - 1
+        return self.reverse_nodemap[v]
+
+
+    cdef int _vertex(self, label) except -1:
+        if self.nodemap is None:
+            if not 0 <= label < self.theGraph.N:
+                raise KeyError(label)
+            return label + 1
+        return self.nodemap[label]
+
+
     def __dealloc__(self):
         cplanarity.gp_Free(&self.theGraph)
+        cplanarity.sp_Free(&self.added_edges)
 
 
     def embed_planar(self):
-        if self.embedding == 0:
-            self.embedding = cplanarity.gp_Embed(self.theGraph, 
-                                             cplanarity.EMBEDFLAGS_PLANAR)
-            cplanarity.gp_SortVertices(self.theGraph)                  
+        with self.lock:
+            self._embed_planar()
+
+
+    cdef _embed_planar(self):
+        cdef cplanarity.resultCacheKeyP key = NULL
+        cdef int result, found = cplanarity.NOTOK
+        if self.embedding != 0:
+            return
+        if self.cache is not None:
+            key = cplanarity.rc_NewKey(self.theGraph,
+                                       cplanarity.EMBEDFLAGS_PLANAR)
+            if key == NULL:
+                raise MemoryError()
+            with self.cache.lock:
+                found = cplanarity.rc_Lookup(self.cache.cache, key,
+                                             &result, self.theGraph)
+            if found == cplanarity.OK:
+                cplanarity.rc_FreeKey(&key)
+                self.embedding = result
+                return
+        self.embedding = cplanarity.gp_Embed(self.theGraph, 
+                                         cplanarity.EMBEDFLAGS_PLANAR)
+        cplanarity.gp_SortVertices(self.theGraph)                  
+        if key != NULL:
+            if self.embedding != cplanarity.NOTOK:
+                with self.cache.lock:
+                    cplanarity.rc_Store(self.cache.cache, &key,
+                                        self.embedding, self.theGraph)
+            cplanarity.rc_FreeKey(&key)
 
 
     def embed_drawplanar(self):
+        with self.lock:
+            self._embed_drawplanar()
+
+
+    cdef _embed_drawplanar(self):
+        if self.edited:
+            cplanarity.gp_ClearEmbedState(self.theGraph)
+            self.edited = False
         status = cplanarity.gp_AttachDrawPlanar(self.theGraph)
         if status == cplanarity.NOTOK:
             raise RuntimeError("planarity: failed attaching drawplanar.")
@@ -83,22 +427,33 @@ cdef class PGraph:
 
     def is_planar(self):
         """Return True if graph is planar."""
-        self.embed_planar()
+        with self.lock:
+            return self._is_planar()
+
+
+    cdef bint _is_planar(self):
+        self._embed_planar()
         if  self.embedding == cplanarity.NONEMBEDDABLE:
             return False
         return True
 
 
     def kuratowski_edges(self):
-        if self.is_planar():
-            return []
-        elif self.embedding == cplanarity.NONEMBEDDABLE:
-            return self.edges(data=False)
-        else:
-            raise RuntimeError("planarity: Unknown error.")        
+        with self.lock:
+            if self._is_planar():
+                return []
+            elif self.embedding == cplanarity.NONEMBEDDABLE:
+                return self._edges(False)
+            else:
+                raise RuntimeError("planarity: Unknown error.")        
 
 
     def nodes(self,data=False):
+        with self.lock:
+            return self._nodes(data)
+
+
+    cdef list _nodes(self,data):
         DRAWPLANAR_ID=1
         cdef cplanarity.DrawPlanarContext *context 
         drawing=cplanarity.gp_FindExtension(self.theGraph, 
@@ -107,7 +462,6 @@ cdef class PGraph:
 
         first=cplanarity.gp_GetFirstVertex(self.theGraph)
         last=cplanarity.gp_GetLastVertex(self.theGraph)+1
-        r=self.reverse_nodemap
         nodes=[]
         for n in range(first,last):
             if data:
@@ -116,20 +470,24 @@ cdef class PGraph:
                     data.update(pos=context.VI[n].pos,
                                 start=context.VI[n].start,
                                 end=context.VI[n].end)
-                nodes.append((r[n],data))
+                nodes.append((self._label(n),data))
             else:
-                nodes.append((r[n]))
+                nodes.append((self._label(n)))
         return nodes
 
 
     def edges(self,data=False):
+        with self.lock:
+            return self._edges(data)
+
+
+    cdef list _edges(self,data):
         DRAWPLANAR_ID=1
         cdef cplanarity.DrawPlanarContext *context 
         drawing=cplanarity.gp_FindExtension(self.theGraph, 
                                             DRAWPLANAR_ID, 
                                             <void *> &context)        
         edges=[]
-        r=self.reverse_nodemap
         first=cplanarity.gp_GetFirstVertex(self.theGraph)
         last=cplanarity.gp_GetLastVertex(self.theGraph)+1
         for n in range(first,last):
@@ -144,18 +502,562 @@ cdef class PGraph:
                             data.update(pos=context.E[e].pos,
                                         start=context.E[e].start,
                                         end=context.E[e].end)
-                        edges.append((r[n],r[nbr],data))
+                        edges.append((self._label(n),self._label(nbr),data))
                     else:
-                        edges.append((r[n],r[nbr]))
+                        edges.append((self._label(n),self._label(nbr)))
                 e=cplanarity.gp_GetNextArc(self.theGraph,e)
                 isarc=cplanarity.gp_IsArc(e)
         return edges
 
 
+    def edge_array(self):
+        """Return the edges as an M x 2 integer array.
+
+        Entries are indices into nodes(); the edges are listed in the
+        same order as edges().  A NumPy array is returned if NumPy is
+        installed, otherwise a flat array.array of length 2*M.
+        """
+        cdef array.array a
+        cdef int count
+        with self.lock:
+            a = _new_int_array(2*self.theGraph.M)
+            with nogil:
+                count = cplanarity.gp_GetEdgeArray(self.theGraph, a.data.as_ints)
+            if count < 0:
+                raise RuntimeError("planarity: failed listing edges.")
+            return _as_ndarray(a, (count, 2))
+
+
+    def rotation_system(self):
+        """Return the adjacency lists as a pair (offsets, neighbors).
+
+        The neighbors of node i (an index into nodes()) are
+        neighbors[offsets[i]:offsets[i+1]].  After a planar embedding
+        each list is the cyclic order of the edges around the node.
+        """
+        cdef array.array offsets, neighbors
+        cdef int count
+        with self.lock:
+            offsets = _new_int_array(self.theGraph.N+1)
+            neighbors = _new_int_array(2*self.theGraph.M)
+            with nogil:
+                count = cplanarity.gp_GetRotationSystem(self.theGraph,
+                                                        offsets.data.as_ints,
+                                                        neighbors.data.as_ints)
+            if count < 0:
+                raise RuntimeError("planarity: failed listing adjacencies.")
+            return _as_ndarray(offsets), _as_ndarray(neighbors)
+
+
+    def faces(self):
+        """Return the faces of the planar embedding as a dict of arrays.
+
+        Arc k is the k-th entry of the neighbors array of
+        rotation_system().  'arc_face' gives the face of each arc, and
+        the arcs of face f, in order around the face, are
+        face_arcs[face_offsets[f]:face_offsets[f+1]]; 'face_sizes' gives
+        the number of arcs of each face.  Each connected component has
+        its own outer face.  The graph is embedded first if necessary.
+        """
+        cdef array.array arc_face, face_offsets, face_arcs
+        cdef int m, count
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            m = self.theGraph.M
+            arc_face = _new_int_array(2*m)
+            face_offsets = _new_int_array(2*m+1)
+            face_arcs = _new_int_array(2*m)
+            with nogil:
+                count = cplanarity.gp_GetFaces(self.theGraph,
+                                               arc_face.data.as_ints,
+                                               face_offsets.data.as_ints,
+                                               face_arcs.data.as_ints)
+            if count < 0:
+                raise RuntimeError("planarity: failed listing faces.")
+            array.resize(face_offsets, count+1)
+            face_sizes = _new_int_array(count)
+            for f in range(count):
+                face_sizes[f] = face_offsets[f+1] - face_offsets[f]
+            return dict(arc_face=_as_ndarray(arc_face),
+                        face_offsets=_as_ndarray(face_offsets),
+                        face_arcs=_as_ndarray(face_arcs),
+                        face_sizes=_as_ndarray(face_sizes))
+
+
+    def can_add_edges(self, pairs):
+        """Return which of the edges u-v for (u, v) in pairs can be added
+        to the planar embedding without changing it, as a boolean array,
+        and a face of faces() that contains both nodes of each pair, or
+        -1.  Nodes in different connected components can be joined in any
+        face and get -1.  The faces at each node are indexed once, then
+        each pair costs O(min(deg u, deg v)).  The graph is embedded
+        first if necessary.
+        """
+        cdef array.array flat = None, shared, addable
+        cdef int count, status
+        cdef Py_ssize_t k
+        if self.nodemap is None:
+            if numpy is not None and isinstance(pairs, numpy.ndarray):
+                flat = _int_array(pairs)
+            else:
+                flat = _int_array(itertools.chain.from_iterable(pairs))
+        if flat is None:
+            flat = array.array('i')
+            for u, v in pairs:
+                flat.append(self._vertex(u) - 1)
+                flat.append(self._vertex(v) - 1)
+        count = len(flat) // 2
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            shared = _new_int_array(count)
+            with nogil:
+                status = cplanarity.gp_GetSharedFaces(self.theGraph, count,
+                                                      flat.data.as_ints,
+                                                      shared.data.as_ints)
+            if status != cplanarity.OK:
+                raise ValueError("planarity: node not in graph.")
+        addable = array.clone(array.array('B'), count, zero=False)
+        for k in range(count):
+            addable[k] = shared[k] != -2
+            if shared[k] < 0:
+                shared[k] = -1
+        if numpy is not None:
+            return numpy.frombuffer(addable, dtype=numpy.bool_), _as_ndarray(shared)
+        return addable, shared
+
+
+    def dual(self):
+        """Return the dual of the planar embedding as a tuple
+        (dual, arc_dual_arc, dual_arc_arc).
+
+        dual is an embedded PGraph whose node f is face f of faces(); a
+        bridge gives a loop and faces sharing several edges are joined
+        by parallel edges.  Arcs are positions in the neighbors arrays
+        of rotation_system(): the dual arc arc_dual_arc[k] crosses arc k,
+        from the face of arc k to the face of its reverse, and
+        dual_arc_arc is the inverse correspondence.  The graph is
+        embedded first if necessary.
+        """
+        cdef PGraph d = PGraph.__new__(PGraph)
+        cdef array.array arc_dual_arc, dual_arc_arc
+        cdef cplanarity.graphP theDual
+        cdef int status
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            if self.theGraph.M == 0:
+                raise ValueError("planarity: graph has no edges.")
+            theDual = cplanarity.gp_New()
+            if theDual == NULL:
+                raise MemoryError()
+            arc_dual_arc = _new_int_array(2*self.theGraph.M)
+            dual_arc_arc = _new_int_array(2*self.theGraph.M)
+            with nogil:
+                status = cplanarity.gp_CreateDualGraph(self.theGraph, theDual,
+                                                       arc_dual_arc.data.as_ints,
+                                                       dual_arc_arc.data.as_ints)
+            if status != cplanarity.OK:
+                cplanarity.gp_Free(&theDual)
+                raise RuntimeError("planarity: failed creating dual graph.")
+        d.theGraph = theDual
+        d.nodemap = None
+        d.reverse_nodemap = None
+        d.embedding = cplanarity.OK
+        return d, _as_ndarray(arc_dual_arc), _as_ndarray(dual_arc_arc)
+
+
+    def separator(self):
+        """Return a planar separator as an array indexed like nodes().
+
+        Entries are 0 or 1 for the two sides and -1 for the separator
+        vertices.  The separator has O(sqrt(n)) vertices, no edge joins
+        the two sides, and each side has at most about two thirds of
+        the vertices.  The graph is embedded first if necessary.
+        """
+        cdef array.array sides
+        cdef int count
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            sides = _new_int_array(self.theGraph.N)
+            with nogil:
+                count = cplanarity.gp_PlanarSeparator(self.theGraph,
+                                                      sides.data.as_ints)
+            if count < 0:
+                raise RuntimeError("planarity: failed finding separator.")
+            return _as_ndarray(sides)
+
+
+    def partition(self, k):
+        """Partition the nodes into k parts of about equal size by
+        recursive planar separators, and return the part of each node
+        as an array indexed like nodes().  The graph is embedded first
+        if necessary.
+        """
+        cdef array.array parts
+        cdef int nparts = k, status
+        if nparts < 1:
+            raise ValueError("planarity: k must be positive.")
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            parts = _new_int_array(self.theGraph.N)
+            with nogil:
+                status = cplanarity.gp_PlanarPartition(self.theGraph, nparts,
+                                                       parts.data.as_ints)
+            if status != cplanarity.OK:
+                raise RuntimeError("planarity: failed partitioning graph.")
+            return _as_ndarray(parts)
+
+
+    def triconnected_components(self):
+        """Return the triconnected components of a biconnected graph, the
+        nodes of its SPQR tree, as a dict.
+
+        'types' lists 'S' for each polygon (a cycle), 'P' for each bond
+        (parallel edges between two nodes) and 'R' for each rigid
+        triconnected component.  The edges of component c are
+        edges[offsets[c]:offsets[c+1]]: an entry k < M is row k of
+        edge_array(), and an entry M+j is the virtual edge j, whose
+        nodes are row j of 'virtual_edges'.  Each virtual edge is in
+        two components and joins them in the SPQR tree.  The
+        decomposition takes O(n+m) time.  The graph must not have been
+        reduced to a Kuratowski subgraph by embedding it.
+        """
+        cdef array.array types, offsets, edges, virtual_edges
+        cdef int m, count
+        with self.lock:
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph reduced to a Kuratowski subgraph.")
+            m = self.theGraph.M
+            types = _new_int_array(m)
+            offsets = _new_int_array(m+1)
+            edges = _new_int_array(3*m)
+            virtual_edges = _new_int_array(2*m)
+            with nogil:
+                count = cplanarity.gp_GetTriconnectedComponents(self.theGraph,
+                                                                types.data.as_ints,
+                                                                offsets.data.as_ints,
+                                                                edges.data.as_ints,
+                                                                virtual_edges.data.as_ints)
+            if count < 0:
+                raise ValueError("planarity: graph not biconnected.")
+        array.resize(offsets, count+1)
+        array.resize(edges, offsets[count])
+        array.resize(virtual_edges, 2*(count-1))
+        letters = {cplanarity.TRICOMP_BOND: 'P',
+                   cplanarity.TRICOMP_POLYGON: 'S',
+                   cplanarity.TRICOMP_RIGID: 'R'}
+        return dict(types=[letters[types[c]] for c in range(count)],
+                    offsets=_as_ndarray(offsets),
+                    edges=_as_ndarray(edges),
+                    virtual_edges=_as_ndarray(virtual_edges, (count-1, 2)))
+
+
+    def try_add_edge(self, u, v):
+        """Add the edge u-v if the graph stays planar and return True, or
+        return False and leave the graph unchanged.  The embedding is
+        updated in place: the edge goes into a face shared by u and v if
+        there is one, and otherwise only the biconnected components
+        between u and v are embedded again.  An edge already in the
+        graph is not added twice.  The graph is embedded first if
+        necessary, and any drawing is redone when it is next needed.
+        """
+        cdef int x = self._vertex(u), y = self._vertex(v), status
+        if x == y:
+            raise ValueError("planarity: self-loops are not supported.")
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            if cplanarity.gp_IsNeighbor(self.theGraph, x, y):
+                return True
+            if self.added_edges == NULL:
+                self.added_edges = cplanarity.sp_New(
+                    cplanarity.gp_GetArcCapacity(self.theGraph) // 2)
+                if self.added_edges == NULL:
+                    raise MemoryError()
+            with nogil:
+                status = cplanarity.gp_TryAddEdgePlanar(self.theGraph, x, y,
+                                                        self.added_edges)
+            if status == cplanarity.NOTOK:
+                raise RuntimeError("planarity: failed adding edge.")
+            if status == cplanarity.OK:
+                self._mark_edited()
+            return status == cplanarity.OK
+
+
+    def checkpoint(self):
+        """Return a checkpoint that rollback() can return to."""
+        with self.lock:
+            if self.added_edges == NULL:
+                return 0
+            return cplanarity.sp_GetCurrentSize(self.added_edges)
+
+
+    def rollback(self, checkpoint):
+        """Remove the edges added by try_add_edge() since checkpoint()
+        returned checkpoint, most recent first.  The embedding stays
+        planar, though the order of the remaining edges around a vertex
+        can differ from the one at the checkpoint.
+        """
+        cdef int c = checkpoint, status = cplanarity.OK
+        with self.lock:
+            if self.added_edges != NULL:
+                with nogil:
+                    status = cplanarity.gp_RollbackAddedEdges(self.theGraph,
+                                                              self.added_edges, c)
+            elif c != 0:
+                status = cplanarity.NOTOK
+            if status != cplanarity.OK:
+                raise ValueError("planarity: invalid checkpoint.")
+            self._mark_edited()
+
+
+    def maximal_planar_subgraph(self, retry=False):
+        """Return a maximal planar subgraph as a tuple (subgraph, rejected).
+
+        subgraph is an embedded PGraph with the same nodes and the edges
+        that one pass of the planarity algorithm could keep, which
+        include a spanning forest, and rejected lists the other edges as
+        (u, v) pairs.  The pass takes O(n+m) time and keeps the edges
+        greedily, so a few rejected edges may still fit.  If retry is
+        True, each rejected edge is then tried again and added if it
+        fits, so that no rejected edge can be added to the subgraph
+        without making it nonplanar; this costs up to O(n+m) per
+        rejected edge.  The graph itself is left unchanged, but it must
+        not have been reduced to a Kuratowski subgraph by embedding it.
+        """
+        cdef PGraph sub = PGraph.__new__(PGraph)
+        cdef array.array pairs
+        cdef cplanarity.graphP theSubgraph
+        cdef int status, count, k
+        cdef bint retryRejected = retry
+        with self.lock:
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph reduced to a Kuratowski subgraph.")
+            theSubgraph = cplanarity.gp_DupGraph(self.theGraph)
+        if theSubgraph == NULL:
+            raise MemoryError()
+        if theSubgraph.embedFlags != 0:
+            cplanarity.gp_ClearEmbedState(theSubgraph)
+        cplanarity.gp_DetachDrawPlanar(theSubgraph)
+        if cplanarity.gp_AttachMaxPlanarSubgraph(theSubgraph) != cplanarity.OK:
+            cplanarity.gp_Free(&theSubgraph)
+            raise RuntimeError("planarity: failed attaching maximal planar subgraph.")
+        with nogil:
+            status = cplanarity.gp_Embed(theSubgraph,
+                                         cplanarity.EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+            if status == cplanarity.OK:
+                cplanarity.gp_SortVertices(theSubgraph)
+                if retryRejected:
+                    status = cplanarity.gp_RetryRejectedEdges(theSubgraph)
+        if status != cplanarity.OK:
+            cplanarity.gp_Free(&theSubgraph)
+            raise RuntimeError("planarity: failed embedding maximal planar subgraph.")
+        # Sized from the subgraph itself, since the graph can change
+        # once its lock is released
+        pairs = _new_int_array(2*cplanarity.gp_GetRejectedEdges(theSubgraph, NULL))
+        count = cplanarity.gp_GetRejectedEdges(theSubgraph, pairs.data.as_ints)
+        # The subgraph is a planar embedding like any other from here on
+        cplanarity.gp_DetachMaxPlanarSubgraph(theSubgraph)
+        theSubgraph.embedFlags = cplanarity.EMBEDFLAGS_PLANAR
+        sub.theGraph = theSubgraph
+        sub.nodemap = self.nodemap
+        sub.reverse_nodemap = self.reverse_nodemap
+        sub.embedding = cplanarity.OK
+        rejected = [(sub._label(pairs[2*k]), sub._label(pairs[2*k+1]))
+                    for k in range(count)]
+        return sub, rejected
+
+
+    def k5_homeomorph_edges(self):
+        """Return the edges of a subgraph homeomorphic to K5, [] if the
+        graph is planar, or None if the search found no K5 homeomorph in
+        a nonplanar graph.
+
+        The search takes O(n+m) time and always finds one in a nonplanar
+        graph with no K3,3 homeomorph, but it can miss one in a graph
+        that has both, so None means only a K3,3 homeomorph was found and
+        the graph may or may not have a K5 homeomorph.  The graph itself
+        is left unchanged, but it must not have been reduced to a
+        Kuratowski subgraph by embedding it.
+        """
+        cdef array.array a
+        cdef cplanarity.graphP theSearch
+        cdef int status, count, k
+        with self.lock:
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph reduced to a Kuratowski subgraph.")
+            theSearch = cplanarity.gp_DupGraph(self.theGraph)
+        if theSearch == NULL:
+            raise MemoryError()
+        if theSearch.embedFlags != 0:
+            cplanarity.gp_ClearEmbedState(theSearch)
+        cplanarity.gp_DetachDrawPlanar(theSearch)
+        if cplanarity.gp_AttachK5Search(theSearch) != cplanarity.OK:
+            cplanarity.gp_Free(&theSearch)
+            raise RuntimeError("planarity: failed attaching K5 search.")
+        status = cplanarity.gp_Embed(theSearch, cplanarity.EMBEDFLAGS_SEARCHFORK5)
+        if status == cplanarity.NOTOK:
+            cplanarity.gp_Free(&theSearch)
+            raise RuntimeError("planarity: failed searching for K5.")
+        if not cplanarity.gp_FoundK5Homeomorph(theSearch):
+            cplanarity.gp_Free(&theSearch)
+            return None if status == cplanarity.NONEMBEDDABLE else []
+        cplanarity.gp_SortVertices(theSearch)
+        a = _new_int_array(2*theSearch.M)
+        count = cplanarity.gp_GetEdgeArray(theSearch, a.data.as_ints)
+        cplanarity.gp_Free(&theSearch)
+        return [(self._label(a[2*k]+1), self._label(a[2*k+1]+1))
+                for k in range(count)]
+
+    def is_projective_planar(self):
+        """Return True if the graph embeds on the projective plane.
+
+        The search branches over the placements of a Kuratowski subgraph
+        and prunes with planarity tests, so it is fast on typical graphs
+        but exponential in the worst case.  The graph itself is left
+        unchanged.
+        """
+        return self._embeds_on_surface(cplanarity.EMBEDFLAGS_PROJECTIVEPLANAR)
+
+    def is_toroidal(self):
+        """Return True if the graph embeds on the torus.
+
+        See is_projective_planar() for the cost of the search.
+        """
+        return self._embeds_on_surface(cplanarity.EMBEDFLAGS_TOROIDAL)
+
+    cdef _embeds_on_surface(self, int embedFlags):
+        cdef cplanarity.graphP theSurface
+        cdef int status
+        with self.lock:
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph reduced to a Kuratowski subgraph.")
+            theSurface = cplanarity.gp_DupGraph(self.theGraph)
+        if theSurface == NULL:
+            raise MemoryError()
+        if theSurface.embedFlags != 0:
+            cplanarity.gp_ClearEmbedState(theSurface)
+        cplanarity.gp_DetachDrawPlanar(theSurface)
+        if cplanarity.gp_AttachSurfaceEmbed(theSurface) != cplanarity.OK:
+            cplanarity.gp_Free(&theSurface)
+            raise RuntimeError("planarity: failed attaching surface embedding.")
+        with nogil:
+            status = cplanarity.gp_Embed(theSurface, embedFlags)
+        cplanarity.gp_Free(&theSurface)
+        if status == cplanarity.NOTOK:
+            raise RuntimeError("planarity: failed surface embedding.")
+        return status == cplanarity.OK
+
+
+    def straight_line_drawing(self):
+        """Return integer coordinates (x, y) of a planar straight-line
+        drawing as two arrays indexed like nodes().
+
+        The drawing is computed in O(n+m) time on the grid [0, 2n-4] x
+        [0, n-2], from a canonical ordering of a triangulated copy of the
+        embedding.  The graph itself is left unchanged.
+        """
+        cdef cplanarity.graphP theDrawing
+        cdef array.array x, y
+        cdef int n, status
+        with self.lock:
+            if self.theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+                raise RuntimeError("planarity: graph not planar.")
+            theDrawing = cplanarity.gp_DupGraph(self.theGraph)
+        if theDrawing == NULL:
+            raise MemoryError()
+        if theDrawing.embedFlags != 0:
+            cplanarity.gp_ClearEmbedState(theDrawing)
+        cplanarity.gp_DetachDrawPlanar(theDrawing)
+        if cplanarity.gp_AttachDrawStraight(theDrawing) != cplanarity.OK:
+            cplanarity.gp_Free(&theDrawing)
+            raise RuntimeError("planarity: failed attaching drawstraight.")
+        status = cplanarity.gp_Embed(theDrawing, cplanarity.EMBEDFLAGS_DRAWSTRAIGHT)
+        if status != cplanarity.OK:
+            cplanarity.gp_Free(&theDrawing)
+            if status == cplanarity.NONEMBEDDABLE:
+                raise RuntimeError("planarity: graph not planar.")
+            raise RuntimeError("planarity: failed straight-line drawing.")
+        cplanarity.gp_SortVertices(theDrawing)
+        n = theDrawing.N
+        x = _new_int_array(n)
+        y = _new_int_array(n)
+        with nogil:
+            status = cplanarity.gp_DrawStraight_GetArrays(theDrawing,
+                        x.data.as_ints, y.data.as_ints)
+        cplanarity.gp_Free(&theDrawing)
+        if status != cplanarity.OK:
+            raise RuntimeError("planarity: failed reading drawing.")
+        return _as_ndarray(x), _as_ndarray(y)
+
+
+    cdef _mark_edited(self):
+        # The drawing, and what gp_Embed() recorded besides the rotation
+        # system, no longer match the edges, which are still embedded
+        self.edited = True
+        self.embedding = cplanarity.OK
+        if cplanarity.gp_DetachDrawPlanar(self.theGraph) == cplanarity.OK:
+            self.theGraph.embedFlags = cplanarity.EMBEDFLAGS_PLANAR
+
+
+    def drawing_arrays(self):
+        """Return the visibility representation as a dict of arrays.
+
+        'vertex_pos', 'vertex_start' and 'vertex_end' are indexed like
+        nodes(); 'edge_pos', 'edge_start' and 'edge_end' are in the order
+        of edge_array().  The graph is drawn first if necessary.
+        """
+        cdef int n, m, status
+        cdef array.array vpos, vstart, vend, epos, estart, eend
+        with self.lock:
+            n = self.theGraph.N
+            m = self.theGraph.M
+            vpos = _new_int_array(n)
+            vstart = _new_int_array(n)
+            vend = _new_int_array(n)
+            epos = _new_int_array(m)
+            estart = _new_int_array(m)
+            eend = _new_int_array(m)
+            for attempt in range(2):
+                with nogil:
+                    status = cplanarity.gp_DrawPlanar_GetArrays(self.theGraph,
+                                vpos.data.as_ints, vstart.data.as_ints,
+                                vend.data.as_ints, epos.data.as_ints,
+                                estart.data.as_ints, eend.data.as_ints)
+                if status == cplanarity.OK:
+                    break
+                self._embed_drawplanar()
+            else:
+                raise RuntimeError("planarity: failed reading drawing.")
+            return dict(vertex_pos=_as_ndarray(vpos),
+                        vertex_start=_as_ndarray(vstart),
+                        vertex_end=_as_ndarray(vend),
+                        edge_pos=_as_ndarray(epos),
+                        edge_start=_as_ndarray(estart),
+                        edge_end=_as_ndarray(eend))
+
+
     def ascii(self):
         cdef char* s = NULL
-        self.embed_drawplanar()
-        status = cplanarity.gp_DrawPlanar_RenderToString(self.theGraph, &s)
+        with self.lock:
+            self._embed_drawplanar()
+            status = cplanarity.gp_DrawPlanar_RenderToString(self.theGraph, &s)
         py_bytes = s[:]
         free(s)
         return py_bytes.decode('ascii')
@@ -163,8 +1065,64 @@ cdef class PGraph:
 
     def write(self,path):
         bpath=path.encode()
-        status=cplanarity.gp_Write(self.theGraph, bpath, 
-                                   cplanarity.WRITE_ADJLIST)    
+        with self.lock:
+            status=cplanarity.gp_Write(self.theGraph, bpath, 
+                                       cplanarity.WRITE_ADJLIST)    
         
+    def write_embedding(self,path):
+        """Save the planar embedding (or the Kuratowski subgraph) of the
+        graph to path in a binary format, embedding the graph first if
+        needed.  The drawing of embed_drawplanar() is saved with it.
+
+        read_embedding() restores the graph without embedding it again.
+        Node labels are not saved; node i of the restored graph is the
+        node mapped to i+1 by mapping().
+        """
+        bpath=path.encode()
+        with self.lock:
+            if self.theGraph.embedFlags == 0:
+                self._embed_planar()
+            status=cplanarity.gp_Write(self.theGraph, bpath,
+                                       cplanarity.WRITE_EMBEDDING)
+        if status != cplanarity.OK:
+            raise IOError("planarity: failed writing embedding to %s." % path)
+
     def mapping(self):
+        if self.reverse_nodemap is None:
+            n = self.theGraph.N
+            return dict(zip(range(1,n+1),range(n)))
         return self.reverse_nodemap
+
+
+def read_embedding(path):
+    """Return a PGraph restored from a file written by write_embedding(),
+    with its embedding and any drawing, without embedding it again.
+    The nodes are the integers 0..n-1."""
+    cdef PGraph g = PGraph.__new__(PGraph)
+    cdef cplanarity.graphP theGraph
+    cdef int status
+    bpath = path.encode()
+    cdef char *cpath = bpath
+    theGraph = cplanarity.gp_New()
+    if theGraph == NULL:
+        raise MemoryError()
+    # The drawing, if there is one, is read by the DrawPlanar extension
+    if cplanarity.gp_AttachDrawPlanar(theGraph) != cplanarity.OK:
+        cplanarity.gp_Free(&theGraph)
+        raise RuntimeError("planarity: failed attaching drawplanar.")
+    with nogil:
+        status = cplanarity.gp_Read(theGraph, cpath)
+    if status != cplanarity.OK or theGraph.embedFlags == 0:
+        cplanarity.gp_Free(&theGraph)
+        raise IOError("planarity: failed reading embedding from %s." % path)
+    if (theGraph.embedFlags & cplanarity.EMBEDFLAGS_DRAWPLANAR) != \
+            cplanarity.EMBEDFLAGS_DRAWPLANAR:
+        cplanarity.gp_DetachDrawPlanar(theGraph)
+    g.theGraph = theGraph
+    g.nodemap = None
+    g.reverse_nodemap = None
+    if theGraph.internalFlags & cplanarity.FLAGS_OBSTRUCTIONFOUND:
+        g.embedding = cplanarity.NONEMBEDDABLE
+    else:
+        g.embedding = cplanarity.OK
+    return g
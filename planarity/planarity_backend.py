@@ -0,0 +1,107 @@
+"""NetworkX backend for planarity.
+
+Installing planarity registers it as the NetworkX backend "planarity"
+through the "networkx.backends" entry point, so that
+
+    nx.check_planarity(G, backend='planarity')
+
+or adding "planarity" to nx.config.backend_priority runs the planarity
+test in the C library instead of the pure Python implementation.
+"""
+import planarity
+from planarity.planarity_networkx import planar_embedding
+
+__all__ = ['BackendInterface', 'backend_interface', 'get_info']
+
+
+class PlanarityGraph:
+    """A graph converted for the planarity backend.
+
+    The C library cannot hold a graph without vertices, so pgraph is None
+    for the null graph.
+    """
+    __networkx_backend__ = 'planarity'
+
+    def __init__(self, pgraph):
+        self.pgraph = pgraph
+
+
+def _pgraph(G):
+    if isinstance(G, PlanarityGraph):
+        return G.pgraph
+    return BackendInterface.convert_from_nx(G).pgraph
+
+
+class BackendInterface:
+    """Functions that NetworkX dispatches to the planarity backend."""
+
+    @staticmethod
+    def convert_from_nx(G, *args, **kwargs):
+        import networkx as nx
+        if G.is_directed() or G.is_multigraph() or nx.number_of_selfloops(G):
+            # planarity is a property of the underlying simple graph
+            H = nx.Graph()
+            H.add_nodes_from(G)
+            H.add_edges_from((u, v) for u, v in G.edges() if u != v)
+            G = H
+        if len(G) == 0:
+            return PlanarityGraph(None)
+        return PlanarityGraph(planarity.PGraph(G))
+
+    @staticmethod
+    def convert_to_nx(obj, *, name=None):
+        if isinstance(obj, PlanarityGraph):
+            if obj.pgraph is None:
+                import networkx as nx
+                return nx.Graph()
+            return planarity.networkx_graph(obj.pgraph)
+        return obj
+
+    @staticmethod
+    def is_planar(G):
+        pgraph = _pgraph(G)
+        return pgraph is None or pgraph.is_planar()
+
+    @staticmethod
+    def check_planarity(G, counterexample=False):
+        import networkx as nx
+        pgraph = _pgraph(G)
+        if pgraph is None:
+            return True, nx.PlanarEmbedding()
+        if pgraph.is_planar():
+            return True, planar_embedding(pgraph)
+        if counterexample:
+            K = nx.Graph()
+            K.add_edges_from(pgraph.kuratowski_edges())
+            return False, K
+        return False, None
+
+    @staticmethod
+    def can_run(name, args, kwargs):
+        return hasattr(BackendInterface, name)
+
+    @staticmethod
+    def should_run(name, args, kwargs):
+        return True
+
+
+backend_interface = BackendInterface()
+
+
+def get_info():
+    """Return backend information for the "networkx.backend_info" entry point."""
+    return {
+        'backend_name': 'planarity',
+        'project': 'planarity',
+        'package': 'planarity',
+        'url': 'https://github.com/hagberg/planarity/',
+        'short_summary': "Planarity testing with Boyer's edge addition algorithm.",
+        'functions': {
+            'is_planar': {},
+            'check_planarity': {
+                'additional_docs': 'Runs the edge addition planarity test '
+                                   'in C and builds the PlanarEmbedding '
+                                   'from its rotation system.',
+            },
+        },
+    }
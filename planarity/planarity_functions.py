@@ -1,15 +1,38 @@
 """Functional interface to planarity."""
 import planarity
 
-__all__ = ['is_planar', 'kuratowski_edges', 'ascii', 'write', 'mapping']
+__all__ = ['is_planar', 'kuratowski_edges', 'ascii', 'write', 'mapping',
+           'write_embedding', 'enable_cache', 'disable_cache', 'cache_info']
+
+_cache = None
+
+def enable_cache(capacity=1024):
+    """Reuse is_planar and kuratowski_edges results for up to capacity
+    recently seen graphs; the previous cache, if any, is dropped."""
+    global _cache
+    _cache = planarity.ResultCache(capacity)
+
+def disable_cache():
+    """Stop caching results."""
+    global _cache
+    _cache = None
+
+def cache_info():
+    """Return a dict of cache hits, misses, size and capacity, or None
+    if the cache is disabled."""
+    cache = _cache
+    if cache is None:
+        return None
+    return dict(hits=cache.hits, misses=cache.misses,
+                size=len(cache), capacity=cache.capacity)
 
 def is_planar(graph):
     """Test planarity of graph."""
-    return planarity.PGraph(graph).is_planar()
+    return planarity.PGraph(graph, cache=_cache).is_planar()
 
 def kuratowski_edges(graph):
     """Return edges of forbidden subgraph of non-planar graph."""
-    return planarity.PGraph(graph).kuratowski_edges()
+    return planarity.PGraph(graph, cache=_cache).kuratowski_edges()
 
 def ascii(graph):
     """Draw text representation of a planar graph."""
@@ -19,6 +42,11 @@ def write(graph, path='stdout'):
     """Write an adjacency list representation of graph to path."""
     planarity.PGraph(graph).write(path)
 
+def write_embedding(graph, path):
+    """Save the planar embedding or Kuratowski subgraph of graph to path,
+    to be restored by planarity.read_embedding()."""
+    planarity.PGraph(graph, cache=_cache).write_embedding(path)
+
 def mapping(graph):
     """Return dictionary of internal mapping of nodes to integers."""
     return planarity.PGraph(graph).mapping()
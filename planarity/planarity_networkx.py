@@ -2,7 +2,8 @@
 import planarity
 
 __all__ = ['kuratowski_subgraph', 'pgraph_graph',
-           'networkx_graph', 'draw']
+           'networkx_graph', 'planar_embedding', 'straight_line_layout',
+           'draw']
 
 def kuratowski_subgraph(graph):
     """Return forbidden subgraph of nonplanar graph G."""
@@ -25,6 +26,54 @@ def networkx_graph(pgraph):
     graph.add_edges_from(pgraph.edges(data=True))
     return graph
 
+def planar_embedding(graph):
+    """Return NetworkX PlanarEmbedding of planar graph, or None if nonplanar.
+
+    The embedding is built from the rotation system computed by the C
+    library, adding all half-edges at once.
+    """
+    try:
+        import networkx as nx
+    except ImportError:
+        raise ImportError("NetworkX required for planar_embedding()")
+    if isinstance(graph, planarity.PGraph):
+        pgraph = graph
+    else:
+        pgraph = planarity.PGraph(graph)
+    if not pgraph.is_planar():
+        return None
+    nodes = pgraph.nodes()
+    offsets, neighbors = pgraph.rotation_system()
+    offsets = list(offsets)
+    neighbors = [nodes[i] for i in neighbors]
+    half_edges = []
+    for i, v in enumerate(nodes):
+        nbrs = neighbors[offsets[i]:offsets[i+1]]
+        d = len(nbrs)
+        # PlanarEmbedding keeps the first neighbor as the last key
+        for k in list(range(1, d)) + [0] if d else []:
+            half_edges.append((v, nbrs[k], {'cw': nbrs[(k+1) % d],
+                                            'ccw': nbrs[k-1]}))
+    embedding = nx.PlanarEmbedding()
+    embedding.add_nodes_from(nodes)
+    # bypass the add_half_edge() checks, the rotations are already complete
+    nx.DiGraph.add_edges_from(embedding, half_edges)
+    return embedding
+
+def straight_line_layout(graph):
+    """Return dict of integer (x, y) node positions of a planar
+    straight-line drawing, for use as the pos argument of networkx.draw().
+
+    Raises RuntimeError if the graph is not planar.
+    """
+    if isinstance(graph, planarity.PGraph):
+        pgraph = graph
+    else:
+        pgraph = planarity.PGraph(graph)
+    xs, ys = pgraph.straight_line_drawing()
+    return {node: (int(x), int(y))
+            for node, x, y in zip(pgraph.nodes(), xs, ys)}
+
 def pgraph_graph(graph):
     """Return pgraph graph built from NetworkX graph."""
     return planarity.PGraph(graph)
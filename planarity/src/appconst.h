@@ -11,15 +11,19 @@ See the LICENSE.TXT file for licensing information.
 #define WINDOWS
 #endif
 
-/* Defines fopen strings for reading and writing text files on PC and UNIX */
+/* Defines fopen strings for reading and writing text and binary files on PC and UNIX */
 
 #ifdef WINDOWS
 #define READTEXT        "rt"
 #define WRITETEXT       "wt"
+#define READBINARY      "rb"
+#define WRITEBINARY     "wb"
 #define FILE_DELIMITER  '\\'
 #else
 #define READTEXT        "r"
 #define WRITETEXT       "w"
+#define READBINARY      "rb"
+#define WRITEBINARY     "wb"
 #define FILE_DELIMITER  '/'
 #endif
 
@@ -0,0 +1,392 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+// fopencookie() is a GNU extension
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "appconst.h"
+#include "compressedFile.h"
+
+#if defined(__GLIBC__)
+#define CF_FOPENCOOKIE
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define CF_FUNOPEN
+#endif
+
+#if !defined(CF_FOPENCOOKIE) && !defined(CF_FUNOPEN)
+#undef PLANARITY_ZLIB
+#undef PLANARITY_ZSTD
+#endif
+
+#ifdef PLANARITY_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef PLANARITY_ZSTD
+#include <zstd.h>
+#endif
+
+/********************************************************************
+ Private functions
+ ********************************************************************/
+
+static int  _HasSuffix(char *FileName, char *suffix);
+
+#if defined(PLANARITY_ZLIB) || defined(PLANARITY_ZSTD)
+typedef long (*cf_ReadFunction)(void *cookie, char *buf, size_t size);
+typedef long (*cf_WriteFunction)(void *cookie, const char *buf, size_t size);
+typedef int  (*cf_CloseFunction)(void *cookie);
+
+static FILE *_OpenCookie(void *cookie, int writing,
+                         cf_ReadFunction readFunction, cf_WriteFunction writeFunction,
+                         cf_CloseFunction closeFunction);
+#endif
+
+#ifdef PLANARITY_ZLIB
+static FILE *_OpenGzip(char *FileName, int writing);
+#endif
+
+#ifdef PLANARITY_ZSTD
+static FILE *_OpenZstd(char *FileName, int writing);
+#endif
+
+/********************************************************************
+ cf_IsCompressedName()
+ Returns TRUE if the file name has the suffix of a compressed format.
+ ********************************************************************/
+
+int  cf_IsCompressedName(char *FileName)
+{
+     return _HasSuffix(FileName, ".gz") || _HasSuffix(FileName, ".zst");
+}
+
+/********************************************************************
+ cf_Open()
+ Opens FileName for reading if Mode starts with 'r', or for writing if
+ it starts with 'w', decompressing or compressing according to the
+ file name suffix.
+
+ Returns the FILE, or NULL if the file could not be opened or if the
+ compressed format is not supported by this build.
+ ********************************************************************/
+
+FILE *cf_Open(char *FileName, char *Mode)
+{
+     if (FileName == NULL)
+         return NULL;
+
+     if (_HasSuffix(FileName, ".gz"))
+     {
+#ifdef PLANARITY_ZLIB
+         return _OpenGzip(FileName, Mode[0] == 'w');
+#else
+         return NULL;
+#endif
+     }
+
+     if (_HasSuffix(FileName, ".zst"))
+     {
+#ifdef PLANARITY_ZSTD
+         return _OpenZstd(FileName, Mode[0] == 'w');
+#else
+         return NULL;
+#endif
+     }
+
+     return fopen(FileName, Mode);
+}
+
+/********************************************************************
+ _HasSuffix()
+ ********************************************************************/
+
+static int  _HasSuffix(char *FileName, char *suffix)
+{
+size_t nameLength = strlen(FileName), suffixLength = strlen(suffix);
+
+     return nameLength > suffixLength &&
+            strcmp(FileName + nameLength - suffixLength, suffix) == 0;
+}
+
+#if defined(PLANARITY_ZLIB) || defined(PLANARITY_ZSTD)
+
+/********************************************************************
+ _OpenCookie()
+ Makes a FILE that calls the given functions to read or write, with
+ whichever interface the C library provides.  The FILE cannot seek.
+ ********************************************************************/
+
+#ifdef CF_FUNOPEN
+
+// funopen() passes the cookie and sizes with different types, so the
+// functions are reached through a small wrapper
+typedef struct
+{
+     void *cookie;
+     cf_ReadFunction readFunction;
+     cf_WriteFunction writeFunction;
+     cf_CloseFunction closeFunction;
+} cf_FunopenCookie;
+
+static int  _FunopenRead(void *cookie, char *buf, int size)
+{
+cf_FunopenCookie *c = (cf_FunopenCookie *) cookie;
+     return (int) c->readFunction(c->cookie, buf, (size_t) size);
+}
+
+static int  _FunopenWrite(void *cookie, const char *buf, int size)
+{
+cf_FunopenCookie *c = (cf_FunopenCookie *) cookie;
+     return (int) c->writeFunction(c->cookie, buf, (size_t) size);
+}
+
+static int  _FunopenClose(void *cookie)
+{
+cf_FunopenCookie *c = (cf_FunopenCookie *) cookie;
+int  Result = c->closeFunction(c->cookie);
+     free(c);
+     return Result;
+}
+
+#endif
+
+static FILE *_OpenCookie(void *cookie, int writing,
+                         cf_ReadFunction readFunction, cf_WriteFunction writeFunction,
+                         cf_CloseFunction closeFunction)
+{
+FILE *theFile;
+
+#ifdef CF_FOPENCOOKIE
+cookie_io_functions_t functions;
+
+     memset(&functions, 0, sizeof(functions));
+     if (writing)
+         functions.write = (cookie_write_function_t *) writeFunction;
+     else
+         functions.read = (cookie_read_function_t *) readFunction;
+     functions.close = closeFunction;
+
+     if ((theFile = fopencookie(cookie, writing ? "w" : "r", functions)) == NULL)
+         closeFunction(cookie);
+#else
+cf_FunopenCookie *c = (cf_FunopenCookie *) malloc(sizeof(cf_FunopenCookie));
+
+     if (c == NULL)
+     {
+         closeFunction(cookie);
+         return NULL;
+     }
+
+     c->cookie = cookie;
+     c->readFunction = readFunction;
+     c->writeFunction = writeFunction;
+     c->closeFunction = closeFunction;
+
+     if ((theFile = funopen(c, writing ? NULL : _FunopenRead, writing ? _FunopenWrite : NULL,
+                            NULL, _FunopenClose)) == NULL)
+         _FunopenClose(c);
+#endif
+
+     return theFile;
+}
+
+#endif
+
+#ifdef PLANARITY_ZLIB
+
+/********************************************************************
+ gzip streams, by zlib
+ ********************************************************************/
+
+static long _GzipRead(void *cookie, char *buf, size_t size)
+{
+     return gzread((gzFile) cookie, buf, (unsigned) size);
+}
+
+static long _GzipWrite(void *cookie, const char *buf, size_t size)
+{
+     return size == 0 ? 0 : (gzwrite((gzFile) cookie, buf, (unsigned) size) == 0 ? -1 : (long) size);
+}
+
+static int  _GzipClose(void *cookie)
+{
+     return gzclose((gzFile) cookie) == Z_OK ? 0 : EOF;
+}
+
+static FILE *_OpenGzip(char *FileName, int writing)
+{
+gzFile gz;
+
+     if ((gz = gzopen(FileName, writing ? "wb" : "rb")) == NULL)
+         return NULL;
+
+     return _OpenCookie(gz, writing, _GzipRead, _GzipWrite, _GzipClose);
+}
+
+#endif
+
+#ifdef PLANARITY_ZSTD
+
+/********************************************************************
+ zstd streams
+ ********************************************************************/
+
+typedef struct
+{
+     FILE *file;
+     ZSTD_DStream *dstream;
+     ZSTD_CStream *cstream;
+     ZSTD_inBuffer in;
+     void *buffer;
+     size_t bufferSize;
+} cf_ZstdStream;
+
+static long _ZstdRead(void *cookie, char *buf, size_t size)
+{
+cf_ZstdStream *z = (cf_ZstdStream *) cookie;
+ZSTD_outBuffer out;
+
+     out.dst = buf;
+     out.size = size;
+     out.pos = 0;
+
+     while (out.pos == 0 && size > 0)
+     {
+         if (z->in.pos == z->in.size)
+         {
+             z->in.src = z->buffer;
+             z->in.size = fread(z->buffer, 1, z->bufferSize, z->file);
+             z->in.pos = 0;
+             if (z->in.size == 0)
+                 return ferror(z->file) ? -1 : 0;
+         }
+
+         if (ZSTD_isError(ZSTD_decompressStream(z->dstream, &out, &z->in)))
+             return -1;
+     }
+
+     return (long) out.pos;
+}
+
+static int  _ZstdFlush(cf_ZstdStream *z, ZSTD_outBuffer *out)
+{
+     if (out->pos > 0 && fwrite(out->dst, 1, out->pos, z->file) != out->pos)
+         return NOTOK;
+     out->pos = 0;
+     return OK;
+}
+
+static long _ZstdWrite(void *cookie, const char *buf, size_t size)
+{
+cf_ZstdStream *z = (cf_ZstdStream *) cookie;
+ZSTD_inBuffer in;
+ZSTD_outBuffer out;
+
+     in.src = buf;
+     in.size = size;
+     in.pos = 0;
+     out.dst = z->buffer;
+     out.size = z->bufferSize;
+     out.pos = 0;
+
+     while (in.pos < in.size)
+     {
+         if (ZSTD_isError(ZSTD_compressStream(z->cstream, &out, &in)) ||
+             _ZstdFlush(z, &out) != OK)
+             return -1;
+     }
+
+     return (long) size;
+}
+
+static int  _ZstdClose(void *cookie)
+{
+cf_ZstdStream *z = (cf_ZstdStream *) cookie;
+ZSTD_outBuffer out;
+size_t remaining;
+int  Result = 0;
+
+     if (z->cstream != NULL)
+     {
+         out.dst = z->buffer;
+         out.size = z->bufferSize;
+         out.pos = 0;
+
+         do {
+             remaining = ZSTD_endStream(z->cstream, &out);
+             if (ZSTD_isError(remaining) || _ZstdFlush(z, &out) != OK)
+             {
+                 Result = EOF;
+                 break;
+             }
+         } while (remaining > 0);
+
+         ZSTD_freeCStream(z->cstream);
+     }
+
+     if (z->dstream != NULL)
+         ZSTD_freeDStream(z->dstream);
+
+     if (z->file != NULL && fclose(z->file) != 0)
+         Result = EOF;
+
+     free(z->buffer);
+     free(z);
+     return Result;
+}
+
+static FILE *_OpenZstd(char *FileName, int writing)
+{
+cf_ZstdStream *z = (cf_ZstdStream *) calloc(1, sizeof(cf_ZstdStream));
+
+     if (z == NULL)
+         return NULL;
+
+     if ((z->file = fopen(FileName, writing ? "wb" : "rb")) == NULL)
+     {
+         free(z);
+         return NULL;
+     }
+
+     if (writing)
+     {
+         z->bufferSize = ZSTD_CStreamOutSize();
+         z->cstream = ZSTD_createCStream();
+         if (z->cstream != NULL && ZSTD_isError(ZSTD_initCStream(z->cstream, 3)))
+         {
+             ZSTD_freeCStream(z->cstream);
+             z->cstream = NULL;
+         }
+     }
+     else
+     {
+         z->bufferSize = ZSTD_DStreamInSize();
+         z->dstream = ZSTD_createDStream();
+         if (z->dstream != NULL && ZSTD_isError(ZSTD_initDStream(z->dstream)))
+         {
+             ZSTD_freeDStream(z->dstream);
+             z->dstream = NULL;
+         }
+     }
+
+     z->buffer = malloc(z->bufferSize);
+
+     if (z->buffer == NULL || (z->cstream == NULL && z->dstream == NULL))
+     {
+         _ZstdClose(z);
+         return NULL;
+     }
+
+     return _OpenCookie(z, writing, _ZstdRead, _ZstdWrite, _ZstdClose);
+}
+
+#endif
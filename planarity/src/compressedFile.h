@@ -0,0 +1,35 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+// Opens files whose names end in .gz or .zst as streams that are
+// decompressed while they are read, or compressed while they are written,
+// so that the graph readers and writers can use them like any other FILE.
+// Other files are opened with fopen().  The returned FILE is closed with
+// fclose(), which also finishes the compressed stream.
+//
+// Support for each format is chosen at build time: .gz files need zlib
+// and PLANARITY_ZLIB, and .zst files need the zstd library and
+// PLANARITY_ZSTD.  The C library must also be able to make a FILE from
+// read and write functions (fopencookie or funopen).  Opening a compressed
+// file without the needed support fails.
+
+FILE *cf_Open(char *FileName, char *Mode);
+int  cf_IsCompressedName(char *FileName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPRESSEDFILE_H */
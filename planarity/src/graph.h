@@ -15,6 +15,8 @@ extern "C" {
 
 #include "graphExtensions.h"
 
+#include "prng.h"
+
 ///////////////////////////////////////////////////////////////////////////////
 // Definitions for higher-order operations at the vertex, edge and graph levels
 ///////////////////////////////////////////////////////////////////////////////
@@ -29,6 +31,13 @@ graphP	gp_DupGraph(graphP theGraph);
 
 int		gp_CreateRandomGraph(graphP theGraph);
 int		gp_CreateRandomGraphEx(graphP theGraph, int numEdges);
+int		gp_CreateRandomGraphR(graphP theGraph, prngP theRNG);
+int		gp_CreateRandomGraphExR(graphP theGraph, int numEdges, prngP theRNG);
+
+int		gp_CreateRandomMaximalPlanarGraph(graphP theGraph, prngP theRNG);
+int		gp_CreateRandomPlanarGraph(graphP theGraph, int numEdges, prngP theRNG);
+int		gp_CreateRandomOuterplanarGraph(graphP theGraph, int numEdges, prngP theRNG);
+int		gp_CreateRandomNearPlanarGraph(graphP theGraph, int numExtraEdges, prngP theRNG);
 
 void	gp_Free(graphP *pGraph);
 
@@ -38,6 +47,7 @@ int		gp_ReadFromString(graphP theGraph, char *inputStr);
 #define WRITE_ADJLIST   1
 #define WRITE_ADJMATRIX 2
 #define WRITE_DEBUGINFO 3
+#define WRITE_EMBEDDING 4
 int		gp_Write(graphP theGraph, char *FileName, int Mode);
 int     gp_WriteToString(graphP theGraph, char **pOutputStr, int Mode);
 
@@ -47,10 +57,25 @@ int		gp_GetVertexDegree(graphP theGraph, int v);
 int		gp_GetVertexInDegree(graphP theGraph, int v);
 int		gp_GetVertexOutDegree(graphP theGraph, int v);
 
+int		gp_GetEdgeArray(graphP theGraph, int *edgeArray);
+int		gp_GetRotationSystem(graphP theGraph, int *offsets, int *neighbors);
+int		gp_GetFaces(graphP theEmbedding, int *arcFaces, int *faceOffsets, int *faceArcs);
+int		gp_CreateDualGraph(graphP theEmbedding, graphP theDual, int *arcDualArcs, int *dualArcArcs);
+int		gp_GetSharedFaces(graphP theEmbedding, int numPairs, int *pairs, int *sharedFaces);
+int		gp_GetTriconnectedComponents(graphP theGraph, int *compTypes, int *compOffsets,
+								 int *compEdges, int *virtualEdges);
+int		gp_PlanarSeparator(graphP theEmbedding, int *sides);
+int		gp_PlanarPartition(graphP theEmbedding, int k, int *parts);
+int		gp_TryAddEdgePlanar(graphP theEmbedding, int u, int v, stackP addedEdges);
+int		gp_RollbackAddedEdges(graphP theEmbedding, stackP addedEdges, int checkpoint);
+void	gp_ClearEmbedState(graphP theEmbedding);
+
 int		gp_GetArcCapacity(graphP theGraph);
 int		gp_EnsureArcCapacity(graphP theGraph, int requiredArcCapacity);
 
 int		gp_AddEdge(graphP theGraph, int u, int ulink, int v, int vlink);
+int		gp_AddEdgesFromArray(graphP theGraph, int numEdges, int *edgeArray, int *duplicates);
+int		gp_AddEdgesFromCompressed(graphP theGraph, int *indptr, int *indices, int minorIsRow);
 int     gp_InsertEdge(graphP theGraph, int u, int e_u, int e_ulink,
                                        int v, int e_v, int e_vlink);
 
@@ -78,6 +103,7 @@ int		gp_TestEmbedResultIntegrity(graphP theGraph, graphP origGraph, int embedRes
 #define EMBEDFLAGS_OUTERPLANAR  2
 
 #define EMBEDFLAGS_DRAWPLANAR   (4|EMBEDFLAGS_PLANAR)
+#define EMBEDFLAGS_DRAWSTRAIGHT (8|EMBEDFLAGS_PLANAR)
 
 #define EMBEDFLAGS_SEARCHFORK23 (16|EMBEDFLAGS_OUTERPLANAR)
 #define EMBEDFLAGS_SEARCHFORK4  (32|EMBEDFLAGS_OUTERPLANAR)
@@ -89,6 +115,12 @@ int		gp_TestEmbedResultIntegrity(graphP theGraph, graphP origGraph, int embedRes
 #define EMBEDFLAGS_PROJECTIVEPLANAR         512
 #define EMBEDFLAGS_TOROIDAL                 1024
 
+/* Types of the components listed by gp_GetTriconnectedComponents() */
+
+#define TRICOMP_BOND     1
+#define TRICOMP_POLYGON  2
+#define TRICOMP_RIGID    3
+
 /* If LOGGING is defined, then write to the log, otherwise no-op
    By default, neither release nor DEBUG builds including LOGGING.
    Logging is useful for seeing details of how various algorithms
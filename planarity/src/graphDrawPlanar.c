@@ -933,6 +933,60 @@ int gp_DrawPlanar_RenderToFile(graphP theEmbedding, char *theFileName)
     return NOTOK;
 }
 
+/********************************************************************
+ gp_DrawPlanar_GetArrays()
+
+ Copies the visibility representation of the planar graph into integer
+ arrays supplied by the caller.  The vertex arrays must have room for N
+ entries and are indexed by zero-based vertex index.  The edge arrays
+ must have room for M entries and list the edges in the order used by
+ gp_GetEdgeArray().  Any of the arrays may be NULL if it is not needed.
+
+ Returns NOTOK if the graph has no drawing, OK otherwise.
+ ********************************************************************/
+
+int  gp_DrawPlanar_GetArrays(graphP theEmbedding,
+                             int *vertexPos, int *vertexStart, int *vertexEnd,
+                             int *edgePos, int *edgeStart, int *edgeEnd)
+{
+DrawPlanarContext *context = NULL;
+int  v, w, e, first, numEdges = 0;
+
+     if (theEmbedding == NULL)
+         return NOTOK;
+
+     gp_FindExtension(theEmbedding, DRAWPLANAR_ID, (void *) &context);
+     if (context == NULL)
+         return NOTOK;
+
+     first = gp_GetFirstVertex(theEmbedding);
+     for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+     {
+          if (vertexPos != NULL)   vertexPos[v - first] = context->VI[v].pos;
+          if (vertexStart != NULL) vertexStart[v - first] = context->VI[v].start;
+          if (vertexEnd != NULL)   vertexEnd[v - first] = context->VI[v].end;
+
+          e = gp_GetFirstArc(theEmbedding, v);
+          while (gp_IsArc(e))
+          {
+              w = gp_GetNeighbor(theEmbedding, e);
+              if (w > v)
+              {
+                  if (numEdges >= theEmbedding->M)
+                      return NOTOK;
+
+                  if (edgePos != NULL)   edgePos[numEdges] = context->E[e].pos;
+                  if (edgeStart != NULL) edgeStart[numEdges] = context->E[e].start;
+                  if (edgeEnd != NULL)   edgeEnd[numEdges] = context->E[e].end;
+                  numEdges++;
+              }
+              e = gp_GetNextArc(theEmbedding, e);
+          }
+     }
+
+     return OK;
+}
+
 /********************************************************************
  _CheckVisibilityRepresentationIntegrity()
  ********************************************************************/
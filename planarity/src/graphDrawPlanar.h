@@ -21,6 +21,10 @@ int gp_DetachDrawPlanar(graphP theGraph);
 int  gp_DrawPlanar_RenderToFile(graphP theEmbedding, char *theFileName);
 int  gp_DrawPlanar_RenderToString(graphP theEmbedding, char **pRenditionString);
 
+int  gp_DrawPlanar_GetArrays(graphP theEmbedding,
+                             int *vertexPos, int *vertexStart, int *vertexEnd,
+                             int *edgePos, int *edgeStart, int *edgeEnd);
+
 #ifdef __cplusplus
 }
 #endif
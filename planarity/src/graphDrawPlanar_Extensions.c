@@ -586,10 +586,14 @@ int  _DrawPlanar_ReadPostprocess(graphP theGraph, void *extraData, long extraDat
                 extraData = strchr(extraData, '\n') + 1;
             }
 
-            // Read the lines that contain edge information
+            // Read the lines that contain edge information, which are
+            // written only for the edge records in use
             EsizeOccupied = gp_EdgeInUseIndexBound(theGraph);
             for (e = gp_GetFirstEdge(theGraph); e < EsizeOccupied; e++)
             {
+                if (gp_EdgeNotInUse(theGraph, e))
+                    continue;
+
                 sscanf(extraData, " %d%c %d %d %d", &tempInt, &tempChar,
                               &context->E[e].pos,
                               &context->E[e].start,
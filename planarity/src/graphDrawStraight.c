@@ -0,0 +1,962 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graphDrawStraight.h"
+#include "graphDrawStraight.private.h"
+
+extern int DRAWSTRAIGHT_ID;
+
+#include "graph.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/********************************************************************
+ Straight-line grid drawing
+
+ The drawing follows de Fraysseix, Pach and Pollack, with the linear
+ time shifting of Chrobak and Payne.  It works on a copy of the
+ rotation system of the embedding, which is made simple, connected,
+ biconnected and then triangulated by adding edges inside faces, so
+ the embedding of the original edges is kept.  A canonical ordering
+ v1, v2, ..., vN of the triangulation is found by removing vertices
+ from the outer face, and each vertex vk is then placed above the
+ contour of the drawing of v1..v(k-1), on the crossing of the lines
+ of slope +1 and -1 through its leftmost and rightmost neighbors on
+ the contour, after shifting the contour right of those neighbors to
+ make room.  Each x coordinate is kept relative to a parent in a tree
+ of the shifted vertex sets, so a shift costs O(1), and one pass down
+ the tree gives the final coordinates.
+
+ With N >= 3, the vertices receive distinct points of the grid
+ [0, 2N-4] x [0, N-2], v1 and v2 are (0, 0) and (2N-4, 0), and the
+ counterclockwise order of the neighbors of each vertex, with the y
+ axis pointing up, is the order of its adjacency list.  The whole
+ drawing takes O(N+M) time.
+ ********************************************************************/
+
+/* Private functions exported to system */
+
+int  _ComputeStraightLineDrawing(DrawStraightContext *context);
+int  _CheckStraightLineDrawingIntegrity(DrawStraightContext *context);
+
+/* Private functions */
+
+#define DS_NIL      (-1)
+
+// The rotation system being triangulated.  Vertices are zero-based,
+// the twin of arc a is a^1, and next and prev link the arcs of each
+// vertex in a circular list, in the order of its adjacency list.
+typedef struct
+{
+     int  N, numArcs;
+     int *head, *next, *prev, *firstArc;
+} ds_Map;
+
+static int  _ds_CreateMap(graphP theEmbedding, ds_Map *map);
+static void _ds_FreeMap(ds_Map *map);
+static int  _ds_AddEdge(ds_Map *map, int u, int uAfter, int w, int wAfter);
+static int  _ds_Connect(ds_Map *map);
+static int  _ds_Biconnect(ds_Map *map);
+static int  _ds_Find(int *parent, int x);
+static int  _ds_Triangulate(ds_Map *map);
+static int  _ds_GetCanonicalOrder(ds_Map *map, int *order, int *leftOf, int *rightOf);
+static int  _ds_PlaceVertices(int N, int *order, int *leftOf, int *rightOf, int *x, int *y);
+
+/********************************************************************
+ _ComputeStraightLineDrawing()
+
+ Gives each vertex of the embedding in context->theGraph a grid point.
+ ********************************************************************/
+
+int  _ComputeStraightLineDrawing(DrawStraightContext *context)
+{
+graphP theEmbedding = context->theGraph;
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding), v;
+int  Result = OK;
+int *order = NULL, *leftOf = NULL, *rightOf = NULL, *x = NULL, *y = NULL;
+ds_Map map;
+
+     // Too few vertices for a triangle go on the x axis
+     if (N < 3)
+     {
+         for (v = 0; v < N; v++)
+         {
+              context->VI[first + v].x = v;
+              context->VI[first + v].y = 0;
+         }
+         return OK;
+     }
+
+     if (_ds_CreateMap(theEmbedding, &map) != OK)
+         return NOTOK;
+
+     if ((order = (int *) malloc(N * sizeof(int))) == NULL ||
+         (leftOf = (int *) malloc(N * sizeof(int))) == NULL ||
+         (rightOf = (int *) malloc(N * sizeof(int))) == NULL ||
+         (x = (int *) malloc(N * sizeof(int))) == NULL ||
+         (y = (int *) malloc(N * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     if (Result == OK)
+     {
+         if (_ds_Connect(&map) != OK ||
+             _ds_Biconnect(&map) != OK ||
+             _ds_Triangulate(&map) != OK ||
+             map.numArcs != 2 * (3 * N - 6) ||
+             _ds_GetCanonicalOrder(&map, order, leftOf, rightOf) != OK ||
+             _ds_PlaceVertices(N, order, leftOf, rightOf, x, y) != OK)
+             Result = NOTOK;
+     }
+
+     if (Result == OK)
+     {
+         for (v = 0; v < N; v++)
+         {
+              context->VI[first + v].x = x[v];
+              context->VI[first + v].y = y[v];
+         }
+     }
+
+     _ds_FreeMap(&map);
+     free(order);
+     free(leftOf);
+     free(rightOf);
+     free(x);
+     free(y);
+
+     return Result;
+}
+
+/********************************************************************
+ _ds_CreateMap()
+
+ Copies the rotation system of theEmbedding into map, leaving out
+ loops and all but the first of a set of parallel edges, with room
+ for the 3N-6 edges of a triangulation.
+ ********************************************************************/
+
+static int  _ds_CreateMap(graphP theEmbedding, ds_Map *map)
+{
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding);
+int  numEdgeIds = theEmbedding->arcCapacity / 2, v, w, e, id, a, last;
+int  Result = OK;
+char *edgeState = NULL;
+int *seen = NULL, *mapArc = NULL;
+
+     memset(map, 0, sizeof(ds_Map));
+     map->N = N;
+
+     // The state of each edge is 0 if undecided, 1 if kept and 2 if left out
+     if ((map->head = (int *) malloc(2 * (3 * N - 6) * sizeof(int))) == NULL ||
+         (map->next = (int *) malloc(2 * (3 * N - 6) * sizeof(int))) == NULL ||
+         (map->prev = (int *) malloc(2 * (3 * N - 6) * sizeof(int))) == NULL ||
+         (map->firstArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (edgeState = (char *) calloc(numEdgeIds + 1, sizeof(char))) == NULL ||
+         (seen = (int *) malloc(N * sizeof(int))) == NULL ||
+         (mapArc = (int *) malloc((numEdgeIds + 1) * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     if (Result == OK)
+     {
+         for (v = 0; v < N; v++)
+              seen[v] = DS_NIL;
+
+         for (v = first; gp_VertexInRange(theEmbedding, v) && Result == OK; v++)
+         {
+              // Note the neighbors already kept from their other endpoint, then
+              // keep the first edge to each other neighbor
+              for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+                   if (edgeState[(e - gp_GetFirstEdge(theEmbedding)) >> 1] == 1)
+                       seen[gp_GetNeighbor(theEmbedding, e) - first] = v;
+
+              for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+              {
+                   id = (e - gp_GetFirstEdge(theEmbedding)) >> 1;
+                   if (edgeState[id] != 0)
+                       continue;
+
+                   w = gp_GetNeighbor(theEmbedding, e);
+                   if (w == v || seen[w - first] == v)
+                       edgeState[id] = 2;
+                   else if (map->numArcs >= 2 * (3 * N - 6))
+                   {
+                       // More edges than a simple planar graph can have
+                       Result = NOTOK;
+                       break;
+                   }
+                   else
+                   {
+                       edgeState[id] = 1;
+                       seen[w - first] = v;
+                       mapArc[id] = map->numArcs;
+                       map->numArcs += 2;
+                   }
+              }
+         }
+     }
+
+     // Each kept edge has the arcs mapArc and mapArc+1 in the same order as
+     // its two arcs in theEmbedding, and the arcs of each vertex are linked
+     // in the order of its adjacency list
+     for (v = first; Result == OK && gp_VertexInRange(theEmbedding, v); v++)
+     {
+          map->firstArc[v - first] = last = DS_NIL;
+          for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+          {
+               id = (e - gp_GetFirstEdge(theEmbedding)) >> 1;
+               if (edgeState[id] != 1)
+                   continue;
+
+               a = mapArc[id] + ((e - gp_GetFirstEdge(theEmbedding)) & 1);
+               map->head[a] = gp_GetNeighbor(theEmbedding, e) - first;
+               if (last == DS_NIL)
+                   map->firstArc[v - first] = a;
+               else
+               {
+                   map->next[last] = a;
+                   map->prev[a] = last;
+               }
+               last = a;
+          }
+
+          if (last != DS_NIL)
+          {
+              map->next[last] = map->firstArc[v - first];
+              map->prev[map->firstArc[v - first]] = last;
+          }
+     }
+
+     if (Result != OK)
+         _ds_FreeMap(map);
+
+     free(edgeState);
+     free(seen);
+     free(mapArc);
+
+     return Result;
+}
+
+/********************************************************************
+ _ds_FreeMap()
+ ********************************************************************/
+
+static void _ds_FreeMap(ds_Map *map)
+{
+     free(map->head);
+     free(map->next);
+     free(map->prev);
+     free(map->firstArc);
+     memset(map, 0, sizeof(ds_Map));
+}
+
+/********************************************************************
+ _ds_AddEdge()
+
+ Adds an edge between u and w, with its arc from u placed after the
+ arc uAfter of u and its arc from w after the arc wAfter of w.  DS_NIL
+ may be given for a vertex that has no arcs yet.
+
+ Returns the arc from u to w.
+ ********************************************************************/
+
+static int  _ds_AddEdge(ds_Map *map, int u, int uAfter, int w, int wAfter)
+{
+int  a = map->numArcs, j, v, after;
+
+     map->numArcs += 2;
+     map->head[a] = w;
+     map->head[a ^ 1] = u;
+
+     for (j = 0; j < 2; j++)
+     {
+          v = j == 0 ? u : w;
+          after = j == 0 ? uAfter : wAfter;
+
+          if (after == DS_NIL)
+          {
+              map->firstArc[v] = map->next[a ^ j] = map->prev[a ^ j] = a ^ j;
+          }
+          else
+          {
+              map->next[a ^ j] = map->next[after];
+              map->prev[a ^ j] = after;
+              map->prev[map->next[after]] = a ^ j;
+              map->next[after] = a ^ j;
+          }
+     }
+
+     return a;
+}
+
+/********************************************************************
+ _ds_Connect()
+
+ Joins each connected component to the first vertex by an edge, which
+ may go into any face of each side since the components are disjoint.
+ ********************************************************************/
+
+static int  _ds_Connect(ds_Map *map)
+{
+int  N = map->N, r, v, a, top;
+int *stack = NULL;
+char *visited = NULL;
+
+     if ((stack = (int *) malloc(N * sizeof(int))) == NULL ||
+         (visited = (char *) calloc(N, sizeof(char))) == NULL)
+     {
+         free(stack);
+         return NOTOK;
+     }
+
+     for (r = 0; r < N; r++)
+     {
+          if (visited[r])
+              continue;
+
+          if (r > 0)
+              _ds_AddEdge(map, 0, map->firstArc[0], r, map->firstArc[r]);
+
+          visited[r] = 1;
+          stack[0] = r;
+          top = 1;
+          while (top > 0)
+          {
+              v = stack[--top];
+              if ((a = map->firstArc[v]) == DS_NIL)
+                  continue;
+
+              do {
+                  if (!visited[map->head[a]])
+                  {
+                      visited[map->head[a]] = 1;
+                      stack[top++] = map->head[a];
+                  }
+                  a = map->next[a];
+              } while (a != map->firstArc[v]);
+          }
+     }
+
+     free(stack);
+     free(visited);
+
+     return OK;
+}
+
+/********************************************************************
+ _ds_Biconnect()
+
+ Finds the blocks of the connected map, then, wherever two arcs a and
+ b that follow each other around a vertex v lead to the neighbors u
+ and w in different blocks, adds the edge u-w inside the face between
+ them.  That merges exactly the two blocks, so u and w could not have
+ been adjacent, and afterward all edges of v are in one block.
+ ********************************************************************/
+
+static int  _ds_Biconnect(ds_Map *map)
+{
+int  N = map->N, numEdges = map->numArcs / 2, numBlocks = 0, Result = OK;
+int  v, w, a, b, top, edgeTop, count, blockA, blockB;
+int *disc = NULL, *low = NULL, *parentArc = NULL, *curArc = NULL, *stack = NULL;
+int *edgeStack = NULL, *block = NULL, *parent = NULL;
+
+     if ((disc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (low = (int *) malloc(N * sizeof(int))) == NULL ||
+         (parentArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (curArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (stack = (int *) malloc(N * sizeof(int))) == NULL ||
+         (edgeStack = (int *) malloc((numEdges + 1) * sizeof(int))) == NULL ||
+         (block = (int *) malloc((3 * N - 6) * sizeof(int))) == NULL ||
+         (parent = (int *) malloc((3 * N - 6) * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     // Depth first search from vertex 0, popping a block of edges each time
+     // a child cannot reach above its parent
+     if (Result == OK)
+     {
+         for (v = 0; v < N; v++)
+              disc[v] = DS_NIL;
+
+         count = 0;
+         disc[0] = low[0] = count++;
+         parentArc[0] = DS_NIL;
+         curArc[0] = map->firstArc[0];
+         stack[0] = 0;
+         top = 1;
+         edgeTop = 0;
+
+         while (top > 0)
+         {
+             v = stack[top - 1];
+             a = curArc[v];
+
+             if (a != DS_NIL)
+             {
+                 curArc[v] = map->next[a] == map->firstArc[v] ? DS_NIL : map->next[a];
+                 if (parentArc[v] != DS_NIL && a == (parentArc[v] ^ 1))
+                     continue;
+
+                 w = map->head[a];
+                 if (disc[w] == DS_NIL)
+                 {
+                     edgeStack[edgeTop++] = a >> 1;
+                     disc[w] = low[w] = count++;
+                     parentArc[w] = a;
+                     curArc[w] = map->firstArc[w];
+                     stack[top++] = w;
+                 }
+                 else if (disc[w] < disc[v])
+                 {
+                     edgeStack[edgeTop++] = a >> 1;
+                     if (disc[w] < low[v])
+                         low[v] = disc[w];
+                 }
+             }
+             else
+             {
+                 top--;
+                 if (parentArc[v] != DS_NIL)
+                 {
+                     w = map->head[parentArc[v] ^ 1];
+                     if (low[v] < low[w])
+                         low[w] = low[v];
+
+                     if (low[v] >= disc[w])
+                     {
+                         do {
+                             block[edgeStack[--edgeTop]] = numBlocks;
+                         } while (edgeStack[edgeTop] != (parentArc[v] >> 1));
+                         parent[numBlocks] = numBlocks;
+                         numBlocks++;
+                     }
+                 }
+             }
+         }
+
+         if (count != N)
+             Result = NOTOK;
+     }
+
+     for (v = 0; v < N && Result == OK; v++)
+     {
+          if ((a = map->firstArc[v]) == DS_NIL)
+              continue;
+
+          do {
+              b = map->next[a];
+              blockA = _ds_Find(parent, block[a >> 1]);
+              blockB = _ds_Find(parent, block[b >> 1]);
+              if (blockA != blockB)
+              {
+                  // The arc from u goes just before its arc to v, and the
+                  // arc from w just after its arc to v
+                  b = _ds_AddEdge(map, map->head[a], map->prev[a ^ 1], map->head[b], b ^ 1);
+                  parent[blockB] = blockA;
+                  block[b >> 1] = blockA;
+              }
+              a = map->next[a];
+          } while (a != map->firstArc[v]);
+     }
+
+     free(disc);
+     free(low);
+     free(parentArc);
+     free(curArc);
+     free(stack);
+     free(edgeStack);
+     free(block);
+     free(parent);
+
+     return Result;
+}
+
+/********************************************************************
+ _ds_Find()
+
+ Finds the set of x in the union-find forest parent, with path
+ compression.
+ ********************************************************************/
+
+static int  _ds_Find(int *parent, int x)
+{
+int  root = x, next;
+
+     while (parent[root] != root)
+         root = parent[root];
+
+     while (parent[x] != root)
+     {
+         next = parent[x];
+         parent[x] = root;
+         x = next;
+     }
+
+     return root;
+}
+
+/********************************************************************
+ _ds_Triangulate()
+
+ Triangulates the faces of the biconnected map.  The faces are taken
+ around each vertex v in turn, with the neighbors of v marked.  The
+ arc a from v to u1 starts the face v, u1, u2, u3, ..., which is a
+ simple cycle.  If u2 is not adjacent to v, the edge v-u2 cuts off
+ the triangle v, u1, u2.  Otherwise that edge runs outside the face,
+ so it separates u1 from u3, and the edge u1-u3 cuts off the triangle
+ u1, u2, u3.  Either way no parallel edge arises, and each face costs
+ time in proportion to its size.
+
+ The face of the arc x to z continues with the arc that follows the
+ arc z to x around z.
+ ********************************************************************/
+
+static int  _ds_Triangulate(ds_Map *map)
+{
+int  N = map->N, v, a, a0, b, c, n;
+int *mark = NULL;
+char *done = NULL;
+
+     if ((mark = (int *) malloc(N * sizeof(int))) == NULL ||
+         (done = (char *) calloc(2 * (3 * N - 6), sizeof(char))) == NULL)
+     {
+         free(mark);
+         return NOTOK;
+     }
+
+     for (v = 0; v < N; v++)
+          mark[v] = DS_NIL;
+
+     for (v = 0; v < N; v++)
+     {
+          a0 = map->firstArc[v];
+          a = a0;
+          do {
+              mark[map->head[a]] = v;
+              a = map->next[a];
+          } while (a != a0);
+
+          do {
+              if (!done[a])
+              {
+                  // New arcs from v go before a, so the walk around v
+                  // goes on from a
+                  int start = a;
+
+                  for (;;)
+                  {
+                       b = map->next[start ^ 1];
+                       c = map->next[b ^ 1];
+                       if (map->head[c] == v)
+                       {
+                           done[start] = done[b] = done[c] = 1;
+                           break;
+                       }
+
+                       if (mark[map->head[b]] != v)
+                       {
+                           n = _ds_AddEdge(map, v, map->prev[start], map->head[b], b ^ 1);
+                           done[start] = done[b] = done[n ^ 1] = 1;
+                           mark[map->head[b]] = v;
+                           start = n;
+                       }
+                       else
+                       {
+                           n = _ds_AddEdge(map, map->head[start], start ^ 1, map->head[c], c ^ 1);
+                           done[b] = done[c] = done[n ^ 1] = 1;
+                       }
+                  }
+              }
+              a = map->next[a];
+          } while (a != a0);
+     }
+
+     free(mark);
+     free(done);
+
+     return OK;
+}
+
+/********************************************************************
+ _ds_GetCanonicalOrder()
+
+ Finds a canonical ordering of the triangulated map, in which v1 and
+ v2 are the ends of its first arc, on the outer face v1, v2, vN.  The
+ vertices vN, ..., v3 are removed in turn from the outer face; the
+ one removed may be any vertex of the contour other than v1 and v2
+ with no chord, which is an edge joining two contour vertices that
+ are not consecutive on it.  The neighbors of vk that join the
+ contour lie between its contour neighbors counterclockwise.
+
+ order receives v1, v2, ..., vN, and leftOf and rightOf receive the
+ leftmost and rightmost neighbor of each vk on the contour of v1..vk-1.
+ ********************************************************************/
+
+static int  _ds_GetCanonicalOrder(ds_Map *map, int *order, int *leftOf, int *rightOf)
+{
+int  N = map->N, v1, v2, vN, k, x, L, R, u, uPrev, uNext, a, e, top = 0;
+int  Result = OK;
+int *chords = NULL, *contourLeft = NULL, *contourRight = NULL, *stack = NULL;
+char *state = NULL;
+
+     // A vertex is 0 if inside, 1 if on the contour and 2 if removed, and
+     // the stack holds candidates for removal, which may have gone stale
+     if ((chords = (int *) calloc(N, sizeof(int))) == NULL ||
+         (contourLeft = (int *) malloc(N * sizeof(int))) == NULL ||
+         (contourRight = (int *) malloc(N * sizeof(int))) == NULL ||
+         (stack = (int *) malloc((3 * N + 1) * sizeof(int))) == NULL ||
+         (state = (char *) calloc(N, sizeof(char))) == NULL)
+         Result = NOTOK;
+
+     if (Result == OK)
+     {
+         e = map->firstArc[0];
+         v1 = 0;
+         v2 = map->head[e];
+         vN = map->head[map->prev[e]];
+
+         order[0] = v1;
+         order[1] = v2;
+         state[v1] = state[v2] = state[vN] = 1;
+         contourRight[v1] = vN;
+         contourLeft[vN] = v1;
+         contourRight[vN] = v2;
+         contourLeft[v2] = vN;
+         stack[top++] = vN;
+
+         for (k = N - 1; k >= 2 && Result == OK; k--)
+         {
+              x = DS_NIL;
+              while (top > 0)
+              {
+                  x = stack[--top];
+                  if (state[x] == 1 && chords[x] == 0 && x != v1 && x != v2)
+                      break;
+                  x = DS_NIL;
+              }
+
+              if (x == DS_NIL)
+              {
+                  Result = NOTOK;
+                  break;
+              }
+
+              order[k] = x;
+              state[x] = 2;
+              L = leftOf[x] = contourLeft[x];
+              R = rightOf[x] = contourRight[x];
+
+              a = map->firstArc[x];
+              while (map->head[a] != L)
+                  a = map->next[a];
+
+              if (map->head[map->next[a]] == R)
+              {
+                  // The edge L-R was a chord, unless it is the edge v1-v2
+                  if (L != v1 || R != v2)
+                  {
+                      if (--chords[L] == 0)
+                          stack[top++] = L;
+                      if (--chords[R] == 0)
+                          stack[top++] = R;
+                  }
+                  contourRight[L] = R;
+                  contourLeft[R] = L;
+                  continue;
+              }
+
+              // Put the neighbors between L and R on the contour, counting
+              // the chords from each to the contour before it
+              uPrev = L;
+              for (a = map->next[a]; map->head[a] != R; a = map->next[a])
+              {
+                   u = map->head[a];
+                   uNext = map->head[map->next[a]];
+                   state[u] = 1;
+                   contourLeft[u] = uPrev;
+                   contourRight[uPrev] = u;
+
+                   e = map->firstArc[u];
+                   do {
+                       if (state[map->head[e]] == 1 && map->head[e] != uPrev && map->head[e] != uNext)
+                       {
+                           chords[u]++;
+                           chords[map->head[e]]++;
+                       }
+                       e = map->next[e];
+                   } while (e != map->firstArc[u]);
+
+                   uPrev = u;
+              }
+              contourRight[uPrev] = R;
+              contourLeft[R] = uPrev;
+
+              for (u = contourRight[L]; u != R; u = contourRight[u])
+                   if (chords[u] == 0)
+                       stack[top++] = u;
+         }
+     }
+
+     free(chords);
+     free(contourLeft);
+     free(contourRight);
+     free(stack);
+     free(state);
+
+     return Result;
+}
+
+/********************************************************************
+ _ds_PlaceVertices()
+
+ Places v1, v2 and v3 at (0, 0), (2, 0) and (1, 1), then each vk over
+ the contour from its leftmost neighbor wp to its rightmost neighbor
+ wq.  The vertices after wp on the contour move right by one and those
+ from wq on by one more, so that the lines of slope +1 from wp and -1
+ from wq cross at a grid point, where vk goes.  The contour vertices
+ strictly between wp and wq go under vk.
+
+ Each vertex keeps dx, its x offset from its parent in a binary tree:
+ its right child is the vertex after it on the contour, or under the
+ same vertex, and its left child is the first vertex under it.  The
+ subtree of a contour vertex holds all vertices right of it and under
+ them, so shifting it shifts them all.
+ ********************************************************************/
+
+static int  _ds_PlaceVertices(int N, int *order, int *leftOf, int *rightOf, int *x, int *y)
+{
+int  k, v, p, q, w, after, last, delta, top, Result = OK;
+int *dx = NULL, *left = NULL, *right = NULL, *stack = NULL;
+
+     if ((dx = (int *) malloc(N * sizeof(int))) == NULL ||
+         (left = (int *) malloc(N * sizeof(int))) == NULL ||
+         (right = (int *) malloc(N * sizeof(int))) == NULL ||
+         (stack = (int *) malloc(N * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     if (Result == OK)
+     {
+         for (v = 0; v < N; v++)
+              left[v] = right[v] = DS_NIL;
+
+         dx[order[0]] = 0;  y[order[0]] = 0;
+         dx[order[2]] = 1;  y[order[2]] = 1;
+         dx[order[1]] = 1;  y[order[1]] = 0;
+         right[order[0]] = order[2];
+         right[order[2]] = order[1];
+
+         for (k = 3; k < N; k++)
+         {
+              v = order[k];
+              p = leftOf[v];
+              q = rightOf[v];
+
+              after = right[p];
+              dx[after]++;
+              dx[q]++;
+
+              delta = 0;
+              last = p;
+              for (w = after; ; w = right[w])
+              {
+                   delta += dx[w];
+                   if (w == q)
+                       break;
+                   last = w;
+              }
+
+              dx[v] = (delta - y[p] + y[q]) / 2;
+              y[v] = (delta + y[p] + y[q]) / 2;
+              dx[q] = delta - dx[v];
+
+              if (after != q)
+              {
+                  dx[after] -= dx[v];
+                  left[v] = after;
+                  right[last] = DS_NIL;
+              }
+
+              right[p] = v;
+              right[v] = q;
+         }
+
+         // Add up the offsets from v1 down the tree
+         x[order[0]] = dx[order[0]];
+         stack[0] = order[0];
+         top = 1;
+         while (top > 0)
+         {
+             v = stack[--top];
+             if (left[v] != DS_NIL)
+             {
+                 x[left[v]] = x[v] + dx[left[v]];
+                 stack[top++] = left[v];
+             }
+             if (right[v] != DS_NIL)
+             {
+                 x[right[v]] = x[v] + dx[right[v]];
+                 stack[top++] = right[v];
+             }
+         }
+     }
+
+     free(dx);
+     free(left);
+     free(right);
+     free(stack);
+
+     return Result;
+}
+
+/********************************************************************
+ gp_DrawStraight_GetArrays()
+
+ Copies the straight-line drawing of the planar graph into integer
+ arrays supplied by the caller, which must have room for N entries and
+ are indexed by zero-based vertex index.
+
+ Returns NOTOK if the graph has no drawing, OK otherwise.
+ ********************************************************************/
+
+int  gp_DrawStraight_GetArrays(graphP theEmbedding, int *vertexX, int *vertexY)
+{
+DrawStraightContext *context = NULL;
+int  v, first;
+
+     if (theEmbedding == NULL || vertexX == NULL || vertexY == NULL ||
+         theEmbedding->embedFlags != EMBEDFLAGS_DRAWSTRAIGHT ||
+         (theEmbedding->internalFlags & FLAGS_OBSTRUCTIONFOUND))
+         return NOTOK;
+
+     gp_FindExtension(theEmbedding, DRAWSTRAIGHT_ID, (void *) &context);
+     if (context == NULL)
+         return NOTOK;
+
+     first = gp_GetFirstVertex(theEmbedding);
+     for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+     {
+          vertexX[v - first] = context->VI[v].x;
+          vertexY[v - first] = context->VI[v].y;
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _CheckStraightLineDrawingIntegrity()
+
+ Tests that the vertices are on distinct points of the grid and that,
+ around each vertex, the neighbors in adjacency list order go around
+ counterclockwise exactly once with no two in the same direction.
+ Repeats of an edge between the same vertices are passed over.
+ ********************************************************************/
+
+static int  _ds_Half(int dx, int dy);
+static int  _ds_Precedes(int dx1, int dy1, int dx2, int dy2);
+static int  _ds_ComparePoints(const void *p1, const void *p2);
+
+int  _CheckStraightLineDrawingIntegrity(DrawStraightContext *context)
+{
+graphP theEmbedding = context->theGraph;
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding);
+int  v, w, e, f, maxX = N < 3 ? N - 1 : 2 * N - 4, maxY = N < 3 ? 0 : N - 2;
+int  wraps, dx1, dy1, dx2, dy2, Result = OK;
+DrawStraight_VertexInfo *points;
+
+     if ((points = (DrawStraight_VertexInfo *) malloc((N + 1) * sizeof(DrawStraight_VertexInfo))) == NULL)
+         return NOTOK;
+
+     for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+     {
+          if (context->VI[v].x < 0 || context->VI[v].x > maxX ||
+              context->VI[v].y < 0 || context->VI[v].y > maxY)
+              Result = NOTOK;
+          points[v - first] = context->VI[v];
+     }
+
+     qsort(points, N, sizeof(DrawStraight_VertexInfo), _ds_ComparePoints);
+     for (v = 1; v < N && Result == OK; v++)
+          if (points[v].x == points[v - 1].x && points[v].y == points[v - 1].y)
+              Result = NOTOK;
+
+     free(points);
+
+     // Each step between successive distinct neighbors turns counterclockwise
+     // by less than a full turn, so the steps add up to exactly one full turn
+     // when they pass the direction of the positive x axis just once
+     for (v = first; Result == OK && gp_VertexInRange(theEmbedding, v); v++)
+     {
+          wraps = 0;
+          for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+          {
+               f = gp_GetNextArcCircular(theEmbedding, e);
+               w = gp_GetNeighbor(theEmbedding, f);
+               if (w == gp_GetNeighbor(theEmbedding, e) || w == v)
+                   continue;
+
+               dx1 = context->VI[gp_GetNeighbor(theEmbedding, e)].x - context->VI[v].x;
+               dy1 = context->VI[gp_GetNeighbor(theEmbedding, e)].y - context->VI[v].y;
+               dx2 = context->VI[w].x - context->VI[v].x;
+               dy2 = context->VI[w].y - context->VI[v].y;
+
+               if (!_ds_Precedes(dx1, dy1, dx2, dy2))
+               {
+                   if (!_ds_Precedes(dx2, dy2, dx1, dy1))
+                   {
+                       Result = NOTOK;
+                       break;
+                   }
+                   wraps++;
+               }
+          }
+
+          if (wraps > 1)
+              Result = NOTOK;
+     }
+
+     return Result;
+}
+
+/********************************************************************
+ _ds_Half()
+ Returns 0 for directions at angles in [0, pi) and 1 for [pi, 2pi).
+ ********************************************************************/
+
+static int  _ds_Half(int dx, int dy)
+{
+     return dy < 0 || (dy == 0 && dx < 0) ? 1 : 0;
+}
+
+/********************************************************************
+ _ds_Precedes()
+ Returns TRUE if the direction (dx1, dy1) has a smaller angle in
+ [0, 2pi) than (dx2, dy2).
+ ********************************************************************/
+
+static int  _ds_Precedes(int dx1, int dy1, int dx2, int dy2)
+{
+int  h1 = _ds_Half(dx1, dy1), h2 = _ds_Half(dx2, dy2);
+
+     if (h1 != h2)
+         return h1 < h2;
+
+     return (long long) dx1 * dy2 - (long long) dy1 * dx2 > 0;
+}
+
+/********************************************************************
+ _ds_ComparePoints()
+ ********************************************************************/
+
+static int  _ds_ComparePoints(const void *p1, const void *p2)
+{
+const DrawStraight_VertexInfo *a = (const DrawStraight_VertexInfo *) p1;
+const DrawStraight_VertexInfo *b = (const DrawStraight_VertexInfo *) p2;
+
+     if (a->x != b->x)
+         return a->x < b->x ? -1 : 1;
+     if (a->y != b->y)
+         return a->y < b->y ? -1 : 1;
+     return 0;
+}
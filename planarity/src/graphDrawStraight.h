@@ -0,0 +1,27 @@
+#ifndef GRAPH_DRAWSTRAIGHT_H
+#define GRAPH_DRAWSTRAIGHT_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graphStructures.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRAWSTRAIGHT_NAME "DrawStraight"
+
+int gp_AttachDrawStraight(graphP theGraph);
+int gp_DetachDrawStraight(graphP theGraph);
+
+int  gp_DrawStraight_GetArrays(graphP theEmbedding, int *vertexX, int *vertexY);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef GRAPH_DRAWSTRAIGHT_PRIVATE_H
+#define GRAPH_DRAWSTRAIGHT_PRIVATE_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Additional equipment for each vertex
+/*
+        x, y: the grid point of the vertex in a straight-line drawing
+*/
+typedef struct
+{
+     int  x, y;
+} DrawStraight_VertexInfo;
+
+typedef DrawStraight_VertexInfo * DrawStraight_VertexInfoP;
+
+typedef struct
+{
+    // Helps distinguish initialize from re-initialize
+    int initialized;
+
+    // The graph that this context augments
+    graphP theGraph;
+
+    // Parallel array for additional vertex level equipment
+    DrawStraight_VertexInfoP VI;
+
+    // Overloaded function pointers
+    graphFunctionTable functions;
+
+} DrawStraightContext;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,403 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+
+#include "graphDrawStraight.private.h"
+#include "graphDrawStraight.h"
+
+extern void _ClearVertexVisitedFlags(graphP theGraph, int);
+
+extern int  _ComputeStraightLineDrawing(DrawStraightContext *context);
+extern int  _CheckStraightLineDrawingIntegrity(DrawStraightContext *context);
+
+/* Forward declarations of local functions */
+
+void _DrawStraight_ClearStructures(DrawStraightContext *context);
+int  _DrawStraight_CreateStructures(DrawStraightContext *context);
+int  _DrawStraight_InitStructures(DrawStraightContext *context);
+
+/* Forward declarations of overloading functions */
+
+int  _DrawStraight_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult);
+int  _DrawStraight_CheckEmbeddingIntegrity(graphP theGraph, graphP origGraph);
+int  _DrawStraight_CheckObstructionIntegrity(graphP theGraph, graphP origGraph);
+
+int  _DrawStraight_InitGraph(graphP theGraph, int N);
+void _DrawStraight_ReinitializeGraph(graphP theGraph);
+int  _DrawStraight_SortVertices(graphP theGraph);
+
+/* Forward declarations of functions used by the extension system */
+
+void *_DrawStraight_DupContext(void *pContext, void *theGraph);
+void _DrawStraight_FreeContext(void *);
+
+/****************************************************************************
+ * DRAWSTRAIGHT_ID - the variable used to hold the integer identifier for
+ * this extension, enabling this feature's extension context to be
+ * distinguished from other features' extension contexts that may be
+ * attached to a graph.
+ ****************************************************************************/
+
+int DRAWSTRAIGHT_ID = 0;
+
+/****************************************************************************
+ gp_AttachDrawStraight()
+
+ This function adjusts the graph data structure to attach the straight-line
+ graph drawing feature.
+
+ To activate this feature during gp_Embed(), use EMBEDFLAGS_DRAWSTRAIGHT.
+ Then a planar graph receives a planar embedding, as for EMBEDFLAGS_PLANAR,
+ and integer grid coordinates for its vertices.  A nonplanar graph gets
+ NONEMBEDDABLE without an isolated obstruction, as with drawing by
+ visibility representation.
+
+ As with gp_AttachDrawPlanar(), this method may be called before gp_Read()
+ or before or after gp_InitGraph().
+
+ Returns OK for success, NOTOK for failure.
+ ****************************************************************************/
+
+int  gp_AttachDrawStraight(graphP theGraph)
+{
+     DrawStraightContext *context = NULL;
+
+     // If the drawing feature has already been attached to the graph,
+     // then there is no need to attach it again
+     gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+     if (context != NULL)
+     {
+         return OK;
+     }
+
+     // Allocate a new extension context
+     context = (DrawStraightContext *) malloc(sizeof(DrawStraightContext));
+     if (context == NULL)
+     {
+         return NOTOK;
+     }
+
+     // First, tell the context that it is not initialized
+     context->initialized = 0;
+
+     // Save a pointer to theGraph in the context
+     context->theGraph = theGraph;
+
+     // Put the overload functions into the context function table.
+     // gp_AddExtension will overload the graph's functions with these, and
+     // return the base function pointers in the context function table
+     memset(&context->functions, 0, sizeof(graphFunctionTable));
+
+     context->functions.fpEmbedPostprocess = _DrawStraight_EmbedPostprocess;
+     context->functions.fpCheckEmbeddingIntegrity = _DrawStraight_CheckEmbeddingIntegrity;
+     context->functions.fpCheckObstructionIntegrity = _DrawStraight_CheckObstructionIntegrity;
+
+     context->functions.fpInitGraph = _DrawStraight_InitGraph;
+     context->functions.fpReinitializeGraph = _DrawStraight_ReinitializeGraph;
+     context->functions.fpSortVertices = _DrawStraight_SortVertices;
+
+     _DrawStraight_ClearStructures(context);
+
+     // Store the drawing context, including the data structure and the
+     // function pointers, as an extension of the graph
+     if (gp_AddExtension(theGraph, &DRAWSTRAIGHT_ID, (void *) context,
+                         _DrawStraight_DupContext, _DrawStraight_FreeContext,
+                         &context->functions) != OK)
+     {
+         _DrawStraight_FreeContext(context);
+         return NOTOK;
+     }
+
+     // Create the drawing structures if the size of the graph is known,
+     // i.e. if the feature is attached after gp_InitGraph()
+     if (theGraph->N > 0)
+     {
+         if (_DrawStraight_CreateStructures(context) != OK ||
+             _DrawStraight_InitStructures(context) != OK)
+         {
+             _DrawStraight_FreeContext(context);
+             return NOTOK;
+         }
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ gp_DetachDrawStraight()
+ ********************************************************************/
+
+int gp_DetachDrawStraight(graphP theGraph)
+{
+    return gp_RemoveExtension(theGraph, DRAWSTRAIGHT_ID);
+}
+
+/********************************************************************
+ _DrawStraight_ClearStructures()
+ ********************************************************************/
+
+void _DrawStraight_ClearStructures(DrawStraightContext *context)
+{
+    if (!context->initialized)
+    {
+        // Before initialization, the pointers are stray, not NULL
+        // Once NULL or allocated, free() can do the job
+        context->VI = NULL;
+
+        context->initialized = 1;
+    }
+    else
+    {
+        if (context->VI != NULL)
+        {
+            free(context->VI);
+            context->VI = NULL;
+        }
+    }
+}
+
+/********************************************************************
+ _DrawStraight_CreateStructures()
+ Create uninitialized structures for the vertex level
+ ********************************************************************/
+int  _DrawStraight_CreateStructures(DrawStraightContext *context)
+{
+     graphP theGraph = context->theGraph;
+     int VIsize = gp_PrimaryVertexIndexBound(theGraph);
+
+     if (theGraph->N <= 0)
+         return NOTOK;
+
+     if ((context->VI = (DrawStraight_VertexInfoP) malloc(VIsize*sizeof(DrawStraight_VertexInfo))) == NULL)
+     {
+         return NOTOK;
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _DrawStraight_InitStructures()
+ Intended to be called when N>0.
+ ********************************************************************/
+int  _DrawStraight_InitStructures(DrawStraightContext *context)
+{
+     graphP theGraph = context->theGraph;
+
+     if (theGraph->N <= 0)
+         return NOTOK;
+
+     memset(context->VI, 0, gp_PrimaryVertexIndexBound(theGraph) * sizeof(DrawStraight_VertexInfo));
+
+     return OK;
+}
+
+/********************************************************************
+ _DrawStraight_DupContext()
+ ********************************************************************/
+
+void *_DrawStraight_DupContext(void *pContext, void *theGraph)
+{
+     DrawStraightContext *context = (DrawStraightContext *) pContext;
+     DrawStraightContext *newContext = (DrawStraightContext *) malloc(sizeof(DrawStraightContext));
+
+     if (newContext != NULL)
+     {
+         int VIsize = gp_PrimaryVertexIndexBound((graphP) theGraph);
+
+         *newContext = *context;
+
+         newContext->theGraph = (graphP) theGraph;
+
+         newContext->initialized = 0;
+         _DrawStraight_ClearStructures(newContext);
+         if (((graphP) theGraph)->N > 0)
+         {
+             if (_DrawStraight_CreateStructures(newContext) != OK)
+             {
+                 _DrawStraight_FreeContext(newContext);
+                 return NULL;
+             }
+
+             // Initialize custom data structures by copying
+             memcpy(newContext->VI, context->VI, VIsize*sizeof(DrawStraight_VertexInfo));
+         }
+     }
+
+     return newContext;
+}
+
+/********************************************************************
+ _DrawStraight_FreeContext()
+ ********************************************************************/
+
+void _DrawStraight_FreeContext(void *pContext)
+{
+     DrawStraightContext *context = (DrawStraightContext *) pContext;
+
+     _DrawStraight_ClearStructures(context);
+     free(pContext);
+}
+
+/********************************************************************
+ ********************************************************************/
+
+int  _DrawStraight_InitGraph(graphP theGraph, int N)
+{
+    DrawStraightContext *context = NULL;
+    gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+
+    if (context == NULL) {
+        return NOTOK;
+    }
+
+    theGraph->N = N;
+    theGraph->NV = N;
+    if (theGraph->arcCapacity == 0)
+        theGraph->arcCapacity = 2*DEFAULT_EDGE_LIMIT*N;
+
+    if (_DrawStraight_CreateStructures(context) != OK ||
+        _DrawStraight_InitStructures(context) != OK)
+        return NOTOK;
+
+    context->functions.fpInitGraph(theGraph, N);
+
+    return OK;
+}
+
+/********************************************************************
+ ********************************************************************/
+
+void _DrawStraight_ReinitializeGraph(graphP theGraph)
+{
+    DrawStraightContext *context = NULL;
+    gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        // Reinitialize the graph
+        context->functions.fpReinitializeGraph(theGraph);
+
+        // Do the reinitialization that is specific to this module
+        _DrawStraight_InitStructures(context);
+    }
+}
+
+/********************************************************************
+ _DrawStraight_SortVertices()
+
+ Moves the coordinates along with their vertices, in place as in
+ _DrawPlanar_SortVertices().
+ ********************************************************************/
+
+int  _DrawStraight_SortVertices(graphP theGraph)
+{
+    DrawStraightContext *context = NULL;
+    gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        if (theGraph->embedFlags == EMBEDFLAGS_DRAWSTRAIGHT)
+        {
+            int v, vIndex;
+            DrawStraight_VertexInfo temp;
+
+            _ClearVertexVisitedFlags(theGraph, FALSE);
+            for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+            {
+                if (gp_GetVertexVisited(theGraph, v))
+                    continue;
+
+                vIndex = gp_GetVertexIndex(theGraph, v);
+
+                while (!gp_GetVertexVisited(theGraph, v))
+                {
+                    temp = context->VI[v];
+                    context->VI[v] = context->VI[vIndex];
+                    context->VI[vIndex] = temp;
+
+                    gp_SetVertexVisited(theGraph, vIndex);
+
+                    vIndex = gp_GetVertexIndex(theGraph, vIndex);
+                }
+            }
+        }
+
+        if (context->functions.fpSortVertices(theGraph) != OK)
+            return NOTOK;
+
+        return OK;
+    }
+
+    return NOTOK;
+}
+
+/********************************************************************
+ ********************************************************************/
+
+int _DrawStraight_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult)
+{
+    DrawStraightContext *context = NULL;
+    gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        int RetVal = context->functions.fpEmbedPostprocess(theGraph, v, edgeEmbeddingResult);
+
+        if (theGraph->embedFlags == EMBEDFLAGS_DRAWSTRAIGHT)
+        {
+            if (RetVal == OK)
+            {
+                RetVal = _ComputeStraightLineDrawing(context);
+            }
+        }
+
+        return RetVal;
+    }
+
+    return NOTOK;
+}
+
+/********************************************************************
+ ********************************************************************/
+
+int  _DrawStraight_CheckEmbeddingIntegrity(graphP theGraph, graphP origGraph)
+{
+    DrawStraightContext *context = NULL;
+    gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        if (context->functions.fpCheckEmbeddingIntegrity(theGraph, origGraph) != OK)
+            return NOTOK;
+
+        if (theGraph->embedFlags == EMBEDFLAGS_DRAWSTRAIGHT)
+            return _CheckStraightLineDrawingIntegrity(context);
+
+        return OK;
+    }
+
+    return NOTOK;
+}
+
+/********************************************************************
+ No obstruction is isolated when drawing a nonplanar graph.
+ ********************************************************************/
+
+int  _DrawStraight_CheckObstructionIntegrity(graphP theGraph, graphP origGraph)
+{
+    DrawStraightContext *context = NULL;
+    gp_FindExtension(theGraph, DRAWSTRAIGHT_ID, (void *)&context);
+
+    if (context == NULL)
+        return NOTOK;
+
+    if (theGraph->embedFlags == EMBEDFLAGS_DRAWSTRAIGHT)
+        return OK;
+
+    return context->functions.fpCheckObstructionIntegrity(theGraph, origGraph);
+}
@@ -135,7 +135,15 @@ int RetVal = OK;
     // Postprocessing to orient the embedding and merge any remaining separated bicomps.
     // Some extension algorithms may overload this function, e.g. to do nothing if they
     // have no need of an embedding.
-    return theGraph->functions.fpEmbedPostprocess(theGraph, v, RetVal);
+    RetVal = theGraph->functions.fpEmbedPostprocess(theGraph, v, RetVal);
+
+    // Record whether the graph now holds an obstruction rather than an embedding
+    if (RetVal == NONEMBEDDABLE)
+        theGraph->internalFlags |= FLAGS_OBSTRUCTIONFOUND;
+    else
+        theGraph->internalFlags &= ~FLAGS_OBSTRUCTIONFOUND;
+
+    return RetVal;
 }
 
 /********************************************************************
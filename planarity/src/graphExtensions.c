@@ -8,6 +8,7 @@ See the LICENSE.TXT file for licensing information.
 #include <string.h>
 
 #include "appconst.h"
+#include "platformThread.h"
 
 #include "graphExtensions.private.h"
 #include "graphExtensions.h"
@@ -31,6 +32,8 @@ graphExtensionP _FindNearestOverload(graphP theGraph, graphExtensionP target, in
  * graphs.  It is used in lieu of identifying extensions by a string
  * name, which is noticeably expensive when a frequently called
  * overload function seeks the extension context for a graph.
+ * IDs are assigned atomically, so extensions can be attached to
+ * different graphs in several threads at once.
  ********************************************************************/
 
 static int moduleIDGenerator = 0;
@@ -216,9 +219,10 @@ int gp_AddExtension(graphP theGraph,
     }
 
     // Assign a unique ID to the extension if it does not already have one
+    // If another thread assigns the ID first, its ID is kept
     if (*pModuleID == 0)
     {
-    	*pModuleID = ++moduleIDGenerator;
+    	platform_AtomicCompareAndSwap(pModuleID, 0, platform_AtomicIncrement(&moduleIDGenerator));
     }
 
     // Allocate the new extension
@@ -8,6 +8,8 @@ See the LICENSE.TXT file for licensing information.
 #include <string.h>
 
 #include "graph.h"
+#include "platformThread.h"
+#include "compressedFile.h"
 
 /* Private functions (exported to system) */
 
@@ -16,6 +18,11 @@ int  _ReadAdjList(graphP theGraph, FILE *Infile, strBufP inBuf);
 int  _WriteAdjList(graphP theGraph, FILE *Outfile, strBufP outBuf);
 int  _WriteAdjMatrix(graphP theGraph, FILE *Outfile, strBufP outBuf);
 int  _WriteDebugInfo(graphP theGraph, FILE *Outfile);
+int  _ReadEmbedding(graphP theGraph, FILE *Infile);
+int  _WriteEmbedding(graphP theGraph, FILE *Outfile);
+
+static int  _ReadEmbeddingInt(FILE *Infile, int *pValue);
+static void _WriteEmbeddingInt(FILE *Outfile, int value);
 
 /********************************************************************
  _ReadAdjMatrix()
@@ -352,6 +359,173 @@ int  _ReadLEDAGraph(graphP theGraph, FILE *Infile)
     return OK;
 }
 
+/********************************************************************
+ Embedding file format
+
+ A binary record of the vertex and edge records of a graph, which is
+ meant for saving the result of gp_Embed() (after gp_SortVertices()) so
+ that it can be reloaded without embedding the graph again.
+
+ Every number is a 32-bit big-endian integer.  Vertices and arcs are
+ numbered from 0 in the file, and -1 stands for NIL.  The file contains
+   - the 4 characters PEMB and the format version, 1
+   - N, M, the number of arc records A (2M plus any holes), and the
+     internalFlags and embedFlags of the graph
+   - for each of the N vertices, its first arc, index and flags
+   - for each of the A arcs, its neighbor (-1 for a hole), next arc
+     and flags
+ followed by any extra data written by the graph extensions, as in the
+ text formats.  The arc flags keep the orientation (inverted and
+ direction bits) and edge types, and since arcs keep their positions,
+ the extension data for each arc, such as the visibility representation
+ of DrawPlanar, is restored with it.
+ ********************************************************************/
+
+#define EMBEDDING_VERSION 1
+
+#define _VertexToFile(theGraph, v) (gp_IsVertex(v) ? (v) - gp_GetFirstVertex(theGraph) : -1)
+#define _VertexFromFile(theGraph, v) ((v) >= 0 ? (v) + gp_GetFirstVertex(theGraph) : NIL)
+#define _ArcToFile(theGraph, e) (gp_IsArc(e) ? (e) - gp_GetFirstEdge(theGraph) : -1)
+#define _ArcFromFile(theGraph, e) ((e) >= 0 ? (e) + gp_GetFirstEdge(theGraph) : NIL)
+
+/********************************************************************
+ _ReadEmbedding()
+ Reads a graph in the embedding file format, restoring its adjacency
+ lists in their saved order.  The links are checked as they are
+ restored, so a damaged file is rejected rather than producing a
+ malformed graph.  O(N + M) time.
+
+ Returns: OK, or NOTOK on file content error (or internal error)
+ ********************************************************************/
+
+int  _ReadEmbedding(graphP theGraph, FILE *Infile)
+{
+int  N, M, numArcs, internalFlags, embedFlags, version, value;
+int  v, e, eNext, ePrev, numListed = 0, numInUse = 0, Result = OK;
+char magic[4], *listed;
+
+     if (fread(magic, 1, 4, Infile) != 4 || memcmp(magic, "PEMB", 4) != 0 ||
+         _ReadEmbeddingInt(Infile, &version) != OK || version != EMBEDDING_VERSION ||
+         _ReadEmbeddingInt(Infile, &N) != OK ||
+         _ReadEmbeddingInt(Infile, &M) != OK ||
+         _ReadEmbeddingInt(Infile, &numArcs) != OK ||
+         _ReadEmbeddingInt(Infile, &internalFlags) != OK ||
+         _ReadEmbeddingInt(Infile, &embedFlags) != OK)
+         return NOTOK;
+
+     if (N <= 0 || M < 0 || numArcs < 2*M || (numArcs & 1))
+         return NOTOK;
+
+     if (gp_InitGraph(theGraph, N) != OK ||
+         (numArcs > 0 && gp_EnsureArcCapacity(theGraph, numArcs) != OK))
+         return NOTOK;
+
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+     {
+          if (_ReadEmbeddingInt(Infile, &value) != OK || value < -1 || value >= numArcs)
+              return NOTOK;
+          gp_SetFirstArc(theGraph, v, _ArcFromFile(theGraph, value));
+          gp_SetLastArc(theGraph, v, NIL);
+
+          if (_ReadEmbeddingInt(Infile, &value) != OK || value < -1 || value >= N)
+              return NOTOK;
+          gp_SetVertexIndex(theGraph, v, _VertexFromFile(theGraph, value));
+
+          if (_ReadEmbeddingInt(Infile, &value) != OK)
+              return NOTOK;
+          theGraph->V[v].flags = (unsigned) value;
+     }
+
+     for (e = gp_GetFirstEdge(theGraph); e < gp_GetFirstEdge(theGraph) + numArcs; e++)
+     {
+          if (_ReadEmbeddingInt(Infile, &value) != OK || value < -1 || value >= N)
+              return NOTOK;
+          gp_SetNeighbor(theGraph, e, _VertexFromFile(theGraph, value));
+
+          if (_ReadEmbeddingInt(Infile, &value) != OK || value < -1 || value >= numArcs)
+              return NOTOK;
+          gp_SetNextArc(theGraph, e, _ArcFromFile(theGraph, value));
+          gp_SetPrevArc(theGraph, e, NIL);
+
+          if (_ReadEmbeddingInt(Infile, &value) != OK)
+              return NOTOK;
+          theGraph->E[e].flags = (unsigned) value;
+     }
+
+     // Restore the previous arc and last arc links by walking each adjacency
+     // list, checking that every arc in use is listed once, by the twin
+     // of an arc that leads to the vertex of the list
+     if ((listed = (char *) calloc(numArcs > 0 ? numArcs : 1, sizeof(char))) == NULL)
+         return NOTOK;
+
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v) && Result == OK; v++)
+     {
+          ePrev = NIL;
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              if (listed[e - gp_GetFirstEdge(theGraph)] || gp_EdgeNotInUse(theGraph, e) ||
+                  gp_GetNeighbor(theGraph, gp_GetTwinArc(theGraph, e)) != v)
+              {
+                  Result = NOTOK;
+                  break;
+              }
+              listed[e - gp_GetFirstEdge(theGraph)] = 1;
+              numListed++;
+
+              eNext = gp_GetNextArc(theGraph, e);
+              gp_SetPrevArc(theGraph, e, ePrev);
+              ePrev = e;
+              e = eNext;
+          }
+          gp_SetLastArc(theGraph, v, ePrev);
+     }
+
+     free(listed);
+
+     if (Result != OK || numListed != 2*M)
+         return NOTOK;
+
+     // The arcs not in use are holes, which are recorded in pairs for reuse,
+     // and every arc in use must have been listed, or the file is damaged
+     theGraph->M = M;
+     for (e = gp_GetFirstEdge(theGraph); e < gp_GetFirstEdge(theGraph) + numArcs; e += 2)
+     {
+          if (gp_EdgeNotInUse(theGraph, e))
+          {
+              if (gp_EdgeInUse(theGraph, gp_GetTwinArc(theGraph, e)))
+                  return NOTOK;
+              sp_Push(theGraph->edgeHoles, e);
+          }
+          else
+              numInUse += gp_EdgeInUse(theGraph, gp_GetTwinArc(theGraph, e)) ? 2 : 1;
+     }
+
+     if (numInUse != numListed)
+         return NOTOK;
+
+     theGraph->internalFlags = internalFlags;
+     theGraph->embedFlags = embedFlags;
+
+     return OK;
+}
+
+/********************************************************************
+ _ReadEmbeddingInt()
+ ********************************************************************/
+
+static int  _ReadEmbeddingInt(FILE *Infile, int *pValue)
+{
+unsigned char bytes[4];
+
+     if (fread(bytes, 1, 4, Infile) != 4)
+         return NOTOK;
+
+     *pValue = (int) (((unsigned) bytes[0] << 24) | ((unsigned) bytes[1] << 16) |
+                      ((unsigned) bytes[2] << 8) | (unsigned) bytes[3]);
+     return OK;
+}
+
 /********************************************************************
  gp_Read()
  Opens the given file, determines whether it is in adjacency list or
@@ -365,7 +539,13 @@ int  _ReadLEDAGraph(graphP theGraph, FILE *Infile)
  In the adjacency list format, digraphs are supported.  Loop edges are
  ignored without producing an error.
 
- Pass "stdin" for the FileName to read from the stdin stream
+ A file written by gp_Write() with WRITE_EMBEDDING is recognized by its
+ first characters, and the saved embedding is restored without calling
+ gp_Embed() again.
+
+ Pass "stdin" for the FileName to read from the stdin stream.
+ A file whose name ends in .gz or .zst is decompressed as it is read
+ (see compressedFile.h).
 
  Returns: OK, NOTOK on internal error, NONEMBEDDABLE if too many edges
  ********************************************************************/
@@ -378,48 +558,56 @@ int RetVal;
 
      if (strcmp(FileName, "stdin") == 0)
           Infile = stdin;
-     else if ((Infile = fopen(FileName, READTEXT)) == NULL)
+     else if ((Infile = cf_Open(FileName, READTEXT)) == NULL)
           return NOTOK;
 
      Ch = (char) fgetc(Infile);
      ungetc(Ch, Infile);
+
+#ifdef WINDOWS
+     // The embedding format is binary, so the file is reopened untranslated
+     if (Ch == 'P' && Infile != stdin && !cf_IsCompressedName(FileName) &&
+         (Infile = freopen(FileName, READBINARY, Infile)) == NULL)
+          return NOTOK;
+#endif
+
      if (Ch == 'N')
           RetVal = _ReadAdjList(theGraph, Infile, NULL);
      else if (Ch == 'L')
           RetVal = _ReadLEDAGraph(theGraph, Infile);
+     else if (Ch == 'P')
+          RetVal = _ReadEmbedding(theGraph, Infile);
      else RetVal = _ReadAdjMatrix(theGraph, Infile, NULL);
 
+     // The rest of the file, if any, is extra data for the extensions.
+     // It is read to the end rather than measured by seeking, which
+     // a compressed stream or stdin may not support.
      if (RetVal == OK)
      {
-         void *extraData = NULL;
-         long filePos = ftell(Infile);
-         long fileSize;
+         char *extraData = NULL, *newExtraData;
+         long extraDataSize = 0, capacity = 0;
+         size_t numRead;
 
-         fseek(Infile, 0, SEEK_END);
-         fileSize = ftell(Infile);
-         fseek(Infile, filePos, SEEK_SET);
+         do {
+             if (extraDataSize == capacity)
+             {
+                 capacity = capacity == 0 ? 4096 : 2 * capacity;
+                 if ((newExtraData = (char *) realloc(extraData, capacity + 1)) == NULL)
+                 {
+                     RetVal = NOTOK;
+                     break;
+                 }
+                 extraData = newExtraData;
+             }
+             numRead = fread(extraData + extraDataSize, 1, capacity - extraDataSize, Infile);
+             extraDataSize += (long) numRead;
+         } while (numRead > 0);
 
-         if (filePos < fileSize)
-         {
-            extraData = malloc(fileSize - filePos + 1);
-            fread(extraData, fileSize - filePos, 1, Infile);
-         }
-/*// Useful for quick debugging of IO extensibility
-         if (extraData == NULL)
-             printf("extraData == NULL\n");
-         else
-         {
-             char *extraDataString = (char *) extraData;
-             extraDataString[fileSize - filePos] = '\0';
-             printf("extraData = '%s'\n", extraDataString);
-         }
-*/
+         if (RetVal == OK && extraDataSize > 0)
+             RetVal = theGraph->functions.fpReadPostprocess(theGraph, extraData, extraDataSize);
 
          if (extraData != NULL)
-         {
-             RetVal = theGraph->functions.fpReadPostprocess(theGraph, extraData, fileSize - filePos);
-             free((void *) extraData);
-         }
+             free(extraData);
      }
 
      if (strcmp(FileName, "stdin") != 0)
@@ -431,7 +619,8 @@ int RetVal;
 /********************************************************************
  gp_ReadFromString()
  Populates theGraph using the information stored in inputStr.
- Supports adjacency list and adjacency matrix formats, not LEDA.
+ Supports adjacency list and adjacency matrix formats, not LEDA or
+ the binary embedding format.
  Returns NOTOK for any error, or OK otherwise
  ********************************************************************/
 
@@ -453,7 +642,7 @@ int	 gp_ReadFromString(graphP theGraph, char *inputStr)
      Ch = sb_GetReadString(inBuf)[0];
      if (Ch == 'N')
          RetVal = _ReadAdjList(theGraph, NULL, inBuf);
-     else if (Ch == 'L')
+     else if (Ch == 'L' || Ch == 'P')
      {
 		 sb_Free(&inBuf);
 		 return NOTOK;
@@ -761,11 +950,88 @@ int v, e, EsizeOccupied;
      return OK;
 }
 
+/********************************************************************
+ _WriteEmbedding()
+ Writes the vertex and edge records of theGraph in the embedding file
+ format (see _ReadEmbedding()).  The adjacency lists of the vertices
+ must hold all M edges and no edges on virtual vertices, so the graph is
+ written after gp_Embed() has finished, and a graph that _ReadEmbedding()
+ would reject is not written.
+
+ Returns: NOTOK for parameter errors; OK otherwise.
+ ********************************************************************/
+
+int  _WriteEmbedding(graphP theGraph, FILE *Outfile)
+{
+int  v, e, numListed = 0, EsizeOccupied;
+
+     if (theGraph == NULL || Outfile == NULL)
+         return NOTOK;
+
+     EsizeOccupied = gp_EdgeInUseIndexBound(theGraph);
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+     {
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              if (gp_EdgeNotInUse(theGraph, e) || !gp_VertexInRange(theGraph, gp_GetNeighbor(theGraph, e)) ||
+                  ++numListed > 2*theGraph->M)
+                  return NOTOK;
+              e = gp_GetNextArc(theGraph, e);
+          }
+     }
+
+     if (numListed != 2*theGraph->M)
+         return NOTOK;
+
+     fwrite("PEMB", 1, 4, Outfile);
+     _WriteEmbeddingInt(Outfile, EMBEDDING_VERSION);
+     _WriteEmbeddingInt(Outfile, theGraph->N);
+     _WriteEmbeddingInt(Outfile, theGraph->M);
+     _WriteEmbeddingInt(Outfile, EsizeOccupied - gp_GetFirstEdge(theGraph));
+     _WriteEmbeddingInt(Outfile, theGraph->internalFlags);
+     _WriteEmbeddingInt(Outfile, theGraph->embedFlags);
+
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+     {
+          _WriteEmbeddingInt(Outfile, _ArcToFile(theGraph, gp_GetFirstArc(theGraph, v)));
+          _WriteEmbeddingInt(Outfile, _VertexToFile(theGraph, gp_GetVertexIndex(theGraph, v)));
+          _WriteEmbeddingInt(Outfile, (int) theGraph->V[v].flags);
+     }
+
+     for (e = gp_GetFirstEdge(theGraph); e < EsizeOccupied; e++)
+     {
+          _WriteEmbeddingInt(Outfile, _VertexToFile(theGraph, gp_GetNeighbor(theGraph, e)));
+          _WriteEmbeddingInt(Outfile, _ArcToFile(theGraph, gp_GetNextArc(theGraph, e)));
+          _WriteEmbeddingInt(Outfile, (int) theGraph->E[e].flags);
+     }
+
+     return ferror(Outfile) ? NOTOK : OK;
+}
+
+/********************************************************************
+ _WriteEmbeddingInt()
+ ********************************************************************/
+
+static void _WriteEmbeddingInt(FILE *Outfile, int value)
+{
+unsigned u = (unsigned) value;
+
+     putc((int) ((u >> 24) & 0xFF), Outfile);
+     putc((int) ((u >> 16) & 0xFF), Outfile);
+     putc((int) ((u >> 8) & 0xFF), Outfile);
+     putc((int) (u & 0xFF), Outfile);
+}
+
 /********************************************************************
  gp_Write()
  Writes theGraph into the file.
  Pass "stdout" or "stderr" to FileName to write to the corresponding stream
- Pass WRITE_ADJLIST, WRITE_ADJMATRIX or WRITE_DEBUGINFO for the Mode
+ A file whose name ends in .gz or .zst is compressed as it is written
+ Pass WRITE_ADJLIST, WRITE_ADJMATRIX, WRITE_DEBUGINFO or WRITE_EMBEDDING
+ for the Mode.  WRITE_EMBEDDING saves the graph in a binary format that
+ gp_Read() restores exactly, including the adjacency list order, so a
+ graph embedded by gp_Embed() can be reloaded without embedding it again.
 
  NOTE: For digraphs, it is an error to use a mode other than WRITE_ADJLIST
 
@@ -787,7 +1053,7 @@ int RetVal;
           Outfile = stdout;
      else if (strcmp(FileName, "stderr") == 0)
           Outfile = stderr;
-     else if ((Outfile = fopen(FileName, WRITETEXT)) == NULL)
+     else if ((Outfile = cf_Open(FileName, Mode == WRITE_EMBEDDING ? WRITEBINARY : WRITETEXT)) == NULL)
           return NOTOK;
 
      switch (Mode)
@@ -801,6 +1067,9 @@ int RetVal;
          case WRITE_DEBUGINFO :
         	 RetVal = _WriteDebugInfo(theGraph, Outfile);
              break;
+         case WRITE_EMBEDDING :
+        	 RetVal = _WriteEmbedding(theGraph, Outfile);
+             break;
          default :
         	 RetVal = NOTOK;
         	 break;
@@ -839,7 +1108,7 @@ int RetVal;
  * free() when the caller doesn't need the string anymore.
  * The format of the content written into the returned string is based
  * on the Mode parameter: WRITE_ADJLIST or WRITE_ADJMATRIX
- * (the WRITE_DEBUGINFO Mode is not supported at this time)
+ * (the WRITE_DEBUGINFO and binary WRITE_EMBEDDING Modes are not supported)
 
  NOTE: For digraphs, it is an error to use a mode other than WRITE_ADJLIST
 
@@ -909,16 +1178,24 @@ int  _WritePostprocess(graphP theGraph, void **pExtraData, long *pExtraDataSize)
  a string to the file PLANARITY.LOG in the current working directory.
  On first write, the file is created or cleared.
  Call this method with NULL to close the log file.
+ Threads share the log file, but each has its own buffer for the
+ _MakeLogStr functions.
  ********************************************************************/
 
+static FILE *logfile = NULL;
+
 void _Log(char *Str)
 {
-static FILE *logfile = NULL;
+FILE *newLogfile, *oldLogfile;
 
-    if (logfile == NULL)
+    if (logfile == NULL && Str != NULL)
     {
-        if ((logfile = fopen("PLANARITY.LOG", WRITETEXT)) == NULL)
+        if ((newLogfile = fopen("PLANARITY.LOG", WRITETEXT)) == NULL)
         	return;
+
+        // Keep the file opened by another thread if it got there first
+        if (!platform_AtomicCompareAndSwapPointer(&logfile, NULL, newLogfile))
+            fclose(newLogfile);
     }
 
     if (Str != NULL)
@@ -926,8 +1203,9 @@ static FILE *logfile = NULL;
         fprintf(logfile, "%s", Str);
         fflush(logfile);
     }
-    else
-        fclose(logfile);
+    else if ((oldLogfile = logfile) != NULL &&
+             platform_AtomicCompareAndSwapPointer(&logfile, oldLogfile, NULL))
+        fclose(oldLogfile);
 }
 
 void _LogLine(char *Str)
@@ -936,7 +1214,7 @@ void _LogLine(char *Str)
 	_Log("\n");
 }
 
-static char LogStr[512];
+static platform_ThreadLocal char LogStr[512];
 
 char *_MakeLogStr1(char *format, int one)
 {
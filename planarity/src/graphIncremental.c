@@ -0,0 +1,550 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+
+#include "graph.h"
+
+extern void _InitIsolatorContext(graphP theGraph);
+
+/********************************************************************
+ Incremental planarity
+
+ gp_TryAddEdgePlanar() adds an edge to an embedding only if the graph
+ stays planar, and keeps the embedding up to date.  If the endpoints
+ share a face, the edge is inserted into that face.  Otherwise, the
+ biconnected components on the path between the endpoints in the
+ block-cut tree are the only ones that change: with the new edge they
+ become one biconnected component, and the graph stays planar exactly
+ if that component is planar.  Only that component is embedded again,
+ and the rest of the graph is attached back at its cut vertices, since
+ the other components at a cut vertex can go in any face there.
+
+ gp_Embed() relies on the depth first search data that it leaves in
+ the graph matching the edges, so after edges are added or removed, it
+ can only embed the graph again after gp_ClearEmbedState().
+ ********************************************************************/
+
+/* Private functions */
+
+static int  _FindSharedFace(graphP theEmbedding, int u, int v, int *pArcU, int *pArcV);
+static int  _EmbedPathBlocks(graphP theEmbedding, int u, int v, int *pNewArc);
+static int  _EmbedCopy(graphP theEmbedding, int u, int v, int *copyIndex, int numCopied,
+                       int *keptArcs, int numKept, graphP *pCopy, int **pCopyArcs);
+
+// States of the edges at the vertices copied by _EmbedPathBlocks()
+#define INC_OTHERBLOCK  0
+#define INC_KEPT        1
+#define INC_PARALLEL    2
+
+/********************************************************************
+ gp_TryAddEdgePlanar()
+
+ Adds the edge (u,v) to theEmbedding, a planar embedding from
+ gp_Embed(), if the graph stays planar, and updates the embedding.
+ When u and v share a face, this costs a walk around the faces of u;
+ otherwise, it costs time linear in the size of the connected
+ component of u, and an embedding of the biconnected component that
+ the edge closes.
+
+ If addedEdges is not NULL, the arc of the new edge in the adjacency
+ list of u is pushed onto it, so that the edges added since a
+ checkpoint (a size of the stack) can be removed with
+ gp_RollbackAddedEdges().
+
+ Returns OK if the edge was added, NONEMBEDDABLE if the graph would
+ not be planar, in which case nothing changes, and NOTOK on failure,
+ including when the arc capacity or the stack is full.
+ ********************************************************************/
+
+int  gp_TryAddEdgePlanar(graphP theEmbedding, int u, int v, stackP addedEdges)
+{
+int  arcU, arcV, newArc, Result;
+
+     if (theEmbedding == NULL || u == v ||
+         u < gp_GetFirstVertex(theEmbedding) || !gp_VertexInRange(theEmbedding, u) ||
+         v < gp_GetFirstVertex(theEmbedding) || !gp_VertexInRange(theEmbedding, v) ||
+         theEmbedding->embedFlags == 0 ||
+         (theEmbedding->internalFlags & FLAGS_OBSTRUCTIONFOUND) ||
+         theEmbedding->M >= theEmbedding->arcCapacity / 2 ||
+         (addedEdges != NULL && sp_GetCurrentSize(addedEdges) >= sp_GetCapacity(addedEdges)))
+         return NOTOK;
+
+     Result = _FindSharedFace(theEmbedding, u, v, &arcU, &arcV);
+
+     if (Result == OK)
+     {
+         if (gp_InsertEdge(theEmbedding, u, arcU, 0, v, arcV, 0) != OK)
+             return NOTOK;
+
+         newArc = gp_IsArc(arcU) ? gp_GetNextArc(theEmbedding, arcU) : gp_GetFirstArc(theEmbedding, u);
+     }
+     else
+         Result = _EmbedPathBlocks(theEmbedding, u, v, &newArc);
+
+     if (Result == OK && addedEdges != NULL)
+         sp_Push(addedEdges, newArc);
+
+     return Result;
+}
+
+/********************************************************************
+ gp_RollbackAddedEdges()
+
+ Deletes the edges whose arcs were pushed onto addedEdges by
+ gp_TryAddEdgePlanar() after its size was checkpoint, most recent
+ first.  Deleting edges keeps a planar embedding, so the graph can be
+ extended again from the result.
+
+ Returns OK on success, NOTOK on failure.
+ ********************************************************************/
+
+int  gp_RollbackAddedEdges(graphP theEmbedding, stackP addedEdges, int checkpoint)
+{
+int  e;
+
+     if (theEmbedding == NULL || addedEdges == NULL ||
+         checkpoint < 0 || checkpoint > sp_GetCurrentSize(addedEdges))
+         return NOTOK;
+
+     while (sp_GetCurrentSize(addedEdges) > checkpoint)
+     {
+         sp_Pop(addedEdges, e);
+         gp_DeleteEdge(theEmbedding, e, 0);
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ gp_ClearEmbedState()
+
+ Clears what gp_Embed() recorded about theEmbedding besides the
+ adjacency lists, so that it can be embedded again from the current
+ rotation system.  The vertices are first put back in their original
+ order if needed, and edge directions are kept.  The embedFlags become
+ 0, as before the first embedding.
+ ********************************************************************/
+
+void gp_ClearEmbedState(graphP theEmbedding)
+{
+int  v, e;
+
+     if (theEmbedding == NULL || theEmbedding->N <= 0)
+         return;
+
+     if (theEmbedding->internalFlags & FLAGS_SORTEDBYDFI)
+         gp_SortVertices(theEmbedding);
+
+     for (v = gp_GetFirstVertex(theEmbedding); gp_VertexInRange(theEmbedding, v); v++)
+     {
+          gp_SetVertexIndex(theEmbedding, v, NIL);
+          gp_InitVertexFlags(theEmbedding, v);
+          gp_SetVertexParent(theEmbedding, v, NIL);
+          gp_SetVertexLeastAncestor(theEmbedding, v, NIL);
+          gp_SetVertexLowpoint(theEmbedding, v, NIL);
+          gp_SetVertexVisitedInfo(theEmbedding, v, NIL);
+          gp_SetVertexPertinentEdge(theEmbedding, v, NIL);
+          gp_SetVertexPertinentRootsList(theEmbedding, v, NIL);
+          gp_SetVertexFuturePertinentChild(theEmbedding, v, NIL);
+          gp_SetVertexSortedDFSChildList(theEmbedding, v, NIL);
+          gp_SetVertexFwdArcList(theEmbedding, v, NIL);
+          gp_SetExtFaceVertex(theEmbedding, v, 0, NIL);
+          gp_SetExtFaceVertex(theEmbedding, v, 1, NIL);
+     }
+
+     for (v = gp_GetFirstVirtualVertex(theEmbedding); gp_VirtualVertexInRange(theEmbedding, v); v++)
+     {
+          gp_SetFirstArc(theEmbedding, v, NIL);
+          gp_SetLastArc(theEmbedding, v, NIL);
+          gp_SetVertexIndex(theEmbedding, v, NIL);
+          gp_InitVertexFlags(theEmbedding, v);
+          gp_SetExtFaceVertex(theEmbedding, v, 0, NIL);
+          gp_SetExtFaceVertex(theEmbedding, v, 1, NIL);
+     }
+
+     for (e = gp_GetFirstEdge(theEmbedding); e < gp_EdgeInUseIndexBound(theEmbedding); e++)
+          theEmbedding->E[e].flags &= EDGEFLAG_DIRECTION_MASK;
+
+     LCReset(theEmbedding->BicompRootLists);
+     LCReset(theEmbedding->sortedDFSChildLists);
+     _InitIsolatorContext(theEmbedding);
+
+     theEmbedding->internalFlags = theEmbedding->embedFlags = 0;
+}
+
+/********************************************************************
+ _FindSharedFace()
+
+ Walks the faces at u to find one that also contains v.  If found, the
+ new edge goes after *pArcU in the list of u and after *pArcV in the
+ list of v, which are the arcs that end the face at those corners.
+ A vertex without arcs shares a face with every vertex, and its arc is
+ NIL.
+
+ Returns OK if a shared face was found, NONEMBEDDABLE otherwise.
+ ********************************************************************/
+
+static int  _FindSharedFace(graphP theEmbedding, int u, int v, int *pArcU, int *pArcV)
+{
+int  e, a;
+
+     *pArcU = *pArcV = NIL;
+     if (!gp_IsArc(gp_GetFirstArc(theEmbedding, u)) || !gp_IsArc(gp_GetFirstArc(theEmbedding, v)))
+         return OK;
+
+     for (e = gp_GetFirstArc(theEmbedding, u); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+     {
+          a = e;
+          do {
+              if (gp_GetNeighbor(theEmbedding, a) == v)
+              {
+                  *pArcU = gp_GetPrevArcCircular(theEmbedding, e);
+                  *pArcV = gp_GetTwinArc(theEmbedding, a);
+                  return OK;
+              }
+              a = gp_GetNextArcCircular(theEmbedding, gp_GetTwinArc(theEmbedding, a));
+          } while (a != e);
+     }
+
+     return NONEMBEDDABLE;
+}
+
+
+/********************************************************************
+ _EmbedPathBlocks()
+
+ Adds the edge (u,v) when u and v do not share a face.  A depth first
+ search from u gives the biconnected components: a vertex whose
+ lowpoint is not below the dfi of its parent starts a component, and
+ any other vertex is in the component of its parent.  The components
+ on the tree path from v to u are copied with the new edge and
+ embedded by _EmbedCopy().  Parallel edges are left out of the copy,
+ and loops belong to no component.
+
+ The new rotation at each copied vertex x is its rotation in the copy,
+ with the arcs of x that were not copied inserted after its first arc
+ in their old cyclic order.  Those arcs lead to the other components
+ at x, which only meet the copy at x, so they keep a planar embedding
+ in any corner of x.  Each parallel edge then goes next to its copied
+ edge, so that the two bound a face.
+
+ If v is not in the component of u, the two components are joined by
+ the new edge at the first arcs of u and v.
+
+ Returns OK, NONEMBEDDABLE or NOTOK like gp_TryAddEdgePlanar().
+ ********************************************************************/
+
+static int  _EmbedPathBlocks(graphP theEmbedding, int u, int v, int *pNewArc)
+{
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding);
+int  numIds = theEmbedding->arcCapacity / 2;
+int  x, y, w, e, m, h, i, k, id, top, anchor, Result = OK;
+int  numVisited = 0, numCopied = 0, numKept = 0, numParallel = 0, numRun = 0;
+int *dfi = NULL, *low = NULL, *parentArc = NULL, *nextArc = NULL, *block = NULL;
+int *order = NULL, *dfsStack = NULL, *copyIndex = NULL, *copyVertex = NULL;
+int *seen = NULL, *seenArc = NULL, *keptArcs = NULL, *parallelArcs = NULL;
+int *runStart = NULL, *runArcs = NULL, *copyArcs = NULL;
+char *edgeState = NULL, *pathBlock = NULL;
+graphP theCopy = NULL;
+
+     *pNewArc = NIL;
+
+     if ((dfi = (int *) malloc(N * sizeof(int))) == NULL ||
+         (low = (int *) malloc(N * sizeof(int))) == NULL ||
+         (parentArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (nextArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (block = (int *) malloc(N * sizeof(int))) == NULL ||
+         (order = (int *) malloc(N * sizeof(int))) == NULL ||
+         (dfsStack = (int *) malloc(N * sizeof(int))) == NULL ||
+         (copyIndex = (int *) malloc(N * sizeof(int))) == NULL ||
+         (copyVertex = (int *) malloc(N * sizeof(int))) == NULL ||
+         (seen = (int *) malloc(N * sizeof(int))) == NULL ||
+         (seenArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (runStart = (int *) malloc((N + 1) * sizeof(int))) == NULL ||
+         (keptArcs = (int *) malloc(numIds * sizeof(int))) == NULL ||
+         (parallelArcs = (int *) malloc(2 * numIds * sizeof(int))) == NULL ||
+         (runArcs = (int *) malloc(2 * numIds * sizeof(int))) == NULL ||
+         (edgeState = (char *) calloc(numIds, sizeof(char))) == NULL ||
+         (pathBlock = (char *) calloc(N, sizeof(char))) == NULL)
+         Result = NOTOK;
+
+     // Depth first search from u for the dfi and lowpoint of each vertex
+     // in the component of u.  Only the arc to the parent is skipped, so
+     // that a parallel edge to the parent counts as a back edge.
+     if (Result == OK)
+     {
+         for (w = 0; w < N; w++)
+              dfi[w] = copyIndex[w] = seen[w] = -1;
+
+         dfi[u - first] = low[u - first] = 0;
+         parentArc[u - first] = NIL;
+         nextArc[u - first] = gp_GetFirstArc(theEmbedding, u);
+         order[numVisited++] = dfsStack[0] = u;
+         top = 1;
+
+         while (top > 0)
+         {
+              x = dfsStack[top-1];
+              e = nextArc[x - first];
+
+              if (gp_IsArc(e))
+              {
+                  nextArc[x - first] = gp_GetNextArc(theEmbedding, e);
+                  y = gp_GetNeighbor(theEmbedding, e);
+
+                  if (dfi[y - first] < 0)
+                  {
+                      dfi[y - first] = low[y - first] = numVisited;
+                      parentArc[y - first] = e;
+                      nextArc[y - first] = gp_GetFirstArc(theEmbedding, y);
+                      order[numVisited++] = dfsStack[top++] = y;
+                  }
+                  else if ((x == u || e != gp_GetTwinArc(theEmbedding, parentArc[x - first])) &&
+                           dfi[y - first] < low[x - first])
+                      low[x - first] = dfi[y - first];
+              }
+              else if (--top > 0)
+              {
+                  y = dfsStack[top-1];
+                  if (low[x - first] < low[y - first])
+                      low[y - first] = low[x - first];
+              }
+         }
+
+         // If v was not reached, any corners of u and v will do
+         if (dfi[v - first] < 0)
+         {
+             Result = gp_InsertEdge(theEmbedding, u, NIL, 0, v, NIL, 0);
+             if (Result == OK)
+                 *pNewArc = gp_GetFirstArc(theEmbedding, u);
+             numVisited = 0;
+         }
+     }
+
+     if (Result == OK && numVisited > 0)
+     {
+         // Each vertex gets the first vertex of its component in the
+         // preorder, whose parent is the cut vertex above the component
+         block[u - first] = u;
+         for (i = 1; i < numVisited; i++)
+         {
+              w = order[i];
+              y = gp_GetNeighbor(theEmbedding, gp_GetTwinArc(theEmbedding, parentArc[w - first]));
+              block[w - first] = low[w - first] >= dfi[y - first] ? w : block[y - first];
+         }
+
+         for (y = v; y != u; y = gp_GetNeighbor(theEmbedding, gp_GetTwinArc(theEmbedding, parentArc[y - first])))
+              pathBlock[block[y - first] - first] = 1;
+
+         for (i = 0; i < numVisited; i++)
+         {
+              w = order[i];
+              if (w == u || pathBlock[block[w - first] - first])
+              {
+                  copyIndex[w - first] = numCopied;
+                  copyVertex[numCopied++] = w;
+              }
+         }
+
+         // An edge between copied vertices is in a copied component.  The
+         // first of a group of parallel edges is kept, from whichever
+         // endpoint is reached first.
+         for (i = 0; i < numCopied; i++)
+         {
+              x = copyVertex[i];
+              for (e = gp_GetFirstArc(theEmbedding, x); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+              {
+                   y = gp_GetNeighbor(theEmbedding, e);
+                   id = (e - gp_GetFirstEdge(theEmbedding)) >> 1;
+                   if (y == x || copyIndex[y - first] < 0 || edgeState[id] != INC_OTHERBLOCK)
+                       continue;
+
+                   if (seen[y - first] == x)
+                   {
+                       edgeState[id] = INC_PARALLEL;
+                       parallelArcs[2*numParallel] = e;
+                       parallelArcs[2*numParallel+1] = seenArc[y - first];
+                       numParallel++;
+                   }
+                   else
+                   {
+                       edgeState[id] = INC_KEPT;
+                       seen[y - first] = x;
+                       seenArc[y - first] = e;
+                       keptArcs[numKept++] = e;
+                   }
+              }
+         }
+
+         // The arcs that were not copied, in cyclic order from an arc
+         // that was
+         for (i = 0; i < numCopied; i++)
+         {
+              x = copyVertex[i];
+              runStart[i] = numRun;
+
+              for (m = gp_GetFirstArc(theEmbedding, x); gp_IsArc(m); m = gp_GetNextArc(theEmbedding, m))
+                   if (edgeState[(m - gp_GetFirstEdge(theEmbedding)) >> 1] != INC_OTHERBLOCK)
+                       break;
+
+              e = gp_IsArc(m) ? gp_GetNextArcCircular(theEmbedding, m) : gp_GetFirstArc(theEmbedding, x);
+              while (gp_IsArc(e) && e != m)
+              {
+                   if (edgeState[(e - gp_GetFirstEdge(theEmbedding)) >> 1] == INC_OTHERBLOCK)
+                       runArcs[numRun++] = e;
+                   e = gp_IsArc(m) ? gp_GetNextArcCircular(theEmbedding, e) : gp_GetNextArc(theEmbedding, e);
+              }
+         }
+         runStart[numCopied] = numRun;
+
+         Result = _EmbedCopy(theEmbedding, u, v, copyIndex, numCopied, keptArcs, numKept, &theCopy, &copyArcs);
+     }
+
+     // The edge is added, and each copied vertex gets its new rotation
+     if (Result == OK && theCopy != NULL)
+     {
+         Result = gp_InsertEdge(theEmbedding, u, NIL, 0, v, NIL, 0);
+         if (Result == OK)
+         {
+             *pNewArc = gp_GetFirstArc(theEmbedding, u);
+             h = gp_GetFirstEdge(theCopy) + 2*numKept;
+             if (gp_GetNeighbor(theCopy, h) != copyIndex[v - first] + first)
+                 h = gp_GetTwinArc(theCopy, h);
+             copyArcs[h] = *pNewArc;
+             copyArcs[gp_GetTwinArc(theCopy, h)] = gp_GetTwinArc(theEmbedding, *pNewArc);
+
+             for (i = 0; i < numCopied; i++)
+             {
+                  x = copyVertex[i];
+                  gp_SetFirstArc(theEmbedding, x, NIL);
+                  gp_SetLastArc(theEmbedding, x, NIL);
+
+                  for (h = gp_GetFirstArc(theCopy, i + first); gp_IsArc(h); h = gp_GetNextArc(theCopy, h))
+                       gp_AttachArc(theEmbedding, x, NIL, 1, copyArcs[h]);
+
+                  anchor = gp_GetFirstArc(theEmbedding, x);
+                  for (k = runStart[i]; k < runStart[i+1]; k++)
+                  {
+                       gp_AttachArc(theEmbedding, x, anchor, 0, runArcs[k]);
+                       anchor = runArcs[k];
+                  }
+             }
+
+             for (k = 0; k < numParallel; k++)
+             {
+                  e = parallelArcs[2*k];
+                  m = parallelArcs[2*k+1];
+                  gp_AttachArc(theEmbedding, gp_GetNeighbor(theEmbedding, gp_GetTwinArc(theEmbedding, e)), m, 0, e);
+                  gp_AttachArc(theEmbedding, gp_GetNeighbor(theEmbedding, e), gp_GetTwinArc(theEmbedding, m), 1,
+                               gp_GetTwinArc(theEmbedding, e));
+             }
+         }
+     }
+
+     gp_Free(&theCopy);
+     free(dfi);
+     free(low);
+     free(parentArc);
+     free(nextArc);
+     free(block);
+     free(order);
+     free(dfsStack);
+     free(copyIndex);
+     free(copyVertex);
+     free(seen);
+     free(seenArc);
+     free(runStart);
+     free(keptArcs);
+     free(parallelArcs);
+     free(runArcs);
+     free(copyArcs);
+     free(edgeState);
+     free(pathBlock);
+
+     return Result;
+}
+
+/********************************************************************
+ _EmbedCopy()
+
+ Makes a graph whose vertex i+1 is the vertex whose copyIndex is i,
+ with a copy of each of the numKept arcs in keptArcs followed by the
+ edge (u,v), and embeds it.  If it is planar, *pCopy receives the
+ embedding, with its vertices in their original order, and *pCopyArcs
+ receives an array that gives the arc of theEmbedding for each arc of
+ the copy.  The arcs of the new edge are left for the caller to fill.
+
+ Returns OK if the copy is planar, NONEMBEDDABLE if it is not, and
+ NOTOK on failure.  *pCopy is NULL unless the result is OK.
+ ********************************************************************/
+
+static int  _EmbedCopy(graphP theEmbedding, int u, int v, int *copyIndex, int numCopied,
+                       int *keptArcs, int numKept, graphP *pCopy, int **pCopyArcs)
+{
+int  first = gp_GetFirstVertex(theEmbedding), numArcs = 2 * (numKept + 1);
+int  k, e, h, cx, cy, Result = OK;
+int *copyArcs = NULL;
+graphP theCopy = NULL;
+
+     *pCopy = NULL;
+     *pCopyArcs = NULL;
+
+     if ((theCopy = gp_New()) == NULL ||
+         (numArcs > 2*DEFAULT_EDGE_LIMIT*numCopied && gp_EnsureArcCapacity(theCopy, numArcs) != OK) ||
+         gp_InitGraph(theCopy, numCopied) != OK ||
+         (copyArcs = (int *) malloc((gp_GetFirstEdge(theCopy) + numArcs) * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     for (k = 0; k <= numKept && Result == OK; k++)
+     {
+          if (k < numKept)
+          {
+              e = keptArcs[k];
+              cx = copyIndex[gp_GetNeighbor(theEmbedding, gp_GetTwinArc(theEmbedding, e)) - first] + first;
+              cy = copyIndex[gp_GetNeighbor(theEmbedding, e) - first] + first;
+          }
+          else
+          {
+              e = NIL;
+              cx = copyIndex[u - first] + first;
+              cy = copyIndex[v - first] + first;
+          }
+
+          if ((Result = gp_AddEdge(theCopy, cx, 0, cy, 0)) == OK)
+          {
+              h = gp_GetFirstArc(theCopy, cx);
+              copyArcs[h] = e;
+              copyArcs[gp_GetTwinArc(theCopy, h)] = gp_IsArc(e) ? gp_GetTwinArc(theEmbedding, e) : NIL;
+          }
+     }
+
+     if (Result == OK)
+     {
+         Result = gp_Embed(theCopy, EMBEDFLAGS_PLANAR);
+         if (Result == OK)
+             Result = gp_SortVertices(theCopy);
+     }
+
+     // The embedding keeps each edge in its place, so the arcs of the
+     // copy still lead to the copies of the same vertices
+     for (h = gp_GetFirstEdge(theCopy); h < gp_GetFirstEdge(theCopy) + 2*numKept && Result == OK; h++)
+          if (gp_GetNeighbor(theCopy, h) != copyIndex[gp_GetNeighbor(theEmbedding, copyArcs[h]) - first] + first)
+              Result = NOTOK;
+
+     if (Result == OK)
+     {
+         *pCopy = theCopy;
+         *pCopyArcs = copyArcs;
+     }
+     else
+     {
+         gp_Free(&theCopy);
+         free(copyArcs);
+     }
+
+     return Result;
+}
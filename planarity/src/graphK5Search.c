@@ -0,0 +1,650 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "graphK5Search.private.h"
+#include "graphK5Search.h"
+
+extern int  _IsolateKuratowskiSubgraph(graphP theGraph, int v, int R);
+extern int  _getImageVertices(graphP theGraph, int *degrees, int maxDegree,
+                              int *imageVerts, int maxNumImageVerts);
+
+/********************************************************************
+ K5 homeomorph search
+
+ With EMBEDFLAGS_SEARCHFORK5, the first blocked bicomp makes the core
+ isolator reduce the graph to a subgraph homeomorphic to K5 or K3,3,
+ as it does for EMBEDFLAGS_PLANAR.  A K5 homeomorph is the answer.  A
+ K3,3 homeomorph does not rule out a K5 homeomorph elsewhere, so the
+ search continues on the edges the graph had before the embedder ran.
+
+ A K5 homeomorph lies in one biconnected component, and no more than
+ one of its paths can pass through the far side of a separation pair,
+ so the homeomorph can be moved into one rigid triconnected component
+ by replacing such a path with the virtual edge of the separation pair.
+ Hence the graph has a K5 homeomorph if and only if the skeleton graph
+ of some rigid triconnected component has one.  Each rigid skeleton of
+ at least ten edges is run through the core planarity algorithm, and
+ the first one whose obstruction is a K5 homeomorph is expanded back
+ into the graph: each virtual edge in the obstruction is replaced by a
+ path through the triconnected component on its other side, which
+ avoids the virtual edge, and the virtual edges on that path are
+ expanded in turn.  Each component is entered at most once because the
+ components form a tree, so the whole search takes O(N+M) time.
+
+ The search is complete for skeletons that are K5 themselves and for
+ skeletons with no K3,3 homeomorph, since then the obstruction must
+ be a K5.  A skeleton that has both is only reported as a K5 if the
+ planarity algorithm happens to isolate the K5, because finding a K5
+ homeomorph among K3,3 homeomorphs is not known to be possible in
+ linear time.  When no K5 is found, the K3,3 homeomorph stays in the
+ graph and gp_FoundK5Homeomorph() returns FALSE.
+ ********************************************************************/
+
+// The hunt through the biconnected components of the original edges
+typedef struct
+{
+     // The edges, as pairs of zero-based vertices
+     int  N, M, *edges;
+
+     // The number of each vertex in the current block, or -1
+     int *localOf;
+
+     // The edges of the K5 homeomorph, as indices into edges
+     int *k5Edges, numK5Edges;
+} k5_Hunt;
+
+// The triconnected components of one biconnected component
+typedef struct
+{
+     int  n, M, numComps;
+
+     // The hunt vertex of each block vertex, and the hunt edge of each
+     // edge in gp_GetEdgeArray() order
+     int *verts, *huntEdge;
+
+     // The block vertices joined by each real and virtual edge
+     int *ends;
+
+     // The components, as listed by gp_GetTriconnectedComponents(), and
+     // the two components that share each virtual edge
+     int *compTypes, *compOffsets, *compEdges, *virtualEdges, *virtualComps;
+
+     // The adjacency lists of a component, built when a path is needed
+     // through it, and the breadth first search of the path
+     int *head, *headStamp, *nodeNext, *seen, *parentNode, *queue;
+
+     // The skeleton numbering of the block vertices, the edges of a K5
+     // homeomorph found in a skeleton, and the virtual edges to expand
+     int *skelOf, *kept, *work;
+} k5_Block;
+
+/* Private functions */
+
+static int  _FindK5InBlocks(k5_Hunt *h);
+static int  _FindK5InBlock(k5_Hunt *h, int *block, int M);
+static int  _InitBlock(k5_Block *b, int M);
+static int  _TestSkeletonForK5(k5_Block *b, int c, int *pNumKept);
+static int  _ExpandK5(k5_Hunt *h, k5_Block *b, int c, int numKept);
+static int  _FindComponentPath(k5_Block *b, int T, int x);
+
+/********************************************************************
+ _K5Search_IsolateObstruction()
+
+ The core handler of a blocked bicomp only isolates an obstruction when
+ the embed flags are exactly EMBEDFLAGS_PLANAR, so the K5 search does
+ the same isolation here.
+ ********************************************************************/
+
+int  _K5Search_IsolateObstruction(graphP theGraph, int v, int RootVertex, int R)
+{
+     if (R != RootVertex)
+         sp_Push2(theGraph->theStack, R, 0);
+
+     if (_IsolateKuratowskiSubgraph(theGraph, v, RootVertex) != OK)
+         return NOTOK;
+
+     return NONEMBEDDABLE;
+}
+
+/********************************************************************
+ _K5Search_FindK5()
+
+ Called once the obstruction is isolated.  If it is not a K5 homeomorph,
+ the edges of theGraph are replaced by a K5 homeomorph found among the
+ original edges, if any.  theGraph is still sorted by DFI, so the edges
+ are added between the DFI positions of their endpoints, and
+ gp_SortVertices() then restores the original numbering as usual.
+
+ Returns OK, with context->foundK5 telling whether a K5 homeomorph is
+ in theGraph, or NOTOK on error.
+ ********************************************************************/
+
+int  _K5Search_FindK5(graphP theGraph, K5SearchContext *context)
+{
+k5_Hunt hunt, *h = &hunt;
+int  degrees[5], imageVerts[6];
+int  *pos, v, e, k, first, EsizeOccupied, RetVal;
+
+     context->foundK5 = FALSE;
+
+     if (_getImageVertices(theGraph, degrees, 4, imageVerts, 6) == OK && degrees[4] == 5)
+     {
+         context->foundK5 = TRUE;
+         return OK;
+     }
+
+     h->N = theGraph->N;
+     h->M = context->numOrigEdges;
+     h->edges = context->origEdges;
+     h->numK5Edges = 0;
+     h->localOf = (int *) malloc(h->N*sizeof(int));
+     h->k5Edges = (int *) malloc((h->M + 1)*sizeof(int));
+     pos = (int *) malloc(h->N*sizeof(int));
+     if (h->localOf == NULL || h->k5Edges == NULL || pos == NULL)
+     {
+         free(h->localOf);
+         free(h->k5Edges);
+         free(pos);
+         return NOTOK;
+     }
+
+     for (v = 0; v < h->N; v++)
+          h->localOf[v] = -1;
+
+     RetVal = _FindK5InBlocks(h);
+
+     if (RetVal == OK && h->numK5Edges > 0)
+     {
+         first = gp_GetFirstVertex(theGraph);
+         for (v = first; gp_VertexInRange(theGraph, v); v++)
+              pos[gp_GetVertexIndex(theGraph, v) - first] = v;
+
+         EsizeOccupied = gp_EdgeInUseIndexBound(theGraph);
+         for (e = gp_GetFirstEdge(theGraph); e < EsizeOccupied; e += 2)
+         {
+              if (gp_EdgeInUse(theGraph, e))
+                  gp_DeleteEdge(theGraph, e, 0);
+         }
+
+         for (k = 0; k < h->numK5Edges && RetVal == OK; k++)
+         {
+              e = h->k5Edges[k];
+              if (gp_AddEdge(theGraph, pos[h->edges[2*e]], 0, pos[h->edges[2*e+1]], 0) != OK)
+                  RetVal = NOTOK;
+         }
+
+         context->foundK5 = RetVal == OK;
+     }
+
+     free(h->localOf);
+     free(h->k5Edges);
+     free(pos);
+     return RetVal;
+}
+
+/********************************************************************
+ _FindK5InBlocks()
+
+ Splits the edges into biconnected components with an iterative depth
+ first search that stacks the edges, and searches each component of at
+ least ten edges until a K5 homeomorph is found.
+ ********************************************************************/
+
+static int  _FindK5InBlocks(k5_Hunt *h)
+{
+int  N = h->N, M = h->M, *edges = h->edges;
+int  *adjStart, *adjEdge, *disc, *low, *parentEdge, *next, *vStack, *eStack;
+int  r, v, w, p, e, k, t = 0, vTop, eTop = 0, numBlock, RetVal = OK;
+
+     adjStart = (int *) calloc(6*N + 1 + 3*M, sizeof(int));
+     if (adjStart == NULL)
+         return NOTOK;
+
+     disc = adjStart + N + 1;
+     low = disc + N;
+     parentEdge = low + N;
+     next = parentEdge + N;
+     vStack = next + N;
+     eStack = vStack + N;
+     adjEdge = eStack + M;
+
+     // The arcs out of each vertex, by counting sort
+     for (e = 0; e < M; e++)
+     {
+          adjStart[edges[2*e] + 1]++;
+          adjStart[edges[2*e+1] + 1]++;
+     }
+     for (v = 0; v < N; v++)
+     {
+          adjStart[v+1] += adjStart[v];
+          next[v] = adjStart[v];
+          disc[v] = -1;
+     }
+     for (e = 0; e < M; e++)
+     {
+          adjEdge[next[edges[2*e]]++] = e;
+          adjEdge[next[edges[2*e+1]]++] = e;
+     }
+     for (v = 0; v < N; v++)
+          next[v] = adjStart[v];
+
+     for (r = 0; r < N && RetVal == OK && h->numK5Edges == 0; r++)
+     {
+          if (disc[r] != -1)
+              continue;
+
+          disc[r] = low[r] = t++;
+          parentEdge[r] = -1;
+          vTop = 0;
+          vStack[vTop++] = r;
+
+          while (vTop > 0)
+          {
+              v = vStack[vTop-1];
+              if (next[v] < adjStart[v+1])
+              {
+                  e = adjEdge[next[v]++];
+                  if (e == parentEdge[v])
+                      continue;
+
+                  w = edges[2*e] == v ? edges[2*e+1] : edges[2*e];
+                  if (disc[w] == -1)
+                  {
+                      eStack[eTop++] = e;
+                      parentEdge[w] = e;
+                      disc[w] = low[w] = t++;
+                      vStack[vTop++] = w;
+                  }
+                  // A back edge to an ancestor; the descendant end
+                  // already stacked the edges to its descendants
+                  else if (disc[w] < disc[v])
+                  {
+                      eStack[eTop++] = e;
+                      if (disc[w] < low[v])
+                          low[v] = disc[w];
+                  }
+                  continue;
+              }
+
+              vTop--;
+              if (parentEdge[v] == -1)
+                  continue;
+
+              p = vStack[vTop-1];
+              if (low[v] < low[p])
+                  low[p] = low[v];
+
+              // The edges stacked since the tree edge into v form a block
+              if (low[v] >= disc[p])
+              {
+                  numBlock = 0;
+                  do {
+                      k = eStack[--eTop];
+                      numBlock++;
+                  } while (k != parentEdge[v]);
+
+                  if (numBlock >= 10)
+                  {
+                      RetVal = _FindK5InBlock(h, eStack + eTop, numBlock);
+                      if (RetVal != OK || h->numK5Edges > 0)
+                          break;
+                  }
+              }
+          }
+     }
+
+     free(adjStart);
+     return RetVal;
+}
+
+/********************************************************************
+ _FindK5InBlock()
+
+ Decomposes the block given by the M hunt edges in block into its
+ triconnected components, and tests the rigid ones for a K5 homeomorph.
+ ********************************************************************/
+
+static int  _FindK5InBlock(k5_Hunt *h, int *block, int M)
+{
+k5_Block blockContext, *b = &blockContext;
+graphP B = NULL;
+int  k, s, u, v, w, e, c, t, j, first, numKept, RetVal = OK;
+
+     if (_InitBlock(b, M) != OK)
+         return NOTOK;
+
+     // Number the vertices of the block
+     b->n = 0;
+     for (k = 0; k < M; k++)
+     {
+          for (s = 0; s < 2; s++)
+          {
+              u = h->edges[2*block[k]+s];
+              if (h->localOf[u] == -1)
+              {
+                  h->localOf[u] = b->n;
+                  b->verts[b->n++] = u;
+              }
+          }
+     }
+
+     // Make a graph of the block, in which edge k is the k-th edge record
+     if ((B = gp_New()) == NULL ||
+         gp_EnsureArcCapacity(B, 2*M) != OK ||
+         gp_InitGraph(B, b->n) != OK)
+         RetVal = NOTOK;
+
+     first = RetVal == OK ? gp_GetFirstVertex(B) : 0;
+     for (k = 0; k < M && RetVal == OK; k++)
+     {
+          u = h->localOf[h->edges[2*block[k]]];
+          w = h->localOf[h->edges[2*block[k]+1]];
+          if (gp_AddEdge(B, first + u, 0, first + w, 0) != OK)
+              RetVal = NOTOK;
+     }
+
+     // Match the edges to the order of gp_GetEdgeArray(), which is the
+     // order gp_GetTriconnectedComponents() uses
+     if (RetVal == OK)
+     {
+         t = 0;
+         for (v = first; gp_VertexInRange(B, v); v++)
+         {
+              e = gp_GetFirstArc(B, v);
+              while (gp_IsArc(e))
+              {
+                  w = gp_GetNeighbor(B, e);
+                  if (w > v)
+                  {
+                      b->huntEdge[t] = block[(e - gp_GetFirstEdge(B)) >> 1];
+                      b->ends[2*t] = v - first;
+                      b->ends[2*t+1] = w - first;
+                      t++;
+                  }
+                  e = gp_GetNextArc(B, e);
+              }
+         }
+
+         b->numComps = gp_GetTriconnectedComponents(B, b->compTypes, b->compOffsets,
+                                                    b->compEdges, b->virtualEdges);
+         if (b->numComps < 1)
+             RetVal = NOTOK;
+     }
+
+     gp_Free(&B);
+
+     if (RetVal == OK)
+     {
+         for (j = 0; j < b->numComps - 1; j++)
+         {
+              b->ends[2*(M+j)] = b->virtualEdges[2*j];
+              b->ends[2*(M+j)+1] = b->virtualEdges[2*j+1];
+              b->virtualComps[2*j] = b->virtualComps[2*j+1] = -1;
+         }
+         for (c = 0; c < b->numComps; c++)
+         {
+              for (k = b->compOffsets[c]; k < b->compOffsets[c+1]; k++)
+              {
+                  if ((j = b->compEdges[k] - M) >= 0)
+                      b->virtualComps[2*j + (b->virtualComps[2*j] != -1)] = c;
+              }
+         }
+         for (v = 0; v < b->n; v++)
+              b->skelOf[v] = b->headStamp[v] = b->seen[v] = -1;
+
+         for (c = 0; c < b->numComps && RetVal == OK; c++)
+         {
+              if (b->compTypes[c] != TRICOMP_RIGID || b->compOffsets[c+1] - b->compOffsets[c] < 10)
+                  continue;
+
+              if ((RetVal = _TestSkeletonForK5(b, c, &numKept)) == OK && numKept > 0)
+              {
+                  RetVal = _ExpandK5(h, b, c, numKept);
+                  break;
+              }
+         }
+     }
+
+     for (v = 0; v < b->n; v++)
+          h->localOf[b->verts[v]] = -1;
+
+     free(b->verts);
+     return RetVal;
+}
+
+/********************************************************************
+ _InitBlock()
+ Allocates the arrays of the block context in one block, which is freed
+ with b->verts.  A block of M edges has at most M+1 vertices, and there
+ are fewer virtual edges than edges.
+ ********************************************************************/
+
+static int  _InitBlock(k5_Block *b, int M)
+{
+int  n = M + 1;
+
+     b->M = M;
+     b->verts = (int *) malloc((6*n + 28*M + 1)*sizeof(int));
+     if (b->verts == NULL)
+         return NOTOK;
+
+     b->huntEdge = b->verts + n;
+     b->ends = b->huntEdge + M;
+     b->compTypes = b->ends + 4*M;
+     b->compOffsets = b->compTypes + M;
+     b->compEdges = b->compOffsets + M + 1;
+     b->virtualEdges = b->compEdges + 3*M;
+     b->virtualComps = b->virtualEdges + 2*M;
+     b->nodeNext = b->virtualComps + 2*M;
+     b->kept = b->nodeNext + 6*M;
+     b->work = b->kept + 3*M;
+     b->head = b->work + 4*M;
+     b->headStamp = b->head + n;
+     b->seen = b->headStamp + n;
+     b->parentNode = b->seen + n;
+     b->queue = b->parentNode + n;
+     b->skelOf = b->queue + n;
+
+     return OK;
+}
+
+/********************************************************************
+ _TestSkeletonForK5()
+
+ Runs the core planarity algorithm on the skeleton of the rigid
+ component c.  If the obstruction it isolates is a K5 homeomorph, its
+ real and virtual edges are stored in b->kept and their number in
+ *pNumKept, which is otherwise zero.
+
+ Returns OK, or NOTOK on error.
+ ********************************************************************/
+
+static int  _TestSkeletonForK5(k5_Block *b, int c, int *pNumKept)
+{
+graphP S = NULL;
+int  start = b->compOffsets[c], size = b->compOffsets[c+1] - start;
+int  *degree = NULL, k, s, x, u, ns = 0, first, numDegree4 = 0, RetVal = OK;
+
+     *pNumKept = 0;
+
+     for (k = 0; k < size; k++)
+     {
+          x = b->compEdges[start+k];
+          for (s = 0; s < 2; s++)
+          {
+              u = b->ends[2*x+s];
+              if (b->skelOf[u] == -1)
+                  b->skelOf[u] = ns++;
+          }
+     }
+
+     if ((degree = (int *) calloc(ns, sizeof(int))) == NULL ||
+         (S = gp_New()) == NULL ||
+         gp_EnsureArcCapacity(S, 2*size) != OK ||
+         gp_InitGraph(S, ns) != OK)
+         RetVal = NOTOK;
+
+     first = RetVal == OK ? gp_GetFirstVertex(S) : 0;
+     for (k = 0; k < size && RetVal == OK; k++)
+     {
+          x = b->compEdges[start+k];
+          if (gp_AddEdge(S, first + b->skelOf[b->ends[2*x]], 0,
+                            first + b->skelOf[b->ends[2*x+1]], 0) != OK)
+              RetVal = NOTOK;
+     }
+
+     if (RetVal == OK)
+     {
+         s = gp_Embed(S, EMBEDFLAGS_PLANAR);
+         if (s == NOTOK)
+             RetVal = NOTOK;
+
+         // The edge records of the skeleton edges kept by the isolator are
+         // still in use, and a K5 homeomorph has five vertices of degree 4
+         else if (s == NONEMBEDDABLE)
+         {
+             for (k = 0; k < size; k++)
+             {
+                  if (gp_EdgeInUse(S, gp_GetFirstEdge(S) + 2*k))
+                  {
+                      x = b->compEdges[start+k];
+                      b->kept[(*pNumKept)++] = x;
+                      if (++degree[b->skelOf[b->ends[2*x]]] == 4)
+                          numDegree4++;
+                      if (++degree[b->skelOf[b->ends[2*x+1]]] == 4)
+                          numDegree4++;
+                  }
+             }
+             if (numDegree4 != 5)
+                 *pNumKept = 0;
+         }
+     }
+
+     for (k = 0; k < size; k++)
+     {
+          x = b->compEdges[start+k];
+          b->skelOf[b->ends[2*x]] = b->skelOf[b->ends[2*x+1]] = -1;
+     }
+
+     gp_Free(&S);
+     free(degree);
+     return RetVal;
+}
+
+/********************************************************************
+ _ExpandK5()
+
+ Adds to the hunt the real edges of the K5 homeomorph found in the
+ skeleton of component c, and replaces each of its virtual edges by a
+ path through the component on the other side of the virtual edge.
+ The virtual edges on such a path are expanded the same way, moving
+ ever farther from c in the tree of components.
+ ********************************************************************/
+
+static int  _ExpandK5(k5_Hunt *h, k5_Block *b, int c, int numKept)
+{
+int  k, x, j, T, u, q, top = 0;
+
+     for (k = 0; k < numKept; k++)
+     {
+          x = b->kept[k];
+          if (x < b->M)
+              h->k5Edges[h->numK5Edges++] = b->huntEdge[x];
+          else
+          {
+              b->work[top++] = x - b->M;
+              b->work[top++] = c;
+          }
+     }
+
+     while (top > 0)
+     {
+          T = b->work[--top];
+          j = b->work[--top];
+          T = b->virtualComps[2*j] == T ? b->virtualComps[2*j+1] : b->virtualComps[2*j];
+          x = b->M + j;
+
+          if (_FindComponentPath(b, T, x) != OK)
+              return NOTOK;
+
+          // Walk the path back from the second endpoint to the first
+          u = b->ends[2*x+1];
+          while (u != b->ends[2*x])
+          {
+              q = b->parentNode[u];
+              k = b->compEdges[q >> 1];
+              if (k < b->M)
+                  h->k5Edges[h->numK5Edges++] = b->huntEdge[k];
+              else
+              {
+                  b->work[top++] = k - b->M;
+                  b->work[top++] = T;
+              }
+              u = b->ends[2*k + (q & 1)];
+          }
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _FindComponentPath()
+
+ Builds the adjacency lists of component T, in which the nodes 2p and
+ 2p+1 are the two ends of the p-th entry of compEdges, and searches
+ breadth first for a path between the endpoints of its virtual edge x
+ that does not use x.  The path is left in parentNode.
+
+ Returns OK, or NOTOK if there is no such path.
+ ********************************************************************/
+
+static int  _FindComponentPath(k5_Block *b, int T, int x)
+{
+int  p, s, y, u, w, q, qHead = 0, qTail = 0;
+int  a = b->ends[2*x], z = b->ends[2*x+1];
+
+     for (p = b->compOffsets[T]; p < b->compOffsets[T+1]; p++)
+     {
+          y = b->compEdges[p];
+          for (s = 0; s < 2; s++)
+          {
+              u = b->ends[2*y+s];
+              if (b->headStamp[u] != T)
+              {
+                  b->headStamp[u] = T;
+                  b->head[u] = -1;
+              }
+              b->nodeNext[2*p+s] = b->head[u];
+              b->head[u] = 2*p+s;
+          }
+     }
+
+     b->seen[a] = T;
+     b->queue[qTail++] = a;
+     while (qHead < qTail && b->seen[z] != T)
+     {
+          u = b->queue[qHead++];
+          for (q = b->head[u]; q != -1; q = b->nodeNext[q])
+          {
+              y = b->compEdges[q >> 1];
+              if (y == x)
+                  continue;
+
+              w = b->ends[2*y + 1 - (q & 1)];
+              if (b->seen[w] != T)
+              {
+                  b->seen[w] = T;
+                  b->parentNode[w] = q;
+                  b->queue[qTail++] = w;
+              }
+          }
+     }
+
+     return b->seen[z] == T ? OK : NOTOK;
+}
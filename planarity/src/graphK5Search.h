@@ -0,0 +1,27 @@
+#ifndef GRAPH_K5SEARCH_H
+#define GRAPH_K5SEARCH_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graphStructures.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define K5SEARCH_NAME "K5Search"
+
+int gp_AttachK5Search(graphP theGraph);
+int gp_DetachK5Search(graphP theGraph);
+
+int gp_FoundK5Homeomorph(graphP theGraph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
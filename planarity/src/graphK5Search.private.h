@@ -0,0 +1,36 @@
+#ifndef GRAPH_K5SEARCH_PRIVATE_H
+#define GRAPH_K5SEARCH_PRIVATE_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    // The edges of the graph as gp_Embed() received it, as pairs of
+    // zero-based vertices, and the number of edges and the capacity in edges
+    int *origEdges;
+    int numOrigEdges, origEdgeCapacity;
+
+    // Whether the obstruction isolated by the last gp_Embed() is a K5
+    // homeomorph
+    int foundK5;
+
+    // Overloaded function pointers
+    graphFunctionTable functions;
+
+} K5SearchContext;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
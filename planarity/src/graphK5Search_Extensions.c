@@ -0,0 +1,275 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+
+#include "graphK5Search.private.h"
+#include "graphK5Search.h"
+
+extern int  _K5Search_IsolateObstruction(graphP theGraph, int v, int RootVertex, int R);
+extern int  _K5Search_FindK5(graphP theGraph, K5SearchContext *context);
+
+extern int  _TestSubgraph(graphP theSubgraph, graphP theGraph);
+extern int  _CheckKuratowskiSubgraphIntegrity(graphP theGraph);
+extern int  _getImageVertices(graphP theGraph, int *degrees, int maxDegree,
+                              int *imageVerts, int maxNumImageVerts);
+extern int  _TestForCompleteGraphObstruction(graphP theGraph, int numVerts,
+                                             int *degrees, int *imageVerts);
+
+/* Forward declarations of overloading functions */
+
+int  _K5Search_EmbeddingInitialize(graphP theGraph);
+int  _K5Search_HandleBlockedBicomp(graphP theGraph, int v, int RootVertex, int R);
+int  _K5Search_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult);
+int  _K5Search_CheckObstructionIntegrity(graphP theGraph, graphP origGraph);
+
+/* Forward declarations of functions used by the extension system */
+
+void *_K5Search_DupContext(void *pContext, void *theGraph);
+void _K5Search_FreeContext(void *);
+
+/****************************************************************************
+ * K5SEARCH_ID - the variable used to hold the integer identifier for this
+ * extension, enabling this feature's extension context to be distinguished
+ * from other features' extension contexts that may be attached to a graph.
+ ****************************************************************************/
+
+int K5SEARCH_ID = 0;
+
+/****************************************************************************
+ gp_AttachK5Search()
+
+ This function adjusts the graph data structure to attach the K5 search
+ feature.
+
+ To activate this feature during gp_Embed(), use EMBEDFLAGS_SEARCHFORK5.
+ Then gp_Embed() returns OK with a planar embedding if the graph is
+ planar, so it has no K5 homeomorph.  Otherwise it returns NONEMBEDDABLE
+ with theGraph reduced to a K5 homeomorph if the search found one, as
+ reported by gp_FoundK5Homeomorph(), or to a K3,3 homeomorph if not.
+ ****************************************************************************/
+
+int  gp_AttachK5Search(graphP theGraph)
+{
+     K5SearchContext *context = NULL;
+
+     // If the K5 search feature has already been attached to the graph,
+     // then there is no need to attach it again
+     gp_FindExtension(theGraph, K5SEARCH_ID, (void *)&context);
+     if (context != NULL)
+     {
+         return OK;
+     }
+
+     // Allocate a new extension context
+     context = (K5SearchContext *) malloc(sizeof(K5SearchContext));
+     if (context == NULL)
+     {
+         return NOTOK;
+     }
+
+     context->origEdges = NULL;
+     context->numOrigEdges = context->origEdgeCapacity = 0;
+     context->foundK5 = FALSE;
+
+     // Put the overload functions into the context function table.
+     // gp_AddExtension will overload the graph's functions with these, and
+     // return the base function pointers in the context function table
+     memset(&context->functions, 0, sizeof(graphFunctionTable));
+
+     context->functions.fpEmbeddingInitialize = _K5Search_EmbeddingInitialize;
+     context->functions.fpHandleBlockedBicomp = _K5Search_HandleBlockedBicomp;
+     context->functions.fpEmbedPostprocess = _K5Search_EmbedPostprocess;
+     context->functions.fpCheckObstructionIntegrity = _K5Search_CheckObstructionIntegrity;
+
+     // Store the K5 search context, including the data structure and the
+     // function pointers, as an extension of the graph
+     if (gp_AddExtension(theGraph, &K5SEARCH_ID, (void *) context,
+                         _K5Search_DupContext, _K5Search_FreeContext,
+                         &context->functions) != OK)
+     {
+         _K5Search_FreeContext(context);
+         return NOTOK;
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ gp_DetachK5Search()
+ ********************************************************************/
+
+int gp_DetachK5Search(graphP theGraph)
+{
+    return gp_RemoveExtension(theGraph, K5SEARCH_ID);
+}
+
+/********************************************************************
+ gp_FoundK5Homeomorph()
+
+ Returns TRUE if the last gp_Embed() with EMBEDFLAGS_SEARCHFORK5
+ reduced theGraph to a K5 homeomorph, and FALSE otherwise.
+ ********************************************************************/
+
+int  gp_FoundK5Homeomorph(graphP theGraph)
+{
+     K5SearchContext *context = NULL;
+
+     if (theGraph == NULL || theGraph->embedFlags != EMBEDFLAGS_SEARCHFORK5)
+         return FALSE;
+
+     gp_FindExtension(theGraph, K5SEARCH_ID, (void *)&context);
+
+     return context != NULL && context->foundK5 ? TRUE : FALSE;
+}
+
+/********************************************************************
+ _K5Search_DupContext()
+ ********************************************************************/
+
+void *_K5Search_DupContext(void *pContext, void *theGraph)
+{
+     K5SearchContext *context = (K5SearchContext *) pContext;
+     K5SearchContext *newContext = (K5SearchContext *) malloc(sizeof(K5SearchContext));
+
+     (void) theGraph;
+
+     if (newContext != NULL)
+     {
+         *newContext = *context;
+
+         // Only the search result outlasts gp_Embed(), so the duplicate
+         // records the original edges when it is embedded
+         newContext->origEdges = NULL;
+         newContext->numOrigEdges = newContext->origEdgeCapacity = 0;
+     }
+
+     return newContext;
+}
+
+/********************************************************************
+ _K5Search_FreeContext()
+ ********************************************************************/
+
+void _K5Search_FreeContext(void *pContext)
+{
+     K5SearchContext *context = (K5SearchContext *) pContext;
+
+     free(context->origEdges);
+     free(pContext);
+}
+
+/********************************************************************
+ _K5Search_EmbeddingInitialize()
+
+ Records the edges of the graph before the core initialization sorts
+ the vertices by DFI, since the isolator deletes most of them once the
+ graph proves nonplanar.
+ ********************************************************************/
+
+int  _K5Search_EmbeddingInitialize(graphP theGraph)
+{
+    K5SearchContext *context = NULL;
+    gp_FindExtension(theGraph, K5SEARCH_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        if (theGraph->embedFlags == EMBEDFLAGS_SEARCHFORK5)
+        {
+            context->foundK5 = FALSE;
+            if (context->origEdgeCapacity < theGraph->M)
+            {
+                free(context->origEdges);
+                context->origEdgeCapacity = 0;
+                if ((context->origEdges = (int *) malloc(2*theGraph->M*sizeof(int))) == NULL)
+                    return NOTOK;
+                context->origEdgeCapacity = theGraph->M;
+            }
+            if ((context->numOrigEdges = gp_GetEdgeArray(theGraph, context->origEdges)) < 0)
+                return NOTOK;
+        }
+
+        return context->functions.fpEmbeddingInitialize(theGraph);
+    }
+
+    return NOTOK;
+}
+
+/********************************************************************
+ _K5Search_HandleBlockedBicomp()
+ ********************************************************************/
+
+int  _K5Search_HandleBlockedBicomp(graphP theGraph, int v, int RootVertex, int R)
+{
+    K5SearchContext *context = NULL;
+    gp_FindExtension(theGraph, K5SEARCH_ID, (void *)&context);
+
+    if (context == NULL)
+        return NOTOK;
+
+    if (theGraph->embedFlags == EMBEDFLAGS_SEARCHFORK5)
+        return _K5Search_IsolateObstruction(theGraph, v, RootVertex, R);
+
+    return context->functions.fpHandleBlockedBicomp(theGraph, v, RootVertex, R);
+}
+
+/********************************************************************
+ _K5Search_EmbedPostprocess()
+
+ A planar graph gets the core postprocessing of its embedding.  For a
+ nonplanar graph, the isolated obstruction is traded for a K5
+ homeomorph if it is not one already and the search finds one.
+ ********************************************************************/
+
+int  _K5Search_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult)
+{
+    K5SearchContext *context = NULL;
+    gp_FindExtension(theGraph, K5SEARCH_ID, (void *)&context);
+
+    if (context == NULL)
+        return NOTOK;
+
+    if (theGraph->embedFlags == EMBEDFLAGS_SEARCHFORK5 && edgeEmbeddingResult == NONEMBEDDABLE)
+        return _K5Search_FindK5(theGraph, context) == OK ? NONEMBEDDABLE : NOTOK;
+
+    return context->functions.fpEmbedPostprocess(theGraph, v, edgeEmbeddingResult);
+}
+
+/********************************************************************
+ _K5Search_CheckObstructionIntegrity()
+
+ When searching for K5, theGraph must be a subgraph of origGraph that
+ is a K5 homeomorph if the search reported one, and a K5 or K3,3
+ homeomorph otherwise.
+ ********************************************************************/
+
+int  _K5Search_CheckObstructionIntegrity(graphP theGraph, graphP origGraph)
+{
+     K5SearchContext *context = NULL;
+     gp_FindExtension(theGraph, K5SEARCH_ID, (void *)&context);
+
+     if (context == NULL)
+         return NOTOK;
+
+     if (theGraph->embedFlags == EMBEDFLAGS_SEARCHFORK5)
+     {
+         int  degrees[5], imageVerts[6];
+
+         if (_TestSubgraph(theGraph, origGraph) != TRUE)
+             return NOTOK;
+
+         if (!context->foundK5)
+             return _CheckKuratowskiSubgraphIntegrity(theGraph);
+
+         if (_getImageVertices(theGraph, degrees, 4, imageVerts, 6) != OK ||
+             _TestForCompleteGraphObstruction(theGraph, 5, degrees, imageVerts) != TRUE)
+             return NOTOK;
+
+         return OK;
+     }
+
+     return context->functions.fpCheckObstructionIntegrity(theGraph, origGraph);
+}
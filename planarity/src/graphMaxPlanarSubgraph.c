@@ -0,0 +1,524 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graphMaxPlanarSubgraph.private.h"
+#include "graphMaxPlanarSubgraph.h"
+
+/********************************************************************
+ Maximal planar subgraph
+
+ The edge addition method embeds the back edges from each vertex v to
+ its descendants in one Walkdown per DFS child of v.  For a planar
+ graph, all of them are embedded.  For a nonplanar graph, the core
+ planarity algorithm stops at the first Walkdown that is blocked and
+ isolates a Kuratowski subgraph.  This extension instead leaves out,
+ or rejects, back edges so that the same pass can continue, and the
+ result is a planar embedding of a planar subgraph that contains the
+ DFS tree.  The rejected edges are recorded in the extension context.
+
+ A Walkdown is only blocked by stopping vertices, i.e. by the future
+ pertinent vertices that it must keep on the external face for the
+ back edges to ancestors of v.  This extension favors the back edges
+ of step v over those: the first Walkdown traversal stops as usual,
+ but the second one, and any traversal that has descended to a child
+ bicomp, passes stopping vertices as if they were inactive, as long as
+ back edges of the DFS child's subtree remain to be embedded.  The
+ back edge embedded beyond a passed vertex encloses it in a proper
+ face, along with the child bicomps of the vertex, so the vertex is
+ flagged as enclosed.
+
+ Nothing is done yet for the back edges from ancestors of v to the
+ enclosed vertices and to their descendants.  Instead, when the Walkup
+ of such a back edge reaches an enclosed vertex, the forward arc is
+ rejected, and each vertex the Walkup visited is flagged as enclosed
+ too, so that later Walkups stop there.  The dead forward arcs are
+ removed once the Walkups of their step are done.
+
+ So each Walkup and Walkdown costs what it does in core planarity,
+ and each vertex is flagged at most once.
+
+ Each edge is rejected because it conflicts with the DFS tree and the
+ back edges embedded before it.  Since the stopping vertices still use
+ lowpoints and least ancestors that count rejected back edges, the
+ Walkdown may stop where it did not need to, so a rejected edge may
+ turn out to fit in the end.  gp_RetryRejectedEdges() tries each one
+ again with gp_TryAddEdgePlanar(), and since an edge that does not fit
+ cannot fit after more edges are added, one pass over the rejected
+ edges makes the subgraph maximal.  Each try can cost O(N+M), so the
+ retry is left to the caller rather than done by gp_Embed().
+ ********************************************************************/
+
+/* Private functions */
+
+static void _EncloseWalkupPath(graphP theGraph, MaxPlanarSubgraphContext *context, int e);
+static void _StopWalkdownTraversal(graphP theGraph, int RootVertex, int RootSide, int W, int WPrevLink);
+static int  _HasUnembeddedArcs(graphP theGraph, int v, int c, int nextChild);
+static void _ClearPertinence(graphP theGraph, int v, int W);
+static void _RejectArc(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int e);
+
+void _MaxPlanarSubgraph_GreedyWalkUp(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int e);
+int  _MaxPlanarSubgraph_GreedyWalkDown(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int RootVertex);
+void _MaxPlanarSubgraph_RejectDeadArcs(graphP theGraph, MaxPlanarSubgraphContext *context);
+int  _MaxPlanarSubgraph_RetryRejectedEdges(graphP theGraph, MaxPlanarSubgraphContext *context);
+
+/********************************************************************
+ _MaxPlanarSubgraph_GreedyWalkUp()
+
+ The core Walkup (see _WalkUp()), except that if it meets a vertex
+ flagged as enclosed, then the path from W is enclosed too, so the
+ pertinence established so far is undone and the forward arc e is
+ put aside as dead.  The vertices visited are kept on the stack, which
+ the Walkdown clears before using it, so they can be flagged.
+ ********************************************************************/
+
+void _MaxPlanarSubgraph_GreedyWalkUp(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int e)
+{
+int  W = gp_GetNeighbor(theGraph, e);
+int  Zig=W, Zag=W, ZigPrevLink=1, ZagPrevLink=0;
+int  nextZig, nextZag, R;
+
+     // The dead arcs of a preceding step can be removed from its forward
+     // arc list now that the loop over that list is done
+     if (context->numDeadArcs > 0 &&
+         gp_GetNeighbor(theGraph, gp_GetTwinArc(theGraph, context->deadArcs[0])) != v)
+         _MaxPlanarSubgraph_RejectDeadArcs(theGraph, context);
+
+     sp_ClearStack(theGraph->theStack);
+     gp_SetVertexPertinentEdge(theGraph, W, e);
+
+     while (Zig != v)
+     {
+         if (context->enclosed[Zig] || context->enclosed[Zag])
+         {
+             _EncloseWalkupPath(theGraph, context, e);
+             return;
+         }
+
+         // Same as the core Walkup, except that a vertex visited in step v
+         // may have been visited by a Walkup that found it enclosed
+         if (gp_IsVirtualVertex(theGraph, (nextZig = gp_GetExtFaceVertex(theGraph, Zig, 1^ZigPrevLink))))
+         {
+             if (gp_GetVertexVisitedInfo(theGraph, Zig) == v) break;
+             R = nextZig;
+             nextZag = gp_GetExtFaceVertex(theGraph, R,
+                                           gp_GetExtFaceVertex(theGraph, R, 0)==Zig ? 1 : 0);
+             if (gp_GetVertexVisitedInfo(theGraph, nextZag) == v)
+             {
+                 if (context->enclosed[nextZag])
+                     _EncloseWalkupPath(theGraph, context, e);
+                 break;
+             }
+         }
+         else if (gp_IsVirtualVertex(theGraph, (nextZag = gp_GetExtFaceVertex(theGraph, Zag, 1^ZagPrevLink))))
+         {
+             if (gp_GetVertexVisitedInfo(theGraph, Zag) == v) break;
+             R = nextZag;
+             nextZig = gp_GetExtFaceVertex(theGraph, R,
+                                           gp_GetExtFaceVertex(theGraph, R, 0)==Zag ? 1 : 0);
+             if (gp_GetVertexVisitedInfo(theGraph, nextZig) == v)
+             {
+                 if (context->enclosed[nextZig])
+                     _EncloseWalkupPath(theGraph, context, e);
+                 break;
+             }
+         }
+         else
+         {
+             if (gp_GetVertexVisitedInfo(theGraph, Zig) == v) break;
+             if (gp_GetVertexVisitedInfo(theGraph, Zag) == v) break;
+             R = NIL;
+         }
+
+         gp_SetVertexVisitedInfo(theGraph, Zig, v);
+         gp_SetVertexVisitedInfo(theGraph, Zag, v);
+         sp_Push2(theGraph->theStack, Zig, Zag);
+
+         if (gp_IsNotVertex(R))
+         {
+             ZigPrevLink = gp_GetExtFaceVertex(theGraph, nextZig, 0)==Zig ? 0 : 1;
+             Zig = nextZig;
+
+             ZagPrevLink = gp_GetExtFaceVertex(theGraph, nextZag, 0)==Zag ? 0 : 1;
+             Zag = nextZag;
+         }
+         else
+         {
+             Zig = Zag = gp_GetPrimaryVertexFromRoot(theGraph, R);
+             ZigPrevLink = 1;
+             ZagPrevLink = 0;
+
+             // The bicomp hangs from an enclosed cut vertex
+             if (context->enclosed[Zig])
+             {
+                 _EncloseWalkupPath(theGraph, context, e);
+                 return;
+             }
+
+             if (gp_GetVertexLowpoint(theGraph, gp_GetDFSChildFromRoot(theGraph, R)) < v)
+                  gp_AppendVertexPertinentRoot(theGraph, Zig, R);
+             else gp_PrependVertexPertinentRoot(theGraph, Zag, R);
+         }
+     }
+}
+
+/********************************************************************
+ _EncloseWalkupPath()
+
+ The Walkup of the forward arc e found that its path is enclosed, so
+ the vertices it visited, which are on the stack, are flagged as
+ enclosed, and the pertinence it established is cleared.  Any other
+ Walkup in the same step that visited them found the same enclosed
+ vertex, so the pertinent roots lists of the vertices are emptied.
+ ********************************************************************/
+
+static void _EncloseWalkupPath(graphP theGraph, MaxPlanarSubgraphContext *context, int e)
+{
+int  W = gp_GetNeighbor(theGraph, e), Zig, Zag;
+
+     gp_SetVertexPertinentEdge(theGraph, W, NIL);
+     context->enclosed[W] = 1;
+
+     while (sp_NonEmpty(theGraph->theStack))
+     {
+         sp_Pop2(theGraph->theStack, Zig, Zag);
+         context->enclosed[Zig] = context->enclosed[Zag] = 1;
+         gp_SetVertexPertinentRootsList(theGraph, Zig, NIL);
+         gp_SetVertexPertinentRootsList(theGraph, Zag, NIL);
+     }
+
+     context->deadArcs[context->numDeadArcs++] = e;
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_GreedyWalkDown()
+
+ The core Walkdown (see _WalkDown()), except that it passes stopping
+ vertices as described above, rather than being blocked, and flags
+ them as enclosed.  When the first traversal descends to a blocked
+ bicomp from a vertex W in the bicomp of RootVertex, it stops at W,
+ so the second traversal passes the stopping vertices instead.
+
+ If the Walkdown leaves forward arcs into the subtree of the DFS child
+ of RootVertex unembedded anyway, then they are rejected.
+
+ Returns OK, or NOTOK on internal failure
+ ********************************************************************/
+
+int  _MaxPlanarSubgraph_GreedyWalkDown(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int RootVertex)
+{
+int  RetVal, W, WPrevLink, R, X, XPrevLink, Y, YPrevLink, RootSide, e;
+int  RootEdgeChild = gp_GetDFSChildFromRoot(theGraph, RootVertex);
+int  nextChild = gp_GetVertexNextDFSChild(theGraph, v, RootEdgeChild);
+
+     if (context->numDeadArcs > 0)
+         _MaxPlanarSubgraph_RejectDeadArcs(theGraph, context);
+
+     sp_ClearStack(theGraph->theStack);
+
+     for (RootSide = 0; RootSide < 2; RootSide++)
+     {
+         W = gp_GetExtFaceVertex(theGraph, RootVertex, RootSide);
+         WPrevLink = gp_GetExtFaceVertex(theGraph, W, 1) == RootVertex ? 1 : 0;
+
+         // Unlike the core Walkdown, the second traversal can start on a singleton
+         // edge, in which case W is entered consistently with RootSide
+         if (gp_GetExtFaceVertex(theGraph, W, 0) == gp_GetExtFaceVertex(theGraph, W, 1))
+             WPrevLink = 1^RootSide;
+
+         while (W != RootVertex)
+         {
+             if (gp_IsArc(gp_GetVertexPertinentEdge(theGraph, W)))
+             {
+                 if (sp_NonEmpty(theGraph->theStack))
+                 {
+                     if ((RetVal = theGraph->functions.fpMergeBicomps(theGraph, v, RootVertex, W, WPrevLink)) != OK)
+                         return RetVal;
+                 }
+                 theGraph->functions.fpEmbedBackEdgeToDescendant(theGraph, RootSide, RootVertex, W, WPrevLink);
+
+                 gp_SetVertexPertinentEdge(theGraph, W, NIL);
+             }
+
+             if (gp_IsVertex(gp_GetVertexPertinentRootsList(theGraph, W)))
+             {
+                 sp_Push2(theGraph->theStack, W, WPrevLink);
+                 R = gp_GetVertexFirstPertinentRoot(theGraph, W);
+
+                 X = gp_GetExtFaceVertex(theGraph, R, 0);
+                 XPrevLink = gp_GetExtFaceVertex(theGraph, X, 1)==R ? 1 : 0;
+                 Y = gp_GetExtFaceVertex(theGraph, R, 1);
+                 YPrevLink = gp_GetExtFaceVertex(theGraph, Y, 0)==R ? 0 : 1;
+
+                 gp_UpdateVertexFuturePertinentChild(theGraph, X, v);
+                 gp_UpdateVertexFuturePertinentChild(theGraph, Y, v);
+                 if (PERTINENT(theGraph, X) && NOTFUTUREPERTINENT(theGraph, X, v))
+                 {
+                     W = X;
+                     WPrevLink = XPrevLink;
+                     sp_Push2(theGraph->theStack, R, 0);
+                 }
+                 else if (PERTINENT(theGraph, Y) && NOTFUTUREPERTINENT(theGraph, Y, v))
+                 {
+                     W = Y;
+                     WPrevLink = YPrevLink;
+                     sp_Push2(theGraph->theStack, R, 1);
+                 }
+                 else if (PERTINENT(theGraph, X))
+                 {
+                     W = X;
+                     WPrevLink = XPrevLink;
+                     sp_Push2(theGraph->theStack, R, 0);
+                 }
+                 else if (PERTINENT(theGraph, Y))
+                 {
+                     W = Y;
+                     WPrevLink = YPrevLink;
+                     sp_Push2(theGraph->theStack, R, 1);
+                 }
+
+                 // The bicomp is blocked, so either the first traversal stops at W
+                 // or the X side is taken, passing the stopping vertex X
+                 else if (RootSide == 0 && sp_GetCurrentSize(theGraph->theStack) == 2)
+                 {
+                     sp_Pop2(theGraph->theStack, W, WPrevLink);
+                     _StopWalkdownTraversal(theGraph, RootVertex, RootSide, W, WPrevLink);
+                     break;
+                 }
+                 else
+                 {
+                     W = X;
+                     WPrevLink = XPrevLink;
+                     sp_Push2(theGraph->theStack, R, 0);
+                 }
+             }
+             else
+             {
+                 gp_UpdateVertexFuturePertinentChild(theGraph, W, v);
+                 if (FUTUREPERTINENT(theGraph, W, v))
+                 {
+                     if (sp_IsEmpty(theGraph->theStack) &&
+                         (RootSide == 0 || !_HasUnembeddedArcs(theGraph, v, RootEdgeChild, nextChild)))
+                     {
+                         _StopWalkdownTraversal(theGraph, RootVertex, RootSide, W, WPrevLink);
+                         break;
+                     }
+
+                     // Pass the stopping vertex, which the next back edge embedded encloses
+                     context->enclosed[W] = 1;
+                 }
+
+                 if (theGraph->functions.fpHandleInactiveVertex(theGraph, RootVertex, &W, &WPrevLink) != OK)
+                     return NOTOK;
+
+                 // Only a bicomp with no pertinent vertex leads back to its root
+                 if (gp_IsVirtualVertex(theGraph, W) && W != RootVertex)
+                     return NOTOK;
+             }
+         }
+     }
+
+     while (gp_IsArc(e = gp_GetVertexFwdArcList(theGraph, v)) &&
+            (gp_IsNotVertex(nextChild) || gp_GetNeighbor(theGraph, e) < nextChild))
+     {
+         gp_SetVertexPertinentEdge(theGraph, gp_GetNeighbor(theGraph, e), NIL);
+         _ClearPertinence(theGraph, v, gp_GetNeighbor(theGraph, e));
+         _RejectArc(theGraph, context, v, e);
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _StopWalkdownTraversal()
+
+ Short-circuits the external face between RootVertex and the vertex W
+ at which the Walkdown traversal on RootSide stops, as the core
+ Walkdown does for a stopping vertex, except that no short-circuit is
+ made if the external face would be left with only RootVertex and W.
+ ********************************************************************/
+
+static void _StopWalkdownTraversal(graphP theGraph, int RootVertex, int RootSide, int W, int WPrevLink)
+{
+int  X;
+
+     if (gp_GetExtFaceVertex(theGraph, RootVertex, 1^RootSide) == W)
+     {
+         X = W;
+         W = gp_GetExtFaceVertex(theGraph, W, WPrevLink);
+         WPrevLink = gp_GetExtFaceVertex(theGraph, W, 0) == X ? 1 : 0;
+     }
+
+     if (W != RootVertex)
+     {
+         gp_SetExtFaceVertex(theGraph, RootVertex, RootSide, W);
+         gp_SetExtFaceVertex(theGraph, W, WPrevLink, RootVertex);
+     }
+}
+
+/********************************************************************
+ _HasUnembeddedArcs()
+
+ Since the Walkdowns of the preceding children of v have embedded or
+ rejected all their forward arcs, there are unembedded forward arcs
+ from v into the subtree of its DFS child c if the forward arc list of
+ v starts with an arc whose descendant endpoint is less than the next
+ child of v after c, if any.
+ ********************************************************************/
+
+static int  _HasUnembeddedArcs(graphP theGraph, int v, int c, int nextChild)
+{
+int  e = gp_GetVertexFwdArcList(theGraph, v);
+
+     return gp_IsArc(e) && c < gp_GetNeighbor(theGraph, e) &&
+            (gp_IsNotVertex(nextChild) || gp_GetNeighbor(theGraph, e) < nextChild);
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_RejectDeadArcs()
+
+ Rejects the forward arcs that their Walkups found to be enclosed.
+ ********************************************************************/
+
+void _MaxPlanarSubgraph_RejectDeadArcs(graphP theGraph, MaxPlanarSubgraphContext *context)
+{
+int  e;
+
+     while (context->numDeadArcs > 0)
+     {
+         e = context->deadArcs[--context->numDeadArcs];
+         _RejectArc(theGraph, context, gp_GetNeighbor(theGraph, gp_GetTwinArc(theGraph, e)), e);
+     }
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_RetryRejectedEdges()
+
+ Adds to the finished embedding each rejected edge that still fits,
+ and keeps the others in the rejected list, in their order.  The
+ rejected edges hold original vertex numbers, so if the vertices are
+ still sorted by DFI, the enclosed flags, which are no longer needed,
+ are overwritten to map each original number to its vertex.
+
+ Returns OK on success, NOTOK on failure.
+ ********************************************************************/
+
+int  _MaxPlanarSubgraph_RetryRejectedEdges(graphP theGraph, MaxPlanarSubgraphContext *context)
+{
+int  v, i, numKept = 0, Result;
+
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+          context->enclosed[theGraph->internalFlags & FLAGS_SORTEDBYDFI ? gp_GetVertexIndex(theGraph, v) : v] = v;
+
+     for (i = 0; i < context->numRejected; i++)
+     {
+          Result = gp_TryAddEdgePlanar(theGraph, context->enclosed[context->rejectedEdges[2*i]],
+                                       context->enclosed[context->rejectedEdges[2*i+1]], NULL);
+          if (Result == NOTOK)
+              return NOTOK;
+
+          if (Result == NONEMBEDDABLE)
+          {
+              context->rejectedEdges[2*numKept] = context->rejectedEdges[2*i];
+              context->rejectedEdges[2*numKept+1] = context->rejectedEdges[2*i+1];
+              numKept++;
+          }
+     }
+
+     context->numRejected = numKept;
+     return OK;
+}
+
+/********************************************************************
+ _RejectArc()
+
+ Removes the forward arc e from the forward arc list of v, records its
+ edge as rejected, and then deletes the edge, whose back arc is not
+ yet in any adjacency list.
+ ********************************************************************/
+
+static void _RejectArc(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int e)
+{
+int  W = gp_GetNeighbor(theGraph, e), eTwin = gp_GetTwinArc(theGraph, e);
+
+     if (gp_GetVertexFwdArcList(theGraph, v) == e)
+     {
+         gp_SetVertexFwdArcList(theGraph, v, gp_GetNextArc(theGraph, e));
+         if (gp_GetVertexFwdArcList(theGraph, v) == e)
+             gp_SetVertexFwdArcList(theGraph, v, NIL);
+     }
+
+     gp_SetNextArc(theGraph, gp_GetPrevArc(theGraph, e), gp_GetNextArc(theGraph, e));
+     gp_SetPrevArc(theGraph, gp_GetNextArc(theGraph, e), gp_GetPrevArc(theGraph, e));
+
+     context->rejectedEdges[2*context->numRejected] = gp_GetVertexIndex(theGraph, v);
+     context->rejectedEdges[2*context->numRejected+1] = gp_GetVertexIndex(theGraph, W);
+     context->numRejected++;
+
+     // Put the arcs at the ends of the adjacency lists of v and W so that
+     // gp_DeleteEdge() can detach them along with deleting the edge
+     gp_SetPrevArc(theGraph, e, NIL);
+     gp_SetNextArc(theGraph, e, NIL);
+     gp_AttachArc(theGraph, v, NIL, 0, e);
+     gp_SetPrevArc(theGraph, eTwin, NIL);
+     gp_SetNextArc(theGraph, eTwin, NIL);
+     gp_AttachArc(theGraph, W, NIL, 0, eTwin);
+
+     gp_DeleteEdge(theGraph, e, 0);
+}
+
+/********************************************************************
+ _ClearPertinence()
+
+ Walks up from W to v as the Walkup does, and empties the pertinent
+ roots list of each cut vertex on the way, since the Walkdown of the
+ subtree is done.  The vertices are marked visited with N+v so that
+ the walk up from another rejected edge in step v stops where this
+ one passed, and so that the marks differ from the Walkup's, which
+ are at most N.
+ ********************************************************************/
+
+static void _ClearPertinence(graphP theGraph, int v, int W)
+{
+int  Zig=W, Zag=W, ZigPrevLink=1, ZagPrevLink=0;
+int  nextZig, nextZag, R, visited = theGraph->N + v;
+
+     while (Zig != v)
+     {
+         if (gp_GetVertexVisitedInfo(theGraph, Zig) == visited ||
+             gp_GetVertexVisitedInfo(theGraph, Zag) == visited)
+             break;
+
+         gp_SetVertexVisitedInfo(theGraph, Zig, visited);
+         gp_SetVertexVisitedInfo(theGraph, Zag, visited);
+
+         nextZig = gp_GetExtFaceVertex(theGraph, Zig, 1^ZigPrevLink);
+         nextZag = gp_GetExtFaceVertex(theGraph, Zag, 1^ZagPrevLink);
+
+         if (gp_IsVirtualVertex(theGraph, nextZig))
+             R = nextZig;
+         else if (gp_IsVirtualVertex(theGraph, nextZag))
+             R = nextZag;
+         else
+             R = NIL;
+
+         if (gp_IsNotVertex(R))
+         {
+             ZigPrevLink = gp_GetExtFaceVertex(theGraph, nextZig, 0)==Zig ? 0 : 1;
+             Zig = nextZig;
+
+             ZagPrevLink = gp_GetExtFaceVertex(theGraph, nextZag, 0)==Zag ? 0 : 1;
+             Zag = nextZag;
+         }
+         else
+         {
+             Zig = Zag = gp_GetPrimaryVertexFromRoot(theGraph, R);
+             ZigPrevLink = 1;
+             ZagPrevLink = 0;
+
+             gp_SetVertexPertinentRootsList(theGraph, Zig, NIL);
+         }
+     }
+}
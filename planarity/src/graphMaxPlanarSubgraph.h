@@ -0,0 +1,28 @@
+#ifndef GRAPH_MAXPLANARSUBGRAPH_H
+#define GRAPH_MAXPLANARSUBGRAPH_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graphStructures.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAXPLANARSUBGRAPH_NAME "MaxPlanarSubgraph"
+
+int gp_AttachMaxPlanarSubgraph(graphP theGraph);
+int gp_DetachMaxPlanarSubgraph(graphP theGraph);
+
+int gp_GetRejectedEdges(graphP theGraph, int *edgePairs);
+int gp_RetryRejectedEdges(graphP theGraph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
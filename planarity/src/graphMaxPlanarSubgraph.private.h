@@ -0,0 +1,42 @@
+#ifndef GRAPH_MAXPLANARSUBGRAPH_PRIVATE_H
+#define GRAPH_MAXPLANARSUBGRAPH_PRIVATE_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    // The edges left out of the embedding, as pairs of original vertex
+    // numbers, and the number of pairs and the capacity in pairs
+    int *rejectedEdges;
+    int numRejected, rejectedCapacity;
+
+    // The forward arcs whose Walkups found them enclosed, which are rejected
+    // once the Walkups of their step are done, with room for every edge
+    int *deadArcs;
+    int numDeadArcs;
+
+    // Flags for the vertices that the embedding has enclosed in a proper
+    // face, so their back edges to ancestors of v can no longer be embedded
+    int *enclosed;
+    int enclosedCapacity;
+
+    // Overloaded function pointers
+    graphFunctionTable functions;
+
+} MaxPlanarSubgraphContext;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
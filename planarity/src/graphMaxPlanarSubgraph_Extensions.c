@@ -0,0 +1,362 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+
+#include "graphMaxPlanarSubgraph.private.h"
+#include "graphMaxPlanarSubgraph.h"
+
+extern void _MaxPlanarSubgraph_GreedyWalkUp(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int e);
+extern int  _MaxPlanarSubgraph_GreedyWalkDown(graphP theGraph, MaxPlanarSubgraphContext *context, int v, int RootVertex);
+extern void _MaxPlanarSubgraph_RejectDeadArcs(graphP theGraph, MaxPlanarSubgraphContext *context);
+extern int  _MaxPlanarSubgraph_RetryRejectedEdges(graphP theGraph, MaxPlanarSubgraphContext *context);
+
+extern int  _TestSubgraph(graphP theSubgraph, graphP theGraph);
+extern int  _CheckEmbeddingFacialIntegrity(graphP theGraph);
+
+/* Forward declarations of overloading functions */
+
+int  _MaxPlanarSubgraph_EmbeddingInitialize(graphP theGraph);
+void _MaxPlanarSubgraph_WalkUp(graphP theGraph, int v, int e);
+int  _MaxPlanarSubgraph_WalkDown(graphP theGraph, int v, int RootVertex);
+int  _MaxPlanarSubgraph_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult);
+int  _MaxPlanarSubgraph_CheckEmbeddingIntegrity(graphP theGraph, graphP origGraph);
+
+/* Forward declarations of functions used by the extension system */
+
+void *_MaxPlanarSubgraph_DupContext(void *pContext, void *theGraph);
+void _MaxPlanarSubgraph_FreeContext(void *);
+
+/****************************************************************************
+ * MAXPLANARSUBGRAPH_ID - the variable used to hold the integer identifier
+ * for this extension, enabling this feature's extension context to be
+ * distinguished from other features' extension contexts that may be
+ * attached to a graph.
+ ****************************************************************************/
+
+int MAXPLANARSUBGRAPH_ID = 0;
+
+/****************************************************************************
+ gp_AttachMaxPlanarSubgraph()
+
+ This function adjusts the graph data structure to attach the maximal
+ planar subgraph feature.
+
+ To activate this feature during gp_Embed(), use
+ EMBEDFLAGS_MAXIMALPLANARSUBGRAPH.  Then gp_Embed() returns OK with a
+ planar embedding of a maximal planar subgraph, and the edges that were
+ left out can be obtained with gp_GetRejectedEdges().
+ ****************************************************************************/
+
+int  gp_AttachMaxPlanarSubgraph(graphP theGraph)
+{
+     MaxPlanarSubgraphContext *context = NULL;
+
+     // If the maximal planar subgraph feature has already been attached to
+     // the graph, then there is no need to attach it again
+     gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+     if (context != NULL)
+     {
+         return OK;
+     }
+
+     // Allocate a new extension context
+     context = (MaxPlanarSubgraphContext *) malloc(sizeof(MaxPlanarSubgraphContext));
+     if (context == NULL)
+     {
+         return NOTOK;
+     }
+
+     context->rejectedEdges = NULL;
+     context->deadArcs = NULL;
+     context->enclosed = NULL;
+     context->numRejected = context->rejectedCapacity = context->numDeadArcs = 0;
+     context->enclosedCapacity = 0;
+
+     // Put the overload functions into the context function table.
+     // gp_AddExtension will overload the graph's functions with these, and
+     // return the base function pointers in the context function table
+     memset(&context->functions, 0, sizeof(graphFunctionTable));
+
+     context->functions.fpEmbeddingInitialize = _MaxPlanarSubgraph_EmbeddingInitialize;
+     context->functions.fpWalkUp = _MaxPlanarSubgraph_WalkUp;
+     context->functions.fpWalkDown = _MaxPlanarSubgraph_WalkDown;
+     context->functions.fpEmbedPostprocess = _MaxPlanarSubgraph_EmbedPostprocess;
+     context->functions.fpCheckEmbeddingIntegrity = _MaxPlanarSubgraph_CheckEmbeddingIntegrity;
+
+     // Store the maximal planar subgraph context, including the data structure
+     // and the function pointers, as an extension of the graph
+     if (gp_AddExtension(theGraph, &MAXPLANARSUBGRAPH_ID, (void *) context,
+                         _MaxPlanarSubgraph_DupContext, _MaxPlanarSubgraph_FreeContext,
+                         &context->functions) != OK)
+     {
+         _MaxPlanarSubgraph_FreeContext(context);
+         return NOTOK;
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ gp_DetachMaxPlanarSubgraph()
+ ********************************************************************/
+
+int gp_DetachMaxPlanarSubgraph(graphP theGraph)
+{
+    return gp_RemoveExtension(theGraph, MAXPLANARSUBGRAPH_ID);
+}
+
+/********************************************************************
+ gp_GetRejectedEdges()
+
+ Stores in edgePairs the edges that the last gp_Embed() with
+ EMBEDFLAGS_MAXIMALPLANARSUBGRAPH left out of the embedding, as pairs
+ of the original vertex numbers, in the order they were rejected.
+ edgePairs needs two entries per rejected edge, which is at most two
+ per edge of the input graph; it can be NULL to only count the edges.
+
+ Returns the number of rejected edges, or -1 if the feature is not
+ attached or the graph was not embedded with it.
+ ********************************************************************/
+
+int  gp_GetRejectedEdges(graphP theGraph, int *edgePairs)
+{
+     MaxPlanarSubgraphContext *context = NULL;
+
+     if (theGraph == NULL || theGraph->embedFlags != EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+         return -1;
+
+     gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+     if (context == NULL)
+         return -1;
+
+     if (edgePairs != NULL && context->numRejected > 0)
+         memcpy(edgePairs, context->rejectedEdges, 2*context->numRejected*sizeof(int));
+
+     return context->numRejected;
+}
+
+/********************************************************************
+ gp_RetryRejectedEdges()
+
+ Adds to the embedding from the last gp_Embed() with
+ EMBEDFLAGS_MAXIMALPLANARSUBGRAPH each rejected edge that fits, which
+ makes the embedded subgraph maximal, and removes those edges from the
+ list of gp_GetRejectedEdges().  The vertices can be in either order.
+ Each of the k rejected edges costs up to O(N+M), so this is an
+ O(k(N+M)) step, which the O(N+M) embedding does not do by itself.
+
+ Returns OK on success, NOTOK if the feature is not attached, the graph
+ was not embedded with it, or on failure.
+ ********************************************************************/
+
+int  gp_RetryRejectedEdges(graphP theGraph)
+{
+     MaxPlanarSubgraphContext *context = NULL;
+
+     if (theGraph == NULL || theGraph->embedFlags != EMBEDFLAGS_MAXIMALPLANARSUBGRAPH ||
+         (theGraph->internalFlags & FLAGS_OBSTRUCTIONFOUND))
+         return NOTOK;
+
+     gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+     if (context == NULL)
+         return NOTOK;
+
+     // A duplicate of the embedded graph has no enclosed flags to reuse
+     if (context->enclosedCapacity < theGraph->N + 1)
+     {
+         free(context->enclosed);
+         context->enclosedCapacity = 0;
+         if ((context->enclosed = (int *) malloc((theGraph->N + 1)*sizeof(int))) == NULL)
+             return NOTOK;
+         context->enclosedCapacity = theGraph->N + 1;
+     }
+
+     return _MaxPlanarSubgraph_RetryRejectedEdges(theGraph, context);
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_DupContext()
+ ********************************************************************/
+
+void *_MaxPlanarSubgraph_DupContext(void *pContext, void *theGraph)
+{
+     MaxPlanarSubgraphContext *context = (MaxPlanarSubgraphContext *) pContext;
+     MaxPlanarSubgraphContext *newContext = (MaxPlanarSubgraphContext *) malloc(sizeof(MaxPlanarSubgraphContext));
+
+     (void) theGraph;
+
+     if (newContext != NULL)
+     {
+         *newContext = *context;
+
+         // Only the rejected edges outlast gp_Embed(), so the duplicate
+         // allocates the other arrays when it is embedded
+         newContext->deadArcs = newContext->enclosed = NULL;
+         newContext->numDeadArcs = newContext->enclosedCapacity = 0;
+
+         if (context->rejectedEdges != NULL)
+         {
+             newContext->rejectedEdges = (int *) malloc(2*context->rejectedCapacity*sizeof(int));
+             newContext->deadArcs = (int *) malloc(context->rejectedCapacity*sizeof(int));
+             if (newContext->rejectedEdges == NULL || newContext->deadArcs == NULL)
+             {
+                 _MaxPlanarSubgraph_FreeContext(newContext);
+                 return NULL;
+             }
+             memcpy(newContext->rejectedEdges, context->rejectedEdges,
+                    2*context->numRejected*sizeof(int));
+         }
+     }
+
+     return newContext;
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_FreeContext()
+ ********************************************************************/
+
+void _MaxPlanarSubgraph_FreeContext(void *pContext)
+{
+     MaxPlanarSubgraphContext *context = (MaxPlanarSubgraphContext *) pContext;
+
+     free(context->rejectedEdges);
+     free(context->deadArcs);
+     free(context->enclosed);
+     free(pContext);
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_EmbeddingInitialize()
+
+ Makes room to record every back edge as rejected, since at most the
+ back edges can be rejected, and clears the enclosed vertex flags.
+ ********************************************************************/
+
+int  _MaxPlanarSubgraph_EmbeddingInitialize(graphP theGraph)
+{
+    MaxPlanarSubgraphContext *context = NULL;
+    gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        if (theGraph->embedFlags == EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+        {
+            context->numRejected = context->numDeadArcs = 0;
+            if (context->rejectedCapacity < theGraph->M)
+            {
+                free(context->rejectedEdges);
+                free(context->deadArcs);
+                context->deadArcs = NULL;
+                context->rejectedCapacity = 0;
+                if ((context->rejectedEdges = (int *) malloc(2*theGraph->M*sizeof(int))) == NULL ||
+                    (context->deadArcs = (int *) malloc(theGraph->M*sizeof(int))) == NULL)
+                    return NOTOK;
+                context->rejectedCapacity = theGraph->M;
+            }
+            if (context->enclosedCapacity < theGraph->N + 1)
+            {
+                free(context->enclosed);
+                context->enclosedCapacity = 0;
+                if ((context->enclosed = (int *) malloc((theGraph->N + 1)*sizeof(int))) == NULL)
+                    return NOTOK;
+                context->enclosedCapacity = theGraph->N + 1;
+            }
+            memset(context->enclosed, 0, (theGraph->N + 1)*sizeof(int));
+        }
+
+        return context->functions.fpEmbeddingInitialize(theGraph);
+    }
+
+    return NOTOK;
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_WalkUp()
+ ********************************************************************/
+
+void _MaxPlanarSubgraph_WalkUp(graphP theGraph, int v, int e)
+{
+    MaxPlanarSubgraphContext *context = NULL;
+    gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        if (theGraph->embedFlags == EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+            _MaxPlanarSubgraph_GreedyWalkUp(theGraph, context, v, e);
+        else
+            context->functions.fpWalkUp(theGraph, v, e);
+    }
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_WalkDown()
+ ********************************************************************/
+
+int  _MaxPlanarSubgraph_WalkDown(graphP theGraph, int v, int RootVertex)
+{
+    MaxPlanarSubgraphContext *context = NULL;
+    gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+
+    if (context == NULL)
+        return NOTOK;
+
+    if (theGraph->embedFlags == EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+        return _MaxPlanarSubgraph_GreedyWalkDown(theGraph, context, v, RootVertex);
+
+    return context->functions.fpWalkDown(theGraph, v, RootVertex);
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_EmbedPostprocess()
+
+ Rejects the dead forward arcs of the last steps that had no Walkdown
+ before the core postprocessing joins the bicomps.
+ ********************************************************************/
+
+int  _MaxPlanarSubgraph_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult)
+{
+    MaxPlanarSubgraphContext *context = NULL;
+    gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+
+    if (context == NULL)
+        return NOTOK;
+
+    if (theGraph->embedFlags != EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+        return context->functions.fpEmbedPostprocess(theGraph, v, edgeEmbeddingResult);
+
+    _MaxPlanarSubgraph_RejectDeadArcs(theGraph, context);
+
+    return context->functions.fpEmbedPostprocess(theGraph, v, edgeEmbeddingResult);
+}
+
+/********************************************************************
+ _MaxPlanarSubgraph_CheckEmbeddingIntegrity()
+
+ For a maximal planar subgraph, theGraph must be a planar embedding
+ of a subgraph of origGraph that lacks exactly the rejected edges.
+ ********************************************************************/
+
+int  _MaxPlanarSubgraph_CheckEmbeddingIntegrity(graphP theGraph, graphP origGraph)
+{
+     MaxPlanarSubgraphContext *context = NULL;
+     gp_FindExtension(theGraph, MAXPLANARSUBGRAPH_ID, (void *)&context);
+
+     if (context == NULL)
+         return NOTOK;
+
+     if (theGraph->embedFlags == EMBEDFLAGS_MAXIMALPLANARSUBGRAPH)
+     {
+         if (_TestSubgraph(theGraph, origGraph) != TRUE ||
+             theGraph->M + context->numRejected != origGraph->M ||
+             _CheckEmbeddingFacialIntegrity(theGraph) != OK)
+             return NOTOK;
+
+         return OK;
+     }
+
+     return context->functions.fpCheckEmbeddingIntegrity(theGraph, origGraph);
+}
@@ -0,0 +1,1117 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "graph.h"
+
+/********************************************************************
+ Planar separators
+
+ gp_PlanarSeparator() follows Lipton and Tarjan.  A breadth first
+ search of the largest connected component gives levels of vertices,
+ and two small levels l0 and l2 around the median level separate the
+ component into the vertices below l0, the middle levels and the
+ vertices above l2.  If the middle levels hold more than two thirds of
+ the component, then the levels up to l0 are contracted to one root
+ vertex, the middle levels are triangulated, and a fundamental cycle
+ of the breadth first search tree separates them.  The tree has depth
+ at most l2-l0, so the cycle is short.
+
+ The number of vertices strictly inside the fundamental cycle of each
+ non-tree edge comes from Euler's formula: a triangulated disk with F
+ faces and a boundary cycle of c vertices has (F - c + 2)/2 interior
+ vertices.  The faces on one side of each cycle are a subtree of the
+ dual spanning tree formed by the non-tree edges, so one pass over
+ that tree and one least common ancestor pass over the search tree
+ measure every cycle in O(N+M) time.
+ ********************************************************************/
+
+/* Private functions */
+
+typedef struct
+{
+     int  weight, piece;
+} sep_PieceRec;
+
+static int  _SeparateComponent(graphP theEmbedding, int *comp, int n, int *level,
+                               int *parentArc, int *piece, int base);
+static int  _SeparateMiddleLevels(graphP theEmbedding, int *comp, int n, int *level,
+                                  int *parentArc, int *piece, int l0, int l2, int base);
+static int  _GetContractedRotation(graphP theEmbedding, int root, int *level, int l0,
+                                   int *parentArc, int *rootArcs);
+static graphP _CreateSubEmbedding(graphP theEmbedding, int *subIndex, int numVertices,
+                                  int root, int *rootArcs, int numRootArcs);
+static int  _Triangulate(graphP theGraph);
+static int  _GetArcPositions(graphP theGraph, int *arcPosition, int *positionArcs);
+static int  _Find(int *parent, int x);
+static int  _AssignSides(int *piece, int N, int numPieces, int *sides);
+static int  _ComparePieces(const void *p1, const void *p2);
+static int  _PartitionEmbedding(graphP theEmbedding, int k, int partBase, int *vertexIds, int *parts);
+static void _BalanceSides(graphP theEmbedding, int *sides, int *size, int target, int *queue);
+
+#define _EdgeId(theGraph, e) (((e) - gp_GetFirstEdge(theGraph)) >> 1)
+
+/********************************************************************
+ gp_PlanarSeparator()
+
+ Finds a vertex separator of the embedding in theEmbedding, which must
+ have been produced by gp_Embed() (or read or built as an embedding)
+ and not have an obstruction, in O(N+M) time.  The separator has
+ O(sqrt(N)) vertices, and removing it leaves two sides that have no
+ edge between them and that each hold at most about two thirds of the
+ vertices.
+
+ sides must have room for N entries.  sides[i] receives 0 or 1 for the
+ side of the zero-based vertex i, or -1 if it is in the separator.
+
+ Returns the number of separator vertices, or -1 on error.
+ ********************************************************************/
+
+int  gp_PlanarSeparator(graphP theEmbedding, int *sides)
+{
+int  N, first, u, v, w, e, j, head, tail, start, numComponents = 0;
+int  bigStart = 0, bigSize = 0, numPieces, Result = OK;
+int *level = NULL, *queue = NULL, *parentArc = NULL, *piece = NULL;
+
+     if (theEmbedding == NULL || sides == NULL || theEmbedding->N <= 0 ||
+         theEmbedding->embedFlags == 0 ||
+         (theEmbedding->internalFlags & FLAGS_OBSTRUCTIONFOUND))
+         return -1;
+
+     N = theEmbedding->N;
+     first = gp_GetFirstVertex(theEmbedding);
+
+     if ((level = (int *) malloc(N * sizeof(int))) == NULL ||
+         (queue = (int *) malloc(N * sizeof(int))) == NULL ||
+         (parentArc = (int *) malloc(N * sizeof(int))) == NULL ||
+         (piece = (int *) malloc(N * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     // Search each connected component breadth first, which leaves the
+     // vertices of each component together in the queue, in level order
+     if (Result == OK)
+     {
+         for (j = 0; j < N; j++)
+              level[j] = -1;
+
+         tail = 0;
+         for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+         {
+              if (level[v - first] >= 0)
+                  continue;
+
+              start = tail;
+              level[v - first] = 0;
+              parentArc[v - first] = NIL;
+              queue[tail++] = v;
+
+              for (head = start; head < tail; head++)
+              {
+                   w = queue[head];
+                   e = gp_GetFirstArc(theEmbedding, w);
+                   while (gp_IsArc(e))
+                   {
+                       u = gp_GetNeighbor(theEmbedding, e);
+                       if (level[u - first] < 0)
+                       {
+                           level[u - first] = level[w - first] + 1;
+                           parentArc[u - first] = gp_GetTwinArc(theEmbedding, e);
+                           queue[tail++] = u;
+                       }
+                       e = gp_GetNextArc(theEmbedding, e);
+                   }
+              }
+
+              for (j = start; j < tail; j++)
+                   piece[queue[j] - first] = numComponents;
+
+              if (tail - start > bigSize)
+              {
+                  bigStart = start;
+                  bigSize = tail - start;
+              }
+              numComponents++;
+         }
+     }
+
+     // Only a component with more than two thirds of the vertices needs
+     // to be separated; otherwise the components are divided between the
+     // sides as they are
+     numPieces = numComponents;
+     if (Result == OK && 3 * (long) bigSize > 2 * (long) N)
+     {
+         Result = _SeparateComponent(theEmbedding, queue + bigStart, bigSize,
+                                     level, parentArc, piece, numPieces);
+         numPieces += 4;
+     }
+
+     if (Result == OK)
+         Result = _AssignSides(piece, N, numPieces, sides);
+     else
+         Result = -1;
+
+     free(level);
+     free(queue);
+     free(parentArc);
+     free(piece);
+
+     return Result;
+}
+
+/********************************************************************
+ _SeparateComponent()
+
+ Separates the component whose n vertices are in comp, in breadth first
+ order, with level and parentArc (the arc to the parent) indexed by
+ zero-based vertex.  The vertices receive the pieces base (below level
+ l0), base+1 and base+2 (the middle levels) and base+3 (above level
+ l2), or -1 for the separator.
+ ********************************************************************/
+
+static int  _SeparateComponent(graphP theEmbedding, int *comp, int n, int *level,
+                               int *parentArc, int *piece, int base)
+{
+int  first = gp_GetFirstVertex(theEmbedding);
+int  depth = level[comp[n-1] - first];
+int  l, l0, l1, l2, j, sum, cost, middle = 0, Result = OK;
+int *count;
+
+     if ((count = (int *) calloc(depth + 2, sizeof(int))) == NULL)
+         return NOTOK;
+
+     for (j = 0; j < n; j++)
+          count[level[comp[j] - first]]++;
+
+     // The median level l1 is the first by which half of the vertices are reached
+     for (l1 = 0, sum = count[0]; 2 * (long) sum < n; )
+          sum += count[++l1];
+
+     // Choose levels l0 <= l1 and l2 > l1 that minimize |L(l0)| + 2(l1 - l0)
+     // and |L(l2)| + 2(l2 - l1 - 1), with the empty level depth+1.  Each is
+     // at most 2 sqrt(n), which bounds both the levels and the depth of the
+     // middle levels.  Level 0 holds only the root, so l0 is never below it.
+     l0 = 0;
+     cost = count[0] + 2 * l1;
+     for (l = 1; l <= l1; l++)
+          if (count[l] + 2 * (l1 - l) <= cost)
+          {
+              cost = count[l] + 2 * (l1 - l);
+              l0 = l;
+          }
+
+     l2 = depth + 1;
+     cost = 2 * (depth - l1);
+     for (l = l1 + 1; l <= depth; l++)
+          if (count[l] + 2 * (l - l1 - 1) < cost)
+          {
+              cost = count[l] + 2 * (l - l1 - 1);
+              l2 = l;
+          }
+
+     for (l = l0 + 1; l < l2; l++)
+          middle += count[l];
+
+     for (j = 0; j < n; j++)
+     {
+          l = level[comp[j] - first];
+          piece[comp[j] - first] = l < l0 ? base : (l == l0 || l == l2 ? -1 : (l > l2 ? base + 3 : base + 1));
+     }
+
+     if (3 * (long) middle > 2 * (long) n)
+         Result = _SeparateMiddleLevels(theEmbedding, comp, n, level, parentArc, piece, l0, l2, base);
+
+     free(count);
+     return Result;
+}
+
+/********************************************************************
+ _SeparateMiddleLevels()
+
+ Splits the vertices of the levels between l0 and l2 into the pieces
+ base+1 and base+2, strictly inside and outside of a fundamental
+ cycle, whose vertices go to the separator.
+
+ The graph H of the middle levels, with the levels up to l0 contracted
+ to a root vertex r, keeps the rotation of the embedding.
+ Its breadth first search tree is the one of the embedding.  Parallel
+ edges to r are removed, so H is simple, and H is then triangulated so
+ that every face has three arcs.  The root face of the dual spanning
+ tree is a face of r, so r is never strictly inside a cycle; it has no
+ weight because it stands for vertices that are already placed.
+ ********************************************************************/
+
+static int  _SeparateMiddleLevels(graphP theEmbedding, int *comp, int n, int *level,
+                                  int *parentArc, int *piece, int l0, int l2, int base)
+{
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding);
+int  numH = 0, numRootArcs = 0, numFaces = 0, W;
+int  j, x, hx, hp, r, e, a, u, v, f, g, id, head, tail, top, M, treeM = 0, c, inside, outside, cycleWeight;
+int  best = -1, bestCost = 0, bestCycle = 0, Result = OK;
+int *subIndex = NULL, *rootArcs = NULL;
+int *hParent = NULL, *hDepth = NULL, *firstChild = NULL, *nextSibling = NULL, *stack = NULL;
+int *ufParent = NULL, *edgeLCA = NULL, *edgeChild = NULL;
+int *arcFaces = NULL, *faceOffsets = NULL, *faceArcs = NULL, *arcPosition = NULL, *positionArcs = NULL;
+int *faceQueue = NULL, *faceParent = NULL, *faceSize = NULL;
+char *isTree = NULL, *black = NULL, *insideFace = NULL;
+graphP H = NULL;
+
+     // Number the vertices of H, giving the contracted levels the last number
+     if ((subIndex = (int *) malloc(N * sizeof(int))) == NULL)
+         return NOTOK;
+
+     for (j = 0; j < N; j++)
+          subIndex[j] = -1;
+
+     for (j = 0; j < n; j++)
+          if (level[comp[j] - first] > l0 && level[comp[j] - first] < l2)
+              subIndex[comp[j] - first] = first + numH++;
+
+     r = first + numH++;
+     for (j = 0; j < n; j++)
+          if (level[comp[j] - first] <= l0)
+              subIndex[comp[j] - first] = r;
+
+     W = numH - 1;
+     if (numH < 3)
+     {
+         free(subIndex);
+         return OK;
+     }
+
+     if ((rootArcs = (int *) malloc(2 * theEmbedding->M * sizeof(int))) == NULL ||
+         (numRootArcs = _GetContractedRotation(theEmbedding, comp[0], level, l0, parentArc, rootArcs)) < 0 ||
+         (H = _CreateSubEmbedding(theEmbedding, subIndex, numH, r, rootArcs, numRootArcs)) == NULL)
+         Result = NOTOK;
+
+     // Mark the tree edges of H and measure the depth of its vertices
+     if (Result == OK)
+     {
+         if ((hParent = (int *) malloc((first + numH) * sizeof(int))) == NULL ||
+             (hDepth = (int *) malloc((first + numH) * sizeof(int))) == NULL ||
+             (isTree = (char *) calloc(H->M + 1, sizeof(char))) == NULL)
+             Result = NOTOK;
+     }
+
+     if (Result == OK)
+     {
+         hParent[r] = NIL;
+         hDepth[r] = 0;
+
+         for (j = 0; j < n && Result == OK; j++)
+         {
+              x = comp[j];
+              hx = subIndex[x - first];
+              if (hx < 0 || hx == r)
+                  continue;
+
+              hp = subIndex[gp_GetNeighbor(theEmbedding, parentArc[x - first]) - first];
+              hParent[hx] = hp;
+              hDepth[hx] = hDepth[hp] + 1;
+
+              e = gp_GetFirstArc(H, hx);
+              while (gp_IsArc(e) && gp_GetNeighbor(H, e) != hp)
+                  e = gp_GetNextArc(H, e);
+
+              if (gp_IsArc(e))
+                  isTree[_EdgeId(H, e)] = 1;
+              else Result = NOTOK;
+         }
+     }
+
+     // Triangulate H and list its faces
+     if (Result == OK)
+     {
+         treeM = H->M;
+         if (_Triangulate(H) != OK)
+             Result = NOTOK;
+     }
+
+     if (Result == OK)
+     {
+         M = H->M;
+         if ((arcFaces = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+             (faceOffsets = (int *) malloc((2 * M + 1) * sizeof(int))) == NULL ||
+             (faceArcs = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+             (arcPosition = (int *) malloc(gp_EdgeIndexBound(H) * sizeof(int))) == NULL ||
+             (positionArcs = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+             (numFaces = gp_GetFaces(H, arcFaces, faceOffsets, faceArcs)) <= 0 ||
+             (faceQueue = (int *) malloc(numFaces * sizeof(int))) == NULL ||
+             (faceParent = (int *) malloc(numFaces * sizeof(int))) == NULL ||
+             (faceSize = (int *) malloc(numFaces * sizeof(int))) == NULL ||
+             (insideFace = (char *) malloc(numFaces * sizeof(char))) == NULL ||
+             (edgeChild = (int *) malloc(M * sizeof(int))) == NULL ||
+             (edgeLCA = (int *) malloc(M * sizeof(int))) == NULL ||
+             (isTree = (char *) realloc(isTree, M * sizeof(char))) == NULL)
+             Result = NOTOK;
+         else
+         {
+             // The added edges are not tree edges
+             memset(isTree + treeM, 0, M - treeM);
+             for (id = 0; id < M; id++)
+                  edgeChild[id] = -1;
+             _GetArcPositions(H, arcPosition, positionArcs);
+         }
+     }
+
+     // Search the dual spanning tree of the non-tree edges from a face of r,
+     // then count the faces in the subtree below each non-tree edge
+     if (Result == OK)
+     {
+         for (f = 0; f < numFaces; f++)
+              faceParent[f] = -2;
+
+         f = arcFaces[arcPosition[gp_GetFirstArc(H, r)]];
+         faceParent[f] = -1;
+         faceQueue[0] = f;
+         tail = 1;
+
+         for (head = 0; head < tail; head++)
+         {
+              f = faceQueue[head];
+              for (j = faceOffsets[f]; j < faceOffsets[f+1]; j++)
+              {
+                   a = positionArcs[faceArcs[j]];
+                   id = _EdgeId(H, a);
+                   if (isTree[id])
+                       continue;
+
+                   g = arcFaces[arcPosition[gp_GetTwinArc(H, a)]];
+                   if (faceParent[g] == -2)
+                   {
+                       faceParent[g] = f;
+                       edgeChild[id] = g;
+                       faceQueue[tail++] = g;
+                   }
+              }
+         }
+
+         if (tail != numFaces)
+             Result = NOTOK;
+         else
+         {
+             for (f = 0; f < numFaces; f++)
+                  faceSize[f] = 1;
+             for (head = numFaces - 1; head > 0; head--)
+                  faceSize[faceParent[faceQueue[head]]] += faceSize[faceQueue[head]];
+         }
+     }
+
+     // Find the least common ancestor of the endpoints of each non-tree edge
+     // with Tarjan's offline method, in a depth first search of the tree
+     if (Result == OK)
+     {
+         if ((firstChild = (int *) malloc((first + numH) * sizeof(int))) == NULL ||
+             (nextSibling = (int *) malloc((first + numH) * sizeof(int))) == NULL ||
+             (stack = (int *) malloc(numH * sizeof(int))) == NULL ||
+             (ufParent = (int *) malloc((first + numH) * sizeof(int))) == NULL ||
+             (black = (char *) calloc(first + numH, sizeof(char))) == NULL)
+             Result = NOTOK;
+     }
+
+     if (Result == OK)
+     {
+         for (hx = first; hx < first + numH; hx++)
+         {
+              firstChild[hx] = NIL;
+              ufParent[hx] = hx;
+         }
+
+         for (hx = first; hx < first + numH; hx++)
+              if (hx != r)
+              {
+                  nextSibling[hx] = firstChild[hParent[hx]];
+                  firstChild[hParent[hx]] = hx;
+              }
+
+         stack[0] = r;
+         top = 1;
+         while (top > 0)
+         {
+              u = stack[top-1];
+              if (gp_IsVertex(firstChild[u]))
+              {
+                  // Descend to the next child, which is taken off the list
+                  stack[top++] = firstChild[u];
+                  firstChild[u] = nextSibling[firstChild[u]];
+                  continue;
+              }
+
+              top--;
+              black[u] = 1;
+              e = gp_GetFirstArc(H, u);
+              while (gp_IsArc(e))
+              {
+                  v = gp_GetNeighbor(H, e);
+                  if (!isTree[_EdgeId(H, e)] && black[v])
+                      edgeLCA[_EdgeId(H, e)] = _Find(ufParent, v);
+                  e = gp_GetNextArc(H, e);
+              }
+
+              if (top > 0)
+                  ufParent[u] = stack[top-1];
+         }
+     }
+
+     // Measure the sides of the fundamental cycle of each non-tree edge, and
+     // keep the cycle whose larger side is smallest
+     if (Result == OK)
+     {
+         for (id = 0; id < H->M && Result == OK; id++)
+         {
+              if (isTree[id] || edgeChild[id] < 0)
+                  continue;
+
+              e = gp_GetFirstEdge(H) + 2 * id;
+              u = gp_GetNeighbor(H, gp_GetTwinArc(H, e));
+              v = gp_GetNeighbor(H, e);
+              c = hDepth[u] + hDepth[v] - 2 * hDepth[edgeLCA[id]] + 1;
+              if ((faceSize[edgeChild[id]] - c) % 2 != 0)
+              {
+                  Result = NOTOK;
+                  break;
+              }
+
+              inside = (faceSize[edgeChild[id]] - c + 2) / 2;
+              cycleWeight = c - (edgeLCA[id] == r ? 1 : 0);
+              outside = W - inside - cycleWeight;
+              if (inside < 0 || outside < 0)
+                  Result = NOTOK;
+              else if (best < 0 || (inside > outside ? inside : outside) < bestCost ||
+                       ((inside > outside ? inside : outside) == bestCost && cycleWeight < bestCycle))
+              {
+                  best = id;
+                  bestCost = inside > outside ? inside : outside;
+                  bestCycle = cycleWeight;
+              }
+         }
+
+         if (best < 0)
+             Result = NOTOK;
+     }
+
+     // Place the middle vertices: the faces inside the cycle are the subtree
+     // below the chosen edge, which the queue lists after their parents, and a
+     // vertex not on the cycle is inside exactly if its first face is
+     if (Result == OK)
+     {
+         for (head = 0; head < numFaces; head++)
+         {
+              f = faceQueue[head];
+              insideFace[f] = f == edgeChild[best] || (faceParent[f] >= 0 && insideFace[faceParent[f]]);
+         }
+
+         memset(black, 0, first + numH);
+         e = gp_GetFirstEdge(H) + 2 * best;
+         for (u = gp_GetNeighbor(H, e); u != edgeLCA[best]; u = hParent[u])
+              black[u] = 1;
+         for (u = gp_GetNeighbor(H, gp_GetTwinArc(H, e)); u != edgeLCA[best]; u = hParent[u])
+              black[u] = 1;
+         black[edgeLCA[best]] = 1;
+
+         for (j = 0; j < n; j++)
+         {
+              x = comp[j];
+              hx = subIndex[x - first];
+              if (hx < 0 || hx == r)
+                  continue;
+
+              if (black[hx])
+                  piece[x - first] = -1;
+              else
+                  piece[x - first] = insideFace[arcFaces[arcPosition[gp_GetFirstArc(H, hx)]]] ? base + 1 : base + 2;
+         }
+     }
+
+     gp_Free(&H);
+     free(subIndex);
+     free(rootArcs);
+     free(hParent);
+     free(hDepth);
+     free(firstChild);
+     free(nextSibling);
+     free(stack);
+     free(ufParent);
+     free(edgeLCA);
+     free(edgeChild);
+     free(arcFaces);
+     free(faceOffsets);
+     free(faceArcs);
+     free(arcPosition);
+     free(positionArcs);
+     free(faceQueue);
+     free(faceParent);
+     free(faceSize);
+     free(insideFace);
+     free(isTree);
+     free(black);
+
+     return Result;
+}
+
+/********************************************************************
+ _GetContractedRotation()
+
+ Lists in rootArcs the arcs that leave the levels up to l0 of the
+ component of root, in the order they have around the vertex that
+ results from contracting those levels.  Contracting the tree edges of
+ the breadth first search one at a time splices the rotation of each
+ child into the rotation of its parent at the tree edge, so the order
+ is that of a walk around the tree.  Non-tree edges within the levels
+ become loops and are left out.
+
+ Returns the number of arcs listed, or -1 on error.
+ ********************************************************************/
+
+static int  _GetContractedRotation(graphP theEmbedding, int root, int *level, int l0,
+                                   int *parentArc, int *rootArcs)
+{
+int  first = gp_GetFirstVertex(theEmbedding), numRootArcs = 0, top, e, y;
+int *stopArc = NULL, *nextArc = NULL;
+
+     if ((stopArc = (int *) malloc(theEmbedding->N * sizeof(int))) == NULL ||
+         (nextArc = (int *) malloc(theEmbedding->N * sizeof(int))) == NULL)
+     {
+         free(stopArc);
+         return -1;
+     }
+
+     // The walk goes once through the list of the root, and around the list
+     // of each other vertex from the arc after the one to its parent
+     stopArc[0] = NIL;
+     nextArc[0] = gp_GetFirstArc(theEmbedding, root);
+     top = 1;
+
+     while (top > 0)
+     {
+          e = nextArc[top-1];
+          if (e == stopArc[top-1])
+          {
+              top--;
+              continue;
+          }
+
+          nextArc[top-1] = top == 1 ? gp_GetNextArc(theEmbedding, e) : gp_GetNextArcCircular(theEmbedding, e);
+          y = gp_GetNeighbor(theEmbedding, e);
+
+          if (level[y - first] > l0)
+              rootArcs[numRootArcs++] = e;
+
+          else if (parentArc[y - first] == gp_GetTwinArc(theEmbedding, e))
+          {
+              stopArc[top] = gp_GetTwinArc(theEmbedding, e);
+              nextArc[top] = gp_GetNextArcCircular(theEmbedding, stopArc[top]);
+              top++;
+          }
+     }
+
+     free(stopArc);
+     free(nextArc);
+     return numRootArcs;
+}
+
+/********************************************************************
+ _CreateSubEmbedding()
+
+ Creates a graph with numVertices vertices from the vertices v of
+ theEmbedding that have subIndex[v - first] >= 0, which gives the new
+ vertex.  Vertices may share a new vertex only if it is root, whose
+ arcs are the edges of rootArcs in that order.  Every other new
+ vertex keeps the order of the arcs of its old vertex.  Loops and
+ repeats of an edge between the same new vertices are left out, so
+ the result is simple, and it is an embedding if theEmbedding is.
+
+ Returns the new graph, with room for triangulating it, or NULL on
+ failure.
+ ********************************************************************/
+
+static graphP _CreateSubEmbedding(graphP theEmbedding, int *subIndex, int numVertices,
+                                  int root, int *rootArcs, int numRootArcs)
+{
+int  first = gp_GetFirstVertex(theEmbedding), numEdges = 0;
+int  v, e, j, hv, hw, id, Result = OK;
+char *edgeState = NULL;
+int *seen = NULL, *subArcs = NULL;
+graphP theSub = NULL;
+
+     // The state of each edge is 0 if undecided, 1 if kept, 2 if left out and
+     // 3 if added to the new graph
+     if ((edgeState = (char *) calloc(theEmbedding->arcCapacity / 2 + 1, sizeof(char))) == NULL ||
+         (seen = (int *) malloc((first + numVertices) * sizeof(int))) == NULL ||
+         (subArcs = (int *) malloc(gp_EdgeIndexBound(theEmbedding) * sizeof(int))) == NULL)
+         Result = NOTOK;
+
+     if (Result == OK)
+     {
+         for (hv = 0; hv < first + numVertices; hv++)
+              seen[hv] = NIL;
+
+         for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+         {
+              hv = subIndex[v - first];
+              if (hv < 0 || hv == root)
+                  continue;
+
+              // Note the neighbors already kept from their other endpoint, then
+              // keep the first edge to each other neighbor
+              for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+                   if (edgeState[_EdgeId(theEmbedding, e)] == 1)
+                       seen[subIndex[gp_GetNeighbor(theEmbedding, e) - first]] = v;
+
+              for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+              {
+                   id = _EdgeId(theEmbedding, e);
+                   if (edgeState[id] != 0)
+                       continue;
+
+                   hw = subIndex[gp_GetNeighbor(theEmbedding, e) - first];
+                   if (hw < 0 || hw == hv || seen[hw] == v)
+                       edgeState[id] = 2;
+                   else
+                   {
+                       edgeState[id] = 1;
+                       seen[hw] = v;
+                       numEdges++;
+                   }
+              }
+         }
+     }
+
+     if (Result == OK)
+     {
+         if ((theSub = gp_New()) == NULL ||
+             gp_EnsureArcCapacity(theSub, 2 * (numEdges + 3 * numVertices)) != OK ||
+             gp_InitGraph(theSub, numVertices) != OK)
+             Result = NOTOK;
+     }
+
+     // Add the kept edges, then relink the arcs of each new vertex in order
+     for (v = first; Result == OK && gp_VertexInRange(theEmbedding, v); v++)
+     {
+          hv = subIndex[v - first];
+          if (hv < 0 || hv == root)
+              continue;
+
+          for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e) && Result == OK; e = gp_GetNextArc(theEmbedding, e))
+          {
+               id = _EdgeId(theEmbedding, e);
+               if (edgeState[id] != 1)
+                   continue;
+
+               edgeState[id] = 3;
+               hw = subIndex[gp_GetNeighbor(theEmbedding, e) - first];
+               if (gp_AddEdge(theSub, hw, 0, hv, 0) != OK)
+                   Result = NOTOK;
+               else
+               {
+                   subArcs[e] = gp_GetFirstArc(theSub, hv);
+                   subArcs[gp_GetTwinArc(theEmbedding, e)] = gp_GetTwinArc(theSub, subArcs[e]);
+               }
+          }
+     }
+
+     if (Result == OK)
+     {
+         for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+         {
+              hv = subIndex[v - first];
+              if (hv < 0 || hv == root)
+                  continue;
+
+              gp_SetFirstArc(theSub, hv, NIL);
+              gp_SetLastArc(theSub, hv, NIL);
+              for (e = gp_GetFirstArc(theEmbedding, v); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+                   if (edgeState[_EdgeId(theEmbedding, e)] == 3)
+                       gp_AttachArc(theSub, hv, NIL, 1, subArcs[e]);
+         }
+
+         if (gp_IsVertex(root))
+         {
+             gp_SetFirstArc(theSub, root, NIL);
+             gp_SetLastArc(theSub, root, NIL);
+             for (j = 0; j < numRootArcs; j++)
+                  if (edgeState[_EdgeId(theEmbedding, rootArcs[j])] == 3)
+                      gp_AttachArc(theSub, root, NIL, 1, subArcs[rootArcs[j]]);
+         }
+
+         theSub->embedFlags = theEmbedding->embedFlags;
+     }
+
+     if (Result != OK)
+         gp_Free(&theSub);
+
+     free(edgeState);
+     free(seen);
+     free(subArcs);
+
+     return theSub;
+}
+
+/********************************************************************
+ _Triangulate()
+
+ Adds edges to the connected embedding theGraph until every face has
+ three arcs.  Each face of k > 3 arcs, from vertices v0, v1, ..., is
+ divided by a fan of edges from v0 to v2, ..., v(k-2), inserted into
+ each adjacency list inside the face.  The fan may add a parallel edge
+ or a loop where a vertex occurs more than once on the face, which
+ keeps the embedding and the count of arcs of each face.
+
+ The graph needs arc capacity for 6N edge records.
+ ********************************************************************/
+
+static int  _Triangulate(graphP theGraph)
+{
+int  M = theGraph->M, numFaces, f, k, j, v0, vj, c0, cj, anchor;
+int  Result = OK;
+int *arcFaces = NULL, *faceOffsets = NULL, *faceArcs = NULL, *arcPosition = NULL, *positionArcs = NULL;
+
+     if ((arcFaces = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (faceOffsets = (int *) malloc((2 * M + 1) * sizeof(int))) == NULL ||
+         (faceArcs = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (arcPosition = (int *) malloc(gp_EdgeIndexBound(theGraph) * sizeof(int))) == NULL ||
+         (positionArcs = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (numFaces = gp_GetFaces(theGraph, arcFaces, faceOffsets, faceArcs)) <= 0)
+         Result = NOTOK;
+
+     if (Result == OK)
+         _GetArcPositions(theGraph, arcPosition, positionArcs);
+
+     for (f = 0; f < numFaces && Result == OK; f++)
+     {
+          k = faceOffsets[f+1] - faceOffsets[f];
+
+          // The chord to vj goes after the arc from v0 that ends the face,
+          // and after the arc from vj that enters vj on the face
+          v0 = gp_GetNeighbor(theGraph, gp_GetTwinArc(theGraph, positionArcs[faceArcs[faceOffsets[f]]]));
+          anchor = gp_GetTwinArc(theGraph, positionArcs[faceArcs[faceOffsets[f] + k - 1]]);
+
+          for (j = 2; j <= k - 2 && Result == OK; j++)
+          {
+               vj = gp_GetNeighbor(theGraph, gp_GetTwinArc(theGraph, positionArcs[faceArcs[faceOffsets[f] + j]]));
+               if (gp_AddEdge(theGraph, v0, 0, vj, 0) != OK)
+               {
+                   Result = NOTOK;
+                   break;
+               }
+
+               cj = gp_GetFirstArc(theGraph, vj);
+               c0 = gp_GetTwinArc(theGraph, cj);
+               gp_DetachArc(theGraph, c0);
+               gp_DetachArc(theGraph, cj);
+               gp_AttachArc(theGraph, v0, anchor, 0, c0);
+               gp_AttachArc(theGraph, vj, gp_GetTwinArc(theGraph, positionArcs[faceArcs[faceOffsets[f] + j - 1]]), 0, cj);
+          }
+     }
+
+     free(arcFaces);
+     free(faceOffsets);
+     free(faceArcs);
+     free(arcPosition);
+     free(positionArcs);
+
+     return Result;
+}
+
+/********************************************************************
+ _GetArcPositions()
+
+ Numbers the arcs in the order of gp_GetRotationSystem().
+ ********************************************************************/
+
+static int  _GetArcPositions(graphP theGraph, int *arcPosition, int *positionArcs)
+{
+int  v, e, numArcs = 0;
+
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+          for (e = gp_GetFirstArc(theGraph, v); gp_IsArc(e); e = gp_GetNextArc(theGraph, e))
+          {
+               arcPosition[e] = numArcs;
+               positionArcs[numArcs++] = e;
+          }
+
+     return numArcs;
+}
+
+/********************************************************************
+ _Find()
+
+ Finds the set of x in the union-find forest parent, with path
+ compression.
+ ********************************************************************/
+
+static int  _Find(int *parent, int x)
+{
+int  root = x, next;
+
+     while (parent[root] != root)
+         root = parent[root];
+
+     while (parent[x] != root)
+     {
+         next = parent[x];
+         parent[x] = root;
+         x = next;
+     }
+
+     return root;
+}
+
+/********************************************************************
+ _AssignSides()
+
+ Divides the pieces between the two sides, largest first, each to the
+ side with fewer vertices so far, and sets sides accordingly.
+
+ Returns the number of separator vertices, or -1 on error.
+ ********************************************************************/
+
+static int  _AssignSides(int *piece, int N, int numPieces, int *sides)
+{
+sep_PieceRec *pieces;
+int *pieceSide = NULL, sideWeight[2] = { 0, 0 }, j, s, separatorSize = 0;
+
+     if ((pieces = (sep_PieceRec *) calloc(numPieces, sizeof(sep_PieceRec))) == NULL ||
+         (pieceSide = (int *) malloc(numPieces * sizeof(int))) == NULL)
+     {
+         free(pieces);
+         return -1;
+     }
+
+     for (j = 0; j < numPieces; j++)
+          pieces[j].piece = j;
+
+     for (j = 0; j < N; j++)
+          if (piece[j] >= 0)
+              pieces[piece[j]].weight++;
+
+     qsort(pieces, numPieces, sizeof(sep_PieceRec), _ComparePieces);
+
+     for (j = 0; j < numPieces; j++)
+     {
+          s = sideWeight[1] < sideWeight[0] ? 1 : 0;
+          pieceSide[pieces[j].piece] = s;
+          sideWeight[s] += pieces[j].weight;
+     }
+
+     for (j = 0; j < N; j++)
+     {
+          if (piece[j] < 0)
+          {
+              sides[j] = -1;
+              separatorSize++;
+          }
+          else
+              sides[j] = pieceSide[piece[j]];
+     }
+
+     free(pieces);
+     free(pieceSide);
+
+     return separatorSize;
+}
+
+static int  _ComparePieces(const void *p1, const void *p2)
+{
+const sep_PieceRec *a = (const sep_PieceRec *) p1, *b = (const sep_PieceRec *) p2;
+
+     if (a->weight != b->weight)
+         return a->weight > b->weight ? -1 : 1;
+     return a->piece - b->piece;
+}
+
+/********************************************************************
+ gp_PlanarPartition()
+
+ Partitions the vertices of the embedding in theEmbedding, with the
+ same requirements as gp_PlanarSeparator(), into k parts of about equal
+ size by recursive separation.  The separator vertices of each step go
+ to the smaller side, then the first side is given k/2 of the parts and
+ vertices are moved across the boundary until it holds k/2 of every k
+ vertices, so each part has N/k vertices to within rounding.  The part
+ of each side is an embedding, so it is separated without embedding it
+ again.  The parts have O(sqrt(N)) boundary vertices per step, plus
+ those of the moved layers, and the total time is O((N+M) log k).
+
+ parts must have room for N entries, and parts[i] receives the part,
+ from 0 to k-1, of the zero-based vertex i.  If k > N, some parts are
+ empty.
+
+ Returns OK on success, NOTOK on failure.
+ ********************************************************************/
+
+int  gp_PlanarPartition(graphP theEmbedding, int k, int *parts)
+{
+int  j, *vertexIds, Result;
+
+     if (theEmbedding == NULL || parts == NULL || k < 1 || theEmbedding->N <= 0 ||
+         theEmbedding->embedFlags == 0 ||
+         (theEmbedding->internalFlags & FLAGS_OBSTRUCTIONFOUND))
+         return NOTOK;
+
+     if ((vertexIds = (int *) malloc(theEmbedding->N * sizeof(int))) == NULL)
+         return NOTOK;
+
+     for (j = 0; j < theEmbedding->N; j++)
+          vertexIds[j] = j;
+
+     Result = _PartitionEmbedding(theEmbedding, k, 0, vertexIds, parts);
+
+     free(vertexIds);
+     return Result;
+}
+
+/********************************************************************
+ _PartitionEmbedding()
+
+ Assigns the parts partBase to partBase+k-1 to the vertices of
+ theEmbedding, whose zero-based vertex i is vertexIds[i] in the
+ partitioned graph.
+ ********************************************************************/
+
+static int  _PartitionEmbedding(graphP theEmbedding, int k, int partBase, int *vertexIds, int *parts)
+{
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding);
+int  j, s, kA, size[2] = { 0, 0 }, Result = OK;
+int *sides = NULL, *subIndex = NULL, *subIds = NULL;
+graphP theSide;
+
+     if (k == 1 || N == 1)
+     {
+         for (j = 0; j < N; j++)
+              parts[vertexIds[j]] = partBase;
+         return OK;
+     }
+
+     if ((sides = (int *) malloc(N * sizeof(int))) == NULL ||
+         (subIndex = (int *) malloc(N * sizeof(int))) == NULL ||
+         (subIds = (int *) malloc(N * sizeof(int))) == NULL ||
+         gp_PlanarSeparator(theEmbedding, sides) < 0)
+         Result = NOTOK;
+
+     if (Result == OK)
+     {
+         for (j = 0; j < N; j++)
+              if (sides[j] >= 0)
+                  size[sides[j]]++;
+
+         for (j = 0; j < N; j++)
+              if (sides[j] < 0)
+              {
+                  sides[j] = size[1] < size[0] ? 1 : 0;
+                  size[sides[j]]++;
+              }
+
+         // A separator can leave up to two thirds of the vertices on one
+         // side, so dividing the parts in proportion to the side sizes
+         // could double the size of a part at each level
+         kA = k / 2;
+         _BalanceSides(theEmbedding, sides, size, (int) ((long) N * kA / k), subIndex);
+     }
+
+     for (s = 0; s < 2 && Result == OK; s++)
+     {
+          size[s] = 0;
+          for (j = 0; j < N; j++)
+               if (sides[j] == s)
+               {
+                   subIds[size[s]] = vertexIds[j];
+                   subIndex[j] = first + size[s]++;
+               }
+               else subIndex[j] = -1;
+
+          // With fewer vertices than parts, a side can be left empty
+          if (size[s] == 0)
+              continue;
+
+          if ((theSide = _CreateSubEmbedding(theEmbedding, subIndex, size[s], NIL, NULL, 0)) == NULL)
+              Result = NOTOK;
+          else
+          {
+              Result = _PartitionEmbedding(theSide, s == 0 ? kA : k - kA,
+                                           s == 0 ? partBase : partBase + kA, subIds, parts);
+              gp_Free(&theSide);
+          }
+     }
+
+     free(sides);
+     free(subIndex);
+     free(subIds);
+
+     return Result;
+}
+
+/********************************************************************
+ _BalanceSides()
+
+ Moves vertices between the sides 0 and 1 given by sides, whose sizes
+ are in size, until side 0 has target vertices.  The vertices leave
+ the larger side in breadth first order from the boundary, so the moved
+ vertices are layers along it, and a new search starts from any vertex
+ left on that side if the boundary runs out, as in a graph with more
+ than one connected component.  queue needs room for N entries.
+ ********************************************************************/
+
+static void _BalanceSides(graphP theEmbedding, int *sides, int *size, int target, int *queue)
+{
+int  N = theEmbedding->N, first = gp_GetFirstVertex(theEmbedding);
+int  from = size[0] > target ? 0 : 1, excess, head = 0, tail = 0, j, v, u, e;
+
+     excess = size[from] - (from == 0 ? target : N - target);
+     if (excess <= 0)
+         return;
+
+     // A queued vertex is marked as side 2 until it is moved
+     for (j = 0; j < N; j++)
+     {
+          if (sides[j] != from)
+              continue;
+
+          e = gp_GetFirstArc(theEmbedding, first + j);
+          while (gp_IsArc(e) && sides[gp_GetNeighbor(theEmbedding, e) - first] != 1 - from)
+              e = gp_GetNextArc(theEmbedding, e);
+
+          if (gp_IsArc(e))
+          {
+              sides[j] = 2;
+              queue[tail++] = j;
+          }
+     }
+
+     for (j = 0; excess > 0; )
+     {
+          if (head == tail)
+          {
+              while (sides[j] != from)
+                  j++;
+              sides[j] = 2;
+              queue[tail++] = j;
+          }
+
+          v = queue[head++];
+          sides[v] = 1 - from;
+          excess--;
+
+          e = gp_GetFirstArc(theEmbedding, first + v);
+          while (gp_IsArc(e))
+          {
+              u = gp_GetNeighbor(theEmbedding, e) - first;
+              if (sides[u] == from)
+              {
+                  sides[u] = 2;
+                  queue[tail++] = u;
+              }
+              e = gp_GetNextArc(theEmbedding, e);
+          }
+     }
+
+     while (head < tail)
+          sides[queue[head++]] = from;
+
+     size[0] = target;
+     size[1] = N - target;
+}
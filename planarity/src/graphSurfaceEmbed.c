@@ -0,0 +1,1933 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "graphSurfaceEmbed.private.h"
+#include "graphSurfaceEmbed.h"
+
+/********************************************************************
+ Projective plane and torus embedding
+
+ With EMBEDFLAGS_PROJECTIVEPLANAR or EMBEDFLAGS_TOROIDAL, gp_Embed()
+ decides whether the graph embeds on the projective plane or on the
+ torus, whose Euler characteristics are 1 and 0.  A planar graph
+ embeds on both, so the core planarity algorithm is run first on a
+ copy of the graph.  Otherwise, since Euler genus and orientable genus
+ are additive over biconnected components, the graph embeds if and
+ only if exactly one of its blocks is nonplanar and that block embeds.
+ The rest of the graph is then embedded in the plane, and each of its
+ connected components is attached in a corner of the one vertex it
+ shares with the nonplanar block, if any.
+
+ In the nonplanar block B, the core planarity algorithm isolates a
+ subgraph K homeomorphic to K5 or K3,3, which is done by
+ _IsolateKuratowskiSubgraph() on a copy of B.  K is not planar, so
+ each face of any embedding of K on either surface is a disk, and so
+ is each face of an embedding of a subgraph H of B that contains K.
+ The embeddings of K are enumerated as rotation systems of its branch
+ vertices, with signatures on the edges outside a spanning tree for
+ the projective plane, keeping those whose faces give the Euler
+ characteristic of the surface.  The rotation of the first branch
+ vertex is restricted to skip the mirror image of each embedding.
+
+ Each embedding of K is extended to B one path at a time.  A bridge
+ of H is an edge of B - H with both ends in H, or a connected
+ component of B - V(H) with its edges to H.  In an embedding of B,
+ each bridge lies in a face of H whose boundary contains all of its
+ attachments in H, so a bridge with no such admissible face fails the
+ branch.  Otherwise a path through the bridge between two of its
+ attachments is embedded across an admissible face, splitting it in
+ two.  A placement of the path is a pair of corners of its end
+ vertices in an admissible face, and the path with fewest placements
+ is embedded next.  A path with one placement is forced, and the
+ search only branches when no path is forced.  Before it does, the
+ bridges confined to one face whose boundary is a simple cycle are
+ tested together for planarity with the cycle and an apex vertex
+ joined to all of its vertices, which fails if they cannot share the
+ disk, and that prunes the branch without trying its placements.
+
+ The search is exact.  Its worst case is exponential, but the forced
+ paths leave little to branch on in practice.  The library creates no
+ threads, so each search runs in the thread of its gp_Embed() call.
+
+ On success, theGraph holds the embedding as a rotation system: the
+ adjacency list of each vertex gives its rotation, and the arcs of an
+ edge carry EDGEFLAG_INVERTED if the edge is twisted, i.e. if a face
+ walk that crosses it continues around the next vertex in the
+ opposite direction.  Only the projective plane has twisted edges.
+ On failure, theGraph keeps all of its edges, since the obstructions
+ to these surfaces are too numerous to isolate one.  Either way,
+ theGraph is left sorted by DFI, as after core planarity.
+ ********************************************************************/
+
+// A biconnected component, with its vertices and edges numbered from
+// zero.  Arc a = 2e+s of edge e leaves vertex ends[a] and enters vertex
+// ends[a^1], and the arcs leaving vertex v are adjArc[adjStart[v]] to
+// adjArc[adjStart[v+1]-1].
+typedef struct
+{
+     int  N, M, eulerChar;
+     int *ends, *adjStart, *adjArc;
+
+     // The vertex and edge of the graph for each vertex and edge of the
+     // block, and the edges of the Kuratowski subgraph K
+     int *verts, *edgeIds, *inK;
+
+     // The bridges of H: the bridge of each vertex and edge not in H, an
+     // edge of each bridge, and the attachments of bridge i in
+     // atts[attStart[i]] to atts[attStart[i+1]-1]
+     int  numBridges;
+     int *compOf, *bridgeOf, *repEdge, *attStart, *atts;
+
+     // The faces of H at each vertex, in increasing order, with the number
+     // of corners the vertex has in each
+     int *vfStart, *vfFace, *vfCount;
+
+     // The number of admissible faces of each bridge, and the first one
+     int *admCount, *admFace;
+
+     // The next path to embed, and scratch space for searches
+     int *path, *queue, *parentArc, *localOf, *stamp;
+     int  pathLen, stampValue;
+} se_Block;
+
+// An embedding of H.  Each edge e of H has sides 2e and 2e+1, each of
+// which is traversed by one face walk, along arc sideArc[s], and next[s]
+// is the side that the face walk traverses next.  faceSide[f] is a side
+// of face f.  All of it lies in data, so that it is copied in one step.
+typedef struct
+{
+     int  numFaces, size;
+     int *data, *sideArc, *next, *faceOf, *faceSide, *edgeIn, *vertIn;
+} se_State;
+
+// The branch graph of K.  Branch arc x = 2p+d runs along path p of K
+// starting from end d, and the arcs of path p, from end 0 to end 1, are
+// pathArcs[pathStart[p]] to pathArcs[pathStart[p+1]-1].  The branch arcs
+// leaving branch vertex i are arcs[i][0] to arcs[i][degree[i]-1].
+typedef struct
+{
+     int  numVerts, numPaths;
+     int  degree[6], arcs[6][4], tail[20], pathStart[11];
+     int  rotNext[20], rotPrev[20], twisted[10], inTree[10];
+     int *pathArcs;
+} se_Kuratowski;
+
+// In a graph made by _SE_NewGraph(), edge record gp_GetFirstEdge()+2k
+// holds the arc of edge k that leaves its second vertex
+#define _SE_ArcOfRecord(theGraph, e) (((e) - gp_GetFirstEdge(theGraph)) ^ 1)
+
+/* Private functions */
+
+static int  _SE_GetEdges(graphP theGraph, int *edges, int *records);
+static int  _SE_NewGraph(int N, int M, int *edges, int *edgeIds, graphP *pGraph);
+static int  _SE_EmbedPlanar(int N, int M, int *edges, int *edgeIds, int *pos, int *rotation);
+static int  _SE_GetBlocks(int N, int M, int *edges, int *blockOf);
+static int  _SE_EmbedGraph(int N, int M, int *edges, int eulerChar,
+                           int *rotStart, int *rotation, int *twisted);
+
+static int  _SE_InitBlock(se_Block *b, int N, int M, int eulerChar);
+static int  _SE_IsolateKuratowski(se_Block *b);
+static int  _SE_ExceedsEulerBound(se_Block *b);
+static int  _SE_EmbedBlock(se_Block *b, int *rotation, int *twisted);
+static int  _SE_InitState(se_State *st, int N, int M);
+static void _SE_CopyState(se_State *dst, se_State *src);
+
+static int  _SE_GetBranchGraph(se_Block *b, se_Kuratowski *k);
+static int  _SE_TraceBranchFaces(se_Kuratowski *k, se_State *st);
+static int  _SE_EmbedKuratowski(se_Block *b, se_State *st);
+
+static int  _SE_Extend(se_Block *b, se_State *st);
+static void _SE_GetBridges(se_Block *b, se_State *st);
+static void _SE_IndexFaces(se_Block *b, se_State *st);
+static int  _SE_GetCorners(se_Block *b, int v, int f);
+static int  _SE_FindPath(se_Block *b, se_State *st, int i);
+static int  _SE_GetPlacements(se_Block *b, se_State *st, int i, int *pNumPlacements, int *placements);
+static int  _SE_ChooseBridge(se_Block *b, se_State *st, int *pBridge, int *pNumPlacements);
+static int  _SE_TestResidues(se_Block *b, se_State *st);
+static void _SE_AddPath(se_Block *b, se_State *st, int *path, int len, int sa, int sw);
+static int  _SE_GetRotation(se_Block *b, se_State *st, int *rotation, int *twisted);
+
+/********************************************************************
+ _SurfaceEmbed_Embed()
+
+ Runs the search on the edges of theGraph, which has not been touched
+ by the embedder yet, and stores the embedding in theGraph if there is
+ one.  The graph is then sorted by DFI, leaving nothing for the main
+ loop of gp_Embed() to do.
+
+ Returns OK with the result in context->embedResult, or NOTOK on error,
+ which includes a graph with a loop.
+ ********************************************************************/
+
+int  _SurfaceEmbed_Embed(graphP theGraph, SurfaceEmbedContext *context)
+{
+int  N = theGraph->N, M = theGraph->M, first = gp_GetFirstVertex(theGraph);
+int  *edges, *records, *twisted, *rotStart, *rotation;
+int  v, k, a, e, ePrev, eulerChar, RetVal;
+
+     eulerChar = theGraph->embedFlags == EMBEDFLAGS_TOROIDAL ? 0 : 1;
+
+     edges = (int *) malloc((6*M + N + 2)*sizeof(int));
+     if (edges == NULL)
+         return NOTOK;
+
+     records = edges + 2*M;
+     twisted = records + M;
+     rotation = twisted + M;
+     rotStart = rotation + 2*M;
+
+     if (_SE_GetEdges(theGraph, edges, records) != M)
+         RetVal = NOTOK;
+     else
+         RetVal = _SE_EmbedGraph(N, M, edges, eulerChar, rotStart, rotation, twisted);
+
+     // Relink each adjacency list in the order of the rotation, and mark
+     // the twisted edges
+     if (RetVal == OK)
+     {
+         for (v = 0; v < N; v++)
+         {
+              ePrev = NIL;
+              for (k = rotStart[v]; k < rotStart[v+1]; k++)
+              {
+                   a = rotation[k];
+                   e = (a & 1) ? gp_GetTwinArc(theGraph, records[a >> 1]) : records[a >> 1];
+
+                   gp_SetPrevArc(theGraph, e, ePrev);
+                   if (gp_IsArc(ePrev))
+                       gp_SetNextArc(theGraph, ePrev, e);
+                   else
+                       gp_SetFirstArc(theGraph, first + v, e);
+                   ePrev = e;
+              }
+              if (gp_IsArc(ePrev))
+                  gp_SetNextArc(theGraph, ePrev, NIL);
+              gp_SetLastArc(theGraph, first + v, ePrev);
+         }
+
+         for (k = 0; k < M; k++)
+         {
+              e = records[k];
+              if (twisted[k])
+              {
+                  gp_SetEdgeFlagInverted(theGraph, e);
+                  gp_SetEdgeFlagInverted(theGraph, gp_GetTwinArc(theGraph, e));
+              }
+              else
+              {
+                  gp_ClearEdgeFlagInverted(theGraph, e);
+                  gp_ClearEdgeFlagInverted(theGraph, gp_GetTwinArc(theGraph, e));
+              }
+         }
+     }
+
+     free(edges);
+
+     if (RetVal == NOTOK)
+         return NOTOK;
+
+     context->embedResult = RetVal;
+
+     if (gp_CreateDFSTree(theGraph) != OK || gp_SortVertices(theGraph) != OK)
+         return NOTOK;
+
+     return OK;
+}
+
+/********************************************************************
+ _SurfaceEmbed_CheckFacialIntegrity()
+
+ Walks the faces of the rotation system in theGraph, switching the
+ direction around the vertices after each twisted edge, and checks
+ that the Euler genus is at most two, with no twisted edges, for the
+ torus, or at most one for the projective plane.  The Euler genus of
+ each connected component is 2 - N + M - F, and the Euler genera of
+ the components add up.
+
+ Returns OK if the embedding is on the surface, NOTOK otherwise.
+ ********************************************************************/
+
+int  _SurfaceEmbed_CheckFacialIntegrity(graphP theGraph)
+{
+char *visited;
+int  EsizeOccupied, v, e, eStart, d, dStart, t, numFaces = 0, numTwisted = 0;
+int  components = 0, eulerGenus;
+
+     EsizeOccupied = gp_EdgeInUseIndexBound(theGraph);
+     visited = (char *) calloc(2*EsizeOccupied, sizeof(char));
+     if (visited == NULL)
+         return NOTOK;
+
+     for (eStart = gp_GetFirstEdge(theGraph); eStart < EsizeOccupied; eStart++)
+     {
+          if (!gp_EdgeInUse(theGraph, eStart))
+              continue;
+
+          if (gp_GetEdgeFlagInverted(theGraph, eStart))
+              numTwisted++;
+
+          // Each state of the walk is an arc with a direction around its
+          // vertices, and the reverse of the walk is the same face
+          for (dStart = 0; dStart < 2; dStart++)
+          {
+               if (visited[2*eStart + dStart])
+                   continue;
+
+               e = eStart;
+               d = dStart;
+               do {
+                   t = gp_GetEdgeFlagInverted(theGraph, e) ? 1 : 0;
+                   visited[2*e + d] = 1;
+                   visited[2*gp_GetTwinArc(theGraph, e) + (1 ^ d ^ t)] = 1;
+
+                   d ^= t;
+                   e = gp_GetTwinArc(theGraph, e);
+                   e = d == 0 ? gp_GetNextArcCircular(theGraph, e)
+                              : gp_GetPrevArcCircular(theGraph, e);
+               } while (e != eStart || d != dStart);
+
+               numFaces++;
+          }
+     }
+
+     free(visited);
+
+     // An isolated vertex is a component with one face
+     for (v = gp_GetFirstVertex(theGraph); gp_VertexInRange(theGraph, v); v++)
+     {
+          if (gp_IsDFSTreeRoot(theGraph, v))
+          {
+              components++;
+              if (gp_GetVertexDegree(theGraph, v) == 0)
+                  numFaces++;
+          }
+     }
+
+     eulerGenus = 2*components - theGraph->N + theGraph->M - numFaces;
+
+     if (theGraph->embedFlags == EMBEDFLAGS_TOROIDAL)
+         return numTwisted == 0 && eulerGenus >= 0 && eulerGenus <= 2 ? OK : NOTOK;
+
+     return eulerGenus >= 0 && eulerGenus <= 1 ? OK : NOTOK;
+}
+
+/********************************************************************
+ _SE_GetEdges()
+
+ Lists the edges of theGraph as pairs of zero-based vertices, the
+ lesser one first, along with the edge record of the arc that leaves
+ the lesser vertex.
+
+ Returns the number of edges listed, or -1 if there is a loop.
+ ********************************************************************/
+
+static int  _SE_GetEdges(graphP theGraph, int *edges, int *records)
+{
+int  v, w, e, first = gp_GetFirstVertex(theGraph), numEdges = 0;
+
+     for (v = first; gp_VertexInRange(theGraph, v); v++)
+     {
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              w = gp_GetNeighbor(theGraph, e);
+              if (w == v)
+                  return -1;
+
+              if (w > v)
+              {
+                  if (numEdges >= theGraph->M)
+                      return -1;
+
+                  edges[2*numEdges] = v - first;
+                  edges[2*numEdges+1] = w - first;
+                  records[numEdges++] = e;
+              }
+              e = gp_GetNextArc(theGraph, e);
+          }
+     }
+
+     return numEdges;
+}
+
+/********************************************************************
+ _SE_NewGraph()
+
+ Makes a graph on N vertices whose k-th edge record is the edge joining
+ zero-based vertices edges[2j] and edges[2j+1], where j is edgeIds[k],
+ or k if edgeIds is NULL.
+ ********************************************************************/
+
+static int  _SE_NewGraph(int N, int M, int *edges, int *edgeIds, graphP *pGraph)
+{
+graphP theGraph;
+int  k, j, first;
+
+     if ((theGraph = gp_New()) == NULL)
+         return NOTOK;
+
+     if ((M > 0 && gp_EnsureArcCapacity(theGraph, 2*M) != OK) ||
+         gp_InitGraph(theGraph, N) != OK)
+     {
+         gp_Free(&theGraph);
+         return NOTOK;
+     }
+
+     first = gp_GetFirstVertex(theGraph);
+     for (k = 0; k < M; k++)
+     {
+          j = edgeIds == NULL ? k : edgeIds[k];
+          if (gp_AddEdge(theGraph, first + edges[2*j], 0, first + edges[2*j+1], 0) != OK)
+          {
+              gp_Free(&theGraph);
+              return NOTOK;
+          }
+     }
+
+     *pGraph = theGraph;
+     return OK;
+}
+
+/********************************************************************
+ _SE_EmbedPlanar()
+
+ Embeds the M edges given by edgeIds, or all M edges if it is NULL, in
+ the plane.  If they are planar, then the arcs leaving each vertex v,
+ numbered as arcs of edges, are appended to rotation at pos[v] in the
+ order of the rotation of v, and pos[v] is advanced.
+
+ Returns OK, NONEMBEDDABLE or NOTOK.
+ ********************************************************************/
+
+static int  _SE_EmbedPlanar(int N, int M, int *edges, int *edgeIds, int *pos, int *rotation)
+{
+graphP theGraph = NULL;
+int  v, e, a, first, RetVal;
+
+     if (M == 0)
+         return OK;
+
+     if (_SE_NewGraph(N, M, edges, edgeIds, &theGraph) != OK)
+         return NOTOK;
+
+     RetVal = gp_Embed(theGraph, EMBEDFLAGS_PLANAR);
+
+     if (RetVal == OK && gp_SortVertices(theGraph) != OK)
+         RetVal = NOTOK;
+
+     if (RetVal == OK)
+     {
+         first = gp_GetFirstVertex(theGraph);
+         for (v = first; gp_VertexInRange(theGraph, v); v++)
+         {
+              e = gp_GetFirstArc(theGraph, v);
+              while (gp_IsArc(e))
+              {
+                  a = _SE_ArcOfRecord(theGraph, e);
+                  if (edgeIds != NULL)
+                      a = 2*edgeIds[a >> 1] + (a & 1);
+                  rotation[pos[v - first]++] = a;
+                  e = gp_GetNextArc(theGraph, e);
+              }
+         }
+     }
+
+     gp_Free(&theGraph);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_GetBlocks()
+
+ Numbers the biconnected components of the graph with an iterative
+ depth first search that stacks the edges, and stores the block of
+ each edge in blockOf.
+
+ Returns the number of blocks, or -1 on error.
+ ********************************************************************/
+
+static int  _SE_GetBlocks(int N, int M, int *edges, int *blockOf)
+{
+int  *adjStart, *adjEdge, *disc, *low, *parentEdge, *next, *vStack, *eStack;
+int  r, v, w, p, e, k, t = 0, vTop, eTop = 0, numBlocks = 0;
+
+     adjStart = (int *) calloc(6*N + 1 + 3*M, sizeof(int));
+     if (adjStart == NULL)
+         return -1;
+
+     disc = adjStart + N + 1;
+     low = disc + N;
+     parentEdge = low + N;
+     next = parentEdge + N;
+     vStack = next + N;
+     eStack = vStack + N;
+     adjEdge = eStack + M;
+
+     // The edges at each vertex, by counting sort
+     for (e = 0; e < M; e++)
+     {
+          adjStart[edges[2*e] + 1]++;
+          adjStart[edges[2*e+1] + 1]++;
+     }
+     for (v = 0; v < N; v++)
+     {
+          adjStart[v+1] += adjStart[v];
+          next[v] = adjStart[v];
+          disc[v] = -1;
+     }
+     for (e = 0; e < M; e++)
+     {
+          adjEdge[next[edges[2*e]]++] = e;
+          adjEdge[next[edges[2*e+1]]++] = e;
+     }
+     for (v = 0; v < N; v++)
+          next[v] = adjStart[v];
+
+     for (r = 0; r < N; r++)
+     {
+          if (disc[r] != -1)
+              continue;
+
+          disc[r] = low[r] = t++;
+          parentEdge[r] = -1;
+          vTop = 0;
+          vStack[vTop++] = r;
+
+          while (vTop > 0)
+          {
+              v = vStack[vTop-1];
+              if (next[v] < adjStart[v+1])
+              {
+                  e = adjEdge[next[v]++];
+                  if (e == parentEdge[v])
+                      continue;
+
+                  w = edges[2*e] == v ? edges[2*e+1] : edges[2*e];
+                  if (disc[w] == -1)
+                  {
+                      eStack[eTop++] = e;
+                      parentEdge[w] = e;
+                      disc[w] = low[w] = t++;
+                      vStack[vTop++] = w;
+                  }
+                  else if (disc[w] < disc[v])
+                  {
+                      eStack[eTop++] = e;
+                      if (disc[w] < low[v])
+                          low[v] = disc[w];
+                  }
+                  continue;
+              }
+
+              vTop--;
+              if (parentEdge[v] == -1)
+                  continue;
+
+              p = vStack[vTop-1];
+              if (low[v] < low[p])
+                  low[p] = low[v];
+
+              // The edges stacked since the tree edge into v form a block
+              if (low[v] >= disc[p])
+              {
+                  do {
+                      k = eStack[--eTop];
+                      blockOf[k] = numBlocks;
+                  } while (k != parentEdge[v]);
+                  numBlocks++;
+              }
+          }
+     }
+
+     free(adjStart);
+     return numBlocks;
+}
+
+/********************************************************************
+ _SE_EmbedGraph()
+
+ Embeds the graph given by its M edges on the surface of the given
+ Euler characteristic.  On success, the arcs leaving zero-based vertex
+ v are rotation[rotStart[v]] to rotation[rotStart[v+1]-1], in rotation
+ order, where arc 2k+s of edge k leaves vertex edges[2k+s], and
+ twisted[k] tells whether edge k is twisted.
+
+ Returns OK, NONEMBEDDABLE or NOTOK.
+ ********************************************************************/
+
+static int  _SE_EmbedGraph(int N, int M, int *edges, int eulerChar,
+                           int *rotStart, int *rotation, int *twisted)
+{
+se_Block blocks[2], *b = NULL, *test;
+int  *blockOf, *order, *pos, *localOf, *blockRot, *blockTwist, *restIds;
+int  v, k, j, i, a, numBlocks, numRest, RetVal;
+
+     memset(blocks, 0, sizeof(blocks));
+
+     blockOf = (int *) malloc((6*M + 2*N + 2)*sizeof(int));
+     if (blockOf == NULL)
+         return NOTOK;
+
+     order = blockOf + M;
+     blockRot = order + M;
+     blockTwist = blockRot + 2*M;
+     restIds = blockTwist + M;
+     pos = restIds + M;
+     localOf = pos + N + 1;
+
+     // The rotation of each vertex starts at its degree prefix
+     for (v = 0; v <= N; v++)
+          rotStart[v] = 0;
+     for (k = 0; k < M; k++)
+     {
+          twisted[k] = 0;
+          rotStart[edges[2*k] + 1]++;
+          rotStart[edges[2*k+1] + 1]++;
+     }
+     for (v = 0; v < N; v++)
+     {
+          rotStart[v+1] += rotStart[v];
+          pos[v] = rotStart[v];
+     }
+
+     // A planar graph has a planar embedding
+     if ((RetVal = _SE_EmbedPlanar(N, M, edges, NULL, pos, rotation)) != NONEMBEDDABLE)
+     {
+         free(blockOf);
+         return RetVal;
+     }
+
+     if ((numBlocks = _SE_GetBlocks(N, M, edges, blockOf)) < 0)
+     {
+         free(blockOf);
+         return NOTOK;
+     }
+
+     // Group the edges by block, reusing pos for the counting sort, since
+     // there are fewer blocks than vertices
+     for (i = 0; i <= numBlocks; i++)
+          pos[i] = 0;
+     for (k = 0; k < M; k++)
+          pos[blockOf[k] + 1]++;
+     for (i = 0; i < numBlocks; i++)
+          pos[i+1] += pos[i];
+     for (k = 0; k < M; k++)
+          order[pos[blockOf[k]]++] = k;
+     for (i = numBlocks; i > 0; i--)
+          pos[i] = pos[i-1];
+     pos[0] = 0;
+
+     // Find the nonplanar blocks, which have at least nine edges.  The
+     // first one is kept in blocks[0], and a second one means failure.
+     for (v = 0; v < N; v++)
+          localOf[v] = -1;
+
+     RetVal = OK;
+     for (i = 0; i < numBlocks && RetVal == OK; i++)
+     {
+          int  blockM = pos[i+1] - pos[i], blockN = 0;
+
+          if (blockM < 9)
+              continue;
+
+          // Number the block vertices
+          for (j = 0; j < blockM; j++)
+          {
+               k = order[pos[i] + j];
+               if (localOf[edges[2*k]] == -1)
+                   localOf[edges[2*k]] = blockN++;
+               if (localOf[edges[2*k+1]] == -1)
+                   localOf[edges[2*k+1]] = blockN++;
+          }
+
+          test = b == NULL ? &blocks[0] : &blocks[1];
+          if (_SE_InitBlock(test, blockN, blockM, eulerChar) != OK)
+              RetVal = NOTOK;
+          else
+          {
+              for (j = 0; j < blockM; j++)
+              {
+                   k = order[pos[i] + j];
+                   test->edgeIds[j] = k;
+                   test->ends[2*j] = localOf[edges[2*k]];
+                   test->ends[2*j+1] = localOf[edges[2*k+1]];
+                   test->verts[test->ends[2*j]] = edges[2*k];
+                   test->verts[test->ends[2*j+1]] = edges[2*k+1];
+              }
+
+              if ((RetVal = _SE_IsolateKuratowski(test)) == NONEMBEDDABLE)
+                  RetVal = b == NULL ? OK : NONEMBEDDABLE;
+              else if (RetVal == OK)
+              {
+                  free(test->ends);
+                  memset(test, 0, sizeof(se_Block));
+                  test = NULL;
+              }
+              if (RetVal == OK && test != NULL)
+                  b = test;
+          }
+
+          for (j = 0; j < blockM; j++)
+          {
+               k = order[pos[i] + j];
+               localOf[edges[2*k]] = localOf[edges[2*k+1]] = -1;
+          }
+     }
+
+     if (RetVal == OK && b == NULL)
+         RetVal = NOTOK;
+
+     if (RetVal == OK && _SE_ExceedsEulerBound(b))
+         RetVal = NONEMBEDDABLE;
+
+     if (RetVal == OK)
+         RetVal = _SE_EmbedBlock(b, blockRot, blockTwist);
+
+     // The rotation of each vertex in the block comes first, and the edges
+     // outside the block are embedded in the plane and appended to it
+     if (RetVal == OK)
+     {
+         for (v = 0; v < N; v++)
+              pos[v] = rotStart[v];
+
+         for (v = 0; v < b->N; v++)
+         {
+              for (j = b->adjStart[v]; j < b->adjStart[v+1]; j++)
+              {
+                   a = blockRot[j];
+                   rotation[pos[b->verts[v]]++] = 2*b->edgeIds[a >> 1] + (a & 1);
+              }
+         }
+         for (j = 0; j < b->M; j++)
+              twisted[b->edgeIds[j]] = blockTwist[j];
+
+         for (k = 0; k < M; k++)
+              blockOf[k] = 0;
+         for (j = 0; j < b->M; j++)
+              blockOf[b->edgeIds[j]] = 1;
+         for (numRest = k = 0; k < M; k++)
+         {
+              if (!blockOf[k])
+                  restIds[numRest++] = k;
+         }
+
+         if ((RetVal = _SE_EmbedPlanar(N, numRest, edges, restIds, pos, rotation)) != OK)
+             RetVal = NOTOK;
+     }
+
+     free(blocks[0].ends);
+     free(blocks[1].ends);
+     free(blockOf);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_InitBlock()
+
+ Allocates the arrays of a block of N vertices and M edges in one
+ block, which is freed with b->ends.  The caller fills in ends, verts
+ and edgeIds, and the arcs are indexed by _SE_IsolateKuratowski().
+ ********************************************************************/
+
+static int  _SE_InitBlock(se_Block *b, int N, int M, int eulerChar)
+{
+     b->N = N;
+     b->M = M;
+     b->eulerChar = eulerChar;
+     b->stampValue = 0;
+     b->numBridges = 0;
+
+     b->ends = (int *) calloc(18*M + 10*N + 8, sizeof(int));
+     if (b->ends == NULL)
+         return NOTOK;
+
+     b->adjStart = b->ends + 2*M;
+     b->adjArc = b->adjStart + N + 1;
+     b->verts = b->adjArc + 2*M;
+     b->edgeIds = b->verts + N;
+     b->inK = b->edgeIds + M;
+     b->compOf = b->inK + M;
+     b->bridgeOf = b->compOf + N;
+     b->repEdge = b->bridgeOf + M;
+     b->attStart = b->repEdge + M;
+     b->atts = b->attStart + M + 1;
+     b->vfStart = b->atts + 2*M;
+     b->vfFace = b->vfStart + N + 1;
+     b->vfCount = b->vfFace + 2*M;
+     b->admCount = b->vfCount + 2*M;
+     b->admFace = b->admCount + M;
+     b->path = b->admFace + M;
+     b->queue = b->path + N + 1;
+     b->parentArc = b->queue + N;
+     b->localOf = b->parentArc + N;
+     b->stamp = b->localOf + N;
+
+     return OK;
+}
+
+/********************************************************************
+ _SE_IsolateKuratowski()
+
+ Indexes the arcs of the block and runs the core planarity algorithm
+ on a copy of it.  If the block is not planar, the edges of the
+ Kuratowski subgraph that the core isolator leaves are marked in inK.
+
+ Returns OK if the block is planar, NONEMBEDDABLE if not, or NOTOK.
+ ********************************************************************/
+
+static int  _SE_IsolateKuratowski(se_Block *b)
+{
+graphP theGraph = NULL;
+int  v, a, e, first, RetVal;
+
+     for (a = 0; a < 2*b->M; a++)
+          b->adjStart[b->ends[a] + 1]++;
+     for (v = 0; v < b->N; v++)
+     {
+          b->adjStart[v+1] += b->adjStart[v];
+          b->queue[v] = b->adjStart[v];
+     }
+     for (a = 0; a < 2*b->M; a++)
+          b->adjArc[b->queue[b->ends[a]]++] = a;
+
+     if (_SE_NewGraph(b->N, b->M, b->ends, NULL, &theGraph) != OK)
+         return NOTOK;
+
+     RetVal = gp_Embed(theGraph, EMBEDFLAGS_PLANAR);
+
+     if (RetVal == NONEMBEDDABLE && gp_SortVertices(theGraph) != OK)
+         RetVal = NOTOK;
+
+     if (RetVal == NONEMBEDDABLE)
+     {
+         first = gp_GetFirstVertex(theGraph);
+         for (a = 0; a < b->M; a++)
+         {
+              e = gp_GetFirstEdge(theGraph) + 2*a;
+              b->inK[a] = gp_EdgeInUse(theGraph, e) ? 1 : 0;
+
+              // The isolator only deletes edges, so the others keep their
+              // records
+              if (b->inK[a] && gp_GetNeighbor(theGraph, e) != first + b->ends[2*a])
+                  RetVal = NOTOK;
+         }
+     }
+
+     gp_Free(&theGraph);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_ExceedsEulerBound()
+
+ A simple graph with N >= 3 vertices on a surface of Euler
+ characteristic c has at most 3(N - c) edges, since each face has at
+ least three sides.
+
+ Returns TRUE if the block is simple and has more edges than that.
+ ********************************************************************/
+
+static int  _SE_ExceedsEulerBound(se_Block *b)
+{
+int  v, j, w;
+
+     if (b->M <= 3*(b->N - b->eulerChar))
+         return FALSE;
+
+     for (v = 0; v < b->N; v++)
+     {
+          b->stampValue++;
+          for (j = b->adjStart[v]; j < b->adjStart[v+1]; j++)
+          {
+               w = b->ends[b->adjArc[j] ^ 1];
+               if (b->stamp[w] == b->stampValue)
+                   return FALSE;
+               b->stamp[w] = b->stampValue;
+          }
+     }
+
+     return TRUE;
+}
+
+/********************************************************************
+ _SE_EmbedBlock()
+
+ Embeds the nonplanar block, whose Kuratowski subgraph is marked in
+ inK.  On success, the arcs leaving vertex v of the block are stored in
+ rotation order in rotation[adjStart[v]] to rotation[adjStart[v+1]-1],
+ and twisted tells which edges are twisted.
+
+ Returns OK, NONEMBEDDABLE or NOTOK.
+ ********************************************************************/
+
+static int  _SE_EmbedBlock(se_Block *b, int *rotation, int *twisted)
+{
+se_State state, *st = &state;
+int  RetVal;
+
+     if (_SE_InitState(st, b->N, b->M) != OK)
+         return NOTOK;
+
+     if ((RetVal = _SE_EmbedKuratowski(b, st)) == OK)
+         RetVal = _SE_GetRotation(b, st, rotation, twisted);
+
+     free(st->data);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_InitState()
+ ********************************************************************/
+
+static int  _SE_InitState(se_State *st, int N, int M)
+{
+     st->numFaces = 0;
+     st->size = 8*M + N + 2;
+     st->data = (int *) malloc(st->size*sizeof(int));
+     if (st->data == NULL)
+         return NOTOK;
+
+     st->sideArc = st->data;
+     st->next = st->sideArc + 2*M;
+     st->faceOf = st->next + 2*M;
+     st->faceSide = st->faceOf + 2*M;
+     st->edgeIn = st->faceSide + M + 2;
+     st->vertIn = st->edgeIn + M;
+
+     return OK;
+}
+
+/********************************************************************
+ _SE_CopyState()
+ ********************************************************************/
+
+static void _SE_CopyState(se_State *dst, se_State *src)
+{
+     dst->numFaces = src->numFaces;
+     memcpy(dst->data, src->data, src->size*sizeof(int));
+}
+
+/********************************************************************
+ _SE_GetBranchGraph()
+
+ Finds the branch vertices of K, which have degree 3 or 4 in K, and
+ follows the paths of K between them.  Also picks a spanning tree of
+ the branch graph, whose edges are left untwisted.
+
+ Returns OK, or NOTOK if K is not a K5 or K3,3 homeomorph.
+ ********************************************************************/
+
+static int  _SE_GetBranchGraph(se_Block *b, se_Kuratowski *k)
+{
+int  *degree = b->localOf, *seen = b->admCount;
+int  v, j, a, x, y, z, p, i, len = 0, top;
+int  queue[6];
+
+     memset(k->degree, 0, sizeof(k->degree));
+     k->numVerts = k->numPaths = 0;
+
+     for (v = 0; v < b->N; v++)
+     {
+          degree[v] = 0;
+          for (j = b->adjStart[v]; j < b->adjStart[v+1]; j++)
+               degree[v] += b->inK[b->adjArc[j] >> 1];
+     }
+
+     // The branch vertex numbers are stored in compOf, or -1
+     for (v = 0; v < b->N; v++)
+     {
+          b->compOf[v] = -1;
+          if (degree[v] > 2)
+          {
+              if (k->numVerts == 6 || degree[v] > 4)
+                  return NOTOK;
+              b->compOf[v] = k->numVerts++;
+          }
+     }
+
+     for (j = 0; j < b->M; j++)
+          seen[j] = 0;
+
+     for (v = 0; v < b->N; v++)
+     {
+          if (b->compOf[v] == -1)
+              continue;
+
+          for (j = b->adjStart[v]; j < b->adjStart[v+1]; j++)
+          {
+               a = b->adjArc[j];
+               if (!b->inK[a >> 1] || seen[a >> 1])
+                   continue;
+
+               if (k->numPaths == 10)
+                   return NOTOK;
+
+               p = k->numPaths++;
+               k->pathStart[p] = len;
+
+               // Follow the path through the vertices of degree two
+               x = a;
+               while (TRUE)
+               {
+                    k->pathArcs[len++] = x;
+                    seen[x >> 1] = 1;
+                    z = b->ends[x ^ 1];
+                    if (b->compOf[z] != -1)
+                        break;
+
+                    for (i = b->adjStart[z]; i < b->adjStart[z+1]; i++)
+                    {
+                         y = b->adjArc[i];
+                         if (b->inK[y >> 1] && (y >> 1) != (x >> 1))
+                             break;
+                    }
+                    if (i == b->adjStart[z+1])
+                        return NOTOK;
+                    x = b->adjArc[i];
+               }
+
+               i = b->compOf[v];
+               k->tail[2*p] = i;
+               k->arcs[i][k->degree[i]++] = 2*p;
+
+               i = b->compOf[z];
+               k->tail[2*p+1] = i;
+               k->arcs[i][k->degree[i]++] = 2*p+1;
+          }
+     }
+     k->pathStart[k->numPaths] = len;
+
+     if (!(k->numVerts == 5 && k->numPaths == 10) && !(k->numVerts == 6 && k->numPaths == 9))
+         return NOTOK;
+
+     // A breadth first spanning tree of the branch graph
+     for (p = 0; p < k->numPaths; p++)
+          k->inTree[p] = 0;
+     for (i = 0; i < k->numVerts; i++)
+          degree[i] = 0;
+
+     degree[0] = 1;
+     queue[0] = 0;
+     for (top = 1, j = 0; j < top; j++)
+     {
+          i = queue[j];
+          for (a = 0; a < k->degree[i]; a++)
+          {
+               x = k->arcs[i][a];
+               z = k->tail[x ^ 1];
+               if (!degree[z])
+               {
+                   degree[z] = 1;
+                   k->inTree[x >> 1] = 1;
+                   queue[top++] = z;
+               }
+          }
+     }
+
+     return top == k->numVerts ? OK : NOTOK;
+}
+
+/********************************************************************
+ _SE_TraceBranchFaces()
+
+ Walks the faces of the embedding of the branch graph given by rotNext,
+ rotPrev and twisted.  If st is not NULL, the faces are expanded into
+ face walks of K in st.
+
+ Returns the number of faces.
+ ********************************************************************/
+
+static int  _SE_TraceBranchFaces(se_Kuratowski *k, se_State *st)
+{
+char visited[40];
+int  x, xStart, d, dStart, t, p, j, a, s, sFirst = 0, sPrev = 0, numFaces = 0;
+
+     memset(visited, 0, sizeof(visited));
+
+     for (xStart = 0; xStart < 2*k->numPaths; xStart++)
+     {
+          for (dStart = 0; dStart < 2; dStart++)
+          {
+               if (visited[2*xStart + dStart])
+                   continue;
+
+               x = xStart;
+               d = dStart;
+               sFirst = -1;
+               do {
+                   t = k->twisted[x >> 1];
+                   visited[2*x + d] = 1;
+                   visited[2*(x ^ 1) + (1 ^ d ^ t)] = 1;
+
+                   if (st != NULL)
+                   {
+                       p = x >> 1;
+                       for (j = k->pathStart[p]; j < k->pathStart[p+1]; j++)
+                       {
+                            a = (x & 1) ? k->pathArcs[k->pathStart[p] + k->pathStart[p+1] - 1 - j] ^ 1
+                                        : k->pathArcs[j];
+
+                            // The first face walk along an edge takes its
+                            // first side
+                            s = st->faceOf[a & ~1] == -1 ? (a & ~1) : (a | 1);
+                            st->sideArc[s] = a;
+                            st->faceOf[s] = numFaces;
+                            if (sFirst == -1)
+                                sFirst = s;
+                            else
+                                st->next[sPrev] = s;
+                            sPrev = s;
+                       }
+                   }
+
+                   d ^= t;
+                   x = d == 0 ? k->rotNext[x ^ 1] : k->rotPrev[x ^ 1];
+               } while (x != xStart || d != dStart);
+
+               if (st != NULL)
+               {
+                   st->next[sPrev] = sFirst;
+                   st->faceSide[numFaces] = sFirst;
+               }
+               numFaces++;
+          }
+     }
+
+     if (st != NULL)
+         st->numFaces = numFaces;
+
+     return numFaces;
+}
+
+/********************************************************************
+ _SE_EmbedKuratowski()
+
+ Tries each embedding of K on the surface, up to mirror images, and
+ extends it to the block.
+
+ Returns OK with the embedding of the block in st, NONEMBEDDABLE if no
+ embedding of K extends, or NOTOK on error.
+ ********************************************************************/
+
+static int  _SE_EmbedKuratowski(se_Block *b, se_State *st)
+{
+static const int perms3[2][2] = {{1, 2}, {2, 1}};
+static const int perms4[6][3] = {{1, 2, 3}, {1, 3, 2}, {2, 1, 3}, {2, 3, 1}, {3, 1, 2}, {3, 2, 1}};
+se_Kuratowski kuratowski, *k = &kuratowski;
+se_State work;
+int  choice[6], numChoices[6], order[4], numFree, freePaths[10];
+int  i, j, d, p, x, mask, numFaces, RetVal = NONEMBEDDABLE;
+const int *perm;
+
+     k->pathArcs = (int *) malloc(b->M*sizeof(int));
+     if (k->pathArcs == NULL)
+         return NOTOK;
+
+     if (_SE_GetBranchGraph(b, k) != OK || _SE_InitState(&work, b->N, b->M) != OK)
+     {
+         free(k->pathArcs);
+         return NOTOK;
+     }
+
+     numFaces = k->numPaths - k->numVerts + b->eulerChar;
+
+     // Only the projective plane has twisted edges, which are the edges
+     // outside the spanning tree, since the others can be untwisted by
+     // reversing rotations
+     numFree = 0;
+     for (p = 0; p < k->numPaths; p++)
+     {
+          if (b->eulerChar == 1 && !k->inTree[p])
+              freePaths[numFree++] = p;
+     }
+
+     for (i = 0; i < k->numVerts; i++)
+     {
+          choice[i] = 0;
+          numChoices[i] = k->degree[i] == 3 ? 2 : 6;
+     }
+
+     while (RetVal == NONEMBEDDABLE)
+     {
+          // Set the rotation of each branch vertex, skipping the mirror
+          // image of the rotation of the first one
+          perm = k->degree[0] == 3 ? perms3[choice[0]] : perms4[choice[0]];
+          if (perm[0] < perm[k->degree[0] - 2])
+          {
+              for (i = 0; i < k->numVerts; i++)
+              {
+                   d = k->degree[i];
+                   perm = d == 3 ? perms3[choice[i]] : perms4[choice[i]];
+                   order[0] = k->arcs[i][0];
+                   for (j = 1; j < d; j++)
+                        order[j] = k->arcs[i][perm[j-1]];
+                   for (j = 0; j < d; j++)
+                   {
+                        k->rotNext[order[j]] = order[(j+1) % d];
+                        k->rotPrev[order[(j+1) % d]] = order[j];
+                   }
+              }
+
+              for (mask = 0; mask < (1 << numFree) && RetVal == NONEMBEDDABLE; mask++)
+              {
+                   for (p = 0; p < k->numPaths; p++)
+                        k->twisted[p] = 0;
+                   for (j = 0; j < numFree; j++)
+                        k->twisted[freePaths[j]] = (mask >> j) & 1;
+
+                   if (_SE_TraceBranchFaces(k, NULL) != numFaces)
+                       continue;
+
+                   // Start H as K, with the face walks of this embedding
+                   for (x = 0; x < b->N; x++)
+                        work.vertIn[x] = 0;
+                   for (x = 0; x < b->M; x++)
+                   {
+                        work.edgeIn[x] = b->inK[x];
+                        work.faceOf[2*x] = work.faceOf[2*x+1] = -1;
+                        if (b->inK[x])
+                            work.vertIn[b->ends[2*x]] = work.vertIn[b->ends[2*x+1]] = 1;
+                   }
+
+                   _SE_TraceBranchFaces(k, &work);
+                   RetVal = _SE_Extend(b, &work);
+              }
+          }
+
+          // Next combination of rotations
+          for (i = 0; i < k->numVerts; i++)
+          {
+               if (++choice[i] < numChoices[i])
+                   break;
+               choice[i] = 0;
+          }
+          if (i == k->numVerts)
+              break;
+     }
+
+     if (RetVal == OK)
+         _SE_CopyState(st, &work);
+
+     free(work.data);
+     free(k->pathArcs);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_Extend()
+
+ Extends the embedding of H in st to the block, embedding forced paths
+ in place and branching over the placements of a path when none is
+ forced.
+
+ Returns OK with the embedding of the block in st, NONEMBEDDABLE if the
+ embedding of H does not extend, or NOTOK on error.
+ ********************************************************************/
+
+static int  _SE_Extend(se_Block *b, se_State *st)
+{
+se_State child;
+int  *placements = NULL, *path, len, i, j, numPlacements, RetVal = OK;
+
+     child.data = NULL;
+
+     while (RetVal == OK)
+     {
+          _SE_GetBridges(b, st);
+          if (b->numBridges == 0)
+              break;
+
+          _SE_IndexFaces(b, st);
+
+          if ((RetVal = _SE_ChooseBridge(b, st, &i, &numPlacements)) != OK)
+              break;
+
+          if ((len = _SE_FindPath(b, st, i)) <= 0)
+          {
+              RetVal = NOTOK;
+              break;
+          }
+
+          if (numPlacements == 1)
+          {
+              int  placement[2];
+
+              _SE_GetPlacements(b, st, i, &numPlacements, placement);
+              _SE_AddPath(b, st, b->path, len, placement[0], placement[1]);
+              continue;
+          }
+
+          // The search is about to branch, so first look for a face that
+          // cannot hold the bridges confined to it
+          if ((RetVal = _SE_TestResidues(b, st)) != OK)
+              break;
+
+          placements = (int *) malloc((2*numPlacements + len)*sizeof(int));
+          if (placements == NULL || _SE_InitState(&child, b->N, b->M) != OK)
+          {
+              RetVal = NOTOK;
+              break;
+          }
+
+          path = placements + 2*numPlacements;
+          memcpy(path, b->path, len*sizeof(int));
+          _SE_GetPlacements(b, st, i, &numPlacements, placements);
+
+          RetVal = NONEMBEDDABLE;
+          for (j = 0; j < numPlacements && RetVal == NONEMBEDDABLE; j++)
+          {
+               _SE_CopyState(&child, st);
+               _SE_AddPath(b, &child, path, len, placements[2*j], placements[2*j+1]);
+               RetVal = _SE_Extend(b, &child);
+          }
+
+          if (RetVal == OK)
+              _SE_CopyState(st, &child);
+          break;
+     }
+
+     free(placements);
+     free(child.data);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_GetBridges()
+
+ Finds the bridges of H.  Each connected component of the vertices not
+ in H is found by a breadth first search, which also collects its
+ attachments, and each edge not in H that joins two vertices of H is a
+ bridge of its own.
+ ********************************************************************/
+
+static void _SE_GetBridges(se_Block *b, se_State *st)
+{
+int  v, x, y, e, j, i, head, tail, numAtts = 0;
+
+     for (v = 0; v < b->N; v++)
+          b->compOf[v] = -1;
+     for (e = 0; e < b->M; e++)
+          b->bridgeOf[e] = -1;
+
+     b->numBridges = 0;
+     for (v = 0; v < b->N; v++)
+     {
+          if (st->vertIn[v] || b->compOf[v] != -1)
+              continue;
+
+          i = b->numBridges++;
+          b->attStart[i] = numAtts;
+          b->repEdge[i] = -1;
+          b->stampValue++;
+
+          b->compOf[v] = i;
+          b->queue[0] = v;
+          for (head = 0, tail = 1; head < tail; head++)
+          {
+               x = b->queue[head];
+               for (j = b->adjStart[x]; j < b->adjStart[x+1]; j++)
+               {
+                    e = b->adjArc[j] >> 1;
+                    y = b->ends[b->adjArc[j] ^ 1];
+                    b->bridgeOf[e] = i;
+
+                    if (st->vertIn[y])
+                    {
+                        if (b->stamp[y] != b->stampValue)
+                        {
+                            b->stamp[y] = b->stampValue;
+                            b->atts[numAtts++] = y;
+                        }
+                        if (b->repEdge[i] == -1)
+                            b->repEdge[i] = e;
+                    }
+                    else if (b->compOf[y] == -1)
+                    {
+                        b->compOf[y] = i;
+                        b->queue[tail++] = y;
+                    }
+               }
+          }
+     }
+
+     for (e = 0; e < b->M; e++)
+     {
+          if (st->edgeIn[e] || b->bridgeOf[e] != -1)
+              continue;
+
+          i = b->numBridges++;
+          b->attStart[i] = numAtts;
+          b->repEdge[i] = e;
+          b->bridgeOf[e] = i;
+          b->atts[numAtts++] = b->ends[2*e];
+          b->atts[numAtts++] = b->ends[2*e+1];
+     }
+
+     b->attStart[b->numBridges] = numAtts;
+}
+
+/********************************************************************
+ _SE_IndexFaces()
+
+ Lists the faces of H at each vertex, with the number of corners the
+ vertex has in each.  The faces are visited in increasing order, so
+ each list is sorted for _SE_GetCorners().
+ ********************************************************************/
+
+static void _SE_IndexFaces(se_Block *b, se_State *st)
+{
+int  v, f, s, sStart, k;
+
+     for (v = 0; v <= b->N; v++)
+          b->vfStart[v] = 0;
+
+     for (f = 0; f < st->numFaces; f++)
+     {
+          b->stampValue++;
+          s = sStart = st->faceSide[f];
+          do {
+              v = b->ends[st->sideArc[s]];
+              if (b->stamp[v] != b->stampValue)
+              {
+                  b->stamp[v] = b->stampValue;
+                  b->vfStart[v+1]++;
+              }
+              s = st->next[s];
+          } while (s != sStart);
+     }
+
+     for (v = 0; v < b->N; v++)
+     {
+          b->vfStart[v+1] += b->vfStart[v];
+          b->queue[v] = b->vfStart[v];
+     }
+
+     for (f = 0; f < st->numFaces; f++)
+     {
+          b->stampValue++;
+          s = sStart = st->faceSide[f];
+          do {
+              v = b->ends[st->sideArc[s]];
+              if (b->stamp[v] != b->stampValue)
+              {
+                  b->stamp[v] = b->stampValue;
+                  k = b->localOf[v] = b->queue[v]++;
+                  b->vfFace[k] = f;
+                  b->vfCount[k] = 1;
+              }
+              else
+                  b->vfCount[b->localOf[v]]++;
+              s = st->next[s];
+          } while (s != sStart);
+     }
+}
+
+/********************************************************************
+ _SE_GetCorners()
+
+ Returns the number of corners of vertex v in face f, found by binary
+ search of the faces of v.
+ ********************************************************************/
+
+static int  _SE_GetCorners(se_Block *b, int v, int f)
+{
+int  lo = b->vfStart[v], hi = b->vfStart[v+1] - 1, mid;
+
+     while (lo <= hi)
+     {
+          mid = (lo + hi) / 2;
+          if (b->vfFace[mid] == f)
+              return b->vfCount[mid];
+          if (b->vfFace[mid] < f)
+              lo = mid + 1;
+          else
+              hi = mid - 1;
+     }
+
+     return 0;
+}
+
+/********************************************************************
+ _SE_FindPath()
+
+ Stores in b->path a path through bridge i between two of its
+ attachments, starting with its representative edge.  For a bridge
+ with internal vertices, the rest of the path is found by a breadth
+ first search from the internal end of that edge.
+
+ Returns the length of the path, or 0 on error.
+ ********************************************************************/
+
+static int  _SE_FindPath(se_Block *b, se_State *st, int i)
+{
+int  e = b->repEdge[i], a, x, y, z, c, j, head, tail, len;
+
+     b->pathLen = 0;
+     if (st->vertIn[b->ends[2*e]] && st->vertIn[b->ends[2*e+1]])
+     {
+         b->path[0] = 2*e;
+         return b->pathLen = 1;
+     }
+
+     a = st->vertIn[b->ends[2*e]] ? 2*e : 2*e+1;
+     y = b->ends[a ^ 1];
+
+     b->stampValue++;
+     b->stamp[y] = b->stampValue;
+     b->parentArc[y] = a;
+     b->queue[0] = y;
+     for (head = 0, tail = 1; head < tail; head++)
+     {
+          x = b->queue[head];
+          for (j = b->adjStart[x]; j < b->adjStart[x+1]; j++)
+          {
+               c = b->adjArc[j];
+               z = b->ends[c ^ 1];
+               if (st->vertIn[z])
+               {
+                   if (z == b->ends[a])
+                       continue;
+
+                   // Unwind the path from the other attachment z
+                   len = 0;
+                   b->path[len++] = c;
+                   while (x != y)
+                   {
+                        b->path[len++] = b->parentArc[x];
+                        x = b->ends[b->parentArc[x]];
+                   }
+                   b->path[len++] = a;
+
+                   for (j = 0; j < len / 2; j++)
+                   {
+                        c = b->path[j];
+                        b->path[j] = b->path[len - 1 - j];
+                        b->path[len - 1 - j] = c;
+                   }
+                   return b->pathLen = len;
+               }
+               if (b->stamp[z] != b->stampValue)
+               {
+                   b->stamp[z] = b->stampValue;
+                   b->parentArc[z] = c;
+                   b->queue[tail++] = z;
+               }
+          }
+     }
+
+     return 0;
+}
+
+/********************************************************************
+ _SE_GetPlacements()
+
+ Counts the admissible faces of bridge i, i.e. the faces of H that
+ contain all of its attachments, and records the count and the first
+ one.  The faces that contain the attachment with fewest faces are the
+ candidates.  Also counts the placements of the path in b->path, which
+ must be a path of bridge i, and if placements is not NULL, stores each
+ as the pair of sides that leave the two ends of the path from the
+ corners it joins.
+
+ Returns the number of admissible faces.
+ ********************************************************************/
+
+static int  _SE_GetPlacements(se_Block *b, se_State *st, int i, int *pNumPlacements, int *placements)
+{
+int  a = b->ends[b->path[0]], w = b->ends[b->path[b->pathLen - 1] ^ 1];
+int  v, v0, j, k, f, s, sStart, numA, numW, numFaces = 0, numPlacements = 0;
+
+     v0 = b->atts[b->attStart[i]];
+     for (j = b->attStart[i] + 1; j < b->attStart[i+1]; j++)
+     {
+          v = b->atts[j];
+          if (b->vfStart[v+1] - b->vfStart[v] < b->vfStart[v0+1] - b->vfStart[v0])
+              v0 = v;
+     }
+
+     b->admFace[i] = -1;
+     for (k = b->vfStart[v0]; k < b->vfStart[v0+1]; k++)
+     {
+          f = b->vfFace[k];
+          for (j = b->attStart[i]; j < b->attStart[i+1]; j++)
+          {
+               if (_SE_GetCorners(b, b->atts[j], f) == 0)
+                   break;
+          }
+          if (j < b->attStart[i+1])
+              continue;
+
+          if (numFaces++ == 0)
+              b->admFace[i] = f;
+
+          numA = _SE_GetCorners(b, a, f);
+          numW = _SE_GetCorners(b, w, f);
+
+          if (placements != NULL)
+          {
+              // Pair each corner of a with each corner of w, using queue
+              // and parentArc for the sides that leave them
+              numA = numW = 0;
+              s = sStart = st->faceSide[f];
+              do {
+                  v = b->ends[st->sideArc[s]];
+                  if (v == a)
+                      b->queue[numA++] = s;
+                  else if (v == w)
+                      b->parentArc[numW++] = s;
+                  s = st->next[s];
+              } while (s != sStart);
+
+              for (j = 0; j < numA; j++)
+              {
+                   for (v = 0; v < numW; v++)
+                   {
+                        placements[2*(numPlacements + j*numW + v)] = b->queue[j];
+                        placements[2*(numPlacements + j*numW + v) + 1] = b->parentArc[v];
+                   }
+              }
+          }
+
+          numPlacements += numA * numW;
+     }
+
+     b->admCount[i] = numFaces;
+     *pNumPlacements = numPlacements;
+     return numFaces;
+}
+
+/********************************************************************
+ _SE_ChooseBridge()
+
+ Finds a path through each bridge and picks the bridge whose path has
+ the fewest placements, stopping at the first forced one.
+
+ Returns OK, or NONEMBEDDABLE if a bridge has no admissible face, or
+ NOTOK on error.
+ ********************************************************************/
+
+static int  _SE_ChooseBridge(se_Block *b, se_State *st, int *pBridge, int *pNumPlacements)
+{
+int  i, numPlacements;
+
+     *pBridge = -1;
+     *pNumPlacements = 0;
+
+     for (i = 0; i < b->numBridges; i++)
+     {
+          if (_SE_FindPath(b, st, i) <= 0)
+              return NOTOK;
+
+          if (_SE_GetPlacements(b, st, i, &numPlacements, NULL) == 0)
+              return NONEMBEDDABLE;
+
+          if (*pBridge == -1 || numPlacements < *pNumPlacements)
+          {
+              *pBridge = i;
+              *pNumPlacements = numPlacements;
+              if (numPlacements == 1)
+                  break;
+          }
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _SE_TestResidues()
+
+ Tests each face whose boundary is a simple cycle against the bridges
+ that have it as their only admissible face.  They must all be
+ embedded inside the disk, which is possible if and only if the cycle,
+ the bridges and an apex vertex joined to each vertex of the cycle
+ form a planar graph.
+
+ Returns OK, or NONEMBEDDABLE if some face fails, or NOTOK on error.
+ ********************************************************************/
+
+static int  _SE_TestResidues(se_Block *b, se_State *st)
+{
+graphP theGraph;
+int  *faceEnd, *faceEdges, f, e, i, s, sStart, x, y, n, L, j, start, first;
+int  RetVal = OK;
+
+     faceEnd = (int *) calloc(st->numFaces + 1 + b->M, sizeof(int));
+     if (faceEnd == NULL)
+         return NOTOK;
+     faceEdges = faceEnd + st->numFaces + 1;
+
+     // Group the edges of the confined bridges by face; afterward, the
+     // edges of face f end at faceEnd[f]
+     for (e = 0; e < b->M; e++)
+     {
+          i = b->bridgeOf[e];
+          if (!st->edgeIn[e] && b->admCount[i] == 1)
+              faceEnd[b->admFace[i] + 1]++;
+     }
+     for (f = 0; f < st->numFaces; f++)
+          faceEnd[f+1] += faceEnd[f];
+     for (e = 0; e < b->M; e++)
+     {
+          i = b->bridgeOf[e];
+          if (!st->edgeIn[e] && b->admCount[i] == 1)
+              faceEdges[faceEnd[b->admFace[i]]++] = e;
+     }
+
+     for (f = 0; f < st->numFaces && RetVal == OK; f++)
+     {
+          start = f == 0 ? 0 : faceEnd[f-1];
+          if (start == faceEnd[f])
+              continue;
+
+          // Number the vertices of the boundary, unless one repeats
+          b->stampValue++;
+          L = 0;
+          s = sStart = st->faceSide[f];
+          do {
+              x = b->ends[st->sideArc[s]];
+              if (b->stamp[x] == b->stampValue)
+                  break;
+              b->stamp[x] = b->stampValue;
+              b->localOf[x] = L++;
+              s = st->next[s];
+          } while (s != sStart);
+
+          if (s != sStart || L < 3)
+              continue;
+
+          n = L;
+          for (j = start; j < faceEnd[f]; j++)
+          {
+               e = faceEdges[j];
+               for (x = 0; x < 2; x++)
+               {
+                    y = b->ends[2*e + x];
+                    if (b->stamp[y] != b->stampValue)
+                    {
+                        b->stamp[y] = b->stampValue;
+                        b->localOf[y] = n++;
+                    }
+               }
+          }
+
+          if ((theGraph = gp_New()) == NULL ||
+              gp_EnsureArcCapacity(theGraph, 2*(2*L + faceEnd[f] - start)) != OK ||
+              gp_InitGraph(theGraph, n + 1) != OK)
+          {
+              gp_Free(&theGraph);
+              RetVal = NOTOK;
+              break;
+          }
+
+          first = gp_GetFirstVertex(theGraph);
+          s = sStart;
+          do {
+              x = b->localOf[b->ends[st->sideArc[s]]];
+              y = b->localOf[b->ends[st->sideArc[s] ^ 1]];
+              if (gp_AddEdge(theGraph, first + x, 0, first + y, 0) != OK ||
+                  gp_AddEdge(theGraph, first + n, 0, first + x, 0) != OK)
+                  RetVal = NOTOK;
+              s = st->next[s];
+          } while (s != sStart);
+
+          for (j = start; j < faceEnd[f]; j++)
+          {
+               e = faceEdges[j];
+               if (gp_AddEdge(theGraph, first + b->localOf[b->ends[2*e]], 0,
+                                        first + b->localOf[b->ends[2*e+1]], 0) != OK)
+                   RetVal = NOTOK;
+          }
+
+          if (RetVal == OK)
+              RetVal = gp_Embed(theGraph, EMBEDFLAGS_PLANAR);
+
+          gp_Free(&theGraph);
+     }
+
+     free(faceEnd);
+     return RetVal;
+}
+
+/********************************************************************
+ _SE_AddPath()
+
+ Embeds the path across the face of H that contains side sa, which
+ leaves the first vertex of the path, and side sw, which leaves the
+ last one.  The face keeps the walk from sw around to sa, closed by the
+ path, and the walk from sa around to sw, closed by the reverse of the
+ path, becomes a new face.
+ ********************************************************************/
+
+static void _SE_AddPath(se_Block *b, se_State *st, int *path, int len, int sa, int sw)
+{
+int  f = st->faceOf[sa], g = st->numFaces++, s, pa = sa, pw = sw, t, e;
+
+     // The sides that lead into sa and sw
+     s = sa;
+     do {
+         if (st->next[s] == sa)
+             pa = s;
+         else if (st->next[s] == sw)
+             pw = s;
+         s = st->next[s];
+     } while (s != sa);
+
+     for (t = 0; t < len; t++)
+     {
+          e = path[t] >> 1;
+          st->edgeIn[e] = 1;
+          st->vertIn[b->ends[path[t]]] = st->vertIn[b->ends[path[t] ^ 1]] = 1;
+          st->sideArc[2*e] = path[t];
+          st->sideArc[2*e+1] = path[t] ^ 1;
+          st->faceOf[2*e] = f;
+
+          st->next[2*e] = t + 1 < len ? 2*(path[t+1] >> 1) : sw;
+          st->next[2*e+1] = t > 0 ? 2*(path[t-1] >> 1) + 1 : sa;
+     }
+
+     st->next[pa] = 2*(path[0] >> 1);
+     st->next[pw] = 2*(path[len-1] >> 1) + 1;
+
+     st->faceSide[f] = sw;
+     st->faceSide[g] = sa;
+     s = sa;
+     do {
+         st->faceOf[s] = g;
+         s = st->next[s];
+     } while (s != sa);
+}
+
+/********************************************************************
+ _SE_GetRotation()
+
+ Reads the rotation system of the embedding of the block from its face
+ walks.  A corner of vertex v lies between a side that enters v and
+ the next side of its face walk, which leaves v, and it joins the two
+ arcs leaving v along their edges.  The arcs and corners at v form one
+ cycle, which gives the rotation of v in one of its two directions.
+ Each face walk then passes each of its corners either along the
+ rotation or against it, and an edge is twisted if a face walk
+ passes the corners at its two ends in different directions.  Lastly,
+ the rotations are reversed along a spanning tree so that only edges
+ outside it can be twisted, which leaves none for the torus.
+
+ Returns OK, or NOTOK if the face walks are not those of an embedding.
+ ********************************************************************/
+
+static int  _SE_GetRotation(se_Block *b, se_State *st, int *rotation, int *twisted)
+{
+int  *prev, *corners, *along, *flip, v, a, a0, c, other, s, j, k, e, x, y, head, tail;
+int  RetVal = OK;
+
+     prev = (int *) malloc((8*b->M + b->N)*sizeof(int));
+     if (prev == NULL)
+         return NOTOK;
+
+     corners = prev + 2*b->M;
+     along = corners + 4*b->M;
+     flip = along + 2*b->M;
+
+     for (s = 0; s < 2*b->M; s++)
+     {
+          prev[st->next[s]] = s;
+          corners[2*s] = corners[2*s+1] = -1;
+     }
+
+     // Corner s joins the arc back along side s and the arc of the next side
+     for (s = 0; s < 2*b->M && RetVal == OK; s++)
+     {
+          a = st->sideArc[s] ^ 1;
+          x = st->sideArc[st->next[s]];
+          if (a == x)
+              RetVal = NOTOK;
+          corners[2*a + (corners[2*a] != -1)] = s;
+          corners[2*x + (corners[2*x] != -1)] = s;
+     }
+
+     for (v = 0; v < b->N && RetVal == OK; v++)
+     {
+          k = b->adjStart[v];
+          a = a0 = b->adjArc[k];
+          c = corners[2*a0];
+          do {
+              rotation[k++] = a;
+
+              if (st->sideArc[c] == (a ^ 1))
+              {
+                  along[c] = 1;
+                  other = st->sideArc[st->next[c]];
+              }
+              else
+              {
+                  along[c] = 0;
+                  other = st->sideArc[c] ^ 1;
+              }
+
+              c = corners[2*other] == c ? corners[2*other+1] : corners[2*other];
+              a = other;
+          } while (a != a0 && k < b->adjStart[v+1]);
+
+          if (a != a0 || k != b->adjStart[v+1])
+              RetVal = NOTOK;
+     }
+
+     if (RetVal == OK)
+     {
+         // Side 2e leaves its tail from the corner prev[2e] and enters its
+         // head at corner 2e
+         for (e = 0; e < b->M; e++)
+              twisted[e] = along[prev[2*e]] ^ along[2*e];
+
+         // Reverse rotations along a breadth first spanning tree
+         for (v = 0; v < b->N; v++)
+              flip[v] = -1;
+         flip[0] = 0;
+         b->queue[0] = 0;
+         for (head = 0, tail = 1; head < tail; head++)
+         {
+              x = b->queue[head];
+              for (j = b->adjStart[x]; j < b->adjStart[x+1]; j++)
+              {
+                   a = b->adjArc[j];
+                   y = b->ends[a ^ 1];
+                   if (flip[y] == -1)
+                   {
+                       flip[y] = flip[x] ^ twisted[a >> 1];
+                       b->queue[tail++] = y;
+                   }
+              }
+         }
+
+         for (e = 0; e < b->M; e++)
+         {
+              twisted[e] ^= flip[b->ends[2*e]] ^ flip[b->ends[2*e+1]];
+              if (twisted[e] && b->eulerChar == 0)
+                  RetVal = NOTOK;
+         }
+
+         for (v = 0; v < b->N; v++)
+         {
+              if (!flip[v])
+                  continue;
+
+              // Keep the first arc first and reverse the rest
+              j = b->adjStart[v] + 1;
+              k = b->adjStart[v+1] - 1;
+              for (; j < k; j++, k--)
+              {
+                   a = rotation[j];
+                   rotation[j] = rotation[k];
+                   rotation[k] = a;
+              }
+         }
+     }
+
+     free(prev);
+     return RetVal;
+}
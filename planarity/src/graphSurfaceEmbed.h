@@ -0,0 +1,25 @@
+#ifndef GRAPH_SURFACEEMBED_H
+#define GRAPH_SURFACEEMBED_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graphStructures.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SURFACEEMBED_NAME "SurfaceEmbed"
+
+int gp_AttachSurfaceEmbed(graphP theGraph);
+int gp_DetachSurfaceEmbed(graphP theGraph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef GRAPH_SURFACEEMBED_PRIVATE_H
+#define GRAPH_SURFACEEMBED_PRIVATE_H
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    // The result of the surface embedding search, which is done before
+    // the embedder's main loop and returned once the loop finds nothing
+    // to embed
+    int embedResult;
+
+    // Overloaded function pointers
+    graphFunctionTable functions;
+
+} SurfaceEmbedContext;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
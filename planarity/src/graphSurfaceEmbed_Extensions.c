@@ -0,0 +1,347 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "graphSurfaceEmbed.private.h"
+#include "graphSurfaceEmbed.h"
+
+extern int  _SurfaceEmbed_Embed(graphP theGraph, SurfaceEmbedContext *context);
+extern int  _SurfaceEmbed_CheckFacialIntegrity(graphP theGraph);
+
+extern int  _TestSubgraph(graphP theSubgraph, graphP theGraph);
+
+/* Forward declarations of overloading functions */
+
+int  _SurfaceEmbed_EmbeddingInitialize(graphP theGraph);
+int  _SurfaceEmbed_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult);
+int  _SurfaceEmbed_CheckEmbeddingIntegrity(graphP theGraph, graphP origGraph);
+int  _SurfaceEmbed_CheckObstructionIntegrity(graphP theGraph, graphP origGraph);
+
+int  _SurfaceEmbed_ReadPostprocess(graphP theGraph, void *extraData, long extraDataSize);
+int  _SurfaceEmbed_WritePostprocess(graphP theGraph, void **pExtraData, long *pExtraDataSize);
+
+/* Forward declarations of functions used by the extension system */
+
+void *_SurfaceEmbed_DupContext(void *pContext, void *theGraph);
+void _SurfaceEmbed_FreeContext(void *);
+
+#define _SurfaceEmbed_IsActive(theGraph) \
+        ((theGraph)->embedFlags == EMBEDFLAGS_PROJECTIVEPLANAR || \
+         (theGraph)->embedFlags == EMBEDFLAGS_TOROIDAL)
+
+/****************************************************************************
+ * SURFACEEMBED_ID - the variable used to hold the integer identifier for
+ * this extension, enabling this feature's extension context to be
+ * distinguished from other features' extension contexts that may be
+ * attached to a graph.
+ ****************************************************************************/
+
+int SURFACEEMBED_ID = 0;
+
+/****************************************************************************
+ gp_AttachSurfaceEmbed()
+
+ This function adjusts the graph data structure to attach the surface
+ embedding feature.
+
+ To activate this feature during gp_Embed(), use
+ EMBEDFLAGS_PROJECTIVEPLANAR or EMBEDFLAGS_TOROIDAL.  Then gp_Embed()
+ returns OK if the graph embeds on the projective plane or the torus,
+ with the rotation system of an embedding in the adjacency lists and
+ EDGEFLAG_INVERTED marking the twisted edges, of which the torus has
+ none.  It returns NONEMBEDDABLE if the graph does not embed, leaving
+ all of its edges in place.
+
+ Since an adjacency list does not show which edges are twisted, writing
+ a projective plane embedding in that format appends a SurfaceEmbed
+ section that lists the twisted edges by their endpoints, and reading
+ it with this feature attached marks those edges again.
+ ****************************************************************************/
+
+int  gp_AttachSurfaceEmbed(graphP theGraph)
+{
+     SurfaceEmbedContext *context = NULL;
+
+     // If the surface embedding feature has already been attached to the
+     // graph, then there is no need to attach it again
+     gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+     if (context != NULL)
+     {
+         return OK;
+     }
+
+     // Allocate a new extension context
+     context = (SurfaceEmbedContext *) malloc(sizeof(SurfaceEmbedContext));
+     if (context == NULL)
+     {
+         return NOTOK;
+     }
+
+     context->embedResult = NOTOK;
+
+     // Put the overload functions into the context function table.
+     // gp_AddExtension will overload the graph's functions with these, and
+     // return the base function pointers in the context function table
+     memset(&context->functions, 0, sizeof(graphFunctionTable));
+
+     context->functions.fpEmbeddingInitialize = _SurfaceEmbed_EmbeddingInitialize;
+     context->functions.fpEmbedPostprocess = _SurfaceEmbed_EmbedPostprocess;
+     context->functions.fpCheckEmbeddingIntegrity = _SurfaceEmbed_CheckEmbeddingIntegrity;
+     context->functions.fpCheckObstructionIntegrity = _SurfaceEmbed_CheckObstructionIntegrity;
+
+     context->functions.fpReadPostprocess = _SurfaceEmbed_ReadPostprocess;
+     context->functions.fpWritePostprocess = _SurfaceEmbed_WritePostprocess;
+
+     // Store the surface embedding context, including the data structure
+     // and the function pointers, as an extension of the graph
+     if (gp_AddExtension(theGraph, &SURFACEEMBED_ID, (void *) context,
+                         _SurfaceEmbed_DupContext, _SurfaceEmbed_FreeContext,
+                         &context->functions) != OK)
+     {
+         _SurfaceEmbed_FreeContext(context);
+         return NOTOK;
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ gp_DetachSurfaceEmbed()
+ ********************************************************************/
+
+int gp_DetachSurfaceEmbed(graphP theGraph)
+{
+    return gp_RemoveExtension(theGraph, SURFACEEMBED_ID);
+}
+
+/********************************************************************
+ _SurfaceEmbed_DupContext()
+ ********************************************************************/
+
+void *_SurfaceEmbed_DupContext(void *pContext, void *theGraph)
+{
+     SurfaceEmbedContext *context = (SurfaceEmbedContext *) pContext;
+     SurfaceEmbedContext *newContext = (SurfaceEmbedContext *) malloc(sizeof(SurfaceEmbedContext));
+
+     (void) theGraph;
+
+     if (newContext != NULL)
+     {
+         *newContext = *context;
+     }
+
+     return newContext;
+}
+
+/********************************************************************
+ _SurfaceEmbed_FreeContext()
+ ********************************************************************/
+
+void _SurfaceEmbed_FreeContext(void *pContext)
+{
+     free(pContext);
+}
+
+/********************************************************************
+ _SurfaceEmbed_EmbeddingInitialize()
+
+ Replaces the core initialization with the whole surface embedding
+ search, which leaves the graph sorted by DFI with no forward arcs or
+ DFS child lists, so the main loop of gp_Embed() does nothing.
+ ********************************************************************/
+
+int  _SurfaceEmbed_EmbeddingInitialize(graphP theGraph)
+{
+    SurfaceEmbedContext *context = NULL;
+    gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+
+    if (context != NULL)
+    {
+        if (_SurfaceEmbed_IsActive(theGraph))
+            return _SurfaceEmbed_Embed(theGraph, context);
+
+        return context->functions.fpEmbeddingInitialize(theGraph);
+    }
+
+    return NOTOK;
+}
+
+/********************************************************************
+ _SurfaceEmbed_EmbedPostprocess()
+ ********************************************************************/
+
+int  _SurfaceEmbed_EmbedPostprocess(graphP theGraph, int v, int edgeEmbeddingResult)
+{
+    SurfaceEmbedContext *context = NULL;
+    gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+
+    if (context == NULL)
+        return NOTOK;
+
+    if (_SurfaceEmbed_IsActive(theGraph))
+        return edgeEmbeddingResult == OK ? context->embedResult : NOTOK;
+
+    return context->functions.fpEmbedPostprocess(theGraph, v, edgeEmbeddingResult);
+}
+
+/********************************************************************
+ _SurfaceEmbed_CheckEmbeddingIntegrity()
+
+ theGraph must have the edges of origGraph, and its face walks must
+ give an Euler genus that fits the surface.
+ ********************************************************************/
+
+int  _SurfaceEmbed_CheckEmbeddingIntegrity(graphP theGraph, graphP origGraph)
+{
+     SurfaceEmbedContext *context = NULL;
+     gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+
+     if (context == NULL)
+         return NOTOK;
+
+     if (_SurfaceEmbed_IsActive(theGraph))
+     {
+         if (_TestSubgraph(theGraph, origGraph) != TRUE ||
+             _TestSubgraph(origGraph, theGraph) != TRUE ||
+             _SurfaceEmbed_CheckFacialIntegrity(theGraph) != OK)
+             return NOTOK;
+
+         return OK;
+     }
+
+     return context->functions.fpCheckEmbeddingIntegrity(theGraph, origGraph);
+}
+
+/********************************************************************
+ _SurfaceEmbed_CheckObstructionIntegrity()
+
+ A graph that does not embed keeps all of its edges.
+ ********************************************************************/
+
+int  _SurfaceEmbed_CheckObstructionIntegrity(graphP theGraph, graphP origGraph)
+{
+     SurfaceEmbedContext *context = NULL;
+     gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+
+     if (context == NULL)
+         return NOTOK;
+
+     if (_SurfaceEmbed_IsActive(theGraph))
+     {
+         if (_TestSubgraph(theGraph, origGraph) != TRUE ||
+             _TestSubgraph(origGraph, theGraph) != TRUE)
+             return NOTOK;
+
+         return OK;
+     }
+
+     return context->functions.fpCheckObstructionIntegrity(theGraph, origGraph);
+}
+
+/********************************************************************
+ _SurfaceEmbed_ReadPostprocess()
+
+ Marks the edges listed in the SurfaceEmbed section, if there is one,
+ as twisted.
+ ********************************************************************/
+
+int  _SurfaceEmbed_ReadPostprocess(graphP theGraph, void *extraData, long extraDataSize)
+{
+     SurfaceEmbedContext *context = NULL;
+     char tag[64], *pos, *end;
+     int  u, v, e, zeroBasedOffset;
+
+     gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+
+     if (context == NULL ||
+         context->functions.fpReadPostprocess(theGraph, extraData, extraDataSize) != OK)
+         return NOTOK;
+
+     sprintf(tag, "<%s>", SURFACEEMBED_NAME);
+     if (extraData == NULL || extraDataSize <= 0 || (pos = strstr((char *) extraData, tag)) == NULL)
+         return OK;
+
+     sprintf(tag, "</%s>", SURFACEEMBED_NAME);
+     if ((end = strstr(pos, tag)) == NULL)
+         return NOTOK;
+
+     zeroBasedOffset = (theGraph->internalFlags & FLAGS_ZEROBASEDIO) ? gp_GetFirstVertex(theGraph) : 0;
+
+     // Each line after the start tag gives the endpoints of a twisted edge
+     for (pos = strchr(pos, '\n'); pos != NULL && pos + 1 < end; pos = strchr(pos + 1, '\n'))
+     {
+          if (sscanf(pos + 1, " %d %d", &u, &v) != 2)
+              return NOTOK;
+
+          u += zeroBasedOffset;
+          v += zeroBasedOffset;
+          if (!gp_VertexInRange(theGraph, u) || u < gp_GetFirstVertex(theGraph) ||
+              !gp_VertexInRange(theGraph, v) || v < gp_GetFirstVertex(theGraph) ||
+              gp_IsNotArc(e = gp_GetNeighborEdgeRecord(theGraph, u, v)))
+              return NOTOK;
+
+          gp_SetEdgeFlagInverted(theGraph, e);
+          gp_SetEdgeFlagInverted(theGraph, gp_GetTwinArc(theGraph, e));
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _SurfaceEmbed_WritePostprocess()
+
+ After a projective plane embedding, appends the SurfaceEmbed section
+ with a line of endpoints for each twisted edge.
+ ********************************************************************/
+
+int  _SurfaceEmbed_WritePostprocess(graphP theGraph, void **pExtraData, long *pExtraDataSize)
+{
+     SurfaceEmbedContext *context = NULL;
+     char line[64], *extraData;
+     int  e, EsizeOccupied, extraDataPos = 0, maxLineSize = 64, zeroBasedOffset;
+
+     gp_FindExtension(theGraph, SURFACEEMBED_ID, (void *)&context);
+
+     if (context == NULL ||
+         context->functions.fpWritePostprocess(theGraph, pExtraData, pExtraDataSize) != OK)
+         return NOTOK;
+
+     if (theGraph->embedFlags != EMBEDFLAGS_PROJECTIVEPLANAR || context->embedResult != OK)
+         return OK;
+
+     if ((extraData = (char *) malloc((2 + theGraph->M) * maxLineSize * sizeof(char))) == NULL)
+         return NOTOK;
+
+     zeroBasedOffset = (theGraph->internalFlags & FLAGS_ZEROBASEDIO) ? gp_GetFirstVertex(theGraph) : 0;
+
+     sprintf(line, "<%s>\n", SURFACEEMBED_NAME);
+     strcpy(extraData+extraDataPos, line);
+     extraDataPos += (int) strlen(line);
+
+     EsizeOccupied = gp_EdgeInUseIndexBound(theGraph);
+     for (e = gp_GetFirstEdge(theGraph); e < EsizeOccupied; e += 2)
+     {
+          if (gp_EdgeInUse(theGraph, e) && gp_GetEdgeFlagInverted(theGraph, e))
+          {
+              sprintf(line, "%d %d\n", gp_GetNeighbor(theGraph, gp_GetTwinArc(theGraph, e)) - zeroBasedOffset,
+                                        gp_GetNeighbor(theGraph, e) - zeroBasedOffset);
+              strcpy(extraData+extraDataPos, line);
+              extraDataPos += (int) strlen(line);
+          }
+     }
+
+     sprintf(line, "</%s>\n", SURFACEEMBED_NAME);
+     strcpy(extraData+extraDataPos, line);
+     extraDataPos += (int) strlen(line);
+
+     free(*pExtraData);
+     *pExtraData = (void *) extraData;
+     *pExtraDataSize = extraDataPos * sizeof(char);
+
+     return OK;
+}
@@ -0,0 +1,1181 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "graph.h"
+
+/********************************************************************
+ Triconnected components
+
+ gp_GetTriconnectedComponents() follows Hopcroft and Tarjan, with the
+ corrections of Gutwenger and Mutzel.  Parallel edges are first split
+ off into bonds.  A depth first search then numbers the vertices and
+ computes the two lowest vertices reached by back edges from each
+ subtree, and the arcs out of each vertex are ordered so that a second
+ search reaches the lowest vertices first.  The second search numbers
+ the vertices again so that every path of the search descends, and a
+ final path search keeps the candidate separation pairs on a stack of
+ triples (h, a, b), where h is the highest vertex of the candidate.
+ Each separation pair {a, b} that is found splits the edges above it
+ off the edge stack into a split component and leaves a virtual edge
+ {a, b} in their place.  Bonds that share a virtual edge are merged at
+ the end, and so are polygons, which gives the unique triconnected
+ components in O(N+M) time.
+
+ The path search adds virtual edges and deletes and replaces arcs as
+ it goes, so it works on its own copy of the edges rather than on the
+ adjacency lists of the graph.  The searches are iterative, so deep
+ depth first search trees do not exhaust the call stack.
+ ********************************************************************/
+
+#define TC_NIL      (-1)
+
+// Edge types
+#define TC_UNSEEN   0
+#define TC_TREE     1
+#define TC_FROND    2
+#define TC_REMOVED  3
+
+// The end of segment marker on the triple stack
+#define TC_EOS      (-1)
+
+typedef struct
+{
+     int  n, M, m, capE, start, Result;
+
+     // Edges 0 to M-1 are the edges of the graph, the rest are virtual
+     int *src, *tgt, *type, *inAdj, *inHigh, *startsPath;
+
+     // Vertices
+     int *number, *lowpt1, *lowpt2, *nd, *father, *degree, *treeArc, *newnum, *nodeAt;
+
+     // The ordered lists of arcs out of each vertex
+     int *adjFirst, *adjLast, *adjEdge, *adjNext, *adjPrev, numAdj;
+
+     // The lists of the sources of the fronds into each vertex
+     int *highFirst, *highValue, *highOwner, *highNext, *highPrev, numHigh;
+
+     // The triple stack and the edge stack
+     int *tsH, *tsA, *tsB, top;
+     int *eStack, eTop;
+
+     // The split components
+     int *compType, *compStart, numComps, *compEdges, compSize, compCapacity;
+
+     // Work space for the searches
+     int *incStart, *incEdges, *pos, *stack, *frameIt, *frameNext, *frameEdge, *frameOutv;
+} tc_Context;
+
+/* Private functions */
+
+static int  _InitContext(tc_Context *c, int N, int M);
+static int  _SplitMultiEdges(tc_Context *c);
+static int  _DFS1(tc_Context *c);
+static void _BuildAcceptableAdjStruct(tc_Context *c);
+static void _PathFinder(tc_Context *c);
+static void _PathSearch(tc_Context *c);
+static void _AfterTreeArc(tc_Context *c, int v, int it, int e, int *outv);
+static int  _AssembleComponents(tc_Context *c, int *compTypes, int *compOffsets,
+                                int *compEdges, int *virtualEdges);
+static int  _NewEdge(tc_Context *c, int u, int v);
+static void _NewComp(tc_Context *c, int type);
+static void _CompAdd(tc_Context *c, int e);
+static void _FinishTricOrPoly(tc_Context *c, int e);
+static void _AdjDelete(tc_Context *c, int v, int k);
+static int  _HighPush(tc_Context *c, int v, int value, int front);
+static void _DelHigh(tc_Context *c, int e);
+static int  _Find(int *parent, int x);
+
+#define _High(c, v) ((c)->highFirst[v] == TC_NIL ? 0 : (c)->highValue[(c)->highFirst[v]])
+
+#define _TPush(c, h, a, b) \
+        ((c)->top++, (c)->tsH[(c)->top] = (h), (c)->tsA[(c)->top] = (a), (c)->tsB[(c)->top] = (b))
+#define _TPushEOS(c) ((c)->top++, (c)->tsA[(c)->top] = TC_EOS)
+
+#define _EPush(c, e) ((c)->eStack[(c)->eTop++] = (e))
+#define _EPop(c) ((c)->eStack[--(c)->eTop])
+#define _ETop(c) ((c)->eStack[(c)->eTop-1])
+
+// The degree two vertex w and its only child lie on a path that forms a
+// polygon with the tree arc into w
+#define _IsDegreeTwoPath(c, w) \
+        ((c)->degree[w] == 2 && (c)->adjFirst[w] != TC_NIL && \
+         (c)->newnum[(c)->tgt[(c)->adjEdge[(c)->adjFirst[w]]]] > (c)->newnum[w])
+
+/********************************************************************
+ gp_GetTriconnectedComponents()
+
+ Decomposes theGraph, which must be biconnected and have no loops, into
+ its triconnected components in O(N+M) time.  Each component is a bond
+ (two vertices joined by parallel edges, a P-node of the SPQR tree), a
+ polygon (a cycle, an S-node) or a rigid triconnected simple graph (an
+ R-node).  Components of the same kind are never joined by a virtual
+ edge, and the components joined by their virtual edges form the SPQR
+ tree.  A graph with two vertices is a single bond.
+
+ compTypes and compOffsets must have room for M and M+1 entries.
+ compTypes[c] receives TRICOMP_BOND, TRICOMP_POLYGON or TRICOMP_RIGID,
+ and the edges of component c are compEdges[compOffsets[c]] through
+ compEdges[compOffsets[c+1]-1], in no particular order, so compEdges
+ must have room for 3*M entries.  Edge k < M is the k-th edge listed by
+ gp_GetEdgeArray(), and edge M+j is the j-th virtual edge, which joins
+ the zero-based vertices virtualEdges[2j] and virtualEdges[2j+1] and
+ belongs to exactly two components.  There is one virtual edge fewer
+ than there are components, so virtualEdges must have room for 2*M
+ entries.
+
+ Returns the number of components, or -1 if theGraph is not biconnected
+ or on error.
+ ********************************************************************/
+
+int  gp_GetTriconnectedComponents(graphP theGraph, int *compTypes, int *compOffsets,
+                                  int *compEdges, int *virtualEdges)
+{
+tc_Context context, *c = &context;
+int  N, M, e, Result;
+
+     if (theGraph == NULL || compTypes == NULL || compOffsets == NULL ||
+         compEdges == NULL || virtualEdges == NULL)
+         return -1;
+
+     N = theGraph->N;
+     M = theGraph->M;
+     if (N < 2 || M < N - 1)
+         return -1;
+
+     if (_InitContext(c, N, M) != OK)
+     {
+         free(c->src);
+         return -1;
+     }
+
+     // gp_GetEdgeArray() does not list loops, so a graph with loops is
+     // caught by the count
+     if (gp_GetEdgeArray(theGraph, c->compEdges) != M)
+     {
+         free(c->src);
+         return -1;
+     }
+
+     for (e = 0; e < M; e++)
+     {
+         c->src[e] = c->compEdges[2*e];
+         c->tgt[e] = c->compEdges[2*e+1];
+         c->type[e] = TC_UNSEEN;
+         c->inAdj[e] = c->inHigh[e] = TC_NIL;
+         c->startsPath[e] = FALSE;
+     }
+     c->m = M;
+
+     if (N == 2)
+     {
+         compTypes[0] = TRICOMP_BOND;
+         compOffsets[0] = 0;
+         compOffsets[1] = M;
+         for (e = 0; e < M; e++)
+              compEdges[e] = e;
+         free(c->src);
+         return 1;
+     }
+
+     Result = _SplitMultiEdges(c);
+
+     if (Result == OK)
+         Result = _DFS1(c);
+
+     if (Result == OK)
+     {
+         _BuildAcceptableAdjStruct(c);
+         _PathFinder(c);
+         _PathSearch(c);
+
+         _NewComp(c, TC_NIL);
+         while (c->eTop > 0)
+             _CompAdd(c, _EPop(c));
+         c->compType[c->numComps-1] = c->compSize - c->compStart[c->numComps-1] >= 4
+                                    ? TRICOMP_RIGID : TRICOMP_POLYGON;
+         Result = c->Result;
+     }
+
+     if (Result == OK)
+         Result = _AssembleComponents(c, compTypes, compOffsets, compEdges, virtualEdges);
+     else
+         Result = -1;
+
+     free(c->src);
+     return Result;
+}
+
+/********************************************************************
+ _InitContext()
+ Allocates the arrays of the context in one block, which is freed with
+ c->src.  There are at most 3M/2 virtual edges, because the split
+ components have at most 3M-6 edges in all and each virtual edge is in
+ two of them, so room for 3M+6 edges leaves a wide margin.
+ ********************************************************************/
+
+static int  _InitContext(tc_Context *c, int N, int M)
+{
+int  n = N, capE = 3*M + 6, tsSize = 2*capE + 2, compCapacity = M + 2*capE;
+int  total, *p;
+
+     memset(c, 0, sizeof(tc_Context));
+
+     total = 18*capE + 19*n + 4 + 3*tsSize + compCapacity;
+
+     if ((p = (int *) malloc(total * sizeof(int))) == NULL)
+         return NOTOK;
+
+     c->src = p;         p += capE;
+     c->tgt = p;         p += capE;
+     c->type = p;        p += capE;
+     c->inAdj = p;       p += capE;
+     c->inHigh = p;      p += capE;
+     c->startsPath = p;  p += capE;
+
+     c->number = p;      p += n;
+     c->lowpt1 = p;      p += n;
+     c->lowpt2 = p;      p += n;
+     c->nd = p;          p += n;
+     c->father = p;      p += n;
+     c->degree = p;      p += n;
+     c->treeArc = p;     p += n;
+     c->newnum = p;      p += n;
+     c->nodeAt = p;      p += n+1;
+
+     c->adjFirst = p;    p += n;
+     c->adjLast = p;     p += n;
+     c->adjEdge = p;     p += capE;
+     c->adjNext = p;     p += capE;
+     c->adjPrev = p;     p += capE;
+
+     c->highFirst = p;   p += n;
+     c->highValue = p;   p += capE;
+     c->highOwner = p;   p += capE;
+     c->highNext = p;    p += capE;
+     c->highPrev = p;    p += capE;
+
+     c->tsH = p;         p += tsSize;
+     c->tsA = p;         p += tsSize;
+     c->tsB = p;         p += tsSize;
+     c->eStack = p;      p += capE;
+
+     c->compType = p;    p += capE+1;
+     c->compStart = p;   p += capE+1;
+     c->compEdges = p;   p += compCapacity;
+
+     c->incStart = p;    p += n+1;
+     c->incEdges = p;    p += 2*capE;
+     c->pos = p;         p += n;
+     c->stack = p;       p += n;
+     c->frameIt = p;     p += n;
+     c->frameNext = p;   p += n;
+     c->frameEdge = p;   p += n;
+     c->frameOutv = p;
+
+     c->n = N;
+     c->M = M;
+     c->capE = capE;
+     c->compCapacity = compCapacity;
+     c->start = 0;
+     c->Result = OK;
+
+     return OK;
+}
+
+/********************************************************************
+ _SplitMultiEdges()
+ Sorts the edges by their endpoints with two counting sorts, and splits
+ each bundle of parallel edges off into a bond with a new virtual edge,
+ which takes the place of the bundle in the graph.
+ ********************************************************************/
+
+static int  _SplitMultiEdges(tc_Context *c)
+{
+int  n = c->n, M = c->M, e, i, j, v, eVirt;
+int *count = c->incStart, *order = c->incEdges, *sorted = c->incEdges + M;
+
+     // Sort by the greater endpoint, then stably by the lesser endpoint
+     memset(count, 0, (n+1) * sizeof(int));
+     for (e = 0; e < M; e++)
+          count[c->tgt[e]+1]++;
+     for (v = 0; v < n; v++)
+          count[v+1] += count[v];
+     for (e = 0; e < M; e++)
+          order[count[c->tgt[e]]++] = e;
+
+     memset(count, 0, (n+1) * sizeof(int));
+     for (e = 0; e < M; e++)
+          count[c->src[e]+1]++;
+     for (v = 0; v < n; v++)
+          count[v+1] += count[v];
+     for (i = 0; i < M; i++)
+          sorted[count[c->src[order[i]]]++] = order[i];
+
+     for (i = 0; i < M; i = j)
+     {
+          e = sorted[i];
+          for (j = i+1; j < M && c->src[sorted[j]] == c->src[e] &&
+                                 c->tgt[sorted[j]] == c->tgt[e]; j++)
+               ;
+
+          if (j - i < 2)
+              continue;
+
+          eVirt = _NewEdge(c, c->src[e], c->tgt[e]);
+          _NewComp(c, TRICOMP_BOND);
+          _CompAdd(c, eVirt);
+          for (; i < j; i++)
+          {
+               _CompAdd(c, sorted[i]);
+               c->type[sorted[i]] = TC_REMOVED;
+          }
+     }
+
+     return c->Result;
+}
+
+/********************************************************************
+ _DFS1()
+ Numbers the vertices in depth first order from 1, records the father,
+ the number of descendants and the two lowest points of each vertex,
+ classifies the edges as tree arcs and fronds, and orients them from
+ father to child and from descendant to ancestor.
+
+ Returns NOTOK if the graph is not biconnected.
+ ********************************************************************/
+
+static int  _DFS1(tc_Context *c)
+{
+int  n = c->n, e, v, w, u, sp, numCount, rootChildren = 0, t;
+
+     // List the edges at each vertex
+     memset(c->incStart, 0, (n+1) * sizeof(int));
+     memset(c->degree, 0, n * sizeof(int));
+     for (e = 0; e < c->m; e++)
+          if (c->type[e] != TC_REMOVED)
+          {
+              c->degree[c->src[e]]++;
+              c->degree[c->tgt[e]]++;
+          }
+     for (v = 0; v < n; v++)
+     {
+          c->incStart[v+1] = c->incStart[v] + c->degree[v];
+          c->pos[v] = c->incStart[v];
+          c->number[v] = 0;
+     }
+     for (e = 0; e < c->m; e++)
+          if (c->type[e] != TC_REMOVED)
+          {
+              c->incEdges[c->pos[c->src[e]]++] = e;
+              c->incEdges[c->pos[c->tgt[e]]++] = e;
+          }
+     for (v = 0; v < n; v++)
+          c->pos[v] = c->incStart[v];
+
+     v = c->start;
+     numCount = 0;
+     c->number[v] = c->lowpt1[v] = c->lowpt2[v] = ++numCount;
+     c->father[v] = TC_NIL;
+     c->nd[v] = 1;
+     c->stack[sp = 0] = v;
+
+     while (sp >= 0)
+     {
+          v = c->stack[sp];
+
+          if (c->pos[v] < c->incStart[v+1])
+          {
+              e = c->incEdges[c->pos[v]++];
+              if (c->type[e] != TC_UNSEEN)
+                  continue;
+
+              w = c->src[e] == v ? c->tgt[e] : c->src[e];
+              if (c->number[w] == 0)
+              {
+                  c->type[e] = TC_TREE;
+                  c->treeArc[w] = e;
+                  c->father[w] = v;
+                  c->number[w] = c->lowpt1[w] = c->lowpt2[w] = ++numCount;
+                  c->nd[w] = 1;
+                  c->stack[++sp] = w;
+              }
+              else
+              {
+                  c->type[e] = TC_FROND;
+                  if (c->number[w] < c->lowpt1[v])
+                  {
+                      c->lowpt2[v] = c->lowpt1[v];
+                      c->lowpt1[v] = c->number[w];
+                  }
+                  else if (c->number[w] > c->lowpt1[v] && c->number[w] < c->lowpt2[v])
+                      c->lowpt2[v] = c->number[w];
+              }
+              continue;
+          }
+
+          // v is finished, so its lowpoints are passed up to its father
+          sp--;
+          if ((u = c->father[v]) == TC_NIL)
+              continue;
+
+          if (c->father[u] == TC_NIL)
+              rootChildren++;
+          else if (c->lowpt1[v] >= c->number[u])
+              return NOTOK;
+
+          if (c->lowpt1[v] < c->lowpt1[u])
+          {
+              c->lowpt2[u] = c->lowpt1[u] < c->lowpt2[v] ? c->lowpt1[u] : c->lowpt2[v];
+              c->lowpt1[u] = c->lowpt1[v];
+          }
+          else if (c->lowpt1[v] == c->lowpt1[u])
+          {
+              if (c->lowpt2[v] < c->lowpt2[u])
+                  c->lowpt2[u] = c->lowpt2[v];
+          }
+          else if (c->lowpt1[v] < c->lowpt2[u])
+              c->lowpt2[u] = c->lowpt1[v];
+
+          c->nd[u] += c->nd[v];
+     }
+
+     if (numCount < n || rootChildren != 1)
+         return NOTOK;
+
+     for (e = 0; e < c->m; e++)
+     {
+          if (c->type[e] == TC_REMOVED)
+              continue;
+
+          if ((c->number[c->tgt[e]] > c->number[c->src[e]]) == (c->type[e] == TC_FROND))
+          {
+              t = c->src[e];
+              c->src[e] = c->tgt[e];
+              c->tgt[e] = t;
+          }
+     }
+
+     return OK;
+}
+
+/********************************************************************
+ _BuildAcceptableAdjStruct()
+ Lists the arcs out of each vertex in order of their value phi, with a
+ bucket sort.  A tree arc v->w goes by lowpt1(w), and before the fronds
+ to lowpt1(w) unless lowpt2(w) >= v, and a frond v->w goes by w.
+ ********************************************************************/
+
+static void _BuildAcceptableAdjStruct(tc_Context *c)
+{
+int  n = c->n, maxPhi = 3*n + 3, e, v, w, k, i, phi;
+int *count = c->incEdges, *order = c->incEdges + maxPhi + 1;
+
+     memset(count, 0, (maxPhi+1) * sizeof(int));
+     for (e = 0; e < c->m; e++)
+     {
+          if (c->type[e] == TC_REMOVED)
+              continue;
+
+          w = c->tgt[e];
+          if (c->type[e] == TC_FROND)
+              phi = 3*c->number[w] + 1;
+          else
+              phi = c->lowpt2[w] < c->number[c->src[e]] ? 3*c->lowpt1[w] : 3*c->lowpt1[w] + 2;
+
+          c->inHigh[e] = phi;
+          count[phi]++;
+     }
+     for (i = 0, k = 0; i <= maxPhi; i++)
+     {
+          phi = count[i];
+          count[i] = k;
+          k += phi;
+     }
+     for (e = 0; e < c->m; e++)
+          if (c->type[e] != TC_REMOVED)
+              order[count[c->inHigh[e]]++] = e;
+
+     for (v = 0; v < n; v++)
+          c->adjFirst[v] = c->adjLast[v] = TC_NIL;
+
+     c->numAdj = 0;
+     for (i = 0; i < k; i++)
+     {
+          e = order[i];
+          v = c->src[e];
+          c->inHigh[e] = TC_NIL;
+
+          c->adjEdge[c->numAdj] = e;
+          c->adjNext[c->numAdj] = TC_NIL;
+          c->adjPrev[c->numAdj] = c->adjLast[v];
+          if (c->adjLast[v] == TC_NIL)
+              c->adjFirst[v] = c->numAdj;
+          else
+              c->adjNext[c->adjLast[v]] = c->numAdj;
+          c->adjLast[v] = c->numAdj;
+          c->inAdj[e] = c->numAdj++;
+     }
+}
+
+/********************************************************************
+ _PathFinder()
+ Numbers the vertices again so that the vertices of each subtree are
+ numbered after its later siblings and before its earlier ones, marks
+ the first arc of each path, and lists the sources of the fronds into
+ each vertex in the order they are found.  The lowpoints are then
+ converted to the new numbers.
+ ********************************************************************/
+
+static void _PathFinder(tc_Context *c)
+{
+int  n = c->n, numCount = n, newPath = TRUE, v, w, e, k, sp;
+int *cur = c->pos, *old2new = c->stack + 0;
+
+     for (v = 0; v < n; v++)
+          c->highFirst[v] = TC_NIL;
+     c->numHigh = 0;
+
+     v = c->start;
+     c->newnum[v] = numCount - c->nd[v] + 1;
+     cur[v] = c->adjFirst[v];
+     c->frameIt[sp = 0] = v;
+
+     while (sp >= 0)
+     {
+          v = c->frameIt[sp];
+
+          if ((k = cur[v]) == TC_NIL)
+          {
+              if (--sp >= 0)
+                  numCount--;
+              continue;
+          }
+
+          cur[v] = c->adjNext[k];
+          e = c->adjEdge[k];
+          w = c->tgt[e];
+
+          if (newPath)
+          {
+              newPath = FALSE;
+              c->startsPath[e] = TRUE;
+          }
+
+          if (c->type[e] == TC_TREE)
+          {
+              c->newnum[w] = numCount - c->nd[w] + 1;
+              cur[w] = c->adjFirst[w];
+              c->frameIt[++sp] = w;
+          }
+          else
+          {
+              c->inHigh[e] = _HighPush(c, w, c->newnum[v], FALSE);
+              newPath = TRUE;
+          }
+     }
+
+     // old2new is indexed by the old numbers, which start at 1
+     for (v = 0; v < n; v++)
+          old2new[c->number[v] - 1] = c->newnum[v];
+
+     for (v = 0; v < n; v++)
+     {
+          c->nodeAt[c->newnum[v]] = v;
+          c->lowpt1[v] = old2new[c->lowpt1[v] - 1];
+          c->lowpt2[v] = old2new[c->lowpt2[v] - 1];
+     }
+}
+
+/********************************************************************
+ _PathSearch()
+ Searches the paths from the start vertex, splitting off a component
+ for each separation pair that is found.  The frame of each vertex on
+ the search path holds its current arc, the arc after it, the tree arc
+ being followed, if any, and the number of tree arcs not yet finished.
+ ********************************************************************/
+
+static void _PathSearch(tc_Context *c)
+{
+int  sp, v, w, e, k, y, b, vnum, wnum, outv, lw;
+
+     c->top = 0;
+     c->tsA[0] = TC_EOS;
+     c->eTop = 0;
+
+     v = c->start;
+     c->stack[sp = 0] = v;
+     c->frameIt[0] = c->adjFirst[v];
+     c->frameEdge[0] = TC_NIL;
+     for (outv = 0, k = c->adjFirst[v]; k != TC_NIL; k = c->adjNext[k])
+          outv++;
+     c->frameOutv[0] = outv;
+
+     while (sp >= 0)
+     {
+          v = c->stack[sp];
+          vnum = c->newnum[v];
+
+          // Finish the tree arc that was followed from v
+          if (c->frameEdge[sp] != TC_NIL)
+          {
+              _AfterTreeArc(c, v, c->frameIt[sp], c->frameEdge[sp], &c->frameOutv[sp]);
+              c->frameEdge[sp] = TC_NIL;
+              c->frameIt[sp] = c->frameNext[sp];
+              continue;
+          }
+
+          if ((k = c->frameIt[sp]) == TC_NIL)
+          {
+              sp--;
+              continue;
+          }
+
+          c->frameNext[sp] = c->adjNext[k];
+          e = c->adjEdge[k];
+          w = c->tgt[e];
+          wnum = c->newnum[w];
+
+          if (c->type[e] == TC_TREE)
+          {
+              if (c->startsPath[e])
+              {
+                  lw = c->lowpt1[w];
+                  if (c->tsA[c->top] > lw)
+                  {
+                      y = 0;
+                      do {
+                          if (c->tsH[c->top] > y)
+                              y = c->tsH[c->top];
+                          b = c->tsB[c->top--];
+                      } while (c->tsA[c->top] > lw);
+
+                      if (wnum + c->nd[w] - 1 > y)
+                          y = wnum + c->nd[w] - 1;
+                      _TPush(c, y, lw, b);
+                  }
+                  else
+                      _TPush(c, wnum + c->nd[w] - 1, lw, vnum);
+                  _TPushEOS(c);
+              }
+
+              c->frameEdge[sp] = e;
+
+              c->stack[++sp] = w;
+              c->frameIt[sp] = c->adjFirst[w];
+              c->frameEdge[sp] = TC_NIL;
+              for (outv = 0, k = c->adjFirst[w]; k != TC_NIL; k = c->adjNext[k])
+                   outv++;
+              c->frameOutv[sp] = outv;
+          }
+          else
+          {
+              if (c->startsPath[e])
+              {
+                  if (c->tsA[c->top] > wnum)
+                  {
+                      y = 0;
+                      do {
+                          if (c->tsH[c->top] > y)
+                              y = c->tsH[c->top];
+                          b = c->tsB[c->top--];
+                      } while (c->tsA[c->top] > wnum);
+
+                      _TPush(c, y > vnum ? y : vnum, wnum, b);
+                  }
+                  else
+                      _TPush(c, vnum, wnum, vnum);
+              }
+
+              _EPush(c, e);
+              c->frameIt[sp] = c->frameNext[sp];
+          }
+     }
+}
+
+/********************************************************************
+ _AfterTreeArc()
+ Once the search returns to v over its tree arc e at position it of the
+ arc list of v, this splits off the components of the type 2 separation
+ pairs {v, b} and then of the type 1 separation pair {lowpt1(w), v},
+ and pops the triples that the rest of the search no longer needs.
+ ********************************************************************/
+
+static void _AfterTreeArc(tc_Context *c, int v, int it, int e, int *outv)
+{
+int  vnum = c->newnum[v], w = c->tgt[e], wnum = c->newnum[w];
+int  a, b, h, x, y, xnum, ynum, eVirt, eAB, e1, e2, eh, low;
+
+     _EPush(c, c->treeArc[w]);
+
+     // Type 2 separation pairs
+     while (vnum != 1 && (c->tsA[c->top] == vnum || _IsDegreeTwoPath(c, w)))
+     {
+          a = c->tsA[c->top];
+          b = c->tsB[c->top];
+
+          if (a == vnum && c->father[c->nodeAt[b]] == c->nodeAt[a])
+          {
+              c->top--;
+              continue;
+          }
+
+          eAB = TC_NIL;
+
+          if (_IsDegreeTwoPath(c, w))
+          {
+              e1 = _EPop(c);
+              e2 = _EPop(c);
+              _AdjDelete(c, w, c->inAdj[e2]);
+
+              x = c->tgt[e2];
+              eVirt = _NewEdge(c, v, x);
+              c->degree[x]--;
+              c->degree[v]--;
+
+              _NewComp(c, TRICOMP_POLYGON);
+              _CompAdd(c, e1);
+              _CompAdd(c, e2);
+              _CompAdd(c, eVirt);
+
+              if (c->eTop > 0)
+              {
+                  e1 = _ETop(c);
+                  if (c->src[e1] == x && c->tgt[e1] == v)
+                  {
+                      eAB = _EPop(c);
+                      _AdjDelete(c, x, c->inAdj[eAB]);
+                      _DelHigh(c, eAB);
+                  }
+              }
+          }
+          else
+          {
+              h = c->tsH[c->top--];
+
+              _NewComp(c, TC_NIL);
+              while (c->eTop > 0)
+              {
+                  eh = _ETop(c);
+                  x = c->src[eh];
+                  y = c->tgt[eh];
+                  xnum = c->newnum[x];
+                  ynum = c->newnum[y];
+                  if (!(a <= xnum && xnum <= h && a <= ynum && ynum <= h))
+                      break;
+
+                  c->eTop--;
+                  if ((xnum == a && ynum == b) || (ynum == a && xnum == b))
+                  {
+                      eAB = eh;
+                      _AdjDelete(c, x, c->inAdj[eh]);
+                      _DelHigh(c, eh);
+                  }
+                  else
+                  {
+                      if (it != c->inAdj[eh])
+                      {
+                          _AdjDelete(c, x, c->inAdj[eh]);
+                          _DelHigh(c, eh);
+                      }
+                      _CompAdd(c, eh);
+                      c->degree[x]--;
+                      c->degree[y]--;
+                  }
+              }
+
+              eVirt = _NewEdge(c, c->nodeAt[a], c->nodeAt[b]);
+              _FinishTricOrPoly(c, eVirt);
+              x = c->nodeAt[b];
+          }
+
+          if (eAB != TC_NIL)
+          {
+              _NewComp(c, TRICOMP_BOND);
+              _CompAdd(c, eAB);
+              _CompAdd(c, eVirt);
+              eVirt = _NewEdge(c, v, x);
+              _CompAdd(c, eVirt);
+              c->degree[x]--;
+              c->degree[v]--;
+          }
+
+          _EPush(c, eVirt);
+          c->adjEdge[it] = eVirt;
+          c->inAdj[eVirt] = it;
+
+          c->degree[x]++;
+          c->degree[v]++;
+          c->father[x] = v;
+          c->treeArc[x] = eVirt;
+          c->type[eVirt] = TC_TREE;
+
+          w = x;
+          wnum = c->newnum[w];
+     }
+
+     // Type 1 separation pair
+     if (c->lowpt2[w] >= vnum && c->lowpt1[w] < vnum &&
+         (c->father[v] != c->start || *outv >= 2))
+     {
+          xnum = ynum = 0;
+          _NewComp(c, TC_NIL);
+          while (c->eTop > 0)
+          {
+              eh = _ETop(c);
+              xnum = c->newnum[c->src[eh]];
+              ynum = c->newnum[c->tgt[eh]];
+              if (!((wnum <= xnum && xnum < wnum + c->nd[w]) ||
+                    (wnum <= ynum && ynum < wnum + c->nd[w])))
+                  break;
+
+              c->eTop--;
+              _CompAdd(c, eh);
+              _DelHigh(c, eh);
+              c->degree[c->src[eh]]--;
+              c->degree[c->tgt[eh]]--;
+          }
+
+          low = c->nodeAt[c->lowpt1[w]];
+          eVirt = _NewEdge(c, v, low);
+          _FinishTricOrPoly(c, eVirt);
+
+          if ((xnum == vnum && ynum == c->lowpt1[w]) || (ynum == vnum && xnum == c->lowpt1[w]))
+          {
+              _NewComp(c, TRICOMP_BOND);
+              eh = _EPop(c);
+              if (it != c->inAdj[eh])
+                  _AdjDelete(c, c->src[eh], c->inAdj[eh]);
+              _CompAdd(c, eh);
+              _CompAdd(c, eVirt);
+              eVirt = _NewEdge(c, v, low);
+              _CompAdd(c, eVirt);
+
+              // The virtual edge takes over the place of eh among the fronds into low
+              c->inHigh[eVirt] = c->inHigh[eh];
+              c->inHigh[eh] = TC_NIL;
+              c->degree[v]--;
+              c->degree[low]--;
+          }
+
+          if (low != c->father[v])
+          {
+              _EPush(c, eVirt);
+              c->adjEdge[it] = eVirt;
+              c->inAdj[eVirt] = it;
+              if (c->inHigh[eVirt] == TC_NIL && _High(c, low) < vnum)
+                  c->inHigh[eVirt] = _HighPush(c, low, vnum, TRUE);
+              c->degree[v]++;
+              c->degree[low]++;
+          }
+          else
+          {
+              _AdjDelete(c, v, it);
+
+              _NewComp(c, TRICOMP_BOND);
+              _CompAdd(c, eVirt);
+              eVirt = _NewEdge(c, low, v);
+              _CompAdd(c, eVirt);
+
+              eh = c->treeArc[v];
+              _CompAdd(c, eh);
+
+              c->treeArc[v] = eVirt;
+              c->type[eVirt] = TC_TREE;
+              c->inAdj[eVirt] = c->inAdj[eh];
+              c->adjEdge[c->inAdj[eh]] = eVirt;
+          }
+     }
+
+     if (c->startsPath[e])
+     {
+          while (c->tsA[c->top] != TC_EOS)
+              c->top--;
+          c->top--;
+     }
+
+     while (c->tsA[c->top] != TC_EOS && c->tsB[c->top] != vnum &&
+            _High(c, v) > c->tsH[c->top])
+          c->top--;
+
+     (*outv)--;
+}
+
+/********************************************************************
+ _AssembleComponents()
+ Merges the bonds that share a virtual edge, and the polygons that
+ share a virtual edge, and writes out the merged components.  Returns
+ the number of components.
+ ********************************************************************/
+
+static int  _AssembleComponents(tc_Context *c, int *compTypes, int *compOffsets,
+                                int *compEdges, int *virtualEdges)
+{
+int  M = c->M, i, j, k, e, r, numOut = 0, numVirtual = 0, total = 0;
+int *comp1 = c->inAdj, *comp2 = c->inHigh, *parent = c->incEdges, *outIndex = c->tsH;
+int *virtualId = c->tsA, *size = c->tsB;
+
+     for (e = 0; e < c->m; e++)
+     {
+          comp1[e] = comp2[e] = TC_NIL;
+          virtualId[e] = TC_NIL;
+     }
+
+     for (i = 0; i < c->numComps; i++)
+     {
+          parent[i] = i;
+          size[i] = 0;
+          for (k = c->compStart[i]; k < (i+1 < c->numComps ? c->compStart[i+1] : c->compSize); k++)
+          {
+              e = c->compEdges[k];
+              if (comp1[e] == TC_NIL)
+                  comp1[e] = i;
+              else
+                  comp2[e] = i;
+          }
+     }
+
+     // A virtual edge between two bonds or two polygons is merged away
+     for (e = M; e < c->m; e++)
+     {
+          if (comp1[e] == TC_NIL || comp2[e] == TC_NIL)
+              continue;
+
+          i = _Find(parent, comp1[e]);
+          j = _Find(parent, comp2[e]);
+          if (c->compType[comp1[e]] == c->compType[comp2[e]] &&
+              c->compType[comp1[e]] != TRICOMP_RIGID && i != j)
+          {
+              parent[j] = i;
+              c->type[e] = TC_REMOVED;
+          }
+     }
+
+     for (i = 0; i < c->numComps; i++)
+     {
+          r = _Find(parent, i);
+          for (k = c->compStart[i]; k < (i+1 < c->numComps ? c->compStart[i+1] : c->compSize); k++)
+               if (c->compEdges[k] < M || c->type[c->compEdges[k]] != TC_REMOVED)
+                   size[r]++;
+     }
+
+     for (i = 0; i < c->numComps; i++)
+     {
+          outIndex[i] = TC_NIL;
+          if (parent[i] == i && size[i] > 0)
+          {
+              if (numOut >= M)
+                  return -1;
+              compTypes[numOut] = c->compType[i];
+              compOffsets[numOut] = total;
+              outIndex[i] = numOut++;
+              total += size[i];
+              size[i] = compOffsets[outIndex[i]];
+          }
+     }
+
+     if (total > 3*M)
+         return -1;
+     compOffsets[numOut] = total;
+
+     for (i = 0; i < c->numComps; i++)
+     {
+          r = _Find(parent, i);
+          for (k = c->compStart[i]; k < (i+1 < c->numComps ? c->compStart[i+1] : c->compSize); k++)
+          {
+               e = c->compEdges[k];
+               if (e >= M)
+               {
+                   if (c->type[e] == TC_REMOVED)
+                       continue;
+
+                   if (virtualId[e] == TC_NIL)
+                   {
+                       if (numVirtual >= M)
+                           return -1;
+                       virtualEdges[2*numVirtual] = c->src[e];
+                       virtualEdges[2*numVirtual+1] = c->tgt[e];
+                       virtualId[e] = numVirtual++;
+                   }
+                   compEdges[size[r]++] = M + virtualId[e];
+               }
+               else
+                   compEdges[size[r]++] = e;
+          }
+     }
+
+     return numOut;
+}
+
+/********************************************************************
+ _NewEdge()
+ Adds the virtual edge u->v.  The capacity is never reached, but if it
+ were then the last edge would be reused and the error recorded.
+ ********************************************************************/
+
+static int  _NewEdge(tc_Context *c, int u, int v)
+{
+int  e;
+
+     if (c->m >= c->capE)
+     {
+         c->Result = NOTOK;
+         return c->m - 1;
+     }
+
+     e = c->m++;
+     c->src[e] = u;
+     c->tgt[e] = v;
+     c->type[e] = TC_UNSEEN;
+     c->inAdj[e] = c->inHigh[e] = TC_NIL;
+     c->startsPath[e] = FALSE;
+     return e;
+}
+
+/********************************************************************
+ _NewComp(), _CompAdd(), _FinishTricOrPoly()
+ A split component is built completely before the next one is begun,
+ so the edges of each component are contiguous in c->compEdges.
+ ********************************************************************/
+
+static void _NewComp(tc_Context *c, int type)
+{
+     if (c->numComps > c->capE)
+     {
+         c->Result = NOTOK;
+         c->numComps--;
+     }
+
+     c->compType[c->numComps] = type;
+     c->compStart[c->numComps++] = c->compSize;
+}
+
+static void _CompAdd(tc_Context *c, int e)
+{
+     if (c->compSize >= c->compCapacity)
+         c->Result = NOTOK;
+     else
+         c->compEdges[c->compSize++] = e;
+}
+
+static void _FinishTricOrPoly(tc_Context *c, int e)
+{
+     _CompAdd(c, e);
+     c->compType[c->numComps-1] = c->compSize - c->compStart[c->numComps-1] >= 4
+                                ? TRICOMP_RIGID : TRICOMP_POLYGON;
+}
+
+/********************************************************************
+ _AdjDelete()
+ Removes the list node k from the arc list of v.
+ ********************************************************************/
+
+static void _AdjDelete(tc_Context *c, int v, int k)
+{
+     if (c->adjPrev[k] == TC_NIL)
+         c->adjFirst[v] = c->adjNext[k];
+     else
+         c->adjNext[c->adjPrev[k]] = c->adjNext[k];
+
+     if (c->adjNext[k] == TC_NIL)
+         c->adjLast[v] = c->adjPrev[k];
+     else
+         c->adjPrev[c->adjNext[k]] = c->adjPrev[k];
+}
+
+/********************************************************************
+ _HighPush()
+ Adds value to the front or the back of the frond list of v, and
+ returns its list node.  Only the front of each list is ever read, so
+ the lists are singly linked forward from the front, with the back
+ found through the previous link of the front node.
+ ********************************************************************/
+
+static int  _HighPush(tc_Context *c, int v, int value, int front)
+{
+int  k, first = c->highFirst[v];
+
+     if (c->numHigh >= c->capE)
+     {
+         c->Result = NOTOK;
+         return TC_NIL;
+     }
+
+     k = c->numHigh++;
+     c->highValue[k] = value;
+     c->highOwner[k] = v;
+
+     if (first == TC_NIL)
+     {
+         c->highNext[k] = TC_NIL;
+         c->highPrev[k] = k;
+         c->highFirst[v] = k;
+     }
+     else if (front)
+     {
+         c->highNext[k] = first;
+         c->highPrev[k] = c->highPrev[first];
+         c->highPrev[first] = k;
+         c->highFirst[v] = k;
+     }
+     else
+     {
+         c->highNext[k] = TC_NIL;
+         c->highPrev[k] = c->highPrev[first];
+         c->highNext[c->highPrev[first]] = k;
+         c->highPrev[first] = k;
+     }
+
+     return k;
+}
+
+/********************************************************************
+ _DelHigh()
+ Removes the frond e from the frond list it is in, if any.
+ ********************************************************************/
+
+static void _DelHigh(tc_Context *c, int e)
+{
+int  k = c->inHigh[e], v, first;
+
+     if (k == TC_NIL)
+         return;
+
+     v = c->highOwner[k];
+     first = c->highFirst[v];
+     c->inHigh[e] = TC_NIL;
+
+     if (k == first)
+     {
+         if ((c->highFirst[v] = c->highNext[k]) != TC_NIL)
+             c->highPrev[c->highNext[k]] = c->highPrev[k];
+     }
+     else
+     {
+         c->highNext[c->highPrev[k]] = c->highNext[k];
+         if (c->highNext[k] != TC_NIL)
+             c->highPrev[c->highNext[k]] = c->highPrev[k];
+         else
+             c->highPrev[first] = c->highPrev[k];
+     }
+}
+
+/********************************************************************
+ _Find()
+ Union-find root with path halving.
+ ********************************************************************/
+
+static int  _Find(int *parent, int x)
+{
+     while (parent[x] != x)
+     {
+         parent[x] = parent[parent[x]];
+         x = parent[x];
+     }
+     return x;
+}
@@ -69,7 +69,13 @@ void _InitEdges(graphP theGraph);
 
 void _ClearGraph(graphP theGraph);
 
-int  _GetRandomNumber(int NMin, int NMax);
+int  _GetRandomNumber(prngP theRNG, int NMin, int NMax);
+unsigned long long _GetSeedFromRand(void);
+int  _CreateRandomTriangulation(graphP theGraph, prngP theRNG);
+void _DeleteRandomEdges(graphP theGraph, int *edgeList, int listSize, int numToDelete, prngP theRNG);
+
+static unsigned long long *_NewHashSet(unsigned long long minSize, int *pHashShift);
+static unsigned long long _FindHashSlot(unsigned long long *hashTable, int hashShift, unsigned long long key);
 
 /* Private functions for which there are FUNCTION POINTERS */
 
@@ -1054,17 +1060,37 @@ graphP result;
 /********************************************************************
  gp_CreateRandomGraph()
 
+ Creates a randomly generated graph as gp_CreateRandomGraphR() does,
+ using a generator seeded from rand(), so the caller's srand() still
+ determines the graph generated.
+
+ Returns OK on success, NOTOK on failure
+ ********************************************************************/
+
+int  gp_CreateRandomGraph(graphP theGraph)
+{
+prngState theRNG;
+
+     prng_Seed(&theRNG, _GetSeedFromRand());
+     return gp_CreateRandomGraphR(theGraph, &theRNG);
+}
+
+/********************************************************************
+ gp_CreateRandomGraphR()
+
  Creates a randomly generated graph.  First a tree is created by
  connecting each vertex to some successor.  Then a random number of
  additional random edges are added.  If an edge already exists, then
  we retry until a non-existent edge is picked.
 
- This function assumes the caller has already called srand().
+ All random choices are drawn from theRNG, so the same seed produces
+ the same graph, and different threads can generate graphs at the
+ same time using different generators.
 
  Returns OK on success, NOTOK on failure
  ********************************************************************/
 
-int  gp_CreateRandomGraph(graphP theGraph)
+int  gp_CreateRandomGraphR(graphP theGraph, prngP theRNG)
 {
 int N, M, u, v, m;
 
@@ -1077,7 +1103,7 @@ int N, M, u, v, m;
 
  	for (v = gp_GetFirstVertex(theGraph)+1; gp_VertexInRange(theGraph, v); v++)
  	{
- 		 u = _GetRandomNumber(gp_GetFirstVertex(theGraph), v-1);
+ 		 u = _GetRandomNumber(theRNG, gp_GetFirstVertex(theGraph), v-1);
          if (gp_AddEdge(theGraph, u, 0, v, 0) != OK)
              return NOTOK;
  	}
@@ -1086,15 +1112,15 @@ int N, M, u, v, m;
         (actually, leave open a small chance that no
         additional edges will be added). */
 
-     M = _GetRandomNumber(7*N/8, theGraph->arcCapacity/2);
+     M = _GetRandomNumber(theRNG, 7*N/8, theGraph->arcCapacity/2);
 
      if (M > N*(N-1)/2)
     	 M = N*(N-1)/2;
 
      for (m = N-1; m < M; m++)
      {
-          u = _GetRandomNumber(gp_GetFirstVertex(theGraph), gp_GetLastVertex(theGraph)-1);
-          v = _GetRandomNumber(u+1, gp_GetLastVertex(theGraph));
+          u = _GetRandomNumber(theRNG, gp_GetFirstVertex(theGraph), gp_GetLastVertex(theGraph)-1);
+          v = _GetRandomNumber(theRNG, u+1, gp_GetLastVertex(theGraph));
 
           // If the edge (u,v) exists, decrement eIndex to try again
           if (gp_IsNeighbor(theGraph, u, v))
@@ -1113,25 +1139,31 @@ int N, M, u, v, m;
 
 /********************************************************************
  _GetRandomNumber()
- This function generates a random number between NMin and NMax
- inclusive.  It assumes that the caller has called srand().
- It calls rand(), but before truncating to the proper range,
- it adds the high bits of the rand() result into the low bits.
- The result of this is that the randomness appearing in the
- truncated bits also has an affect on the non-truncated bits.
+ This function generates a uniformly distributed random number
+ between NMin and NMax inclusive using the given generator.
  ********************************************************************/
 
-int  _GetRandomNumber(int NMin, int NMax)
+int  _GetRandomNumber(prngP theRNG, int NMin, int NMax)
 {
-int  N = rand();
+     return prng_GetRandomNumber(theRNG, NMin, NMax);
+}
 
-     if (NMax < NMin) return NMin;
+/********************************************************************
+ _GetSeedFromRand()
+ Combines several rand() results into a 64-bit seed, so that the
+ functions that predate the explicit generator state are still
+ determined by the caller's srand().
+ ********************************************************************/
 
-     N += ((N&0xFFFF0000)>>16);
-     N += ((N&0x0000FF00)>>8);
-     N &= 0x7FFFFFF;
-     N %= (NMax-NMin+1);
-     return N+NMin;
+unsigned long long _GetSeedFromRand(void)
+{
+unsigned long long seed = 0;
+int  I;
+
+     for (I = 0; I < 4; I++)
+          seed = (seed << 16) ^ (unsigned long long) rand();
+
+     return seed;
 }
 
 /********************************************************************
@@ -1207,6 +1239,21 @@ int e = gp_GetFirstArc(theGraph, parent);
 
 /********************************************************************
  gp_CreateRandomGraphEx()
+ Creates a random graph with the specified number of edges as
+ gp_CreateRandomGraphExR() does, using a generator seeded from rand(),
+ so the caller's srand() still determines the graph generated.
+ ********************************************************************/
+
+int  gp_CreateRandomGraphEx(graphP theGraph, int numEdges)
+{
+prngState theRNG;
+
+     prng_Seed(&theRNG, _GetSeedFromRand());
+     return gp_CreateRandomGraphExR(theGraph, numEdges, &theRNG);
+}
+
+/********************************************************************
+ gp_CreateRandomGraphExR()
  Given a graph structure with a pre-specified number of vertices N,
  this function creates a graph with the specified number of edges.
 
@@ -1214,10 +1261,10 @@ int e = gp_GetFirstArc(theGraph, parent);
  numEdges is larger, then a maximal planar graph is generated, then
  (numEdges - 3N + 6) additional random edges are added.
 
- This function assumes the caller has already called srand().
+ All random choices are drawn from theRNG.
  ********************************************************************/
 
-int  gp_CreateRandomGraphEx(graphP theGraph, int numEdges)
+int  gp_CreateRandomGraphExR(graphP theGraph, int numEdges, prngP theRNG)
 {
 int N, arc, M, root, v, c, p, last, u, e, EsizeOccupied;
 
@@ -1230,7 +1277,7 @@ int N, arc, M, root, v, c, p, last, u, e, EsizeOccupied;
 
  	for (v = gp_GetFirstVertex(theGraph)+1; gp_VertexInRange(theGraph, v); v++)
     {
-        u = _GetRandomNumber(gp_GetFirstVertex(theGraph), v-1);
+        u = _GetRandomNumber(theRNG, gp_GetFirstVertex(theGraph), v-1);
         if (gp_AddEdge(theGraph, u, 0, v, 0) != OK)
             return NOTOK;
 
@@ -1318,8 +1365,8 @@ int N, arc, M, root, v, c, p, last, u, e, EsizeOccupied;
 
     while (theGraph->M < numEdges)
     {
-        u = _GetRandomNumber(gp_GetFirstVertex(theGraph), gp_GetLastVertex(theGraph));
-        v = _GetRandomNumber(gp_GetFirstVertex(theGraph), gp_GetLastVertex(theGraph));
+        u = _GetRandomNumber(theRNG, gp_GetFirstVertex(theGraph), gp_GetLastVertex(theGraph));
+        v = _GetRandomNumber(theRNG, gp_GetFirstVertex(theGraph), gp_GetLastVertex(theGraph));
 
         if (u != v && !gp_IsNeighbor(theGraph, u, v))
             if (gp_AddEdge(theGraph, u, 0, v, 0) != OK)
@@ -1343,6 +1390,333 @@ int N, arc, M, root, v, c, p, last, u, e, EsizeOccupied;
     return OK;
 }
 
+/********************************************************************
+ _CreateRandomTriangulation()
+ Creates a random maximal planar graph on the N vertices of theGraph
+ by random triangulation growth: starting from the triangle 1, 2, 3,
+ each further vertex v is placed in a face chosen uniformly at random
+ from the faces of the triangulation so far (including the outer face),
+ and joined to the three vertices of that face, which splits the face
+ into three faces.  This takes O(N) time since no edge is tested for
+ existence.
+
+ The edges are added in a fixed pattern: (1,2), (2,3), (3,1), then
+ three edges for each vertex v >= 4, the first of which is to a vertex
+ less than v.  Edges 0, 1 and 3(v-3) (counting from 0 in the order
+ added) therefore form a spanning tree.  _CreateRandomPlanarGraph()
+ depends on this pattern.
+
+ For N < 3, the graph created is a path.
+ ********************************************************************/
+
+int  _CreateRandomTriangulation(graphP theGraph, prngP theRNG)
+{
+int  N = theGraph->N, numFaces, f, a, b, c, v;
+int  *faces;
+
+     if (N < 3)
+         return N == 2 ? gp_AddEdge(theGraph, 1, 0, 2, 0) : OK;
+
+     if ((faces = (int *) malloc(3 * (2*N - 4) * sizeof(int))) == NULL)
+         return NOTOK;
+
+     if (gp_AddEdge(theGraph, 1, 0, 2, 0) != OK ||
+         gp_AddEdge(theGraph, 2, 0, 3, 0) != OK ||
+         gp_AddEdge(theGraph, 3, 0, 1, 0) != OK)
+     {
+         free(faces);
+         return NOTOK;
+     }
+
+     // The inner and outer faces of the triangle
+     faces[0] = 1; faces[1] = 2; faces[2] = 3;
+     faces[3] = 1; faces[4] = 3; faces[5] = 2;
+     numFaces = 2;
+
+     for (v = 4; v <= N; v++)
+     {
+          f = prng_GetRandomNumber(theRNG, 0, numFaces-1);
+          a = faces[3*f];
+          b = faces[3*f+1];
+          c = faces[3*f+2];
+
+          if (gp_AddEdge(theGraph, v, 0, a, 0) != OK ||
+              gp_AddEdge(theGraph, v, 0, b, 0) != OK ||
+              gp_AddEdge(theGraph, v, 0, c, 0) != OK)
+          {
+              free(faces);
+              return NOTOK;
+          }
+
+          // Face (a,b,c) becomes (a,b,v), and faces (b,c,v) and (c,a,v) are new
+          faces[3*f+2] = v;
+          faces[3*numFaces] = b; faces[3*numFaces+1] = c; faces[3*numFaces+2] = v;
+          numFaces++;
+          faces[3*numFaces] = c; faces[3*numFaces+1] = a; faces[3*numFaces+2] = v;
+          numFaces++;
+     }
+
+     free(faces);
+     return OK;
+}
+
+/********************************************************************
+ _DeleteRandomEdges()
+ Deletes numToDelete edges chosen uniformly at random from the
+ listSize edges in edgeList, by a partial Fisher-Yates shuffle of the
+ list.  The edgeList is reordered.
+ ********************************************************************/
+
+void _DeleteRandomEdges(graphP theGraph, int *edgeList, int listSize, int numToDelete, prngP theRNG)
+{
+int  I, J, e;
+
+     if (numToDelete > listSize)
+         numToDelete = listSize;
+
+     for (I = 0; I < numToDelete; I++)
+     {
+          J = prng_GetRandomNumber(theRNG, I, listSize-1);
+          e = edgeList[J];
+          edgeList[J] = edgeList[I];
+          edgeList[I] = e;
+
+          gp_DeleteEdge(theGraph, e, 0);
+     }
+}
+
+/********************************************************************
+ gp_CreateRandomMaximalPlanarGraph()
+ Given a graph structure with N vertices and no edges, creates a
+ random maximal planar graph (3N-6 edges for N >= 3) in O(N) time by
+ random triangulation growth.  All random choices are drawn from theRNG.
+
+ Returns OK on success, NOTOK on failure
+ ********************************************************************/
+
+int  gp_CreateRandomMaximalPlanarGraph(graphP theGraph, prngP theRNG)
+{
+     if (theGraph == NULL || theRNG == NULL || theGraph->N <= 0 || theGraph->M != 0)
+         return NOTOK;
+
+     return _CreateRandomTriangulation(theGraph, theRNG);
+}
+
+/********************************************************************
+ gp_CreateRandomPlanarGraph()
+ Given a graph structure with N vertices and no edges, creates a
+ random planar graph with numEdges edges in O(N) time.  The graph must
+ not have had edges deleted since it was initialized or reinitialized.  A random
+ maximal planar graph is created, then edges are deleted at random
+ until numEdges remain.  If numEdges >= N-1, then only edges outside
+ of a spanning tree are deleted, so the graph is connected.
+ If numEdges exceeds 3N-6, then a maximal planar graph is created.
+
+ All random choices are drawn from theRNG.
+
+ Returns OK on success, NOTOK on failure
+ ********************************************************************/
+
+int  gp_CreateRandomPlanarGraph(graphP theGraph, int numEdges, prngP theRNG)
+{
+int  N, numTreeEdges, numOtherEdges, k, v;
+int  *edgeList;
+
+     // The edge positions are computed from the order in which the edges
+     // are added, so deleted edges must not have left holes to be reused
+     if (theGraph == NULL || theRNG == NULL || theGraph->N <= 0 || theGraph->M != 0 ||
+         sp_NonEmpty(theGraph->edgeHoles))
+         return NOTOK;
+
+     N = theGraph->N;
+     if (_CreateRandomTriangulation(theGraph, theRNG) != OK)
+         return NOTOK;
+
+     if (numEdges < 0)
+         numEdges = 0;
+
+     if (numEdges >= theGraph->M)
+         return OK;
+
+     if ((edgeList = (int *) malloc(theGraph->M * sizeof(int))) == NULL)
+         return NOTOK;
+
+     // List the edges outside of the spanning tree first, then the tree
+     // edges, according to the order in which _CreateRandomTriangulation()
+     // added them (the k-th edge added is at arc gp_GetFirstEdge() + 2k)
+     numOtherEdges = 0;
+     if (N >= 3)
+     {
+         edgeList[numOtherEdges++] = gp_GetFirstEdge(theGraph) + 2*2;
+         for (v = 4; v <= N; v++)
+         {
+              k = 3*(v-3);
+              edgeList[numOtherEdges++] = gp_GetFirstEdge(theGraph) + 2*(k+1);
+              edgeList[numOtherEdges++] = gp_GetFirstEdge(theGraph) + 2*(k+2);
+         }
+     }
+
+     numTreeEdges = 0;
+     for (k = 0; k < theGraph->M; k++)
+          if (k < 2 || (k >= 3 && k % 3 == 0))
+              edgeList[numOtherEdges + numTreeEdges++] = gp_GetFirstEdge(theGraph) + 2*k;
+
+     k = theGraph->M - numEdges;
+     _DeleteRandomEdges(theGraph, edgeList, numOtherEdges, k, theRNG);
+     if (k > numOtherEdges)
+         _DeleteRandomEdges(theGraph, edgeList + numOtherEdges, numTreeEdges, k - numOtherEdges, theRNG);
+
+     free(edgeList);
+     return OK;
+}
+
+/********************************************************************
+ gp_CreateRandomOuterplanarGraph()
+ Given a graph structure with N vertices and no edges, creates a
+ random outerplanar graph with numEdges edges in O(N) time.  As for
+ gp_CreateRandomPlanarGraph(), the graph must not have had edges deleted
+ since it was initialized or reinitialized.
+
+ A random maximal outerplanar graph (2N-3 edges) is grown from the
+ triangle 1, 2, 3 by repeatedly choosing a random edge (u, w) of the
+ outer cycle and adding a new vertex v adjacent to u and w, so that
+ (u, v) and (v, w) replace (u, w) on the outer cycle.  Then chords
+ are deleted at random until numEdges remain, and if numEdges < N
+ then edges of the outer cycle are also deleted at random.
+
+ All random choices are drawn from theRNG.
+
+ Returns OK on success, NOTOK on failure
+ ********************************************************************/
+
+int  gp_CreateRandomOuterplanarGraph(graphP theGraph, int numEdges, prngP theRNG)
+{
+int  N, numOuterEdges, numChords, I, u, v, w, e, Result = OK;
+int  *outerEdges = NULL, *edgeList = NULL;
+
+     // As in gp_CreateRandomPlanarGraph(), each new edge must be at the
+     // end of the edges in use rather than in a hole left by a deleted edge
+     if (theGraph == NULL || theRNG == NULL || theGraph->N <= 0 || theGraph->M != 0 ||
+         sp_NonEmpty(theGraph->edgeHoles))
+         return NOTOK;
+
+     N = theGraph->N;
+     if (N < 3)
+         return N == 2 && numEdges > 0 ? gp_AddEdge(theGraph, 1, 0, 2, 0) : OK;
+
+     // Each outer cycle edge is kept as the triple (u, w, arc)
+     if ((outerEdges = (int *) malloc(3 * N * sizeof(int))) == NULL ||
+         (edgeList = (int *) malloc((2*N - 3) * sizeof(int))) == NULL)
+     {
+         if (outerEdges != NULL) free(outerEdges);
+         return NOTOK;
+     }
+
+     numOuterEdges = 0;
+     for (u = 1; u <= 3 && Result == OK; u++)
+     {
+          w = u % 3 + 1;
+          Result = gp_AddEdge(theGraph, u, 0, w, 0);
+          outerEdges[3*numOuterEdges] = u;
+          outerEdges[3*numOuterEdges+1] = w;
+          outerEdges[3*numOuterEdges+2] = gp_EdgeInUseIndexBound(theGraph) - 2;
+          numOuterEdges++;
+     }
+
+     // Each time an outer edge is split, it becomes a chord
+     numChords = 0;
+     for (v = 4; v <= N && Result == OK; v++)
+     {
+          I = prng_GetRandomNumber(theRNG, 0, numOuterEdges-1);
+          u = outerEdges[3*I];
+          w = outerEdges[3*I+1];
+          edgeList[numChords++] = outerEdges[3*I+2];
+
+          if ((Result = gp_AddEdge(theGraph, u, 0, v, 0)) != OK)
+              break;
+          outerEdges[3*I+1] = v;
+          outerEdges[3*I+2] = gp_EdgeInUseIndexBound(theGraph) - 2;
+
+          if ((Result = gp_AddEdge(theGraph, v, 0, w, 0)) != OK)
+              break;
+          outerEdges[3*numOuterEdges] = v;
+          outerEdges[3*numOuterEdges+1] = w;
+          outerEdges[3*numOuterEdges+2] = gp_EdgeInUseIndexBound(theGraph) - 2;
+          numOuterEdges++;
+     }
+
+     if (Result == OK && numEdges < theGraph->M)
+     {
+         e = theGraph->M - (numEdges < 0 ? 0 : numEdges);
+
+         for (I = 0; I < numOuterEdges; I++)
+              edgeList[numChords + I] = outerEdges[3*I+2];
+
+         _DeleteRandomEdges(theGraph, edgeList, numChords, e, theRNG);
+         if (e > numChords)
+             _DeleteRandomEdges(theGraph, edgeList + numChords, numOuterEdges, e - numChords, theRNG);
+     }
+
+     free(outerEdges);
+     free(edgeList);
+     return Result == OK ? OK : NOTOK;
+}
+
+/********************************************************************
+ gp_CreateRandomNearPlanarGraph()
+ Given a graph structure with N vertices and no edges, creates a
+ random maximal planar graph as gp_CreateRandomMaximalPlanarGraph()
+ does, then adds numExtraEdges random edges between non-adjacent
+ vertices.  For N >= 5 and numExtraEdges > 0, the result is nonplanar
+ but only barely so, which exercises the obstruction isolation code
+ on large inputs.  The arc capacity is increased if needed.
+
+ The time is O(N) for the maximal planar graph, plus the time to test
+ each random candidate edge for existence with gp_IsNeighbor().
+
+ All random choices are drawn from theRNG.
+
+ Returns OK on success, NOTOK on failure
+ ********************************************************************/
+
+int  gp_CreateRandomNearPlanarGraph(graphP theGraph, int numExtraEdges, prngP theRNG)
+{
+int  N, u, v, numNonEdges;
+
+     if (theGraph == NULL || theRNG == NULL || theGraph->N <= 0 || theGraph->M != 0)
+         return NOTOK;
+
+     N = theGraph->N;
+     if (_CreateRandomTriangulation(theGraph, theRNG) != OK)
+         return NOTOK;
+
+     // Do not try to add more edges than there are pairs of non-adjacent vertices
+     numNonEdges = (int) (((long long) N * (N-1)) / 2 - theGraph->M < 0x7FFFFFFF ?
+    		              ((long long) N * (N-1)) / 2 - theGraph->M : 0x7FFFFFFF);
+     if (numExtraEdges > numNonEdges)
+         numExtraEdges = numNonEdges;
+     if (numExtraEdges <= 0)
+         return OK;
+
+     if (gp_EnsureArcCapacity(theGraph, 2*(theGraph->M + numExtraEdges)) != OK)
+         return NOTOK;
+
+     while (numExtraEdges > 0)
+     {
+          u = prng_GetRandomNumber(theRNG, 1, N);
+          v = prng_GetRandomNumber(theRNG, 1, N);
+
+          if (u != v && !gp_IsNeighbor(theGraph, u, v))
+          {
+              if (gp_AddEdge(theGraph, u, 0, v, 0) != OK)
+                  return NOTOK;
+              numExtraEdges--;
+          }
+     }
+
+     return OK;
+}
+
 /********************************************************************
  gp_IsNeighbor()
 
@@ -1504,6 +1878,444 @@ int  e, degree;
      return degree;
 }
 
+/********************************************************************
+ gp_GetEdgeArray()
+
+ Lists the edges of the graph in the integer array edgeArray, which
+ must have room for 2*M entries.  The endpoints of the k-th edge are
+ stored in edgeArray[2k] and edgeArray[2k+1] as zero-based vertex
+ indices (i.e. v - gp_GetFirstVertex()), the lesser endpoint first.
+ Edges are listed in order of their lesser endpoint and, for each
+ vertex, in the order of its adjacency list.  This is the same order
+ in which gp_DrawPlanar_GetArrays() lists edge positions.
+
+ Returns the number of edges listed, or -1 on error.
+ ********************************************************************/
+
+int  gp_GetEdgeArray(graphP theGraph, int *edgeArray)
+{
+int  v, w, e, first, numEdges = 0;
+
+     if (theGraph == NULL || (edgeArray == NULL && theGraph->M > 0))
+         return -1;
+
+     first = gp_GetFirstVertex(theGraph);
+     for (v = first; gp_VertexInRange(theGraph, v); v++)
+     {
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              w = gp_GetNeighbor(theGraph, e);
+              if (w > v)
+              {
+                  if (numEdges >= theGraph->M)
+                      return -1;
+
+                  edgeArray[2*numEdges] = v - first;
+                  edgeArray[2*numEdges+1] = w - first;
+                  numEdges++;
+              }
+              e = gp_GetNextArc(theGraph, e);
+          }
+     }
+
+     return numEdges;
+}
+
+/********************************************************************
+ gp_GetRotationSystem()
+
+ Stores the adjacency lists of the graph in compressed sparse row form.
+ The neighbors of the zero-based vertex i are stored, in adjacency list
+ order, in neighbors[offsets[i]] to neighbors[offsets[i+1]-1], again
+ as zero-based vertex indices.  After a successful planar embedding,
+ the adjacency list order of each vertex is its rotation in the
+ combinatorial planar embedding.
+
+ offsets must have room for N+1 entries and neighbors for 2*M entries.
+
+ Returns the number of arcs stored, or -1 on error.
+ ********************************************************************/
+
+int  gp_GetRotationSystem(graphP theGraph, int *offsets, int *neighbors)
+{
+int  v, e, first, numArcs = 0;
+
+     if (theGraph == NULL || offsets == NULL || (neighbors == NULL && theGraph->M > 0))
+         return -1;
+
+     first = gp_GetFirstVertex(theGraph);
+     for (v = first; gp_VertexInRange(theGraph, v); v++)
+     {
+          offsets[v - first] = numArcs;
+
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              if (numArcs >= 2*theGraph->M)
+                  return -1;
+
+              neighbors[numArcs++] = gp_GetNeighbor(theGraph, e) - first;
+              e = gp_GetNextArc(theGraph, e);
+          }
+     }
+     offsets[theGraph->N] = numArcs;
+
+     return numArcs;
+}
+
+/********************************************************************
+ gp_GetFaces()
+
+ Lists the faces of the embedding in one pass over the arcs.  Arcs are
+ identified by their position in the neighbors array of
+ gp_GetRotationSystem(), so arc k goes from the vertex whose range of
+ positions contains k to neighbors[k].  A face is traversed by going
+ from each arc e to the arc after the twin of e in the adjacency list
+ of its head vertex (circularly), the same walk that the embedding
+ integrity test makes.
+
+ The face containing arc k is stored in arcFaces[k], and the arcs of
+ face f are stored, in traversal order, in faceArcs[faceOffsets[f]] to
+ faceArcs[faceOffsets[f+1]-1].  Faces are numbered in the order of
+ their first arc.  Each connected component with edges has its own
+ outer face, and isolated vertices are in no face.
+
+ arcFaces and faceArcs must have room for 2*M entries, and faceOffsets
+ for 2*M+1 entries (the number of faces plus one is enough if known).
+
+ Returns the number of faces, or -1 on error, including when the
+ adjacency lists do not form a consistent rotation system.
+ ********************************************************************/
+
+int  gp_GetFaces(graphP theEmbedding, int *arcFaces, int *faceOffsets, int *faceArcs)
+{
+int  v, e, eStart, k, first, numArcs = 0, numFaces = 0, numListed = 0;
+int *arcPosition;
+
+     if (theEmbedding == NULL || faceOffsets == NULL ||
+         ((arcFaces == NULL || faceArcs == NULL) && theEmbedding->M > 0))
+         return -1;
+
+     if ((arcPosition = (int *) malloc(gp_EdgeIndexBound(theEmbedding) * sizeof(int))) == NULL)
+         return -1;
+
+     for (e = gp_GetFirstEdge(theEmbedding); e < gp_EdgeIndexBound(theEmbedding); e++)
+          arcPosition[e] = -1;
+
+     // Number the arcs in rotation system order
+     first = gp_GetFirstVertex(theEmbedding);
+     for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+     {
+          e = gp_GetFirstArc(theEmbedding, v);
+          while (gp_IsArc(e))
+          {
+              if (numArcs >= 2*theEmbedding->M || arcPosition[e] >= 0)
+              {
+                  free(arcPosition);
+                  return -1;
+              }
+              arcFaces[numArcs] = -1;
+              arcPosition[e] = numArcs++;
+              e = gp_GetNextArc(theEmbedding, e);
+          }
+     }
+
+     if (numArcs != 2*theEmbedding->M)
+     {
+         free(arcPosition);
+         return -1;
+     }
+
+     // Walk the face of each arc not yet in a face, in the same order
+     for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+     {
+          eStart = gp_GetFirstArc(theEmbedding, v);
+          while (gp_IsArc(eStart))
+          {
+              if (arcFaces[arcPosition[eStart]] < 0)
+              {
+                  faceOffsets[numFaces] = numListed;
+                  e = eStart;
+                  do {
+                      k = arcPosition[e];
+                      if (k < 0 || arcFaces[k] >= 0)
+                      {
+                          free(arcPosition);
+                          return -1;
+                      }
+                      arcFaces[k] = numFaces;
+                      faceArcs[numListed++] = k;
+
+                      e = gp_GetNextArcCircular(theEmbedding, gp_GetTwinArc(theEmbedding, e));
+                  } while (e != eStart);
+
+                  numFaces++;
+              }
+              eStart = gp_GetNextArc(theEmbedding, eStart);
+          }
+     }
+     faceOffsets[numFaces] = numListed;
+
+     free(arcPosition);
+     return numFaces;
+}
+
+/********************************************************************
+ gp_CreateDualGraph()
+
+ Creates in theDual, a graph from gp_New() that has not been
+ initialized, the dual of the embedding in theEmbedding, in O(N+M)
+ time.  The zero-based vertex f of the dual is the face f listed by
+ gp_GetFaces(), and each edge of the embedding is crossed by one edge
+ of the dual, between the faces on its two sides.  A bridge gives a
+ loop in the dual, and faces that share more than one edge are joined
+ by parallel edges.  The arcs of each dual vertex are in the order of
+ the arcs around its face, so the dual is itself embedded, and its
+ faces correspond to the vertices of the embedding.  Each connected
+ component has its own outer face, so the dual of a disconnected graph
+ is the disjoint union of the duals of its components.
+
+ Arcs are identified by their positions in gp_GetRotationSystem(), for
+ the embedding and for the dual.  If not NULL, arcDualArcs[k] receives
+ the dual arc that crosses arc k, which goes from the face of arc k to
+ the face of its twin arc, and dualArcArcs receives the inverse
+ correspondence.  Each must have room for 2*M entries.
+
+ The embedding must have at least one edge.
+
+ Returns OK on success, NOTOK on failure.
+ ********************************************************************/
+
+int  gp_CreateDualGraph(graphP theEmbedding, graphP theDual, int *arcDualArcs, int *dualArcArcs)
+{
+int  M, v, e, d, k, j, f, first, numFaces, numArcs = 0, Result = OK;
+int *arcFaces = NULL, *faceOffsets = NULL, *faceArcs = NULL;
+int *arcPosition = NULL, *twinPositions = NULL, *dualArcs = NULL;
+
+     if (theEmbedding == NULL || theDual == NULL || theDual->N > 0 || theEmbedding->M <= 0)
+         return NOTOK;
+
+     M = theEmbedding->M;
+     if ((arcFaces = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (faceOffsets = (int *) malloc((2 * M + 1) * sizeof(int))) == NULL ||
+         (faceArcs = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (arcPosition = (int *) malloc(gp_EdgeIndexBound(theEmbedding) * sizeof(int))) == NULL ||
+         (twinPositions = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (dualArcs = (int *) malloc(2 * M * sizeof(int))) == NULL ||
+         (numFaces = gp_GetFaces(theEmbedding, arcFaces, faceOffsets, faceArcs)) <= 0)
+         Result = NOTOK;
+
+     // Find the position of the twin of each arc (gp_GetFaces() has
+     // checked that the adjacency lists hold each of the 2M arcs once)
+     if (Result == OK)
+     {
+         first = gp_GetFirstVertex(theEmbedding);
+         for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+         {
+              e = gp_GetFirstArc(theEmbedding, v);
+              while (gp_IsArc(e))
+              {
+                  arcPosition[e] = numArcs++;
+                  e = gp_GetNextArc(theEmbedding, e);
+              }
+         }
+
+         for (v = first; gp_VertexInRange(theEmbedding, v); v++)
+         {
+              e = gp_GetFirstArc(theEmbedding, v);
+              while (gp_IsArc(e))
+              {
+                  twinPositions[arcPosition[e]] = arcPosition[gp_GetTwinArc(theEmbedding, e)];
+                  e = gp_GetNextArc(theEmbedding, e);
+              }
+         }
+     }
+
+     // Add a dual edge for each edge, between the faces of its two arcs
+     if (Result == OK &&
+         (gp_EnsureArcCapacity(theDual, 2 * M) != OK || gp_InitGraph(theDual, numFaces) != OK))
+         Result = NOTOK;
+
+     first = gp_GetFirstVertex(theDual);
+     for (k = 0; k < 2 * M && Result == OK; k++)
+     {
+          if (twinPositions[k] < k)
+              continue;
+
+          if (gp_AddEdge(theDual, arcFaces[k] + first, 0, arcFaces[twinPositions[k]] + first, 0) != OK)
+              Result = NOTOK;
+          else
+          {
+              d = gp_GetFirstArc(theDual, arcFaces[k] + first);
+              dualArcs[k] = d;
+              dualArcs[twinPositions[k]] = gp_GetTwinArc(theDual, d);
+          }
+     }
+
+     // Relink the arcs of each dual vertex in the order around its face
+     if (Result == OK)
+     {
+         for (f = 0; f < numFaces; f++)
+         {
+              gp_SetFirstArc(theDual, f + first, NIL);
+              gp_SetLastArc(theDual, f + first, NIL);
+
+              for (j = faceOffsets[f]; j < faceOffsets[f+1]; j++)
+                   gp_AttachArc(theDual, f + first, NIL, 1, dualArcs[faceArcs[j]]);
+         }
+
+         for (j = 0; j < 2 * M; j++)
+         {
+              if (arcDualArcs != NULL)
+                  arcDualArcs[faceArcs[j]] = j;
+              if (dualArcArcs != NULL)
+                  dualArcArcs[j] = faceArcs[j];
+         }
+
+         theDual->embedFlags = theEmbedding->embedFlags;
+     }
+
+     free(arcFaces);
+     free(faceOffsets);
+     free(faceArcs);
+     free(arcPosition);
+     free(twinPositions);
+     free(dualArcs);
+
+     return Result;
+}
+
+/********************************************************************
+ gp_GetSharedFaces()
+
+ For each of numPairs pairs of vertices, finds a face of the embedding
+ that contains both, so that an edge between them can be added in that
+ face without changing the rest of the embedding.  The k-th pair is
+ pairs[2k] and pairs[2k+1], as zero-based vertex indices like
+ gp_AddEdgesFromArray().
+
+ The faces are listed once by gp_GetFaces() and sharedFaces[k] receives
+ a face of the k-th pair numbered as there, or -1 if the two vertices
+ are in different connected components, which can be joined in any
+ face, or -2 if they share no face or are the same vertex.
+
+ The faces at each vertex are those of its arcs, and the pairs of a
+ vertex and one of its faces are put in a hash set.  Each pair is then
+ answered by looking up the other vertex with the faces of the one of
+ lower degree, so it costs O(min(deg(u), deg(v))).
+
+ Returns OK on success, NOTOK on failure, including when a vertex is
+ out of range.
+ ********************************************************************/
+
+int  gp_GetSharedFaces(graphP theEmbedding, int numPairs, int *pairs, int *sharedFaces)
+{
+unsigned long long *hashTable = NULL, key;
+int  M, v, e, k, j, u, x, y, first, head, tail, hashShift, Result = OK;
+int *arcFaces = NULL, *faceOffsets = NULL, *faceArcs = NULL, *arcOffsets = NULL;
+int *component = NULL, *queue = NULL;
+
+     if (theEmbedding == NULL || numPairs < 0 || (numPairs > 0 && (pairs == NULL || sharedFaces == NULL)))
+         return NOTOK;
+
+     for (k = 0; k < 2 * numPairs; k++)
+          if (pairs[k] < 0 || pairs[k] >= theEmbedding->N)
+              return NOTOK;
+
+     M = theEmbedding->M;
+
+     if ((arcFaces = (int *) malloc((2 * M + 1) * sizeof(int))) == NULL ||
+         (faceOffsets = (int *) malloc((2 * M + 1) * sizeof(int))) == NULL ||
+         (faceArcs = (int *) malloc((2 * M + 1) * sizeof(int))) == NULL ||
+         (arcOffsets = (int *) malloc((theEmbedding->N + 1) * sizeof(int))) == NULL ||
+         (component = (int *) malloc(theEmbedding->N * sizeof(int))) == NULL ||
+         (queue = (int *) malloc(theEmbedding->N * sizeof(int))) == NULL ||
+         (hashTable = _NewHashSet(4 * (unsigned long long) M, &hashShift)) == NULL ||
+         gp_GetFaces(theEmbedding, arcFaces, faceOffsets, faceArcs) < 0)
+         Result = NOTOK;
+
+     // Put each vertex with the faces of its arcs in the hash set, and
+     // label each vertex with the first vertex of its connected component
+     if (Result == OK)
+     {
+         first = gp_GetFirstVertex(theEmbedding);
+         for (v = 0; v < theEmbedding->N; v++)
+              component[v] = -1;
+
+         for (v = 0, j = 0; v < theEmbedding->N; v++)
+         {
+              arcOffsets[v] = j;
+              for (e = gp_GetFirstArc(theEmbedding, v + first); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e), j++)
+              {
+                   // Key zero marks an empty slot, so the keys are offset by one
+                   key = (((unsigned long long) v << 32) | (unsigned) arcFaces[j]) + 1;
+                   hashTable[_FindHashSlot(hashTable, hashShift, key)] = key;
+              }
+
+              if (component[v] < 0)
+              {
+                  component[v] = v;
+                  queue[0] = v;
+                  for (head = 0, tail = 1; head < tail; head++)
+                  {
+                       x = queue[head];
+                       for (e = gp_GetFirstArc(theEmbedding, x + first); gp_IsArc(e); e = gp_GetNextArc(theEmbedding, e))
+                       {
+                            y = gp_GetNeighbor(theEmbedding, e) - first;
+                            if (component[y] < 0)
+                            {
+                                component[y] = v;
+                                queue[tail++] = y;
+                            }
+                       }
+                  }
+              }
+         }
+         arcOffsets[theEmbedding->N] = j;
+     }
+
+     for (k = 0; k < numPairs && Result == OK; k++)
+     {
+          u = pairs[2*k];
+          v = pairs[2*k+1];
+          sharedFaces[k] = component[u] != component[v] ? -1 : -2;
+          if (u == v || sharedFaces[k] == -1)
+              continue;
+
+          if (arcOffsets[u+1] - arcOffsets[u] <= arcOffsets[v+1] - arcOffsets[v])
+          {
+              x = u;
+              y = v;
+          }
+          else
+          {
+              x = v;
+              y = u;
+          }
+
+          for (j = arcOffsets[x]; j < arcOffsets[x+1]; j++)
+          {
+               key = (((unsigned long long) y << 32) | (unsigned) arcFaces[j]) + 1;
+               if (hashTable[_FindHashSlot(hashTable, hashShift, key)] == key)
+               {
+                   sharedFaces[k] = arcFaces[j];
+                   break;
+               }
+          }
+     }
+
+     free(arcFaces);
+     free(faceOffsets);
+     free(faceArcs);
+     free(arcOffsets);
+     free(component);
+     free(queue);
+     free(hashTable);
+
+     return Result;
+}
+
 /********************************************************************
  gp_AttachArc()
 
@@ -1646,6 +2458,170 @@ int  upos, vpos;
      return OK;
 }
 
+/********************************************************************
+ gp_AddEdgesFromArray()
+
+ Adds a batch of numEdges undirected edges to the graph.  The endpoints
+ of the k-th edge are given by edgeArray[2k] and edgeArray[2k+1] as
+ zero-based vertex indices, i.e. the format produced by gp_GetEdgeArray().
+
+ An edge that repeats an earlier edge of the batch, in either direction,
+ is not added.  Repeats are detected with a hash set of endpoint pairs,
+ so the batch costs O(numEdges) rather than a search of an adjacency
+ list per edge.  Edges already in the graph before the call are not
+ checked.  If duplicates is not NULL, it receives the index k of each
+ skipped edge, so it needs room for up to numEdges entries.
+
+ As with gp_AddEdge(), edges beyond the arc capacity are not added.
+
+ Returns the number of skipped repeated edges, or -1 if an endpoint is
+ out of range or memory could not be allocated.
+ ********************************************************************/
+
+int  gp_AddEdgesFromArray(graphP theGraph, int numEdges, int *edgeArray, int *duplicates)
+{
+unsigned long long *hashTable, key, slot;
+int  k, u, v, first, hashShift, numDuplicates = 0;
+
+     if (theGraph == NULL || numEdges < 0 || (edgeArray == NULL && numEdges > 0))
+         return -1;
+
+     if ((hashTable = _NewHashSet(2 * (unsigned long long) numEdges, &hashShift)) == NULL)
+         return -1;
+
+     first = gp_GetFirstVertex(theGraph);
+     for (k = 0; k < numEdges; k++)
+     {
+          u = edgeArray[2*k];
+          v = edgeArray[2*k+1];
+          if (u < 0 || v < 0 || u >= theGraph->N || v >= theGraph->N)
+          {
+              free(hashTable);
+              return -1;
+          }
+
+          // Key zero marks an empty slot, so the keys are offset by one
+          key = u < v ? ((unsigned long long) u << 32) | (unsigned) v
+                      : ((unsigned long long) v << 32) | (unsigned) u;
+          key++;
+
+          slot = _FindHashSlot(hashTable, hashShift, key);
+          if (hashTable[slot] == key)
+          {
+              if (duplicates != NULL)
+                  duplicates[numDuplicates] = k;
+              numDuplicates++;
+              continue;
+          }
+          hashTable[slot] = key;
+
+          if (gp_AddEdge(theGraph, u + first, 0, v + first, 0) == NOTOK)
+          {
+              free(hashTable);
+              return -1;
+          }
+     }
+
+     free(hashTable);
+     return numDuplicates;
+}
+
+/********************************************************************
+ _NewHashSet()
+ Allocates an empty open addressing hash set of 64-bit keys, with a
+ power of two number of slots that is at least minSize, and sets
+ *pHashShift to 64 minus the log of that number for _FindHashSlot().
+ Zero marks an empty slot, so zero cannot be a key.
+
+ Returns the slot array, to be freed with free(), or NULL on failure.
+ ********************************************************************/
+
+static unsigned long long *_NewHashSet(unsigned long long minSize, int *pHashShift)
+{
+unsigned long long hashSize = 1;
+
+     *pHashShift = 64;
+     while (hashSize < minSize)
+     {
+         hashSize <<= 1;
+         (*pHashShift)--;
+     }
+
+     return (unsigned long long *) calloc(hashSize, sizeof(unsigned long long));
+}
+
+/********************************************************************
+ _FindHashSlot()
+ Returns the slot of a hash set made by _NewHashSet() that holds key,
+ or else the empty slot where key belongs.  The home slot is found by
+ Fibonacci hashing, and then the slots are probed linearly.
+ ********************************************************************/
+
+static unsigned long long _FindHashSlot(unsigned long long *hashTable, int hashShift, unsigned long long key)
+{
+unsigned long long slot, hashMask;
+
+     if (hashShift >= 64)
+         return 0;
+
+     hashMask = ~0ULL >> hashShift;
+     slot = (key * 0x9E3779B97F4A7C15ULL) >> hashShift;
+     while (hashTable[slot] != 0 && hashTable[slot] != key)
+         slot = (slot + 1) & hashMask;
+
+     return slot;
+}
+
+/********************************************************************
+ gp_AddEdgesFromCompressed()
+
+ Adds the edges of a sparse adjacency matrix given in compressed sparse
+ row (CSR) or compressed sparse column (CSC) form.  The minor indices
+ stored for the zero-based major index i are indices[indptr[i]] to
+ indices[indptr[i+1]-1], for i from 0 to N-1.
+
+ Only entries above the diagonal of the matrix are used, so each edge of
+ a symmetric matrix is added once and self-loops are ignored.  For CSR,
+ the major index is the row, so the entries used are those whose minor
+ index is greater than i; for CSC, set minorIsRow to TRUE so the entries
+ used are those whose minor index is less than i.
+
+ The matrix is assumed to have no repeated entries.  As with gp_AddEdge(),
+ edges beyond the arc capacity are not added.
+
+ Returns OK, or NOTOK if an index is out of range.
+ ********************************************************************/
+
+int  gp_AddEdgesFromCompressed(graphP theGraph, int *indptr, int *indices, int minorIsRow)
+{
+int  i, j, k, first;
+
+     if (theGraph == NULL || indptr == NULL)
+         return NOTOK;
+
+     first = gp_GetFirstVertex(theGraph);
+     for (i = 0; i < theGraph->N; i++)
+     {
+          if (indptr[i] > indptr[i+1] || (indices == NULL && indptr[i] < indptr[i+1]))
+              return NOTOK;
+
+          for (k = indptr[i]; k < indptr[i+1]; k++)
+          {
+               j = indices[k];
+               if (j < 0 || j >= theGraph->N)
+                   return NOTOK;
+
+               if (minorIsRow ? j < i : j > i)
+               {
+                   if (gp_AddEdge(theGraph, i + first, 0, j + first, 0) == NOTOK)
+                       return NOTOK;
+               }
+          }
+     }
+
+     return OK;
+}
+
 /********************************************************************
  gp_InsertEdge()
 
@@ -0,0 +1,209 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "appconst.h"
+#include "latencyHistogram.h"
+#include <stdlib.h>
+
+static int _lh_GetBucketIndex(long long ns);
+static long long _lh_GetBucketUpperBound(int index);
+
+/****************************************************************************
+ lh_New()
+ Creates an empty latency histogram.
+ ****************************************************************************/
+
+latencyHistogramP lh_New(void)
+{
+latencyHistogramP theHist;
+
+     theHist = (latencyHistogramP) malloc(sizeof(latencyHistogram));
+
+     if (theHist != NULL)
+         lh_Reset(theHist);
+
+     return theHist;
+}
+
+/****************************************************************************
+ lh_Free()
+ ****************************************************************************/
+
+void lh_Free(latencyHistogramP *pHist)
+{
+     if (pHist == NULL || *pHist == NULL) return;
+
+     free(*pHist);
+     *pHist = NULL;
+}
+
+/****************************************************************************
+ lh_Reset()
+ Discards all samples collected so far.
+ ****************************************************************************/
+
+void lh_Reset(latencyHistogramP theHist)
+{
+     memset(theHist->counts, 0, sizeof(theHist->counts));
+     theHist->numSamples = 0;
+     theHist->minNs = theHist->maxNs = theHist->totalNs = 0;
+}
+
+/****************************************************************************
+ _lh_GetBucketIndex()
+ Values less than 2^(LH_SUBBUCKET_BITS+1) each get their own bucket.
+ Larger values with highest set bit e are placed in one of LH_SUBBUCKET_COUNT
+ buckets of width 2^(e-LH_SUBBUCKET_BITS) according to the next
+ LH_SUBBUCKET_BITS bits below the highest set bit.
+ ****************************************************************************/
+
+static int _lh_GetBucketIndex(long long ns)
+{
+unsigned long long v;
+int e = 0;
+
+     if (ns < 2*LH_SUBBUCKET_COUNT)
+         return ns < 0 ? 0 : (int) ns;
+
+     v = (unsigned long long) ns;
+     while (v >>= 1)
+         e++;
+
+     return (e - LH_SUBBUCKET_BITS + 1) * LH_SUBBUCKET_COUNT +
+            (int) ((ns >> (e - LH_SUBBUCKET_BITS)) & (LH_SUBBUCKET_COUNT - 1));
+}
+
+/****************************************************************************
+ _lh_GetBucketUpperBound()
+ Returns the largest nanosecond value that maps to the given bucket index.
+ ****************************************************************************/
+
+static long long _lh_GetBucketUpperBound(int index)
+{
+int e, sub;
+long long width;
+
+     if (index < 2*LH_SUBBUCKET_COUNT)
+         return index;
+
+     e = index / LH_SUBBUCKET_COUNT + LH_SUBBUCKET_BITS - 1;
+     sub = index % LH_SUBBUCKET_COUNT;
+     width = 1LL << (e - LH_SUBBUCKET_BITS);
+
+     return ((long long) (LH_SUBBUCKET_COUNT + sub)) * width + width - 1;
+}
+
+/****************************************************************************
+ lh_AddSample()
+ Records one latency measurement, given in nanoseconds.
+ ****************************************************************************/
+
+int  lh_AddSample(latencyHistogramP theHist, long long ns)
+{
+     if (theHist == NULL || ns < 0)
+         return NOTOK;
+
+     if (theHist->numSamples == 0 || ns < theHist->minNs)
+         theHist->minNs = ns;
+     if (ns > theHist->maxNs)
+         theHist->maxNs = ns;
+
+     theHist->counts[_lh_GetBucketIndex(ns)]++;
+     theHist->numSamples++;
+     theHist->totalNs += ns;
+
+     return OK;
+}
+
+/****************************************************************************
+ lh_Merge()
+ Adds all samples of histSrc into histDst, e.g. to combine the histograms
+ collected separately by several workers.
+ ****************************************************************************/
+
+int  lh_Merge(latencyHistogramP histDst, latencyHistogramP histSrc)
+{
+int  I;
+
+     if (histDst == NULL || histSrc == NULL)
+         return NOTOK;
+
+     if (histSrc->numSamples == 0)
+         return OK;
+
+     if (histDst->numSamples == 0 || histSrc->minNs < histDst->minNs)
+         histDst->minNs = histSrc->minNs;
+     if (histSrc->maxNs > histDst->maxNs)
+         histDst->maxNs = histSrc->maxNs;
+
+     for (I = 0; I < LH_NUMBUCKETS; I++)
+          histDst->counts[I] += histSrc->counts[I];
+
+     histDst->numSamples += histSrc->numSamples;
+     histDst->totalNs += histSrc->totalNs;
+
+     return OK;
+}
+
+/****************************************************************************
+ lh_GetPercentile()
+ Returns the latency in nanoseconds at or below which the given percentage
+ of samples fall, or 0 if there are no samples.  The result is the upper
+ bound of the bucket containing the percentile, clamped to the observed
+ minimum and maximum so that e.g. the 100th percentile is the exact maximum.
+ ****************************************************************************/
+
+long long lh_GetPercentile(latencyHistogramP theHist, double percentile)
+{
+unsigned long long rank, cumulative = 0;
+long long value;
+int  I;
+
+     if (theHist == NULL || theHist->numSamples == 0)
+         return 0;
+
+     if (percentile < 0.0) percentile = 0.0;
+     if (percentile > 100.0) percentile = 100.0;
+
+     rank = (unsigned long long) ((percentile / 100.0) * theHist->numSamples + 0.999999);
+     if (rank < 1) rank = 1;
+     if (rank > theHist->numSamples) rank = theHist->numSamples;
+
+     for (I = 0; I < LH_NUMBUCKETS; I++)
+     {
+          cumulative += theHist->counts[I];
+          if (cumulative >= rank)
+              break;
+     }
+
+     value = _lh_GetBucketUpperBound(I);
+
+     if (value > theHist->maxNs) value = theHist->maxNs;
+     if (value < theHist->minNs) value = theHist->minNs;
+
+     return value;
+}
+
+/****************************************************************************
+ lh_GetSummary()
+ Fills the summary with the p50/p90/p99/max latencies of the histogram.
+ ****************************************************************************/
+
+void lh_GetSummary(latencyHistogramP theHist, latencySummaryP theSummary)
+{
+     memset(theSummary, 0, sizeof(latencySummary));
+
+     if (theHist == NULL || theHist->numSamples == 0)
+         return;
+
+     theSummary->numSamples = theHist->numSamples;
+     theSummary->minNs = theHist->minNs;
+     theSummary->p50Ns = lh_GetPercentile(theHist, 50.0);
+     theSummary->p90Ns = lh_GetPercentile(theHist, 90.0);
+     theSummary->p99Ns = lh_GetPercentile(theHist, 99.0);
+     theSummary->maxNs = theHist->maxNs;
+     theSummary->meanNs = (double) theHist->totalNs / (double) theHist->numSamples;
+}
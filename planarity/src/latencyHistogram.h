@@ -0,0 +1,62 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// includes mem functions like memset
+#include <string.h>
+
+// The histogram has log-linear buckets: each power of two range of
+// nanosecond values is split into 2^LH_SUBBUCKET_BITS equal sub-buckets,
+// so any percentile is reported to within about 6% of the true value,
+// using a fixed amount of memory regardless of the number of samples.
+
+#define LH_SUBBUCKET_BITS   4
+#define LH_SUBBUCKET_COUNT  (1 << LH_SUBBUCKET_BITS)
+#define LH_NUMBUCKETS       (64 * LH_SUBBUCKET_COUNT)
+
+typedef struct
+{
+        unsigned long long counts[LH_NUMBUCKETS];
+        unsigned long long numSamples;
+        long long minNs, maxNs, totalNs;
+} latencyHistogram;
+
+typedef latencyHistogram * latencyHistogramP;
+
+// Summary of the distribution of per-graph latencies, in nanoseconds
+
+typedef struct
+{
+        unsigned long long numSamples;
+        long long minNs, p50Ns, p90Ns, p99Ns, maxNs;
+        double meanNs;
+} latencySummary;
+
+typedef latencySummary * latencySummaryP;
+
+latencyHistogramP lh_New(void);
+void lh_Free(latencyHistogramP *);
+
+void lh_Reset(latencyHistogramP);
+int  lh_AddSample(latencyHistogramP, long long ns);
+int  lh_Merge(latencyHistogramP histDst, latencyHistogramP histSrc);
+
+long long lh_GetPercentile(latencyHistogramP, double percentile);
+void lh_GetSummary(latencyHistogramP, latencySummaryP);
+
+#define lh_GetNumSamples(theHist) (theHist->numSamples)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCYHISTOGRAM_H */
@@ -64,6 +64,9 @@ int helpMessage(char *param)
         "    -2 = Search for subgraph homeomorphic to K_{2,3}\n"
         "    -3 = Search for subgraph homeomorphic to K_{3,3}\n"
         "    -4 = Search for subgraph homeomorphic to K_4\n"
+        "    -5 = Search for subgraph homeomorphic to K_5\n"
+        "    -c = Projective plane embedding\n"
+        "    -t = Torus embedding\n"
     	"\n";
 
 	ProjectTitle();
@@ -130,13 +133,22 @@ int helpMessage(char *param)
 	    Message(
 	    	"'planarity -r [-q] C K N': Random graphs\n"
 	    	"'planarity -s [-q] C I O [O2]': Specific graph\n"
+	    	"'planarity -multi [-q] C I O [O2]': Each graph in I, results in O, graphs in O2\n"
 	        "'planarity -rm [-q] N O [O2]': Random maximal planar graph\n"
 	        "'planarity -rn [-q] N O [O2]': Random nonplanar graph (maximal planar + edge)\n"
+	        "'planarity -bench [-q] [C] [N] [O]': Benchmark suite, JSON results in O\n"
+	        "'planarity -serve [-q] S': Serve requests on Unix domain socket S\n"
 	        "'planarity I O [-n O2]': Legacy command-line (default -s -p)\n"
 	    	"\n"
 	    );
 
-	    Message("-q is for quiet mode (no messages to stdout and stderr)\n\n");
+	    Message("-q is for quiet mode (no messages to stdout and stderr)\n");
+	    Message("-seed S may follow the command to seed random graph generation with S\n");
+	    Message("-threads T may follow -r to divide the random graphs among T threads,\n"
+	    		"  -serve to serve up to T connections at once, or -multi to run T workers\n");
+	    Message("-cache C may follow -s, -serve or -multi to reuse the results of up to C repeated graphs\n");
+	    Message("Input and output files named *.gz or *.zst are decompressed and compressed,\n"
+	    		"  if this program was built with zlib or zstd\n\n");
 
 	    Message(commandStr);
 
@@ -151,6 +163,9 @@ int helpMessage(char *param)
 	    	"    For -s, if C=-p or -o, then O2 receives the embedding obstruction\n"
 	       	"    For -s, if C=-d, then O2 receives a drawing of the planar graph\n"
 	    	"    For -rm and -rn, O2 contains the original randomly generated graph\n"
+	    	"    For -bench, O receives the JSON results (default stdout), C selects\n"
+	    	"    one algorithm (default all), and N is the largest number of vertices\n"
+	    	"    in the graph families (default 10000000)\n"
 	    	"\n"
 	    );
 
@@ -158,8 +173,10 @@ int helpMessage(char *param)
 	        "planarity process results: 0=OK, -1=NOTOK, 1=NONEMBEDDABLE\n"
 	    	"    1 result only produced by specific graph mode (-s)\n"
 	        "      with command -2,-3,-4: found K_{2,3}, K_{3,3} or K_4\n"
+	        "      with command -5: found K_5, or K_{3,3} if no K_5 was found\n"
 	    	"      with command -p,-d: found planarity obstruction\n"
 	    	"      with command -o: found outerplanarity obstruction\n"
+	    	"      with command -c,-t: graph does not embed on the surface\n"
 	    );
 	}
 
@@ -185,6 +202,9 @@ char Choice;
                 "2. Search for subgraph homeomorphic to K_{2,3}\n"
                 "3. Search for subgraph homeomorphic to K_{3,3}\n"
                 "4. Search for subgraph homeomorphic to K_4\n"
+                "5. Search for subgraph homeomorphic to K_5\n"
+                "C. Projective plane embedding\n"
+                "T. Torus embedding\n"
         		"H. Help message for command line version\n"
                 "R. Reconfigure options\n"
                 "X. Exit\n"
@@ -208,7 +228,7 @@ char Choice;
         	if (Choice == 'p'  || Choice == 'd' || Choice == 'o')
         		secondOutfile ="";
 
-            if (!strchr("pdo234", Choice)) {
+            if (!strchr("pdo2345ct", Choice)) {
             	Message("Invalid menu choice, please try again.");
             } else {
             	switch (tolower(Mode))
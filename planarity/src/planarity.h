@@ -17,10 +17,16 @@ extern "C" {
 #include <ctype.h>
 #include "graph.h"
 #include "platformTime.h"
+#include "platformThread.h"
+#include "latencyHistogram.h"
+#include "resultCache.h"
+#include "compressedFile.h"
 
 #include "graphK23Search.h"
 #include "graphK33Search.h"
 #include "graphK4Search.h"
+#include "graphK5Search.h"
+#include "graphSurfaceEmbed.h"
 #include "graphDrawPlanar.h"
 
 void ProjectTitle();
@@ -34,6 +40,9 @@ int SpecificGraph(
 );
 int RandomGraph(char command, int extraEdges, int numVertices, char *outfileName, char *outfile2Name);
 int RandomGraphs(char command, int, int);
+int Benchmark(char *commands, int maxN, char *outfileName);
+int Serve(char *socketName);
+int MultiGraph(char command, char *infileName, char *outfileName, char *outfile2Name);
 
 /* Command line, Menu, and Configuration */
 int commandLine(int argc, char *argv[]);
@@ -47,7 +56,13 @@ extern char Mode,
      AdjListsForEmbeddingsOut,
      quietMode;
 
+extern int  randomSeedGiven;
+extern unsigned long long randomSeed;
+extern int  numThreads;
+extern resultCacheP theResultCache;
+
 void Reconfigure();
+unsigned long long GetRandomSeed();
 
 /* Low-level Utilities */
 #define MAXLINE 1024
@@ -72,6 +87,7 @@ void AttachAlgorithm(graphP theGraph, char command);
 char *ConstructInputFilename(char *infileName);
 char *ConstructPrimaryOutputFilename(char *infileName, char *outfileName, char command);
 void WriteAlgorithmResults(graphP theGraph, int Result, char command, platform_time start, platform_time end, char *infileName);
+void WriteLatencySummary(latencyHistogramP theHist, latencySummaryP pSummary);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,451 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "planarity.h"
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define BENCH_HAVE_MALLINFO2
+#endif
+
+/****************************************************************************
+ Benchmark graph families.
+
+ Every family is generated from a fixed seed (or the one given by -seed) so
+ that repeated runs, and runs of different versions of the library, process
+ exactly the same graphs.
+ ****************************************************************************/
+
+#define BENCH_SEED                  12345
+#define BENCH_NEARPLANAR_EXTRAEDGES 8
+#define BENCH_DEFAULT_MAXN          10000000
+
+// Repetitions are used on small graphs so that each measurement covers
+// at least about this many edges
+#define BENCH_EDGES_PER_MEASUREMENT 1000000
+#define BENCH_MAX_REPS              1000
+
+#define BENCHFAMILY_RANDOM          0
+#define BENCHFAMILY_MAXPLANAR       1
+#define BENCHFAMILY_NEARPLANAR      2
+#define BENCHFAMILY_GRID            3
+#define BENCHFAMILY_K33SUBDIVISION  4
+#define BENCHFAMILY_K5SUBDIVISION   5
+#define BENCHFAMILY_PATH            6
+#define BENCHFAMILY_STAR            7
+#define BENCHFAMILY_TREE            8
+#define BENCHFAMILY_OUTERPLANAR     9
+#define NUM_BENCHFAMILIES           10
+
+static char *BenchFamilyNames[NUM_BENCHFAMILIES] = {
+	"random", "maxplanar", "nearplanar", "grid", "k33subdivision",
+	"k5subdivision", "path", "star", "tree", "outerplanar"
+};
+
+// Smallest number of vertices for which each family is defined
+static int BenchFamilyMinN[NUM_BENCHFAMILIES] = {
+	2, 3, 6, 2, 6, 5, 2, 2, 2, 3
+};
+
+int  _Bench_GetEdgeLimit(int family, int N);
+int  _Bench_CreateGraph(graphP theGraph, int family, prngP theRNG);
+graphP _Bench_MakeGraph(int N, int edgeLimit, char command);
+int  _Bench_RunCase(FILE *outfile, int *pFirstResult, int family, int N, char command, unsigned long long seed);
+
+int  _Bench_AddRandomTree(graphP theGraph, prngP theRNG);
+int  _Bench_AddSubdividedEdges(graphP theGraph, int numBranchVertices, int *branchEdges, int numBranchEdges);
+
+long _Bench_GetPeakRSSKB(void);
+long long _Bench_GetHeapBytes(void);
+
+/****************************************************************************
+ Benchmark()
+ Runs each algorithm in the commands string (any of "pdo2345") on each
+ benchmark graph family, at sizes 10, 100, ..., up to maxN vertices, and
+ writes the results as a JSON document to the given file, or to stdout if
+ outfileName is NULL.
+
+ Each result records the number of nanoseconds per edge taken by gp_Embed()
+ alone (graph generation and result verification are not timed), the
+ latency distribution over repetitions, the peak resident set size of the
+ process so far, and the heap bytes held by the graphs of the case.
+ ****************************************************************************/
+
+int  Benchmark(char *commands, int maxN, char *outfileName)
+{
+FILE *outfile = stdout;
+int  family, N, c, Result = OK, firstResult = TRUE;
+unsigned long long seed = randomSeedGiven ? randomSeed : BENCH_SEED;
+
+	if (commands == NULL || *commands == '\0')
+		commands = "pdo2345";
+
+	if (maxN < 10)
+		maxN = BENCH_DEFAULT_MAXN;
+
+	if (outfileName != NULL && (outfile = fopen(outfileName, WRITETEXT)) == NULL)
+	{
+		sprintf(Line, "Failed to open benchmark output file %.200s\n", outfileName);
+		ErrorMessage(Line);
+		return NOTOK;
+	}
+
+	fprintf(outfile, "{\n  \"suite\": \"planarity-benchmark\",\n  \"seed\": %llu,\n  \"maxN\": %d,\n  \"results\": [",
+			seed, maxN);
+
+	for (family = 0; family < NUM_BENCHFAMILIES && Result == OK; family++)
+	{
+		for (N = 10; N <= maxN && Result == OK; N = N > maxN / 10 ? maxN + 1 : N * 10)
+		{
+			for (c = 0; commands[c] != '\0' && Result == OK; c++)
+			{
+				if (strchr("pdo2345", commands[c]) == NULL)
+					continue;
+
+				Result = _Bench_RunCase(outfile, &firstResult, family, N, commands[c], seed);
+			}
+		}
+	}
+
+	fprintf(outfile, "\n  ]\n}\n");
+
+	if (outfile != stdout)
+		fclose(outfile);
+	else
+		fflush(stdout);
+
+	if (Result != OK)
+		ErrorMessage("Benchmark stopped due to an error.\n");
+
+	return Result;
+}
+
+/****************************************************************************
+ _Bench_RunCase()
+ Generates the graph for one family and size, then repeatedly copies it into
+ a working graph and times gp_Embed() with the algorithm of the command.
+ The result of the first repetition is checked for integrity.
+ ****************************************************************************/
+
+int  _Bench_RunCase(FILE *outfile, int *pFirstResult, int family, int N, char command, unsigned long long seed)
+{
+graphP theGraph = NULL, origGraph = NULL;
+latencyHistogramP latencyHist = NULL;
+latencySummary theSummary;
+prngState theRNG;
+platform_time start, end;
+long long totalNs = 0, heapBytes, heapBase;
+int  reps, rep, M, Result = OK, embedResult = OK;
+char *resultName;
+
+	if (N < BenchFamilyMinN[family])
+		return OK;
+
+	heapBase = _Bench_GetHeapBytes();
+
+	if ((origGraph = _Bench_MakeGraph(N, _Bench_GetEdgeLimit(family, N), command)) == NULL ||
+		(theGraph = _Bench_MakeGraph(N, _Bench_GetEdgeLimit(family, N), command)) == NULL ||
+		(latencyHist = lh_New()) == NULL)
+	{
+		sprintf(Line, "Not enough memory for %s graph on %d vertices.\n", BenchFamilyNames[family], N);
+		ErrorMessage(Line);
+		gp_Free(&theGraph);
+		gp_Free(&origGraph);
+		return NOTOK;
+	}
+
+	prng_Seed(&theRNG, seed);
+
+	if (_Bench_CreateGraph(origGraph, family, &theRNG) != OK)
+	{
+		sprintf(Line, "Failed to create %s graph on %d vertices.\n", BenchFamilyNames[family], N);
+		ErrorMessage(Line);
+		Result = NOTOK;
+	}
+
+	M = origGraph->M;
+	reps = BENCH_EDGES_PER_MEASUREMENT / (M > 0 ? M : 1);
+	reps = reps < 1 ? 1 : (reps > BENCH_MAX_REPS ? BENCH_MAX_REPS : reps);
+
+	for (rep = 0; rep < reps && Result == OK; rep++)
+	{
+		if (gp_CopyGraph(theGraph, origGraph) != OK)
+		{
+			Result = NOTOK;
+			break;
+		}
+
+		platform_GetTime(start);
+		embedResult = gp_Embed(theGraph, GetEmbedFlags(command));
+		platform_GetTime(end);
+
+		lh_AddSample(latencyHist, platform_GetDurationNs(start, end));
+		totalNs += platform_GetDurationNs(start, end);
+
+		if (rep == 0 && gp_TestEmbedResultIntegrity(theGraph, origGraph, embedResult) != embedResult)
+			embedResult = NOTOK;
+
+		if (embedResult != OK && embedResult != NONEMBEDDABLE)
+		{
+			sprintf(Line, "Algorithm %s failed on %s graph on %d vertices.\n",
+					GetAlgorithmName(command), BenchFamilyNames[family], N);
+			ErrorMessage(Line);
+			Result = NOTOK;
+		}
+	}
+
+	heapBytes = _Bench_GetHeapBytes();
+	heapBytes = heapBytes >= 0 && heapBase >= 0 ? heapBytes - heapBase : -1;
+
+	if (Result == OK)
+	{
+		lh_GetSummary(latencyHist, &theSummary);
+		resultName = embedResult == OK ? "OK" : "NONEMBEDDABLE";
+
+		fprintf(outfile, "%s\n    {\"family\": \"%s\", \"algorithm\": \"%s\", \"command\": \"-%c\", "
+				"\"N\": %d, \"M\": %d, \"result\": \"%s\", \"reps\": %d, "
+				"\"nsPerEdge\": %.3lf, \"p50Ns\": %lld, \"p90Ns\": %lld, \"p99Ns\": %lld, \"maxNs\": %lld, "
+				"\"peakRSSKB\": %ld, \"heapBytes\": %lld}",
+				*pFirstResult ? "" : ",",
+				BenchFamilyNames[family], GetAlgorithmName(command), command,
+				N, M, resultName, reps,
+				(double) totalNs / ((double) reps * (M > 0 ? M : 1)),
+				theSummary.p50Ns, theSummary.p90Ns, theSummary.p99Ns, theSummary.maxNs,
+				_Bench_GetPeakRSSKB(), heapBytes);
+		*pFirstResult = FALSE;
+
+		if (outfile != stdout)
+		{
+			sprintf(Line, "%-15s %-22s N=%-9d %10.3lf ns/edge\n", BenchFamilyNames[family],
+					GetAlgorithmName(command), N, (double) totalNs / ((double) reps * (M > 0 ? M : 1)));
+			Message(Line);
+		}
+	}
+
+	gp_Free(&theGraph);
+	gp_Free(&origGraph);
+	lh_Free(&latencyHist);
+
+	return Result;
+}
+
+/****************************************************************************
+ _Bench_MakeGraph()
+ Makes a graph with N vertices and room for at least edgeLimit edges, and
+ attaches the algorithm given by the command.
+ ****************************************************************************/
+
+graphP _Bench_MakeGraph(int N, int edgeLimit, char command)
+{
+graphP theGraph;
+
+	if ((theGraph = gp_New()) == NULL)
+		return NULL;
+
+	if ((edgeLimit > DEFAULT_EDGE_LIMIT*N && gp_EnsureArcCapacity(theGraph, 2*edgeLimit) != OK) ||
+		gp_InitGraph(theGraph, N) != OK)
+	{
+		gp_Free(&theGraph);
+		return NULL;
+	}
+
+	AttachAlgorithm(theGraph, command);
+
+	return theGraph;
+}
+
+/****************************************************************************
+ _Bench_GetEdgeLimit()
+ Returns the number of edges created by the family generator for N vertices
+ ****************************************************************************/
+
+int  _Bench_GetEdgeLimit(int family, int N)
+{
+	switch (family)
+	{
+		case BENCHFAMILY_RANDOM         : return N - 1 + N/2;
+		case BENCHFAMILY_MAXPLANAR      : return 3*N - 6;
+		case BENCHFAMILY_NEARPLANAR     : return 3*N - 6 + BENCH_NEARPLANAR_EXTRAEDGES;
+		case BENCHFAMILY_GRID           : return 2*N;
+		case BENCHFAMILY_K33SUBDIVISION : return N + 3;
+		case BENCHFAMILY_K5SUBDIVISION  : return N + 5;
+		case BENCHFAMILY_OUTERPLANAR    : return 2*N - 3;
+	}
+
+	return N - 1;
+}
+
+/****************************************************************************
+ _Bench_CreateGraph()
+ Adds the edges of the given family to theGraph, which has no edges yet.
+ ****************************************************************************/
+
+int  _Bench_CreateGraph(graphP theGraph, int family, prngP theRNG)
+{
+int  N = theGraph->N, u, v, r, c, m;
+int  K33Edges[] = { 1,4, 1,5, 1,6, 2,4, 2,5, 2,6, 3,4, 3,5, 3,6 };
+int  K5Edges[] = { 1,2, 1,3, 1,4, 1,5, 2,3, 2,4, 2,5, 3,4, 3,5, 4,5 };
+
+	switch (family)
+	{
+		case BENCHFAMILY_RANDOM :
+			if (_Bench_AddRandomTree(theGraph, theRNG) != OK)
+				return NOTOK;
+			for (m = 0; m < N/2; )
+			{
+				u = prng_GetRandomNumber(theRNG, 1, N);
+				v = prng_GetRandomNumber(theRNG, 1, N);
+				if (u != v && !gp_IsNeighbor(theGraph, u, v))
+				{
+					if (gp_AddEdge(theGraph, u, 0, v, 0) != OK)
+						return NOTOK;
+					m++;
+				}
+			}
+			return OK;
+
+		case BENCHFAMILY_MAXPLANAR :
+			return gp_CreateRandomMaximalPlanarGraph(theGraph, theRNG);
+
+		case BENCHFAMILY_NEARPLANAR :
+			return gp_CreateRandomNearPlanarGraph(theGraph, BENCH_NEARPLANAR_EXTRAEDGES, theRNG);
+
+		case BENCHFAMILY_GRID :
+			// An r x c grid, with any vertices left over appended as a path
+			for (r = 1; (r+1)*(r+1) <= N; r++)
+				;
+			c = N / r;
+			for (v = 1; v <= r*c; v++)
+			{
+				if ((v-1) % c != c-1 && gp_AddEdge(theGraph, v, 0, v+1, 0) != OK)
+					return NOTOK;
+				if (v + c <= r*c && gp_AddEdge(theGraph, v, 0, v+c, 0) != OK)
+					return NOTOK;
+			}
+			for (v = r*c+1; v <= N; v++)
+				if (gp_AddEdge(theGraph, v-1, 0, v, 0) != OK)
+					return NOTOK;
+			return OK;
+
+		case BENCHFAMILY_K33SUBDIVISION :
+			return _Bench_AddSubdividedEdges(theGraph, 6, K33Edges, 9);
+
+		case BENCHFAMILY_K5SUBDIVISION :
+			return _Bench_AddSubdividedEdges(theGraph, 5, K5Edges, 10);
+
+		case BENCHFAMILY_PATH :
+			for (v = 2; v <= N; v++)
+				if (gp_AddEdge(theGraph, v-1, 0, v, 0) != OK)
+					return NOTOK;
+			return OK;
+
+		case BENCHFAMILY_STAR :
+			for (v = 2; v <= N; v++)
+				if (gp_AddEdge(theGraph, 1, 0, v, 0) != OK)
+					return NOTOK;
+			return OK;
+
+		case BENCHFAMILY_TREE :
+			return _Bench_AddRandomTree(theGraph, theRNG);
+
+		case BENCHFAMILY_OUTERPLANAR :
+			return gp_CreateRandomOuterplanarGraph(theGraph, 2*N - 3, theRNG);
+	}
+
+	return NOTOK;
+}
+
+/****************************************************************************
+ _Bench_AddRandomTree()
+ Connects each vertex v > 1 to a random vertex in [1, v-1]
+ ****************************************************************************/
+
+int  _Bench_AddRandomTree(graphP theGraph, prngP theRNG)
+{
+int  v;
+
+	for (v = 2; v <= theGraph->N; v++)
+		if (gp_AddEdge(theGraph, prng_GetRandomNumber(theRNG, 1, v-1), 0, v, 0) != OK)
+			return NOTOK;
+
+	return OK;
+}
+
+/****************************************************************************
+ _Bench_AddSubdividedEdges()
+ Adds the edges of a graph on the first numBranchVertices vertices, given as
+ pairs in branchEdges, with the remaining vertices of theGraph spread evenly
+ over the edges as subdivision vertices.
+ ****************************************************************************/
+
+int  _Bench_AddSubdividedEdges(graphP theGraph, int numBranchVertices, int *branchEdges, int numBranchEdges)
+{
+int  numPathVertices = theGraph->N - numBranchVertices;
+int  I, J, u, v, pathLength, nextVertex = numBranchVertices + 1;
+
+	for (I = 0; I < numBranchEdges; I++)
+	{
+		pathLength = numPathVertices / numBranchEdges + (I < numPathVertices % numBranchEdges ? 1 : 0);
+
+		u = branchEdges[2*I];
+		for (J = 0; J < pathLength; J++)
+		{
+			v = nextVertex++;
+			if (gp_AddEdge(theGraph, u, 0, v, 0) != OK)
+				return NOTOK;
+			u = v;
+		}
+
+		if (gp_AddEdge(theGraph, u, 0, branchEdges[2*I+1], 0) != OK)
+			return NOTOK;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ _Bench_GetPeakRSSKB()
+ Returns the peak resident set size of the process in kilobytes, or -1 if
+ it is not available on this platform.
+ ****************************************************************************/
+
+long _Bench_GetPeakRSSKB(void)
+{
+#ifdef WIN32
+	return -1;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+
+#ifdef __APPLE__
+	return (long) (usage.ru_maxrss / 1024);
+#else
+	return (long) usage.ru_maxrss;
+#endif
+#endif
+}
+
+/****************************************************************************
+ _Bench_GetHeapBytes()
+ Returns the number of heap bytes currently allocated by the process, or -1
+ if it is not available on this platform.
+ ****************************************************************************/
+
+long long _Bench_GetHeapBytes(void)
+{
+#ifdef BENCH_HAVE_MALLINFO2
+	struct mallinfo2 info = mallinfo2();
+	return (long long) (info.uordblks + info.hblkhd);
+#else
+	return -1;
+#endif
+}
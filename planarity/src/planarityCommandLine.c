@@ -0,0 +1,490 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "planarity.h"
+
+#ifdef WIN32
+#include <direct.h>
+#define getcwd _getcwd
+#define chdir _chdir
+#else
+#include <unistd.h>
+#endif
+
+int runQuickRegressionTests(int argc, char *argv[]);
+int callRandomGraphs(int argc, char *argv[]);
+int callSpecificGraph(int argc, char *argv[]);
+int callRandomMaxPlanarGraph(int argc, char *argv[]);
+int callRandomNonplanarGraph(int argc, char *argv[]);
+int callBenchmark(int argc, char *argv[]);
+int callServe(int argc, char *argv[]);
+int callMultiGraph(int argc, char *argv[]);
+
+/****************************************************************************
+ Command Line Processor
+ ****************************************************************************/
+
+int commandLine(int argc, char *argv[])
+{
+	int Result = OK, I, J;
+
+	// Take the optional '-seed S', '-threads T' and '-cache C' parameters out of the
+	// command line so that the commands below see their usual parameter positions
+	for (I = 2; I < argc-1; )
+	{
+		if (strcmp(argv[I], "-seed") == 0)
+		{
+			randomSeed = strtoull(argv[I+1], NULL, 10);
+			randomSeedGiven = TRUE;
+		}
+		else if (strcmp(argv[I], "-threads") == 0)
+			numThreads = atoi(argv[I+1]);
+		else if (strcmp(argv[I], "-cache") == 0)
+		{
+			rc_Free(&theResultCache);
+			theResultCache = rc_New(atoi(argv[I+1]));
+		}
+		else
+		{
+			I++;
+			continue;
+		}
+
+		for (J = I, argc -= 2; J < argc; J++)
+			argv[J] = argv[J+2];
+	}
+
+	if (argc >= 3 && strcmp(argv[2], "-q") == 0)
+		quietMode = 'y';
+
+	if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "-help") == 0)
+		Result = helpMessage(argc >= 3 ? argv[2] : NULL);
+
+	else if (strcmp(argv[1], "-i") == 0 || strcmp(argv[1], "-info") == 0)
+		Result = helpMessage(argv[1]);
+
+	else if (strcmp(argv[1], "-test") == 0)
+		Result = runQuickRegressionTests(argc, argv);
+
+	else if (strcmp(argv[1], "-r") == 0)
+		Result = callRandomGraphs(argc, argv);
+
+	else if (strcmp(argv[1], "-s") == 0)
+		Result = callSpecificGraph(argc, argv);
+
+	else if (strcmp(argv[1], "-rm") == 0)
+		Result = callRandomMaxPlanarGraph(argc, argv);
+
+	else if (strcmp(argv[1], "-rn") == 0)
+		Result = callRandomNonplanarGraph(argc, argv);
+
+	else if (strcmp(argv[1], "-bench") == 0)
+		Result = callBenchmark(argc, argv);
+
+	else if (strcmp(argv[1], "-serve") == 0)
+		Result = callServe(argc, argv);
+
+	else if (strcmp(argv[1], "-multi") == 0)
+		Result = callMultiGraph(argc, argv);
+
+	else
+	{
+		ErrorMessage("Unsupported command line.  Here is the help for this program.\n");
+		helpMessage(NULL);
+		Result = NOTOK;
+	}
+
+	rc_Free(&theResultCache);
+
+	return Result == OK ? 0 : (Result == NONEMBEDDABLE ? 1 : -1);
+}
+
+/****************************************************************************
+ Legacy Command Line Processor from version 1.x
+ ****************************************************************************/
+
+int legacyCommandLine(int argc, char *argv[])
+{
+graphP theGraph = gp_New();
+int Result;
+
+	if (argc < 3)
+	{
+		gp_Free(&theGraph);
+		return -2;
+	}
+
+	Result = gp_Read(theGraph, argv[1]);
+	if (Result != OK)
+	{
+		if (Result != NONEMBEDDABLE)
+		{
+			if (strlen(argv[1]) > MAXLINE - 100)
+				sprintf(Line, "Failed to read graph\n");
+			else
+				sprintf(Line, "Failed to read graph %s\n", argv[1]);
+			ErrorMessage(Line);
+			gp_Free(&theGraph);
+			return -2;
+		}
+	}
+
+	Result = gp_Embed(theGraph, EMBEDFLAGS_PLANAR);
+
+	if (Result == OK)
+	{
+		gp_SortVertices(theGraph);
+		gp_Write(theGraph, argv[2], WRITE_ADJLIST);
+	}
+
+	else if (Result == NONEMBEDDABLE)
+	{
+		if (argc >= 5 && strcmp(argv[3], "-n") == 0)
+		{
+			gp_SortVertices(theGraph);
+			gp_Write(theGraph, argv[4], WRITE_ADJLIST);
+		}
+	}
+	else
+		Result = NOTOK;
+
+	gp_Free(&theGraph);
+
+	// In the legacy 1.x versions, OK/NONEMBEDDABLE was 0 and NOTOK was -2
+	return Result == OK || Result == NONEMBEDDABLE ? 0 : -2;
+}
+
+/****************************************************************************
+ Quick regression test
+ ****************************************************************************/
+
+int runSpecificGraphTests(char *samplesDir);
+int runSpecificGraphTest(char *command, char *infileName);
+
+int runQuickRegressionTests(int argc, char *argv[])
+{
+	char *samplesDir = "samples";
+	int samplesDirArgLocation = 2;
+
+	// Skip optional -q quiet mode command-line paramater, if present
+	if (argc > samplesDirArgLocation && strcmp(argv[samplesDirArgLocation], "-q") == 0)
+		samplesDirArgLocation++;
+
+	// Accept overriding sample directory command-line parameter, if present
+	if (argc > samplesDirArgLocation)
+		samplesDir = argv[samplesDirArgLocation];
+
+	if (runSpecificGraphTests(samplesDir) < 0)
+		return NOTOK;
+
+	return OK;
+}
+
+int runSpecificGraphTests(char *samplesDir)
+{
+	char origDir[2048];
+	int retVal = 0;
+
+	if (!getcwd(origDir, 2048))
+		return -1;
+
+	if (chdir(samplesDir) != 0)
+	{
+		// Give success result, but warn if no samples (except no warning if in quiet mode)
+		Message("WARNING: Unable to change to samples directory to run tests on samples.\n");
+		return 0;
+	}
+
+	if (runSpecificGraphTest("-p", "maxPlanar5.txt") < 0)
+	{
+		retVal = -1;
+		Message("Planarity test on maxPlanar5.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-d", "maxPlanar5.txt") < 0)
+	{
+		retVal = -1;
+		Message("Graph drawing test maxPlanar5.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-d", "drawExample.txt") < 0)
+	{
+		retVal = -1;
+		Message("Graph drawing on drawExample.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-p", "Petersen.txt") < 0)
+	{
+		retVal = -1;
+		Message("Planarity test on Petersen.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-o", "Petersen.txt") < 0)
+	{
+		retVal = -1;
+		Message("Outerplanarity test on Petersen.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-2", "Petersen.txt") < 0)
+	{
+		retVal = -1;
+		Message("K_{2,3} search on Petersen.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-3", "Petersen.txt") < 0)
+	{
+		retVal = -1;
+		Message("K_{3,3} search on Petersen.txt failed.\n");
+	}
+
+	if (runSpecificGraphTest("-4", "Petersen.txt") < 0)
+	{
+		retVal = -1;
+		Message("K_4 search on Petersen.txt failed.\n");
+	}
+
+	if (retVal == 0)
+		Message("Tests of all specific graphs succeeded.\n");
+	else
+		Message("One or more specific graph tests FAILED.\n");
+
+	if (chdir(origDir) != 0)
+		return -1;
+
+	FlushConsole(stdout);
+	return retVal;
+}
+
+/****************************************************************************
+ runSpecificGraphTest()
+ Runs the algorithm given by the command on the input file, then compares
+ the primary output with the expected output in infileName.ALGORITHM.out.txt
+ Returns 0 on success, -1 on failure
+ ****************************************************************************/
+
+int runSpecificGraphTest(char *command, char *infileName)
+{
+	int Result = OK;
+	char *actualOutput = NULL, *actualOutput2 = NULL;
+	char *inputString = NULL;
+	char *expectedFileName = NULL;
+	char *algorithmName = GetAlgorithmName(command[1]);
+
+	if ((inputString = ReadTextFileIntoString(infileName)) == NULL)
+		return -1;
+
+	Result = SpecificGraph(command[1], infileName, NULL, NULL,
+			               inputString, &actualOutput, &actualOutput2);
+
+	if (Result == OK || Result == NONEMBEDDABLE)
+	{
+		expectedFileName = (char *) malloc(strlen(infileName) + strlen(algorithmName) + 10);
+		if (expectedFileName == NULL)
+			Result = NOTOK;
+		else
+		{
+			sprintf(expectedFileName, "%s.%s.out.txt", infileName, algorithmName);
+			if (actualOutput != NULL && TextFileMatchesString(expectedFileName, actualOutput) != TRUE)
+				Result = NOTOK;
+		}
+	}
+
+	if (expectedFileName != NULL) free(expectedFileName);
+	if (inputString != NULL) free(inputString);
+	if (actualOutput != NULL) free(actualOutput);
+	if (actualOutput2 != NULL) free(actualOutput2);
+
+	return Result == OK || Result == NONEMBEDDABLE ? 0 : -1;
+}
+
+/****************************************************************************
+ callRandomGraphs()
+ ****************************************************************************/
+
+// 'planarity -r [-q] C K N': Random graphs
+int callRandomGraphs(int argc, char *argv[])
+{
+	char Choice = 0;
+	int offset = 0, NumGraphs, SizeOfGraphs;
+
+	if (argc < 5)
+		return NOTOK;
+
+	if (argv[2][0] == '-' && (Choice = argv[2][1]) == 'q')
+	{
+		if (argc < 6)
+			return NOTOK;
+		Choice = argv[3][1];
+		offset = 1;
+	}
+
+	NumGraphs = atoi(argv[3+offset]);
+	SizeOfGraphs = atoi(argv[4+offset]);
+
+	return RandomGraphs(Choice, NumGraphs, SizeOfGraphs);
+}
+
+/****************************************************************************
+ callSpecificGraph()
+ ****************************************************************************/
+
+// 'planarity -s [-q] C I O [O2]': Specific graph
+int callSpecificGraph(int argc, char *argv[])
+{
+	char Choice = 0, *infileName = NULL, *outfileName = NULL, *outfile2Name = NULL;
+	int offset = 0;
+
+	if (argc < 5)
+		return NOTOK;
+
+	if (argv[2][0] == '-' && (Choice = argv[2][1]) == 'q')
+	{
+		if (argc < 6)
+			return NOTOK;
+		Choice = argv[3][1];
+		offset = 1;
+	}
+
+	infileName = argv[3+offset];
+	outfileName = argv[4+offset];
+	if (argc == 6+offset)
+		outfile2Name = argv[5+offset];
+
+	return SpecificGraph(Choice, infileName, outfileName, outfile2Name, NULL, NULL, NULL);
+}
+
+/****************************************************************************
+ callMultiGraph()
+ ****************************************************************************/
+
+// 'planarity -multi [-q] C I O [O2]': Process each graph in the file I
+int callMultiGraph(int argc, char *argv[])
+{
+	char Choice = 0;
+	int offset = 0;
+	char *infileName=NULL, *outfileName=NULL, *outfile2Name=NULL;
+
+	if (argc < 5)
+		return NOTOK;
+
+	if (argv[2][0] == '-' && argv[2][1] == 'q')
+	{
+		if (argc < 6)
+			return NOTOK;
+		offset = 1;
+	}
+
+	// The command needs its dash; a bare 'p' would leave Choice unset
+	if (argv[2+offset][0] != '-')
+		return NOTOK;
+	Choice = argv[2+offset][1];
+
+	infileName = argv[3+offset];
+	outfileName = argv[4+offset];
+	if (argc == 6+offset)
+		outfile2Name = argv[5+offset];
+
+	return MultiGraph(Choice, infileName, outfileName, outfile2Name);
+}
+
+/****************************************************************************
+ callRandomMaxPlanarGraph()
+ ****************************************************************************/
+
+// 'planarity -rm [-q] N O [O2]': Maximal planar random graph
+int callRandomMaxPlanarGraph(int argc, char *argv[])
+{
+	int offset = 0, numVertices;
+	char *outfileName = NULL, *outfile2Name = NULL;
+
+	if (argc < 4)
+		return NOTOK;
+
+	if (argv[2][0] == '-' && argv[2][1] == 'q')
+	{
+		if (argc < 5)
+			return NOTOK;
+		offset = 1;
+	}
+
+	numVertices = atoi(argv[2+offset]);
+	outfileName = argv[3+offset];
+	if (argc == 5+offset)
+		outfile2Name = argv[4+offset];
+
+	return RandomGraph('p', 0, numVertices, outfileName, outfile2Name);
+}
+
+/****************************************************************************
+ callRandomNonplanarGraph()
+ ****************************************************************************/
+
+// 'planarity -rn [-q] N O [O2]': Non-planar random graph (maximal planar plus edge)
+int callRandomNonplanarGraph(int argc, char *argv[])
+{
+	int offset = 0, numVertices;
+	char *outfileName = NULL, *outfile2Name = NULL;
+
+	if (argc < 4)
+		return NOTOK;
+
+	if (argv[2][0] == '-' && argv[2][1] == 'q')
+	{
+		if (argc < 5)
+			return NOTOK;
+		offset = 1;
+	}
+
+	numVertices = atoi(argv[2+offset]);
+	outfileName = argv[3+offset];
+	if (argc == 5+offset)
+		outfile2Name = argv[4+offset];
+
+	return RandomGraph('p', 1, numVertices, outfileName, outfile2Name);
+}
+
+/****************************************************************************
+ callBenchmark()
+ ****************************************************************************/
+
+// 'planarity -bench [-q] [C] [N] [O]': Benchmark suite
+int callBenchmark(int argc, char *argv[])
+{
+	char *commands = NULL, *outfileName = NULL;
+	int argIndex = 2, maxN = 0;
+
+	if (argc > argIndex && strcmp(argv[argIndex], "-q") == 0)
+		argIndex++;
+
+	if (argc > argIndex && argv[argIndex][0] == '-' && strlen(argv[argIndex]) == 2)
+		commands = argv[argIndex++] + 1;
+
+	if (argc > argIndex && isdigit(argv[argIndex][0]))
+		maxN = atoi(argv[argIndex++]);
+
+	if (argc > argIndex)
+		outfileName = argv[argIndex++];
+
+	return Benchmark(commands, maxN, outfileName);
+}
+
+/****************************************************************************
+ callServe()
+ ****************************************************************************/
+
+// 'planarity -serve [-q] S': Serve requests on the Unix domain socket S
+int callServe(int argc, char *argv[])
+{
+	int argIndex = 2;
+
+	if (argc > argIndex && strcmp(argv[argIndex], "-q") == 0)
+		argIndex++;
+
+	if (argc != argIndex + 1)
+		return NOTOK;
+
+	return Serve(argv[argIndex]);
+}
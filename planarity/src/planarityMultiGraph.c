@@ -0,0 +1,505 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "planarity.h"
+
+/****************************************************************************
+ MultiGraph()
+ Runs the algorithm given by command on each graph in the file infileName,
+ which contains a sequence of graphs in adjacency list format, each one
+ starting with its "N=" line.  As with gp_Read() and gp_Write(), files
+ whose names end in .gz or .zst are decompressed or compressed.
+
+ For each graph, in order, a line is written to outfileName with the result
+ 0 if the graph is embeddable (or has no homeomorphic subgraph for 2, 3, 4,
+ 5), 1 if not, or -1 if the graph could not be read or processed, i.e. the
+ same values as the process return code of a specific graph command.  For 5,
+ the result is 2 if the graph is not planar but the search found only a
+ K_{3,3} homeomorph, so it may or may not have a K_5 homeomorph.  For c
+ and t, a graph with more edges than the graph can hold, 3N by default, has
+ result 1 without running the algorithm, since it has too many edges to
+ embed on the projective plane or the torus.
+
+ If outfile2Name is not NULL, then the result graphs are written to it in
+ adjacency list format, in order: for p, o and d, the embedding or the
+ obstruction of each graph with result 0 or 1, for 2, 3, 4 and 5, the
+ homeomorphic subgraph of each graph with result 1, so not the K_{3,3}
+ of a graph with result 2, and for c and t, the embedding of each graph
+ with result 0, followed for c by a SurfaceEmbed section that lists the
+ twisted edges.
+
+ The work is divided into a pipeline so that reading, the algorithm and
+ writing overlap: this thread reads the text of each graph, the number of
+ workers given by the -threads option parse the graphs and run the
+ algorithm, and a writer thread writes the results.  The stages pass graphs through a ring of
+ slots, each of which is filled by the reader, processed by a worker and
+ emptied by the writer.  The slot of a graph is given by its sequence
+ number, so the writer takes the results in the input order, and the
+ reader waits when the slot it needs has not yet been emptied, which
+ bounds the number of graphs in memory.  A slot passes from stage to stage
+ when its state is changed under the pipeline lock, and a stage that needs
+ a slot in another state sleeps on the condition variable of the slot, so
+ threads waiting for the reader or for each other do not use a processor.
+
+ If the -cache option was given, the workers share the result cache.  As
+ for a specific graph, the results of d, 5, c and t are not cached.
+ Unlike SpecificGraph(), the results are not checked for integrity.
+
+ Each worker times the algorithm on each of its graphs into its own latency
+ histogram, and the histograms are merged and reported as for RandomGraphs().
+
+ Returns OK if every graph was processed, or NOTOK otherwise.
+ ****************************************************************************/
+
+// The states of a pipeline slot
+#define SLOT_EMPTY   0
+#define SLOT_READ    1
+#define SLOT_WORKING 2
+#define SLOT_DONE    3
+
+// A pipeline slot holds one graph between stages.  The text buffer of
+// a slot is reused for each graph that passes through it.  The state and
+// seq are guarded by the pipeline lock, and stateChanged is signaled
+// whenever the state changes.
+typedef struct
+{
+	int  state, seq;
+	platform_cond stateChanged;
+	strBufP text;
+	graphP theGraph;
+	int  Result;
+} pipelineSlot;
+
+// State shared by the stages.  Only the slot states, nextClaim and numGraphs
+// are changed by more than one thread; nextClaim atomically, and the others
+// under the lock.  The cache has its own lock.
+typedef struct
+{
+	char command;
+	int  embedFlags;
+	pipelineSlot *slots;
+	int  numSlots;
+	volatile int nextClaim;
+	int  numGraphs;
+	platform_mutex lock, cacheLock;
+	FILE *outfile, *outfile2;
+	int  numEmbeddable, numNonembeddable, numK5NotFound, numErrors;
+} pipelineState;
+
+// A worker thread has its own latency histogram, so it records the time
+// of each graph without taking a lock
+typedef struct
+{
+	pipelineState *pipeline;
+	latencyHistogramP latencyHist;
+} pipelineWorker;
+
+platform_ThreadResult MultiGraphWorker(void *arg);
+platform_ThreadResult MultiGraphWriter(void *arg);
+int  _ReadNextGraphText(FILE *infile, strBufP text, strBufP nextLine);
+int  _RunPipelineAlgorithm(pipelineState *pipeline, graphP theGraph);
+void _SetSlotState(pipelineState *pipeline, pipelineSlot *slot, int state);
+
+int  MultiGraph(char command, char *infileName, char *outfileName, char *outfile2Name)
+{
+pipelineState pipeline;
+pipelineWorker *workers = NULL;
+platform_thread *threads = NULL, writer;
+platform_time start, end;
+latencyHistogramP latencyHist = NULL;
+strBufP nextLine = NULL;
+FILE *infile = NULL;
+pipelineSlot *slot;
+int  T, NumWorkers, numStarted = 0, writerStarted = FALSE, seq, Result = OK;
+
+	if (command == '\0' || !strchr("pdo2345ct", command))
+	{
+		ErrorMessage("Unsupported command for multiple graphs.\n");
+		return NOTOK;
+	}
+
+	memset(&pipeline, 0, sizeof(pipelineState));
+	pipeline.command = command;
+	pipeline.embedFlags = GetEmbedFlags(command);
+	pipeline.numGraphs = -1;
+
+	// The ring has enough slots to keep every worker busy while the reader
+	// and writer each work on another few graphs
+	NumWorkers = numThreads < 1 ? 1 : numThreads;
+	pipeline.numSlots = 4 * NumWorkers + 16;
+
+	if ((infile = strcmp(infileName, "stdin") == 0 ? stdin : cf_Open(infileName, READTEXT)) == NULL ||
+		(pipeline.outfile = strcmp(outfileName, "stdout") == 0 ? stdout : cf_Open(outfileName, WRITETEXT)) == NULL ||
+		(outfile2Name != NULL && (pipeline.outfile2 = strcmp(outfile2Name, "stdout") == 0 ? stdout : cf_Open(outfile2Name, WRITETEXT)) == NULL))
+	{
+		ErrorMessage("Failed to open the input or output file.\n");
+		Result = NOTOK;
+	}
+	else if ((pipeline.slots = (pipelineSlot *) calloc(pipeline.numSlots, sizeof(pipelineSlot))) == NULL ||
+			 (workers = (pipelineWorker *) calloc(NumWorkers, sizeof(pipelineWorker))) == NULL ||
+			 (threads = (platform_thread *) calloc(NumWorkers, sizeof(platform_thread))) == NULL ||
+			 (nextLine = sb_New(0)) == NULL || (latencyHist = lh_New()) == NULL)
+	{
+		ErrorMessage("Failed to allocate the pipeline.\n");
+		Result = NOTOK;
+	}
+
+	for (T = 0; Result == OK && T < pipeline.numSlots; T++)
+	{
+		if ((pipeline.slots[T].text = sb_New(0)) == NULL)
+		{
+			ErrorMessage("Failed to allocate the pipeline.\n");
+			Result = NOTOK;
+		}
+	}
+
+	for (T = 0; Result == OK && T < NumWorkers; T++)
+	{
+		workers[T].pipeline = &pipeline;
+		if ((workers[T].latencyHist = lh_New()) == NULL)
+		{
+			ErrorMessage("Failed to allocate the pipeline.\n");
+			Result = NOTOK;
+		}
+	}
+
+	if (Result == OK)
+	{
+		platform_MutexInit(pipeline.lock);
+		platform_MutexInit(pipeline.cacheLock);
+		for (T = 0; T < pipeline.numSlots; T++)
+			platform_CondInit(pipeline.slots[T].stateChanged);
+		platform_GetTime(start);
+
+		writerStarted = platform_CreateThread(writer, MultiGraphWriter, &pipeline) == OK;
+		for (numStarted = 0; writerStarted && numStarted < NumWorkers; numStarted++)
+		{
+			if (platform_CreateThread(threads[numStarted], MultiGraphWorker, &workers[numStarted]) != OK)
+				break;
+		}
+
+		if (!writerStarted || numStarted == 0)
+		{
+			ErrorMessage("Failed to start the pipeline threads.\n");
+			Result = NOTOK;
+		}
+
+		// Read the text of each graph into the slot for its sequence number
+		// once the writer has emptied it
+		for (seq = 0; Result == OK; seq++)
+		{
+			slot = &pipeline.slots[seq % pipeline.numSlots];
+			platform_MutexLock(pipeline.lock);
+			while (slot->state != SLOT_EMPTY)
+				platform_CondWait(slot->stateChanged, pipeline.lock);
+			platform_MutexUnlock(pipeline.lock);
+
+			if (_ReadNextGraphText(infile, slot->text, nextLine) != OK)
+				break;
+
+			platform_MutexLock(pipeline.lock);
+			slot->seq = seq;
+			slot->state = SLOT_READ;
+			platform_CondBroadcast(slot->stateChanged);
+			platform_MutexUnlock(pipeline.lock);
+		}
+
+		// Tell the workers and the writer how many graphs there are, waking
+		// those waiting for a graph beyond the last one
+		platform_MutexLock(pipeline.lock);
+		pipeline.numGraphs = Result == OK ? seq : 0;
+		for (T = 0; T < pipeline.numSlots; T++)
+			platform_CondBroadcast(pipeline.slots[T].stateChanged);
+		platform_MutexUnlock(pipeline.lock);
+
+		for (T = 0; T < numStarted; T++)
+		{
+			platform_JoinThread(threads[T]);
+			lh_Merge(latencyHist, workers[T].latencyHist);
+		}
+		if (writerStarted)
+			platform_JoinThread(writer);
+
+		platform_GetTime(end);
+		for (T = 0; T < pipeline.numSlots; T++)
+			platform_CondDestroy(pipeline.slots[T].stateChanged);
+		platform_MutexDestroy(pipeline.cacheLock);
+		platform_MutexDestroy(pipeline.lock);
+
+		if (Result == OK)
+		{
+			sprintf(Line, "Processed %d graphs (%d %s, %d not, %d errors) in %.3lf seconds with %d workers.\n",
+					seq, pipeline.numEmbeddable, command == 'o' ? "outerplanar" : command == 'c' ? "projective planar" : command == 't' ? "toroidal" :
+					strchr("2345", command) ? "without the subgraph" : "planar",
+					pipeline.numNonembeddable, pipeline.numErrors, platform_GetDuration(start, end), numStarted);
+			Message(Line);
+			if (command == '5' && pipeline.numK5NotFound > 0)
+			{
+				sprintf(Line, "%d nonplanar graphs had no K_5 homeomorph found (result 2).\n", pipeline.numK5NotFound);
+				Message(Line);
+			}
+
+			// Report the distribution of the time taken by the algorithm on each graph
+			WriteLatencySummary(latencyHist, NULL);
+		}
+
+		if (pipeline.numErrors > 0)
+			Result = NOTOK;
+	}
+
+	if (infile != NULL && infile != stdin) fclose(infile);
+	if (pipeline.outfile != NULL && pipeline.outfile != stdout) fclose(pipeline.outfile);
+	if (pipeline.outfile2 != NULL && pipeline.outfile2 != stdout) fclose(pipeline.outfile2);
+	for (T = 0; pipeline.slots != NULL && T < pipeline.numSlots; T++)
+		sb_Free(&pipeline.slots[T].text);
+	if (pipeline.slots != NULL) free(pipeline.slots);
+	for (T = 0; workers != NULL && T < NumWorkers; T++)
+		lh_Free(&workers[T].latencyHist);
+	if (workers != NULL) free(workers);
+	if (threads != NULL) free(threads);
+	lh_Free(&latencyHist);
+	sb_Free(&nextLine);
+
+	FlushConsole(stdout);
+	return Result;
+}
+
+/****************************************************************************
+ MultiGraphWorker()
+ Claims the next sequence number, waits for the reader to fill its slot,
+ then parses the graph and runs the algorithm on it, until all graphs have
+ been claimed.
+ ****************************************************************************/
+
+platform_ThreadResult MultiGraphWorker(void *arg)
+{
+pipelineWorker *worker = (pipelineWorker *) arg;
+pipelineState *pipeline = worker->pipeline;
+pipelineSlot *slot;
+platform_time runStart, runEnd;
+int  seq;
+
+	while ((seq = platform_AtomicIncrement(&pipeline->nextClaim) - 1) >= 0)
+	{
+		slot = &pipeline->slots[seq % pipeline->numSlots];
+
+		// A worker that claimed a later sequence number with the same slot
+		// can see the slot filled for this one, and has to leave it alone
+		platform_MutexLock(pipeline->lock);
+		while (slot->state != SLOT_READ || slot->seq != seq)
+		{
+			if (pipeline->numGraphs >= 0 && seq >= pipeline->numGraphs)
+			{
+				platform_MutexUnlock(pipeline->lock);
+				return platform_ThreadReturnValue;
+			}
+			platform_CondWait(slot->stateChanged, pipeline->lock);
+		}
+		slot->state = SLOT_WORKING;
+		platform_MutexUnlock(pipeline->lock);
+
+		if ((slot->theGraph = gp_New()) == NULL)
+			slot->Result = NOTOK;
+		else
+		{
+			switch (pipeline->command)
+			{
+				case 'd' : gp_AttachDrawPlanar(slot->theGraph); break;
+				case '2' : gp_AttachK23Search(slot->theGraph); break;
+				case '3' : gp_AttachK33Search(slot->theGraph); break;
+				case '4' : gp_AttachK4Search(slot->theGraph); break;
+				case '5' : gp_AttachK5Search(slot->theGraph); break;
+				case 'c' : gp_AttachSurfaceEmbed(slot->theGraph); break;
+				case 't' : gp_AttachSurfaceEmbed(slot->theGraph); break;
+			}
+
+			// As for a specific graph, the algorithms still run correctly
+			// if too many edges were given and some had to be dropped,
+			// except c and t, but a graph with more than 3N edges embeds
+			// on neither the projective plane nor the torus
+			slot->Result = gp_ReadFromString(slot->theGraph, sb_GetFullString(slot->text));
+			if (slot->Result == NONEMBEDDABLE && !strchr("ct", pipeline->command))
+				slot->Result = OK;
+		}
+
+		if (slot->Result == OK)
+		{
+			platform_GetTime(runStart);
+			slot->Result = _RunPipelineAlgorithm(pipeline, slot->theGraph);
+			platform_GetTime(runEnd);
+
+			lh_AddSample(worker->latencyHist, platform_GetDurationNs(runStart, runEnd));
+		}
+		else
+			gp_Free(&slot->theGraph);
+
+		_SetSlotState(pipeline, slot, SLOT_DONE);
+	}
+
+	return platform_ThreadReturnValue;
+}
+
+/****************************************************************************
+ _RunPipelineAlgorithm()
+ Runs the algorithm on theGraph, or restores its result from the cache,
+ and leaves the result in the original vertex order.
+ ****************************************************************************/
+
+int  _RunPipelineAlgorithm(pipelineState *pipeline, graphP theGraph)
+{
+resultCacheKeyP theKey = NULL;
+int  Result, cacheHit = FALSE;
+
+	// The cached certificate does not include a planar drawing, whether an
+	// obstruction is a K_5, or which edges of a surface embedding are twisted
+	if (theResultCache != NULL && !strchr("d5ct", pipeline->command) &&
+		(theKey = rc_NewKey(theGraph, pipeline->embedFlags)) != NULL)
+	{
+		platform_MutexLock(pipeline->cacheLock);
+		cacheHit = rc_Lookup(theResultCache, theKey, &Result, theGraph) == OK;
+		platform_MutexUnlock(pipeline->cacheLock);
+	}
+
+	if (!cacheHit)
+	{
+		Result = gp_Embed(theGraph, pipeline->embedFlags);
+		gp_SortVertices(theGraph);
+
+		if (theKey != NULL && Result != NOTOK)
+		{
+			platform_MutexLock(pipeline->cacheLock);
+			rc_Store(theResultCache, &theKey, Result, theGraph);
+			platform_MutexUnlock(pipeline->cacheLock);
+		}
+	}
+
+	rc_FreeKey(&theKey);
+	return Result;
+}
+
+/****************************************************************************
+ MultiGraphWriter()
+ Writes the results of the graphs in sequence order, freeing each graph
+ and emptying its slot for the reader.
+ ****************************************************************************/
+
+platform_ThreadResult MultiGraphWriter(void *arg)
+{
+pipelineState *pipeline = (pipelineState *) arg;
+pipelineSlot *slot;
+char *outputStr;
+int  seq, k5NotFound;
+
+	for (seq = 0; ; seq++)
+	{
+		slot = &pipeline->slots[seq % pipeline->numSlots];
+
+		platform_MutexLock(pipeline->lock);
+		while (slot->state != SLOT_DONE)
+		{
+			if (pipeline->numGraphs >= 0 && seq >= pipeline->numGraphs)
+			{
+				platform_MutexUnlock(pipeline->lock);
+				return platform_ThreadReturnValue;
+			}
+			platform_CondWait(slot->stateChanged, pipeline->lock);
+		}
+		platform_MutexUnlock(pipeline->lock);
+
+		// The K_5 search leaves a K_{3,3} homeomorph in a nonplanar graph
+		// when it finds no K_5, which is not a K_5 homeomorph to report
+		k5NotFound = pipeline->command == '5' && slot->Result == NONEMBEDDABLE &&
+					 slot->theGraph != NULL && !gp_FoundK5Homeomorph(slot->theGraph);
+
+		if (slot->Result == OK)
+			pipeline->numEmbeddable++;
+		else if (k5NotFound)
+			pipeline->numK5NotFound++;
+		else if (slot->Result == NONEMBEDDABLE)
+			pipeline->numNonembeddable++;
+		else
+			pipeline->numErrors++;
+
+		fprintf(pipeline->outfile, "%d\n", slot->Result == OK ? 0 : k5NotFound ? 2 : (slot->Result == NONEMBEDDABLE ? 1 : -1));
+
+		if (pipeline->outfile2 != NULL && slot->theGraph != NULL && !k5NotFound &&
+			(strchr("pdo", pipeline->command) ? slot->Result != NOTOK :
+			 strchr("ct", pipeline->command) ? slot->Result == OK : slot->Result == NONEMBEDDABLE))
+		{
+			outputStr = NULL;
+			if (gp_WriteToString(slot->theGraph, &outputStr, WRITE_ADJLIST) == OK)
+				fputs(outputStr, pipeline->outfile2);
+			else
+				pipeline->numErrors++;
+			if (outputStr != NULL)
+				free(outputStr);
+		}
+
+		gp_Free(&slot->theGraph);
+		_SetSlotState(pipeline, slot, SLOT_EMPTY);
+	}
+}
+
+/****************************************************************************
+ _SetSlotState()
+ Passes the slot to the next stage, waking the threads waiting on it.
+ ****************************************************************************/
+
+void _SetSlotState(pipelineState *pipeline, pipelineSlot *slot, int state)
+{
+	platform_MutexLock(pipeline->lock);
+	slot->state = state;
+	platform_CondBroadcast(slot->stateChanged);
+	platform_MutexUnlock(pipeline->lock);
+}
+
+/****************************************************************************
+ _ReadNextGraphText()
+ Reads the text of the next graph, i.e. the lines from an "N=" line up to
+ the next one, into text.  The "N=" line that ends a graph is kept in
+ nextLine for the next call.
+
+ Returns OK if a graph was read, or NOTOK at the end of the file.
+ ****************************************************************************/
+
+int  _ReadNextGraphText(FILE *infile, strBufP text, strBufP nextLine)
+{
+char buffer[MAXLINE];
+int  lineStart = TRUE;
+
+	sb_ClearBuf(text);
+	if (sb_GetSize(nextLine) > 0)
+	{
+		sb_ConcatString(text, sb_GetFullString(nextLine));
+		sb_ClearBuf(nextLine);
+	}
+
+	while (fgets(buffer, MAXLINE, infile) != NULL)
+	{
+		// A line starting with N= begins the next graph, unless none has begun
+		if (lineStart && buffer[0] == 'N' && buffer[1] == '=' && sb_GetSize(text) > 0)
+		{
+			sb_ConcatString(nextLine, buffer);
+			lineStart = buffer[strlen(buffer) - 1] == '\n';
+
+			// The rest of a long N= line also belongs to the next graph
+			while (!lineStart && fgets(buffer, MAXLINE, infile) != NULL)
+			{
+				sb_ConcatString(nextLine, buffer);
+				lineStart = buffer[strlen(buffer) - 1] == '\n';
+			}
+			return OK;
+		}
+
+		// Skip anything before the first graph
+		if (sb_GetSize(text) > 0 || (lineStart && buffer[0] == 'N'))
+			sb_ConcatString(text, buffer);
+
+		lineStart = buffer[strlen(buffer) - 1] == '\n';
+	}
+
+	return sb_GetSize(text) > 0 ? OK : NOTOK;
+}
@@ -17,43 +17,96 @@ graphP MakeGraph(int Size, char command);
  The number of graphs to generate, and the number of vertices for each graph,
  can be sent as the second and third params.  For each that is sent as zero,
  this method will prompt the user for a value.
+
+ If the -threads option gave more than one thread, then the graphs are
+ divided among that many workers, each with its own graphs and its own
+ stream of random numbers, and the statistics of the workers are merged
+ before being reported.
  ****************************************************************************/
 
 #define NUM_MINORS  9
 
+// State shared by all workers, protected by the lock
+typedef struct
+{
+	platform_mutex lock;
+	int  numThreads, numProcessed, countUpdateFreq, errorFound;
+	int  writeErrorReported_Random, writeErrorReported_Embedded,
+		 writeErrorReported_AdjList, writeErrorReported_Obstructed,
+		 writeErrorReported_Error;
+} randomGraphsSharedState;
+
+// Per-worker graphs, random number stream and statistics
+typedef struct
+{
+	randomGraphsSharedState *shared;
+	char command;
+	int  threadIndex, NumGraphs;
+	graphP theGraph, origGraph;
+	prngState theRNG;
+	int  Result, MainStatistic;
+	int  ObstructionMinorFreqs[NUM_MINORS];
+	latencyHistogramP latencyHist;
+} randomGraphsWorker;
+
+platform_ThreadResult RandomGraphsWorker(void *arg);
+void WriteRandomGraph(randomGraphsWorker *worker, graphP theGraph, char *dirName, int K, int Mode, int *pWriteErrorReported);
+
 int  RandomGraphs(char command, int NumGraphs, int SizeOfGraphs)
 {
-char theFileName[256];
-int  K, countUpdateFreq;
+int  K, T, countUpdateFreq, NumThreads;
 int Result=OK, MainStatistic=0;
 int  ObstructionMinorFreqs[NUM_MINORS];
-graphP theGraph=NULL, origGraph=NULL;
 platform_time start, end;
+latencyHistogramP latencyHist = NULL;
+randomGraphsSharedState shared;
+randomGraphsWorker *workers = NULL;
+platform_thread *threads = NULL;
+prngState theRNG;
+unsigned long long seed;
 int embedFlags = GetEmbedFlags(command);
-int ReuseGraphs = TRUE;
-int writeResult;
-int writeErrorReported_Random=FALSE, writeErrorReported_Embedded=FALSE,
-	writeErrorReported_AdjList=FALSE, writeErrorReported_Obstructed=FALSE,
-	writeErrorReported_Error=FALSE;
 
      GetNumberIfZero(&NumGraphs, "Enter number of graphs to generate:", 1, 1000000000);
      GetNumberIfZero(&SizeOfGraphs, "Enter size of graphs:", 1, 10000);
 
-   	 theGraph = MakeGraph(SizeOfGraphs, command);
-   	 origGraph = MakeGraph(SizeOfGraphs, command);
-   	 if (theGraph == NULL || origGraph == NULL)
-   	 {
-   		 gp_Free(&theGraph);
-   		 return NOTOK;
-   	 }
+     NumThreads = numThreads < 1 ? 1 : (numThreads > NumGraphs ? NumGraphs : numThreads);
 
-     // Initialize a secondary statistics array
-     for (K=0; K < NUM_MINORS; K++)
-          ObstructionMinorFreqs[K] = 0;
+     // Make the graphs of all workers here, before any worker starts, because
+     // attaching an algorithm extension the first time assigns its global ID
+     latencyHist = lh_New();
+     workers = (randomGraphsWorker *) calloc(NumThreads, sizeof(randomGraphsWorker));
+     threads = (platform_thread *) calloc(NumThreads, sizeof(platform_thread));
+     Result = latencyHist != NULL && workers != NULL && threads != NULL ? OK : NOTOK;
 
-   	 // Seed the random number generator with "now". Do it after any prompting
-   	 // to tie randomness to human process of answering the prompt.
-   	 srand(time(NULL));
+     for (T = 0; T < NumThreads && Result == OK; T++)
+     {
+    	 workers[T].theGraph = MakeGraph(SizeOfGraphs, command);
+    	 workers[T].origGraph = MakeGraph(SizeOfGraphs, command);
+    	 workers[T].latencyHist = lh_New();
+    	 if (workers[T].theGraph == NULL || workers[T].origGraph == NULL || workers[T].latencyHist == NULL)
+    		 Result = NOTOK;
+     }
+
+     if (Result != OK)
+     {
+    	 for (T = 0; workers != NULL && T < NumThreads; T++)
+    	 {
+    		 gp_Free(&workers[T].theGraph);
+    		 gp_Free(&workers[T].origGraph);
+    		 lh_Free(&workers[T].latencyHist);
+    	 }
+    	 if (workers != NULL) free(workers);
+    	 if (threads != NULL) free(threads);
+    	 lh_Free(&latencyHist);
+    	 return NOTOK;
+     }
+
+   	 // Seed the random number generator with "now", unless a seed was given.
+   	 // Do it after any prompting to tie randomness to human process of
+   	 // answering the prompt.  Each worker gets its own non-overlapping
+   	 // stream of random numbers from the same seed.
+   	 seed = GetRandomSeed();
+   	 prng_Seed(&theRNG, seed);
 
    	 // Select a counter update frequency that updates more frequently with larger graphs
    	 // and which is relatively prime with 10 so that all digits of the count will change
@@ -63,6 +116,21 @@ int writeErrorReported_Random=FALSE, writeErrorReported_Embedded=FALSE,
    	 countUpdateFreq = countUpdateFreq % 2 == 0 ? countUpdateFreq+1 : countUpdateFreq;
    	 countUpdateFreq = countUpdateFreq % 5 == 0 ? countUpdateFreq+2 : countUpdateFreq;
 
+     memset(&shared, 0, sizeof(randomGraphsSharedState));
+     platform_MutexInit(shared.lock);
+     shared.numThreads = NumThreads;
+     shared.countUpdateFreq = countUpdateFreq;
+
+     for (T = 0; T < NumThreads; T++)
+     {
+    	 workers[T].shared = &shared;
+    	 workers[T].command = command;
+    	 workers[T].threadIndex = T;
+    	 workers[T].NumGraphs = NumGraphs / NumThreads + (T < NumGraphs % NumThreads ? 1 : 0);
+    	 workers[T].theRNG = theRNG;
+    	 prng_Jump(&theRNG);
+     }
+
    	 // Start the count
      fprintf(stdout, "0\r");
      fflush(stdout);
@@ -70,150 +138,66 @@ int writeErrorReported_Random=FALSE, writeErrorReported_Embedded=FALSE,
      // Start the timer
      platform_GetTime(start);
 
-     // Generate and process the number of graphs requested
-     for (K=0; K < NumGraphs; K++)
+     // Generate and process the number of graphs requested, in this thread
+     // if there is only one worker
+     if (NumThreads == 1)
+    	 RandomGraphsWorker(&workers[0]);
+     else
      {
-          if ((Result = gp_CreateRandomGraph(theGraph)) == OK)
-          {
-              if (tolower(OrigOut)=='y')
-              {
-                  sprintf(theFileName, "random%c%d.txt", FILE_DELIMITER, K%10);
-                  writeResult = gp_Write(theGraph, theFileName, WRITE_ADJLIST);
-                  if (writeResult != OK && !writeErrorReported_Random)
-                  {
-                	  sprintf(Line, "Failed to write graph %s\nMake the directory if not present\n", theFileName);
-                	  ErrorMessage(Line);
-                	  writeErrorReported_Random = TRUE;
-                  }
-              }
-
-              gp_CopyGraph(origGraph, theGraph);
-
-              if (strchr("pdo234", command))
-              {
-                  Result = gp_Embed(theGraph, embedFlags);
-
-                  if (gp_TestEmbedResultIntegrity(theGraph, origGraph, Result) != Result)
-                      Result = NOTOK;
+    	 for (T = 0; T < NumThreads; T++)
+    	 {
+    		 if (platform_CreateThread(threads[T], RandomGraphsWorker, &workers[T]) != OK)
+    			 break;
+    	 }
 
-                  if (Result == OK)
-                  {
-                       MainStatistic++;
+    	 // If a thread could not be started, then the remaining workers run here
+    	 for (K = T; K < NumThreads; K++)
+    		 RandomGraphsWorker(&workers[K]);
 
-                       if (tolower(EmbeddableOut) == 'y')
-                       {
-                           sprintf(theFileName, "embedded%c%d.txt", FILE_DELIMITER, K%10);
-                           writeResult = gp_Write(theGraph, theFileName, WRITE_ADJMATRIX);
-                           if (writeResult != OK && !writeErrorReported_Embedded)
-                           {
-                        	   sprintf(Line, "Failed to write graph %s\nMake the directory if not present\n", theFileName);
-                        	   ErrorMessage(Line);
-                        	   writeErrorReported_Embedded = TRUE;
-                           }
-                       }
-
-                       if (tolower(AdjListsForEmbeddingsOut) == 'y')
-                       {
-                           sprintf(theFileName, "adjlist%c%d.txt", FILE_DELIMITER, K%10);
-                           writeResult = gp_Write(theGraph, theFileName, WRITE_ADJLIST);
-                           if (writeResult != OK && !writeErrorReported_AdjList)
-                           {
-                        	   sprintf(Line, "Failed to write graph %s\nMake the directory if not present\n", theFileName);
-                        	   ErrorMessage(Line);
-                        	   writeErrorReported_AdjList = TRUE;
-                           }
-                       }
-                  }
-                  else if (Result == NONEMBEDDABLE)
-                  {
-                       if (embedFlags == EMBEDFLAGS_PLANAR || embedFlags == EMBEDFLAGS_OUTERPLANAR)
-                       {
-                           if (theGraph->IC.minorType & MINORTYPE_A)
-                                ObstructionMinorFreqs[0] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_B)
-                                ObstructionMinorFreqs[1] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_C)
-                                ObstructionMinorFreqs[2] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_D)
-                                ObstructionMinorFreqs[3] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_E)
-                                ObstructionMinorFreqs[4] ++;
-
-                           if (theGraph->IC.minorType & MINORTYPE_E1)
-                                ObstructionMinorFreqs[5] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_E2)
-                                ObstructionMinorFreqs[6] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_E3)
-                                ObstructionMinorFreqs[7] ++;
-                           else if (theGraph->IC.minorType & MINORTYPE_E4)
-                                ObstructionMinorFreqs[8] ++;
+    	 while (T-- > 0)
+    		 platform_JoinThread(threads[T]);
+     }
 
-                           if (tolower(ObstructedOut) == 'y')
-                           {
-                               sprintf(theFileName, "obstructed%c%d.txt", FILE_DELIMITER, K%10);
-                               writeResult = gp_Write(theGraph, theFileName, WRITE_ADJMATRIX);
-                               if (writeResult != OK && !writeErrorReported_Obstructed)
-                               {
-                            	   sprintf(Line, "Failed to write graph %s\nMake the directory if not present\n", theFileName);
-                            	   ErrorMessage(Line);
-                            	   writeErrorReported_Obstructed = TRUE;
-                               }
-                           }
-                       }
-                  }
-              }
+     // Stop the timer
+     platform_GetTime(end);
 
-              // If there is an error in processing, then write the file for debugging
-              if (Result != OK && Result != NONEMBEDDABLE)
-              {
-                   sprintf(theFileName, "error%c%d.txt", FILE_DELIMITER, K%10);
-                   writeResult = gp_Write(origGraph, theFileName, WRITE_ADJLIST);
-                   if (writeResult != OK && !writeErrorReported_Error)
-                   {
-                	   sprintf(Line, "Failed to write graph %s\nMake the directory if not present\n", theFileName);
-                	   ErrorMessage(Line);
-                	   writeErrorReported_Error = TRUE;
-                   }
-              }
-          }
+     // Merge the statistics of the workers, and free their graph structures
+     for (K=0; K < NUM_MINORS; K++)
+          ObstructionMinorFreqs[K] = 0;
 
-          // Reinitialize or recreate graphs for next iteration
-          ReinitializeGraph(&theGraph, ReuseGraphs, command);
-          ReinitializeGraph(&origGraph, ReuseGraphs, command);
+     for (T = 0; T < NumThreads; T++)
+     {
+    	 if (workers[T].Result != OK && workers[T].Result != NONEMBEDDABLE)
+    		 Result = NOTOK;
 
-          // Show progress, but not so often that it bogs down progress
-          if (quietMode == 'n' && (K+1) % countUpdateFreq == 0)
-          {
-              fprintf(stdout, "%d\r", K+1);
-              fflush(stdout);
-          }
+    	 MainStatistic += workers[T].MainStatistic;
+    	 for (K=0; K < NUM_MINORS; K++)
+    		 ObstructionMinorFreqs[K] += workers[T].ObstructionMinorFreqs[K];
+    	 lh_Merge(latencyHist, workers[T].latencyHist);
 
-          // Terminate loop on error
-          if (Result != OK && Result != NONEMBEDDABLE)
-          {
-        	  ErrorMessage("\nError found\n");
-              Result = NOTOK;
-              break;
-          }
+    	 gp_Free(&workers[T].theGraph);
+    	 gp_Free(&workers[T].origGraph);
+    	 lh_Free(&workers[T].latencyHist);
      }
 
-     // Stop the timer
-     platform_GetTime(end);
+     platform_MutexDestroy(shared.lock);
+     free(workers);
+     free(threads);
 
      // Finish the count
      fprintf(stdout, "%d\n", NumGraphs);
      fflush(stdout);
 
-     // Free the graph structures created before the loop
-     gp_Free(&theGraph);
-     gp_Free(&origGraph);
-
      // Print some demographic results
-     if (Result == OK || Result == NONEMBEDDABLE)
+     if (Result == OK)
          Message("\nNo Errors Found.");
-     sprintf(Line, "\nDone (%.3lf seconds).\n", platform_GetDuration(start,end));
+     sprintf(Line, "\nDone (%.3lf seconds, random seed %llu).\n", platform_GetDuration(start,end), seed);
      Message(Line);
 
+     // Report the distribution of the time taken by the algorithm on each graph
+     WriteLatencySummary(latencyHist, NULL);
+     lh_Free(&latencyHist);
+
      // Report statistics for planar or outerplanar embedding
      if (embedFlags == EMBEDFLAGS_PLANAR || embedFlags == EMBEDFLAGS_OUTERPLANAR)
      {
@@ -266,11 +250,166 @@ int writeErrorReported_Random=FALSE, writeErrorReported_Embedded=FALSE,
          sprintf(Line, "Of the generated graphs, %d did not contain a K_4 homeomorph as a subgraph.\n", MainStatistic);
          Message(Line);
      }
+     else if (embedFlags == EMBEDFLAGS_SEARCHFORK5)
+     {
+         sprintf(Line, "Of the generated graphs, %d were planar, so did not contain a K_5 homeomorph as a subgraph.\n", MainStatistic);
+         Message(Line);
+     }
+     else if (embedFlags == EMBEDFLAGS_PROJECTIVEPLANAR)
+     {
+         sprintf(Line, "Of the generated graphs, %d embedded on the projective plane.\n", MainStatistic);
+         Message(Line);
+     }
+     else if (embedFlags == EMBEDFLAGS_TOROIDAL)
+     {
+         sprintf(Line, "Of the generated graphs, %d embedded on the torus.\n", MainStatistic);
+         Message(Line);
+     }
 
 
      FlushConsole(stdout);
 
-     return Result==OK || Result==NONEMBEDDABLE ? OK : NOTOK;
+     return Result;
+}
+
+/****************************************************************************
+ RandomGraphsWorker()
+ Generates, processes and checks the worker's share of the random graphs
+ using only the worker's own graphs and random number stream.
+ Worker K generates graphs K, K+T, K+2T, ..., where T is the number of
+ workers, so the output files are named as in a single-threaded run.
+ ****************************************************************************/
+
+platform_ThreadResult RandomGraphsWorker(void *arg)
+{
+randomGraphsWorker *worker = (randomGraphsWorker *) arg;
+randomGraphsSharedState *shared = worker->shared;
+graphP theGraph = worker->theGraph, origGraph = worker->origGraph;
+int  I, K, numProcessed, Result = OK;
+int  embedFlags = GetEmbedFlags(worker->command);
+int  ReuseGraphs = TRUE;
+platform_time embedStart, embedEnd;
+
+     for (I = 0; I < worker->NumGraphs && !platform_AtomicRead(&shared->errorFound); I++)
+     {
+          K = worker->threadIndex + I * shared->numThreads;
+
+          if ((Result = gp_CreateRandomGraphR(theGraph, &worker->theRNG)) == OK)
+          {
+              if (tolower(OrigOut)=='y')
+                  WriteRandomGraph(worker, theGraph, "random", K, WRITE_ADJLIST, &shared->writeErrorReported_Random);
+
+              gp_CopyGraph(origGraph, theGraph);
+
+              if (strchr("pdo2345ct", worker->command))
+              {
+                  platform_GetTime(embedStart);
+                  Result = gp_Embed(theGraph, embedFlags);
+                  platform_GetTime(embedEnd);
+
+                  lh_AddSample(worker->latencyHist, platform_GetDurationNs(embedStart, embedEnd));
+
+                  if (gp_TestEmbedResultIntegrity(theGraph, origGraph, Result) != Result)
+                      Result = NOTOK;
+
+                  if (Result == OK)
+                  {
+                       worker->MainStatistic++;
+
+                       if (tolower(EmbeddableOut) == 'y')
+                           WriteRandomGraph(worker, theGraph, "embedded", K, WRITE_ADJMATRIX, &shared->writeErrorReported_Embedded);
+
+                       if (tolower(AdjListsForEmbeddingsOut) == 'y')
+                           WriteRandomGraph(worker, theGraph, "adjlist", K, WRITE_ADJLIST, &shared->writeErrorReported_AdjList);
+                  }
+                  else if (Result == NONEMBEDDABLE)
+                  {
+                       if (embedFlags == EMBEDFLAGS_PLANAR || embedFlags == EMBEDFLAGS_OUTERPLANAR)
+                       {
+                           if (theGraph->IC.minorType & MINORTYPE_A)
+                                worker->ObstructionMinorFreqs[0] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_B)
+                                worker->ObstructionMinorFreqs[1] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_C)
+                                worker->ObstructionMinorFreqs[2] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_D)
+                                worker->ObstructionMinorFreqs[3] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_E)
+                                worker->ObstructionMinorFreqs[4] ++;
+
+                           if (theGraph->IC.minorType & MINORTYPE_E1)
+                                worker->ObstructionMinorFreqs[5] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_E2)
+                                worker->ObstructionMinorFreqs[6] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_E3)
+                                worker->ObstructionMinorFreqs[7] ++;
+                           else if (theGraph->IC.minorType & MINORTYPE_E4)
+                                worker->ObstructionMinorFreqs[8] ++;
+
+                           if (tolower(ObstructedOut) == 'y')
+                               WriteRandomGraph(worker, theGraph, "obstructed", K, WRITE_ADJMATRIX, &shared->writeErrorReported_Obstructed);
+                       }
+                  }
+              }
+
+              // If there is an error in processing, then write the file for debugging
+              if (Result != OK && Result != NONEMBEDDABLE)
+                  WriteRandomGraph(worker, origGraph, "error", K, WRITE_ADJLIST, &shared->writeErrorReported_Error);
+          }
+
+          // Reinitialize or recreate graphs for next iteration
+          ReinitializeGraph(&theGraph, ReuseGraphs, worker->command);
+          ReinitializeGraph(&origGraph, ReuseGraphs, worker->command);
+
+          platform_MutexLock(shared->lock);
+          numProcessed = ++shared->numProcessed;
+
+          // Show progress, but not so often that it bogs down progress
+          if (quietMode == 'n' && numProcessed % shared->countUpdateFreq == 0)
+          {
+              fprintf(stdout, "%d\r", numProcessed);
+              fflush(stdout);
+          }
+
+          // Terminate all workers on error
+          if (Result != OK && Result != NONEMBEDDABLE)
+          {
+              // Set atomically since other workers read the flag without the lock
+              if (platform_AtomicCompareAndSwap(&shared->errorFound, FALSE, TRUE))
+            	  ErrorMessage("\nError found\n");
+              Result = NOTOK;
+          }
+          platform_MutexUnlock(shared->lock);
+     }
+
+     worker->theGraph = theGraph;
+     worker->origGraph = origGraph;
+     worker->Result = Result;
+
+     return platform_ThreadReturnValue;
+}
+
+/****************************************************************************
+ WriteRandomGraph()
+ Writes one of the last 10 graphs of a kind to a file in the given
+ directory, reporting a write failure only once per kind of graph.
+ ****************************************************************************/
+
+void WriteRandomGraph(randomGraphsWorker *worker, graphP theGraph, char *dirName, int K, int Mode, int *pWriteErrorReported)
+{
+char theFileName[256], theLine[MAXLINE];
+
+     sprintf(theFileName, "%s%c%d.txt", dirName, FILE_DELIMITER, K%10);
+
+     // Workers take turns so that two of them never write the same file
+     platform_MutexLock(worker->shared->lock);
+     if (gp_Write(theGraph, theFileName, Mode) != OK && !*pWriteErrorReported)
+     {
+    	 sprintf(theLine, "Failed to write graph %s\nMake the directory if not present\n", theFileName);
+    	 ErrorMessage(theLine);
+    	 *pWriteErrorReported = TRUE;
+     }
+     platform_MutexUnlock(worker->shared->lock);
 }
 
 /****************************************************************************
@@ -328,6 +467,9 @@ graphP MakeGraph(int Size, char command)
 		case '2' : gp_AttachK23Search(theGraph); break;
 		case '3' : gp_AttachK33Search(theGraph); break;
 		case '4' : gp_AttachK4Search(theGraph); break;
+		case '5' : gp_AttachK5Search(theGraph); break;
+		case 'c' : gp_AttachSurfaceEmbed(theGraph); break;
+		case 't' : gp_AttachSurfaceEmbed(theGraph); break;
 	}
 
 	return theGraph;
@@ -359,6 +501,8 @@ int RandomGraph(char command, int extraEdges, int numVertices, char *outfileName
 {
 int  Result;
 platform_time start, end;
+prngState theRNG;
+unsigned long long seed;
 graphP theGraph=NULL, origGraph;
 int embedFlags = GetEmbedFlags(command);
 char saveEdgeListFormat;
@@ -367,18 +511,19 @@ char saveEdgeListFormat;
      if ((theGraph = MakeGraph(numVertices, command)) == NULL)
     	 return NOTOK;
 
-     srand(time(NULL));
+     seed = GetRandomSeed();
+     prng_Seed(&theRNG, seed);
 
      Message("Creating the random graph...\n");
      platform_GetTime(start);
-     if (gp_CreateRandomGraphEx(theGraph, 3*numVertices-6+extraEdges) != OK)
+     if (gp_CreateRandomGraphExR(theGraph, 3*numVertices-6+extraEdges, &theRNG) != OK)
      {
-         ErrorMessage("gp_CreateRandomGraphEx() failed\n");
+         ErrorMessage("gp_CreateRandomGraphExR() failed\n");
          return NOTOK;
      }
      platform_GetTime(end);
 
-     sprintf(Line, "Created random graph with %d edges in %.3lf seconds. ", theGraph->M, platform_GetDuration(start,end));
+     sprintf(Line, "Created random graph with %d edges (random seed %llu) in %.3lf seconds. ", theGraph->M, seed, platform_GetDuration(start,end));
      Message(Line);
      FlushConsole(stdout);
 
@@ -394,7 +539,7 @@ char saveEdgeListFormat;
      Message("Now processing\n");
      FlushConsole(stdout);
 
-     if (strchr("pdo234", command))
+     if (strchr("pdo2345ct", command))
      {
          platform_GetTime(start);
          Result = gp_Embed(theGraph, embedFlags);
@@ -0,0 +1,593 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "planarity.h"
+
+/****************************************************************************
+ Serve()
+ Runs the algorithms on graphs received over a Unix domain socket, so that
+ a client can process many graphs without starting a process, or reading
+ and writing files, for each one.
+
+ The protocol is a sequence of messages.  Each message is a length L
+ followed by L bytes of content, and all values are 32-bit integers in
+ network byte order.  A request has the content
+
+     C N M u_1 v_1 ... u_M v_M
+
+ where C is the command character (p, o, 2, 3, 4, 5, c or t; see the help
+ message), N is the number of vertices, and the M edges are given by
+ zero-based endpoints.  The response has the content
+
+     R [offsets_0 ... offsets_N neighbors...]
+
+ where R is the result (OK=1, NONEMBEDDABLE=-1, or NOTOK=0 for an error,
+ and for 5 also SERVER_K5NOTFOUND=2 if the graph is not planar but the
+ search found only a K_{3,3} homeomorph, so it may or may not have a K_5
+ homeomorph), and the optional rotation system gives the zero-based neighbors of vertex
+ i as neighbors[offsets_i] to neighbors[offsets_{i+1}-1].  For p and o,
+ the rotation system is the embedding or the obstruction, and for 2, 3,
+ 4 and 5 it is the homeomorphic subgraph, which is only sent if one was
+ found (R is NONEMBEDDABLE).  For c and t, only R is sent, since a
+ rotation system does not show which edges of a projective plane or torus
+ embedding are twisted.  A request with C equal to q stops the server.
+
+ A client may send several requests without waiting for responses.  Each
+ connection is served by one worker thread, which processes all of the
+ complete requests it has received before sending their responses in one
+ write, in the order of the requests.  The number of workers is given by
+ the -threads option, and each reuses its graphs from one request to the
+ next.  If the -cache option was given, the workers share the result cache,
+ except for 5, c and t, since a cached certificate does not say whether an
+ obstruction is a K_5 or which edges of a surface embedding are twisted.
+
+ Unlike SpecificGraph(), the results are not checked for integrity.
+ Each worker times the algorithm on each graph into its own latency
+ histogram, and the histograms are merged and reported when the server
+ stops.
+
+ Returns OK if the server was stopped by a client, or NOTOK on error.
+ ****************************************************************************/
+
+#ifdef WIN32
+
+int Serve(char *socketName)
+{
+	ErrorMessage("The server mode requires Unix domain sockets.\n");
+	return NOTOK;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+
+#define SERVER_COMMANDS "po2345ct"
+#define SERVER_MAXMESSAGE (1 << 30)
+#define SERVER_READSIZE 65536
+#define SERVER_K5NOTFOUND 2
+
+// A growable buffer of 32-bit words
+typedef struct
+{
+	int *words;
+	int  size, capacity;
+} serverBuffer;
+
+struct serverWorkerStruct;
+
+// State shared by all workers, protected by the lock
+typedef struct
+{
+	platform_mutex lock;
+	int  listenFd, stopping;
+	struct serverWorkerStruct *workers;
+	int  numWorkers;
+} serverSharedState;
+
+// Per-worker graphs (one per command, since each command attaches a
+// different extension), edge array, message buffers and latency histogram
+typedef struct serverWorkerStruct
+{
+	serverSharedState *shared;
+	int  connFd;
+	graphP graphs[sizeof(SERVER_COMMANDS)];
+	serverBuffer edges, in, out;
+	latencyHistogramP latencyHist;
+} serverWorker;
+
+platform_ThreadResult ServerWorker(void *arg);
+int  _ServeConnection(serverWorker *worker, int fd);
+int  _ServeRequest(serverWorker *worker, int *request, int numWords);
+int  _ServeGraph(serverWorker *worker, char command, int N, int M, int *pResult, graphP *pGraph);
+graphP _MakeServerGraph(int N, int M, char command);
+void _StopServer(serverSharedState *shared);
+int  _EnsureBufferCapacity(serverBuffer *buffer, int capacity);
+int  _SendAll(int fd, char *data, size_t length);
+
+int Serve(char *socketName)
+{
+serverSharedState shared;
+serverWorker *workers = NULL;
+platform_thread *threads = NULL;
+latencyHistogramP latencyHist = NULL;
+struct sockaddr_un address;
+struct stat socketStat;
+int  T, K, NumThreads, Result = OK;
+
+	if (strlen(socketName) >= sizeof(address.sun_path))
+	{
+		ErrorMessage("The socket name is too long.\n");
+		return NOTOK;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketName);
+
+	// Replace the socket left by an earlier server, but no other kind of file
+	if (stat(socketName, &socketStat) == 0 && S_ISSOCK(socketStat.st_mode))
+		unlink(socketName);
+
+	memset(&shared, 0, sizeof(serverSharedState));
+	if ((shared.listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+		bind(shared.listenFd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+		listen(shared.listenFd, SOMAXCONN) != 0)
+	{
+		ErrorMessage("Failed to listen on the socket.\n");
+		if (shared.listenFd >= 0)
+			close(shared.listenFd);
+		return NOTOK;
+	}
+
+	// A client that disconnects early must not terminate the server
+	signal(SIGPIPE, SIG_IGN);
+
+	NumThreads = numThreads < 1 ? 1 : numThreads;
+	workers = (serverWorker *) calloc(NumThreads, sizeof(serverWorker));
+	threads = (platform_thread *) calloc(NumThreads, sizeof(platform_thread));
+	latencyHist = lh_New();
+	for (T = 0; workers != NULL && T < NumThreads; T++)
+	{
+		if ((workers[T].latencyHist = lh_New()) == NULL)
+			break;
+	}
+
+	if (workers == NULL || threads == NULL || latencyHist == NULL || T < NumThreads)
+	{
+		ErrorMessage("Failed to allocate the server workers.\n");
+		Result = NOTOK;
+	}
+	else
+	{
+		platform_MutexInit(shared.lock);
+		shared.workers = workers;
+		shared.numWorkers = NumThreads;
+
+		for (T = 0; T < NumThreads; T++)
+		{
+			workers[T].shared = &shared;
+			workers[T].connFd = -1;
+		}
+
+		sprintf(Line, "Serving on '%s' with %d thread%s.\n", socketName, NumThreads, NumThreads == 1 ? "" : "s");
+		Message(Line);
+		FlushConsole(stdout);
+
+		// Worker 0 runs in this thread, after starting the others
+		for (T = 1; T < NumThreads; T++)
+		{
+			if (platform_CreateThread(threads[T], ServerWorker, &workers[T]) != OK)
+				break;
+		}
+
+		ServerWorker(&workers[0]);
+
+		// All workers stop once any of them stops
+		while (--T > 0)
+			platform_JoinThread(threads[T]);
+
+		for (T = 0; T < NumThreads; T++)
+		{
+			for (K = 0; K < (int) sizeof(SERVER_COMMANDS); K++)
+				gp_Free(&workers[T].graphs[K]);
+			free(workers[T].edges.words);
+			free(workers[T].in.words);
+			free(workers[T].out.words);
+			lh_Merge(latencyHist, workers[T].latencyHist);
+		}
+
+		platform_MutexDestroy(shared.lock);
+		Message("Server stopped.\n");
+
+		// Report the distribution of the time taken by the algorithm on each graph
+		WriteLatencySummary(latencyHist, NULL);
+	}
+
+	close(shared.listenFd);
+	unlink(socketName);
+
+	for (T = 0; workers != NULL && T < NumThreads; T++)
+		lh_Free(&workers[T].latencyHist);
+	if (workers != NULL) free(workers);
+	if (threads != NULL) free(threads);
+	lh_Free(&latencyHist);
+
+	FlushConsole(stdout);
+	return Result;
+}
+
+/****************************************************************************
+ ServerWorker()
+ Serves one connection at a time until the server is stopped.
+ ****************************************************************************/
+
+platform_ThreadResult ServerWorker(void *arg)
+{
+serverWorker *worker = (serverWorker *) arg;
+serverSharedState *shared = worker->shared;
+int  fd, stopRequested;
+
+	for (;;)
+	{
+		if ((fd = accept(shared->listenFd, NULL, NULL)) < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+
+		platform_MutexLock(shared->lock);
+		if (!shared->stopping)
+			worker->connFd = fd;
+		platform_MutexUnlock(shared->lock);
+
+		if (worker->connFd != fd)
+		{
+			close(fd);
+			break;
+		}
+
+		stopRequested = _ServeConnection(worker, fd) == NONEMBEDDABLE;
+
+		platform_MutexLock(shared->lock);
+		worker->connFd = -1;
+		platform_MutexUnlock(shared->lock);
+		close(fd);
+
+		if (stopRequested)
+			break;
+	}
+
+	// Whether it was requested or this worker failed to accept connections,
+	// make the other workers stop too
+	_StopServer(shared);
+
+	return platform_ThreadReturnValue;
+}
+
+/****************************************************************************
+ _StopServer()
+ Wakes the workers that are waiting for a connection or for a request,
+ which then find that the server is stopping.
+ ****************************************************************************/
+
+void _StopServer(serverSharedState *shared)
+{
+int  T;
+
+	platform_MutexLock(shared->lock);
+	shared->stopping = TRUE;
+	shutdown(shared->listenFd, SHUT_RDWR);
+	for (T = 0; T < shared->numWorkers; T++)
+	{
+		if (shared->workers[T].connFd >= 0)
+			shutdown(shared->workers[T].connFd, SHUT_RD);
+	}
+	platform_MutexUnlock(shared->lock);
+}
+
+/****************************************************************************
+ _ServeConnection()
+ Reads requests until the client closes the connection.  Each read may
+ deliver several requests, and their responses are sent together.
+
+ Returns OK when the client closes the connection, NONEMBEDDABLE if the
+ client asked the server to stop, or NOTOK on a protocol or I/O error.
+ ****************************************************************************/
+
+int  _ServeConnection(serverWorker *worker, int fd)
+{
+serverBuffer *in = &worker->in;
+int  pos, numWords, Result = OK;
+long received, numBytes = 0;
+
+	for (;;)
+	{
+		// Make room for at least one more read, then receive what is available
+		if (_EnsureBufferCapacity(in, (int) ((numBytes + SERVER_READSIZE) / sizeof(int)) + 1) != OK)
+			return NOTOK;
+
+		received = recv(fd, (char *) in->words + numBytes, (size_t) in->capacity * sizeof(int) - numBytes, 0);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return received == 0 && numBytes == 0 ? OK : NOTOK;
+		numBytes += received;
+
+		// Process every complete request, collecting the responses
+		worker->out.size = 0;
+		for (pos = 0; Result == OK && numBytes - pos * (long) sizeof(int) >= (long) sizeof(int); )
+		{
+			unsigned length = ntohl((unsigned) in->words[pos]);
+
+			if (length % sizeof(int) != 0 || length > SERVER_MAXMESSAGE)
+				return NOTOK;
+
+			numWords = (int) (length / sizeof(int));
+			if (numBytes - pos * (long) sizeof(int) < (long) sizeof(int) * (1 + numWords))
+			{
+				// Make sure the rest of an incomplete request will fit
+				if (_EnsureBufferCapacity(in, numWords + 1 + SERVER_READSIZE / (int) sizeof(int)) != OK)
+					return NOTOK;
+				break;
+			}
+
+			Result = _ServeRequest(worker, in->words + pos + 1, numWords);
+			pos += 1 + numWords;
+		}
+
+		if (Result == NOTOK)
+			return NOTOK;
+
+		if (worker->out.size > 0 &&
+			_SendAll(fd, (char *) worker->out.words, worker->out.size * sizeof(int)) != OK)
+			return NOTOK;
+
+		if (Result == NONEMBEDDABLE)
+			return NONEMBEDDABLE;
+
+		// Keep the start of an incomplete request for the next read
+		numBytes -= pos * (long) sizeof(int);
+		memmove(in->words, in->words + pos, numBytes);
+	}
+}
+
+/****************************************************************************
+ _ServeRequest()
+ Runs the requested algorithm and appends the response to the output.
+
+ Returns OK, NONEMBEDDABLE for the stop request, or NOTOK if the request
+ is malformed, in which case the connection is closed without a response.
+ ****************************************************************************/
+
+int  _ServeRequest(serverWorker *worker, int *request, int numWords)
+{
+serverBuffer *out = &worker->out;
+graphP theGraph = NULL;
+char command;
+int  N, M, K, Result, *response, count;
+
+	if (numWords < 3)
+		return NOTOK;
+
+	command = (char) ntohl((unsigned) request[0]);
+	N = (int) ntohl((unsigned) request[1]);
+	M = (int) ntohl((unsigned) request[2]);
+
+	if (N < 0 || M < 0 || numWords != 3 + 2 * (long) M)
+		return NOTOK;
+
+	if (command == 'q')
+		Result = OK;
+
+	else if (command == '\0' || strchr(SERVER_COMMANDS, command) == NULL)
+		Result = NOTOK;
+
+	else
+	{
+		if (_EnsureBufferCapacity(&worker->edges, 2 * M) != OK)
+			return NOTOK;
+		for (K = 0; K < 2 * M; K++)
+			worker->edges.words[K] = (int) ntohl((unsigned) request[3 + K]);
+
+		if (_ServeGraph(worker, command, N, M, &Result, &theGraph) != OK)
+			Result = NOTOK;
+	}
+
+	// Append the length, the result and, if there is one, the rotation system
+	if (Result != NOTOK && command != 'q' &&
+		(strchr("po", command) || (strchr("2345", command) && Result == NONEMBEDDABLE)))
+		count = 1 + (N + 1) + (theGraph != NULL ? 2 * theGraph->M : 0);
+	else
+		count = 1;
+
+	if (_EnsureBufferCapacity(out, out->size + 1 + count) != OK)
+		return NOTOK;
+
+	response = out->words + out->size;
+	response[0] = (int) htonl((unsigned) (count * sizeof(int)));
+	response[1] = (int) htonl((unsigned) Result);
+
+	if (count > 1)
+	{
+		if (theGraph == NULL)
+			response[2] = 0;
+		else if (gp_GetRotationSystem(theGraph, response + 2, response + 2 + (N + 1)) < 0)
+		{
+			count = 1;
+			response[0] = (int) htonl((unsigned) sizeof(int));
+			response[1] = (int) htonl((unsigned) NOTOK);
+		}
+		for (K = 2; K < 1 + count; K++)
+			response[K] = (int) htonl((unsigned) response[K]);
+	}
+
+	out->size += 1 + count;
+
+	return command == 'q' ? NONEMBEDDABLE : OK;
+}
+
+/****************************************************************************
+ _ServeGraph()
+ Loads the edges into the worker's graph for the command, reusing it if it
+ has the right number of vertices and room for the edges, and runs the
+ algorithm, consulting the
+ result cache if there is one.  On success, *pGraph is the graph holding
+ the result, in the original vertex order, or NULL for a graph with no
+ vertices or when *pResult is SERVER_K5NOTFOUND.
+ ****************************************************************************/
+
+int  _ServeGraph(serverWorker *worker, char command, int N, int M, int *pResult, graphP *pGraph)
+{
+graphP *pWorkerGraph = &worker->graphs[strchr(SERVER_COMMANDS, command) - SERVER_COMMANDS];
+resultCacheKeyP theKey = NULL;
+platform_time runStart, runEnd;
+int  embedFlags = GetEmbedFlags(command), cacheHit = FALSE;
+
+	*pGraph = NULL;
+
+	// The graph library does not support graphs with no vertices
+	if (N == 0)
+	{
+		*pResult = M == 0 ? OK : NOTOK;
+		return OK;
+	}
+
+	if (*pWorkerGraph != NULL && (*pWorkerGraph)->N == N && (*pWorkerGraph)->arcCapacity >= 2 * M)
+		gp_ReinitializeGraph(*pWorkerGraph);
+	else
+	{
+		gp_Free(pWorkerGraph);
+		if ((*pWorkerGraph = _MakeServerGraph(N, M, command)) == NULL)
+			return NOTOK;
+	}
+
+	if (gp_AddEdgesFromArray(*pWorkerGraph, M, worker->edges.words, NULL) < 0)
+		return NOTOK;
+
+	platform_GetTime(runStart);
+
+	if (theResultCache != NULL && !strchr("5ct", command) &&
+		(theKey = rc_NewKey(*pWorkerGraph, embedFlags)) != NULL)
+	{
+		platform_MutexLock(worker->shared->lock);
+		cacheHit = rc_Lookup(theResultCache, theKey, pResult, *pWorkerGraph) == OK;
+		platform_MutexUnlock(worker->shared->lock);
+	}
+
+	if (!cacheHit)
+	{
+		*pResult = gp_Embed(*pWorkerGraph, embedFlags);
+		gp_SortVertices(*pWorkerGraph);
+
+		if (theKey != NULL && *pResult != NOTOK)
+		{
+			platform_MutexLock(worker->shared->lock);
+			rc_Store(theResultCache, &theKey, *pResult, *pWorkerGraph);
+			platform_MutexUnlock(worker->shared->lock);
+		}
+	}
+
+	rc_FreeKey(&theKey);
+
+	platform_GetTime(runEnd);
+	lh_AddSample(worker->latencyHist, platform_GetDurationNs(runStart, runEnd));
+
+	if (*pResult == NOTOK)
+		return NOTOK;
+
+	// The K_{3,3} left by a K_5 search that found no K_5 is not sent
+	if (command == '5' && *pResult == NONEMBEDDABLE && !gp_FoundK5Homeomorph(*pWorkerGraph))
+	{
+		*pResult = SERVER_K5NOTFOUND;
+		return OK;
+	}
+
+	*pGraph = *pWorkerGraph;
+	return OK;
+}
+
+/****************************************************************************
+ _MakeServerGraph()
+ Makes a graph with N vertices and room for M edges, so that no edge of a
+ request is dropped, and attaches the algorithm given by the command.  The
+ capacity is set before the algorithm is attached because some extensions
+ cannot extend their edge data afterward.
+ ****************************************************************************/
+
+graphP _MakeServerGraph(int N, int M, char command)
+{
+graphP theGraph;
+
+	if ((theGraph = gp_New()) == NULL)
+		return NULL;
+
+	if ((M > DEFAULT_EDGE_LIMIT*N && gp_EnsureArcCapacity(theGraph, 2*M) != OK) ||
+		gp_InitGraph(theGraph, N) != OK)
+	{
+		gp_Free(&theGraph);
+		return NULL;
+	}
+
+	AttachAlgorithm(theGraph, command);
+
+	return theGraph;
+}
+
+/****************************************************************************
+ _EnsureBufferCapacity()
+ ****************************************************************************/
+
+int  _EnsureBufferCapacity(serverBuffer *buffer, int capacity)
+{
+int *newWords;
+int  newCapacity = buffer->capacity > 0 ? buffer->capacity : 1024;
+
+	if (capacity <= buffer->capacity)
+		return OK;
+
+	while (newCapacity < capacity)
+		newCapacity *= 2;
+
+	if ((newWords = (int *) realloc(buffer->words, newCapacity * sizeof(int))) == NULL)
+		return NOTOK;
+
+	buffer->words = newWords;
+	buffer->capacity = newCapacity;
+	return OK;
+}
+
+/****************************************************************************
+ _SendAll()
+ ****************************************************************************/
+
+int  _SendAll(int fd, char *data, size_t length)
+{
+long sent;
+
+	while (length > 0)
+	{
+		if ((sent = send(fd, data, length, 0)) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return NOTOK;
+		}
+		data += sent;
+		length -= sent;
+	}
+
+	return OK;
+}
+
+#endif
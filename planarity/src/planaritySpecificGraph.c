@@ -38,7 +38,8 @@ int SpecificGraph(
 {
 graphP theGraph, origGraph;
 platform_time start, end;
-int Result = OK;
+resultCacheKeyP theKey = NULL;
+int Result = OK, cacheHit = FALSE;
 
     // Get the filename of the graph to test
     if (inputStr == NULL)
@@ -56,6 +57,9 @@ int Result = OK;
 		case '2' : gp_AttachK23Search(theGraph); break;
 		case '3' : gp_AttachK33Search(theGraph); break;
 		case '4' : gp_AttachK4Search(theGraph); break;
+		case '5' : gp_AttachK5Search(theGraph); break;
+		case 'c' : gp_AttachSurfaceEmbed(theGraph); break;
+		case 't' : gp_AttachSurfaceEmbed(theGraph); break;
 	}
 
     // Read the graph into memory
@@ -72,7 +76,7 @@ int Result = OK;
 	{
 		Message("The graph contains too many edges.\n");
 		// Some of the algorithms will still run correctly with some edges removed.
-		if (strchr("pdo234", command))
+		if (strchr("pdo2345", command))
 		{
 			Message("Some edges were removed, but the algorithm will still run correctly.\n");
 			Result = OK;
@@ -91,9 +95,16 @@ int Result = OK;
         origGraph = gp_DupGraph(theGraph);
 
         // Run the algorithm
-        if (strchr("pdo234", command))
+        if (strchr("pdo2345ct", command))
         {
     		int embedFlags = GetEmbedFlags(command);
+
+    		// The cached certificate does not include a planar drawing, whether an obstruction
+    		// is a K_5, or which edges of a surface embedding are twisted, so drawings, K_5
+    		// searches and surface embeddings are not cached
+    		if (theResultCache != NULL && !strchr("d5ct", command))
+    			theKey = rc_NewKey(theGraph, embedFlags);
+
 	        platform_GetTime(start);
 
 //	        gp_CreateDFSTree(theGraph);
@@ -101,9 +112,18 @@ int Result = OK;
 //			gp_Write(theGraph, "debug.before.txt", WRITE_DEBUGINFO);
 //	        gp_SortVertices(theGraph);
 
-			Result = gp_Embed(theGraph, embedFlags);
-	        platform_GetTime(end);
-	        Result = gp_TestEmbedResultIntegrity(theGraph, origGraph, Result);
+	        // On a cache hit, theGraph receives the stored result in the original vertex order
+	        if (theKey != NULL && rc_Lookup(theResultCache, theKey, &Result, theGraph) == OK)
+	        {
+	        	cacheHit = TRUE;
+	        	platform_GetTime(end);
+	        }
+	        else
+	        {
+	        	Result = gp_Embed(theGraph, embedFlags);
+	        	platform_GetTime(end);
+	        	Result = gp_TestEmbedResultIntegrity(theGraph, origGraph, Result);
+	        }
         }
         else
         {
@@ -130,16 +150,21 @@ int Result = OK;
 	// Provide the output file(s)
 	else
 	{
-        // Restore the vertex ordering of the original graph (undo DFS numbering)
-        if (strchr("pdo234", command))
+        // Restore the vertex ordering of the original graph (undo DFS numbering),
+        // then cache the result with the embedding or obstruction as its certificate
+        if (strchr("pdo2345ct", command) && !cacheHit)
+        {
             gp_SortVertices(theGraph);
+            if (theKey != NULL)
+                rc_Store(theResultCache, &theKey, Result, theGraph);
+        }
 
         // Determine the name of the primary output file
         outfileName = ConstructPrimaryOutputFilename(infileName, outfileName, command);
 
         // For some algorithms, the primary output file is not always written
-        if ((strchr("pdo", command) && Result == NONEMBEDDABLE) ||
-        	(strchr("234", command) && Result == OK))
+        if ((strchr("pdoct", command) && Result == NONEMBEDDABLE) ||
+        	(strchr("2345", command) && Result == OK))
         {
         	// Do not write the file
         }
@@ -202,8 +227,9 @@ int Result = OK;
 		}
 	}
 
-	// Free the graph
+	// Free the graph and the cache key, if the cache did not take it
 	gp_Free(&theGraph);
+	rc_FreeKey(&theKey);
 
 	// Flush any remaining message content to the user, and return the result
     FlushConsole(stdout);
@@ -229,6 +255,11 @@ void WriteAlgorithmResults(graphP theGraph, int Result, char command, platform_t
 		case '2' : sprintf(Line, "has %s subgraph homeomorphic to K_{2,3}.\n", Result==OK ? "no" : "a"); break;
 		case '3' : sprintf(Line, "has %s subgraph homeomorphic to K_{3,3}.\n", Result==OK ? "no" : "a"); break;
 		case '4' : sprintf(Line, "has %s subgraph homeomorphic to K_4.\n", Result==OK ? "no" : "a"); break;
+		case '5' : sprintf(Line, "%s.\n", Result==OK ? "has no subgraph homeomorphic to K_5" :
+		                   gp_FoundK5Homeomorph(theGraph) ? "has a subgraph homeomorphic to K_5" :
+		                   "is not planar, but no subgraph homeomorphic to K_5 was found"); break;
+		case 'c' : sprintf(Line, "%s on the projective plane.\n", Result==OK ? "embeds" : "does not embed"); break;
+		case 't' : sprintf(Line, "%s on the torus.\n", Result==OK ? "embeds" : "does not embed"); break;
 		default  : sprintf(Line, "has not been processed due to unrecognized command.\n"); break;
 	}
 	Message(Line);
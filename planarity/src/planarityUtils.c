@@ -17,6 +17,16 @@ char Mode='r',
      AdjListsForEmbeddingsOut='n',
      quietMode='n';
 
+// Set by the -seed command-line option to make random graph generation reproducible
+int  randomSeedGiven = FALSE;
+unsigned long long randomSeed = 0;
+
+// Set by the -threads command-line option for random graph generation (-r)
+int  numThreads = 1;
+
+// Created by the -cache command-line option to reuse results for repeated graphs
+resultCacheP theResultCache = NULL;
+
 void Reconfigure()
 {
      fflush(stdin);
@@ -52,6 +62,19 @@ void Reconfigure()
      FlushConsole(stdout);
 }
 
+/****************************************************************************
+ GetRandomSeed()
+ Returns the seed given by the -seed option, or a seed based on "now"
+ ****************************************************************************/
+
+unsigned long long GetRandomSeed()
+{
+	if (randomSeedGiven)
+		return randomSeed;
+
+	return ((unsigned long long) time(NULL) << 20) ^ (unsigned long long) clock();
+}
+
 /****************************************************************************
  MESSAGE - prints a string, but when debugging adds \n and flushes stdout
  ****************************************************************************/
@@ -363,6 +386,9 @@ int GetEmbedFlags(char command)
 		case '2' : embedFlags = EMBEDFLAGS_SEARCHFORK23; break;
 		case '3' : embedFlags = EMBEDFLAGS_SEARCHFORK33; break;
 		case '4' : embedFlags = EMBEDFLAGS_SEARCHFORK4; break;
+		case '5' : embedFlags = EMBEDFLAGS_SEARCHFORK5; break;
+		case 'c' : embedFlags = EMBEDFLAGS_PROJECTIVEPLANAR; break;
+		case 't' : embedFlags = EMBEDFLAGS_TOROIDAL; break;
 	}
 
 	return embedFlags;
@@ -383,6 +409,9 @@ char *GetAlgorithmName(char command)
 		case '2' : algorithmName = K23SEARCH_NAME; break;
 		case '3' : algorithmName = K33SEARCH_NAME; break;
 		case '4' : algorithmName = K4SEARCH_NAME; break;
+		case '5' : algorithmName = K5SEARCH_NAME; break;
+		case 'c' : algorithmName = SURFACEEMBED_NAME; break;
+		case 't' : algorithmName = SURFACEEMBED_NAME; break;
 	}
 
 	return algorithmName;
@@ -399,6 +428,9 @@ void AttachAlgorithm(graphP theGraph, char command)
 		case '2' : gp_AttachK23Search(theGraph); break;
 		case '3' : gp_AttachK33Search(theGraph); break;
 		case '4' : gp_AttachK4Search(theGraph); break;
+		case '5' : gp_AttachK5Search(theGraph); break;
+		case 'c' : gp_AttachSurfaceEmbed(theGraph); break;
+		case 't' : gp_AttachSurfaceEmbed(theGraph); break;
 	}
 }
 
@@ -504,3 +536,27 @@ char *ConstructPrimaryOutputFilename(char *infileName, char *outfileName, char c
 
 	return theFileName;
 }
+
+/****************************************************************************
+ WriteLatencySummary()
+ Reports the distribution of per-graph latencies collected in theHist,
+ in microseconds.  If pSummary is not NULL, it also receives the summary.
+ ****************************************************************************/
+
+void WriteLatencySummary(latencyHistogramP theHist, latencySummaryP pSummary)
+{
+	latencySummary theSummary;
+
+	lh_GetSummary(theHist, &theSummary);
+	if (pSummary != NULL)
+		*pSummary = theSummary;
+
+	if (theSummary.numSamples == 0)
+		return;
+
+	sprintf(Line, "Per-graph latency (us): p50=%.3lf p90=%.3lf p99=%.3lf max=%.3lf (mean=%.3lf, n=%llu)\n",
+			theSummary.p50Ns / 1000.0, theSummary.p90Ns / 1000.0,
+			theSummary.p99Ns / 1000.0, theSummary.maxNs / 1000.0,
+			theSummary.meanNs / 1000.0, theSummary.numSamples);
+	Message(Line);
+}
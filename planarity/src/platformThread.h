@@ -0,0 +1,87 @@
+#ifndef PLATFORM_THREAD
+#define PLATFORM_THREAD
+
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+// Minimal threading primitives for the planarity application.
+// The graph library itself does not create threads; separate graphs can be
+// processed concurrently provided that each graph is used by one thread at
+// a time.  The library uses the atomic and thread-local macros below so that
+// it has no unsynchronized global state, e.g. extension IDs are assigned
+// atomically when an extension is first attached.
+
+#ifdef WIN32
+
+#include <windows.h>
+
+typedef HANDLE platform_thread;
+typedef CRITICAL_SECTION platform_mutex;
+typedef CONDITION_VARIABLE platform_cond;
+
+#define platform_ThreadResult DWORD WINAPI
+#define platform_ThreadReturnValue 0
+
+#define platform_CreateThread(thread, function, arg) \
+		((thread = CreateThread(NULL, 0, function, arg, 0, NULL)) != NULL ? OK : NOTOK)
+#define platform_JoinThread(thread) (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+
+#define platform_MutexInit(mutex) InitializeCriticalSection(&(mutex))
+#define platform_MutexDestroy(mutex) DeleteCriticalSection(&(mutex))
+#define platform_MutexLock(mutex) EnterCriticalSection(&(mutex))
+#define platform_MutexUnlock(mutex) LeaveCriticalSection(&(mutex))
+
+#define platform_ThreadLocal __declspec(thread)
+
+#define platform_CondInit(cond) InitializeConditionVariable(&(cond))
+#define platform_CondDestroy(cond)
+#define platform_CondWait(cond, mutex) SleepConditionVariableCS(&(cond), &(mutex), INFINITE)
+#define platform_CondBroadcast(cond) WakeAllConditionVariable(&(cond))
+
+#define platform_AtomicRead(pValue) InterlockedCompareExchange((LONG volatile *) (pValue), 0, 0)
+#define platform_AtomicIncrement(pValue) InterlockedIncrement((LONG volatile *) (pValue))
+#define platform_AtomicCompareAndSwap(pValue, oldValue, newValue) \
+		(InterlockedCompareExchange((LONG volatile *) (pValue), newValue, oldValue) == (oldValue))
+#define platform_AtomicCompareAndSwapPointer(pPointer, oldPointer, newPointer) \
+		(InterlockedCompareExchangePointer((PVOID volatile *) (pPointer), newPointer, oldPointer) == (oldPointer))
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_t platform_thread;
+typedef pthread_mutex_t platform_mutex;
+typedef pthread_cond_t platform_cond;
+
+#define platform_ThreadResult void *
+#define platform_ThreadReturnValue NULL
+
+#define platform_CreateThread(thread, function, arg) \
+		(pthread_create(&(thread), NULL, function, arg) == 0 ? OK : NOTOK)
+#define platform_JoinThread(thread) pthread_join(thread, NULL)
+
+#define platform_MutexInit(mutex) pthread_mutex_init(&(mutex), NULL)
+#define platform_MutexDestroy(mutex) pthread_mutex_destroy(&(mutex))
+#define platform_MutexLock(mutex) pthread_mutex_lock(&(mutex))
+#define platform_MutexUnlock(mutex) pthread_mutex_unlock(&(mutex))
+
+#define platform_ThreadLocal __thread
+
+#define platform_CondInit(cond) pthread_cond_init(&(cond), NULL)
+#define platform_CondDestroy(cond) pthread_cond_destroy(&(cond))
+#define platform_CondWait(cond, mutex) pthread_cond_wait(&(cond), &(mutex))
+#define platform_CondBroadcast(cond) pthread_cond_broadcast(&(cond))
+
+#define platform_AtomicRead(pValue) __sync_add_and_fetch(pValue, 0)
+#define platform_AtomicIncrement(pValue) __sync_add_and_fetch(pValue, 1)
+#define platform_AtomicCompareAndSwap(pValue, oldValue, newValue) \
+		__sync_bool_compare_and_swap(pValue, oldValue, newValue)
+#define platform_AtomicCompareAndSwapPointer(pPointer, oldPointer, newPointer) \
+		__sync_bool_compare_and_swap(pPointer, oldPointer, newPointer)
+
+#endif
+
+#endif
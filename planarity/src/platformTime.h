@@ -12,42 +12,44 @@ See the LICENSE.TXT file for licensing information.
 #include <windows.h>
 #include <winbase.h>
 
-#define platform_time DWORD
-#define platform_GetTime(timeVar) (timeVar = GetTickCount())
-#define platform_GetDuration(startTime, endTime) ((double) (endTime-startTime) / 1000.0)
+// QueryPerformanceCounter() is monotonic and has sub-microsecond resolution,
+// unlike GetTickCount(), which only ticks every 10-16 milliseconds
+
+typedef LARGE_INTEGER platform_time;
+
+#define platform_GetTime(timeVar) QueryPerformanceCounter(&(timeVar))
+
+static __inline long long platform_GetDurationNs(platform_time startTime, platform_time endTime)
+{
+	LARGE_INTEGER freq;
+	long long ticks = endTime.QuadPart - startTime.QuadPart;
+	QueryPerformanceFrequency(&freq);
+	return (ticks / freq.QuadPart) * 1000000000LL +
+	       ((ticks % freq.QuadPart) * 1000000000LL) / freq.QuadPart;
+}
 
 #else
 
 #include <time.h>
 
-typedef struct {
-	clock_t hiresTime;
-	time_t lowresTime;
-} platform_time;
+// CLOCK_MONOTONIC gives wall-clock nanosecond timing that is not affected by
+// adjustments to the system time. The former clock() measure was processor
+// time with a resolution of only 1-10 milliseconds on many systems, which made
+// it useless for timing the embedding of a single graph.
 
-#define platform_GetTime(timeVar) (timeVar.hiresTime = clock(), timeVar.lowresTime = time(NULL))
+typedef struct timespec platform_time;
 
-// Many flavors of Unix have CLOCKS_PER_SEC at 1 million, and clock_t as a 4 byte long integer
-// which means that the clock() construct has a resolution of only about 2000 seconds
-// If we're getting a duration longer than that, then we fall back to the coarser time() measure
+#define platform_GetTime(timeVar) clock_gettime(CLOCK_MONOTONIC, &(timeVar))
 
-#define platform_GetDuration(startTime, endTime) ( \
-		( (double) (endTime.lowresTime - startTime.lowresTime) ) > 2000 ? \
-		( (double) (endTime.lowresTime - startTime.lowresTime) ) : \
-		( (double) (endTime.hiresTime - startTime.hiresTime)) / CLOCKS_PER_SEC)
+#define platform_GetDurationNs(startTime, endTime) ( \
+		((long long) ((endTime).tv_sec - (startTime).tv_sec)) * 1000000000LL + \
+		((long long) ((endTime).tv_nsec - (startTime).tv_nsec)) )
 
-/*
-#define platform_time clock_t
-#define platform_GetTime() clock()
-#define platform_GetDuration(startTime, endTime) (((double) (endTime - startTime)) / CLOCKS_PER_SEC)
-*/
+#endif
 
-/*
-#define platform_time time_t
-#define platform_GetTime() time((time_t *)NULL)
-#define platform_GetDuration(startTime, endTime) ((double) (endTime - startTime))
-*/
+// Duration in seconds, as used in the timing reports of the planarity application
 
-#endif
+#define platform_GetDuration(startTime, endTime) \
+		((double) platform_GetDurationNs(startTime, endTime) / 1000000000.0)
 
 #endif
@@ -0,0 +1,141 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include "appconst.h"
+#include "prng.h"
+#include <stdlib.h>
+
+#define _prng_Rotl(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+/****************************************************************************
+ prng_New()
+ Allocates a generator and seeds it with the given seed.
+ ****************************************************************************/
+
+prngP prng_New(unsigned long long seed)
+{
+prngP theRNG = (prngP) malloc(sizeof(prngState));
+
+     if (theRNG != NULL)
+         prng_Seed(theRNG, seed);
+
+     return theRNG;
+}
+
+/****************************************************************************
+ prng_Free()
+ ****************************************************************************/
+
+void prng_Free(prngP *pRNG)
+{
+     if (pRNG == NULL || *pRNG == NULL) return;
+
+     free(*pRNG);
+     *pRNG = NULL;
+}
+
+/****************************************************************************
+ prng_Seed()
+ Expands the 64-bit seed into the 256-bit state using splitmix64, which
+ guarantees a nonzero state and well-mixed bits even for small seeds.
+ ****************************************************************************/
+
+void prng_Seed(prngP theRNG, unsigned long long seed)
+{
+unsigned long long z;
+int  I;
+
+     for (I = 0; I < 4; I++)
+     {
+          seed += 0x9E3779B97F4A7C15ULL;
+          z = seed;
+          z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+          z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+          theRNG->s[I] = z ^ (z >> 31);
+     }
+}
+
+/****************************************************************************
+ prng_Next()
+ Returns the next 64 pseudo-random bits.
+ ****************************************************************************/
+
+unsigned long long prng_Next(prngP theRNG)
+{
+unsigned long long *s = theRNG->s;
+unsigned long long result = _prng_Rotl(s[1] * 5, 7) * 9;
+unsigned long long t = s[1] << 17;
+
+     s[2] ^= s[0];
+     s[3] ^= s[1];
+     s[1] ^= s[2];
+     s[0] ^= s[3];
+
+     s[2] ^= t;
+     s[3] = _prng_Rotl(s[3], 45);
+
+     return result;
+}
+
+/****************************************************************************
+ prng_Jump()
+ Advances the generator by 2^128 steps.  Starting from one seed, calling
+ prng_Jump() once per additional stream gives non-overlapping streams for
+ parallel workers.
+ ****************************************************************************/
+
+void prng_Jump(prngP theRNG)
+{
+static const unsigned long long JUMP[] = {
+     0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+     0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+};
+unsigned long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+int  I, b;
+
+     for (I = 0; I < 4; I++)
+     {
+          for (b = 0; b < 64; b++)
+          {
+               if (JUMP[I] & (1ULL << b))
+               {
+                   s0 ^= theRNG->s[0];
+                   s1 ^= theRNG->s[1];
+                   s2 ^= theRNG->s[2];
+                   s3 ^= theRNG->s[3];
+               }
+               prng_Next(theRNG);
+          }
+     }
+
+     theRNG->s[0] = s0;
+     theRNG->s[1] = s1;
+     theRNG->s[2] = s2;
+     theRNG->s[3] = s3;
+}
+
+/****************************************************************************
+ prng_GetRandomNumber()
+ Returns a uniformly distributed number between NMin and NMax inclusive.
+ Values of the 64-bit output that would bias the result toward the low end
+ of the range are rejected, so the result has no modulo bias.
+ ****************************************************************************/
+
+int  prng_GetRandomNumber(prngP theRNG, int NMin, int NMax)
+{
+unsigned long long range, limit, r;
+
+     if (NMax <= NMin) return NMin;
+
+     range = (unsigned long long) ((long long) NMax - (long long) NMin) + 1;
+     limit = ~0ULL - (~0ULL % range);
+
+     do {
+         r = prng_Next(theRNG);
+     } while (r >= limit);
+
+     return NMin + (int) (r % range);
+}
@@ -0,0 +1,41 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#ifndef PRNG_H
+#define PRNG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A pseudo-random number generator with explicit state (xoshiro256**).
+// Each generator is independent of the C library rand() and of every other
+// generator, so random graph generation is reproducible from a seed and
+// can proceed in several threads at once, each with its own generator.
+// The state can be allocated with prng_New() or declared as a local
+// variable and initialized with prng_Seed().
+
+typedef struct
+{
+        unsigned long long s[4];
+} prngState;
+
+typedef prngState * prngP;
+
+prngP prng_New(unsigned long long seed);
+void prng_Free(prngP *);
+
+void prng_Seed(prngP theRNG, unsigned long long seed);
+void prng_Jump(prngP theRNG);
+
+unsigned long long prng_Next(prngP theRNG);
+int  prng_GetRandomNumber(prngP theRNG, int NMin, int NMax);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PRNG_H */
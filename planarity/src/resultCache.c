@@ -0,0 +1,552 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "appconst.h"
+#include "resultCache.h"
+
+struct resultCacheEntryStruct
+{
+        resultCacheKeyP key;
+        int result;
+
+        // Rotation system of the certificate graph, or NULL if not stored
+        int *certOffsets, *certNeighbors;
+
+        // Next entry in the same hash bucket, and neighbors in LRU order
+        resultCacheEntryP hashNext, moreRecent, lessRecent;
+};
+
+static unsigned long long _rc_Mix(unsigned long long z);
+static int  _rc_EnsureScratch(resultCacheP theCache, int size);
+static int  _rc_KeysEqual(resultCacheP theCache, resultCacheKeyP a, resultCacheKeyP b);
+static resultCacheEntryP _rc_Find(resultCacheP theCache, resultCacheKeyP theKey);
+static void _rc_Unlink(resultCacheP theCache, resultCacheEntryP theEntry);
+static void _rc_PushFront(resultCacheP theCache, resultCacheEntryP theEntry);
+static void _rc_Evict(resultCacheP theCache, resultCacheEntryP theEntry);
+static void _rc_FreeCertificate(resultCacheEntryP theEntry);
+static int  _rc_StoreCertificate(resultCacheEntryP theEntry, graphP certificate);
+static int  _rc_RestoreCertificate(resultCacheP theCache, resultCacheEntryP theEntry, graphP certificate);
+
+/****************************************************************************
+ rc_New()
+ Creates an empty cache that holds at most capacity results.
+ ****************************************************************************/
+
+resultCacheP rc_New(int capacity)
+{
+resultCacheP theCache;
+int numBuckets = 1;
+
+     if (capacity < 0)
+         return NULL;
+
+     while (numBuckets < 2 * capacity)
+         numBuckets <<= 1;
+
+     if ((theCache = (resultCacheP) calloc(1, sizeof(resultCache))) == NULL)
+         return NULL;
+
+     theCache->buckets = (resultCacheEntryP *) calloc(numBuckets, sizeof(resultCacheEntryP));
+     if (theCache->buckets == NULL)
+     {
+         free(theCache);
+         return NULL;
+     }
+
+     theCache->capacity = capacity;
+     theCache->hashMask = numBuckets - 1;
+
+     return theCache;
+}
+
+/****************************************************************************
+ rc_Free()
+ ****************************************************************************/
+
+void rc_Free(resultCacheP *pCache)
+{
+     if (pCache == NULL || *pCache == NULL) return;
+
+     while ((*pCache)->leastRecent != NULL)
+         _rc_Evict(*pCache, (*pCache)->leastRecent);
+
+     free((*pCache)->buckets);
+     free((*pCache)->scratch);
+     free(*pCache);
+     *pCache = NULL;
+}
+
+/****************************************************************************
+ rc_NewKey()
+ Creates the cache key for the current edge set of theGraph and the given
+ embedFlags.  The key records, for each zero-based vertex u, the neighbors
+ v >= u in compressed sparse row form, which is all that is needed to
+ compare edge sets exactly.  Make the key before calling gp_Embed(), which
+ changes the graph.
+
+ Returns NULL if memory could not be allocated.
+ ****************************************************************************/
+
+resultCacheKeyP rc_NewKey(graphP theGraph, int embedFlags)
+{
+resultCacheKeyP theKey;
+unsigned long long u, w, hash = 0;
+int  v, e, first, numArcs = 0;
+
+     if (theGraph == NULL)
+         return NULL;
+
+     if ((theKey = (resultCacheKeyP) calloc(1, sizeof(resultCacheKey))) == NULL)
+         return NULL;
+
+     first = gp_GetFirstVertex(theGraph);
+     for (v = first; gp_VertexInRange(theGraph, v); v++)
+     {
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              if (gp_GetNeighbor(theGraph, e) >= v)
+                  numArcs++;
+              e = gp_GetNextArc(theGraph, e);
+          }
+     }
+
+     theKey->embedFlags = embedFlags;
+     theKey->N = theGraph->N;
+     theKey->numArcs = numArcs;
+     theKey->offsets = (int *) malloc((theGraph->N + 1) * sizeof(int));
+     theKey->neighbors = (int *) malloc((numArcs > 0 ? numArcs : 1) * sizeof(int));
+     if (theKey->offsets == NULL || theKey->neighbors == NULL)
+     {
+         rc_FreeKey(&theKey);
+         return NULL;
+     }
+
+     // The hash is a sum over the edges, so it is independent of edge order
+     numArcs = 0;
+     for (v = first; gp_VertexInRange(theGraph, v); v++)
+     {
+          theKey->offsets[v - first] = numArcs;
+
+          e = gp_GetFirstArc(theGraph, v);
+          while (gp_IsArc(e))
+          {
+              if (gp_GetNeighbor(theGraph, e) >= v)
+              {
+                  u = (unsigned long long) (v - first);
+                  w = (unsigned long long) (gp_GetNeighbor(theGraph, e) - first);
+                  hash += _rc_Mix((u << 32) | w);
+                  theKey->neighbors[numArcs++] = (int) w;
+              }
+              e = gp_GetNextArc(theGraph, e);
+          }
+     }
+     theKey->offsets[theGraph->N] = numArcs;
+
+     theKey->hash = hash ^ _rc_Mix(((unsigned long long) theGraph->N << 32) | (unsigned) embedFlags);
+
+     return theKey;
+}
+
+/****************************************************************************
+ rc_FreeKey()
+ ****************************************************************************/
+
+void rc_FreeKey(resultCacheKeyP *pKey)
+{
+     if (pKey == NULL || *pKey == NULL) return;
+
+     free((*pKey)->offsets);
+     free((*pKey)->neighbors);
+     free(*pKey);
+     *pKey = NULL;
+}
+
+/****************************************************************************
+ rc_Lookup()
+ Looks for a stored result for theKey.  On a hit, the result of gp_Embed()
+ is returned in pResult, and the entry becomes the most recently used.
+ If certificate is not NULL, a hit also requires a stored certificate,
+ which is restored into the certificate graph.  That graph must have the
+ same number of vertices as the key; its edges are replaced by those of
+ the stored embedding or obstruction, in the same adjacency list order.
+
+ Returns OK on a hit and NOTOK on a miss, which leaves the certificate
+ graph unchanged.
+ ****************************************************************************/
+
+int  rc_Lookup(resultCacheP theCache, resultCacheKeyP theKey, int *pResult, graphP certificate)
+{
+resultCacheEntryP theEntry;
+
+     if (theCache == NULL || theKey == NULL || pResult == NULL)
+         return NOTOK;
+
+     theEntry = _rc_Find(theCache, theKey);
+
+     if (theEntry == NULL ||
+         (certificate != NULL && theEntry->certOffsets == NULL) ||
+         (certificate != NULL && _rc_RestoreCertificate(theCache, theEntry, certificate) != OK))
+     {
+         theCache->misses++;
+         return NOTOK;
+     }
+
+     _rc_Unlink(theCache, theEntry);
+     _rc_PushFront(theCache, theEntry);
+
+     *pResult = theEntry->result;
+     theCache->hits++;
+     return OK;
+}
+
+/****************************************************************************
+ rc_Store()
+ Stores the result of gp_Embed() for the key in *pKey.  The cache takes
+ ownership of the key and sets *pKey to NULL.  If certificate is not NULL,
+ the rotation system of the certificate graph (the embedding or obstruction
+ produced by gp_Embed(), after gp_SortVertices()) is stored as well.
+ The least recently used entry is dropped if the cache is full.
+
+ Returns OK, or NOTOK on error, in which case the key is freed.
+ ****************************************************************************/
+
+int  rc_Store(resultCacheP theCache, resultCacheKeyP *pKey, int result, graphP certificate)
+{
+resultCacheEntryP theEntry;
+int  bucket;
+
+     if (theCache == NULL || pKey == NULL || *pKey == NULL)
+         return NOTOK;
+
+     if (theCache->capacity == 0)
+     {
+         rc_FreeKey(pKey);
+         return OK;
+     }
+
+     // If the result is already cached, just update it
+     if ((theEntry = _rc_Find(theCache, *pKey)) != NULL)
+     {
+         rc_FreeKey(pKey);
+         _rc_Unlink(theCache, theEntry);
+         _rc_PushFront(theCache, theEntry);
+         theEntry->result = result;
+         if (certificate != NULL)
+         {
+             _rc_FreeCertificate(theEntry);
+             return _rc_StoreCertificate(theEntry, certificate);
+         }
+         return OK;
+     }
+
+     if ((theEntry = (resultCacheEntryP) calloc(1, sizeof(resultCacheEntry))) == NULL)
+     {
+         rc_FreeKey(pKey);
+         return NOTOK;
+     }
+
+     theEntry->key = *pKey;
+     theEntry->result = result;
+     *pKey = NULL;
+
+     if (certificate != NULL && _rc_StoreCertificate(theEntry, certificate) != OK)
+     {
+         rc_FreeKey(&theEntry->key);
+         free(theEntry);
+         return NOTOK;
+     }
+
+     bucket = (int) (theEntry->key->hash & theCache->hashMask);
+     theEntry->hashNext = theCache->buckets[bucket];
+     theCache->buckets[bucket] = theEntry;
+     _rc_PushFront(theCache, theEntry);
+     theCache->size++;
+
+     if (theCache->size > theCache->capacity)
+         _rc_Evict(theCache, theCache->leastRecent);
+
+     return OK;
+}
+
+/****************************************************************************
+ _rc_Mix()
+ The splitmix64 finalizer, which spreads every input bit over the output.
+ ****************************************************************************/
+
+static unsigned long long _rc_Mix(unsigned long long z)
+{
+     z += 0x9E3779B97F4A7C15ULL;
+     z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+     z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+     return z ^ (z >> 31);
+}
+
+/****************************************************************************
+ _rc_EnsureScratch()
+ The scratch array is kept all zero between uses.
+ ****************************************************************************/
+
+static int  _rc_EnsureScratch(resultCacheP theCache, int size)
+{
+int *newScratch;
+
+     if (size <= theCache->scratchSize)
+         return OK;
+
+     if ((newScratch = (int *) calloc(size, sizeof(int))) == NULL)
+         return NOTOK;
+
+     free(theCache->scratch);
+     theCache->scratch = newScratch;
+     theCache->scratchSize = size;
+     return OK;
+}
+
+/****************************************************************************
+ _rc_KeysEqual()
+ Compares the edge sets of two keys that have the same hash.  The offsets
+ must match exactly; the neighbor lists of each vertex are compared as
+ multisets, by counting in the scratch array, since they need not be in
+ the same order.
+ ****************************************************************************/
+
+static int  _rc_KeysEqual(resultCacheP theCache, resultCacheKeyP a, resultCacheKeyP b)
+{
+int  u, k, equal = TRUE;
+int *count;
+
+     if (a->hash != b->hash || a->embedFlags != b->embedFlags ||
+         a->N != b->N || a->numArcs != b->numArcs)
+         return FALSE;
+
+     if (memcmp(a->offsets, b->offsets, (a->N + 1) * sizeof(int)) != 0)
+         return FALSE;
+
+     if (_rc_EnsureScratch(theCache, a->N) != OK)
+         return FALSE;
+
+     count = theCache->scratch;
+     for (u = 0; u < a->N && equal; u++)
+     {
+          for (k = a->offsets[u]; k < a->offsets[u+1]; k++)
+               count[a->neighbors[k]]++;
+
+          for (k = b->offsets[u]; k < b->offsets[u+1]; k++)
+               if (--count[b->neighbors[k]] < 0)
+                   equal = FALSE;
+
+          for (k = a->offsets[u]; k < a->offsets[u+1]; k++)
+               count[a->neighbors[k]] = 0;
+          for (k = b->offsets[u]; k < b->offsets[u+1]; k++)
+               count[b->neighbors[k]] = 0;
+     }
+
+     return equal;
+}
+
+/****************************************************************************
+ _rc_Find()
+ ****************************************************************************/
+
+static resultCacheEntryP _rc_Find(resultCacheP theCache, resultCacheKeyP theKey)
+{
+resultCacheEntryP theEntry = theCache->buckets[theKey->hash & theCache->hashMask];
+
+     while (theEntry != NULL && !_rc_KeysEqual(theCache, theEntry->key, theKey))
+         theEntry = theEntry->hashNext;
+
+     return theEntry;
+}
+
+/****************************************************************************
+ _rc_Unlink()
+ Removes the entry from the LRU list, but not from its hash bucket.
+ ****************************************************************************/
+
+static void _rc_Unlink(resultCacheP theCache, resultCacheEntryP theEntry)
+{
+     if (theEntry->moreRecent != NULL)
+         theEntry->moreRecent->lessRecent = theEntry->lessRecent;
+     else
+         theCache->mostRecent = theEntry->lessRecent;
+
+     if (theEntry->lessRecent != NULL)
+         theEntry->lessRecent->moreRecent = theEntry->moreRecent;
+     else
+         theCache->leastRecent = theEntry->moreRecent;
+
+     theEntry->moreRecent = theEntry->lessRecent = NULL;
+}
+
+/****************************************************************************
+ _rc_PushFront()
+ Makes the entry the most recently used.
+ ****************************************************************************/
+
+static void _rc_PushFront(resultCacheP theCache, resultCacheEntryP theEntry)
+{
+     theEntry->moreRecent = NULL;
+     theEntry->lessRecent = theCache->mostRecent;
+
+     if (theCache->mostRecent != NULL)
+         theCache->mostRecent->moreRecent = theEntry;
+     else
+         theCache->leastRecent = theEntry;
+
+     theCache->mostRecent = theEntry;
+}
+
+/****************************************************************************
+ _rc_Evict()
+ Removes the entry from the cache and frees it.
+ ****************************************************************************/
+
+static void _rc_Evict(resultCacheP theCache, resultCacheEntryP theEntry)
+{
+resultCacheEntryP *pLink = &theCache->buckets[theEntry->key->hash & theCache->hashMask];
+
+     while (*pLink != theEntry)
+         pLink = &(*pLink)->hashNext;
+     *pLink = theEntry->hashNext;
+
+     _rc_Unlink(theCache, theEntry);
+     theCache->size--;
+
+     _rc_FreeCertificate(theEntry);
+     rc_FreeKey(&theEntry->key);
+     free(theEntry);
+}
+
+/****************************************************************************
+ _rc_FreeCertificate()
+ ****************************************************************************/
+
+static void _rc_FreeCertificate(resultCacheEntryP theEntry)
+{
+     free(theEntry->certOffsets);
+     free(theEntry->certNeighbors);
+     theEntry->certOffsets = theEntry->certNeighbors = NULL;
+}
+
+/****************************************************************************
+ _rc_StoreCertificate()
+ ****************************************************************************/
+
+static int  _rc_StoreCertificate(resultCacheEntryP theEntry, graphP certificate)
+{
+     if (certificate->N != theEntry->key->N)
+         return NOTOK;
+
+     theEntry->certOffsets = (int *) malloc((certificate->N + 1) * sizeof(int));
+     theEntry->certNeighbors = (int *) malloc((certificate->M > 0 ? 2 * certificate->M : 1) * sizeof(int));
+
+     if (theEntry->certOffsets == NULL || theEntry->certNeighbors == NULL ||
+         gp_GetRotationSystem(certificate, theEntry->certOffsets, theEntry->certNeighbors) < 0)
+     {
+         _rc_FreeCertificate(theEntry);
+         return NOTOK;
+     }
+
+     return OK;
+}
+
+/****************************************************************************
+ _rc_RestoreCertificate()
+ Replaces the edges of the certificate graph with the stored ones.  The
+ edges are first added in any order, then the arcs of each vertex are
+ relinked in the stored rotation order.  Arcs to the same neighbor are
+ interchangeable, so the arcs of a vertex are pushed onto per-neighbor
+ stacks (heads in the scratch array, links in arcNext) and popped in
+ rotation order.  The embedFlags and FLAGS_OBSTRUCTIONFOUND are then set
+ as gp_Embed() sets them.
+
+ Returns NOTOK without changing the certificate if it lacks the vertices
+ or the arc capacity for the stored edges, or if memory runs out.
+ ****************************************************************************/
+
+static int  _rc_RestoreCertificate(resultCacheP theCache, resultCacheEntryP theEntry, graphP certificate)
+{
+int  N = theEntry->key->N;
+int *offsets = theEntry->certOffsets, *neighbors = theEntry->certNeighbors;
+int *arcHead, *arcNext;
+int  u, w, k, e, eNext, first, numLoopArcs, Result = OK;
+
+     // Check everything that can fail before changing the graph, so that a
+     // miss leaves it intact.  The stored arcs come from a rotation system,
+     // so each arc (u, w) has a twin (w, u) and the relinking cannot fail.
+     if (certificate->N != N || offsets[N] > certificate->arcCapacity ||
+         _rc_EnsureScratch(theCache, N) != OK)
+         return NOTOK;
+
+     if ((arcNext = (int *) malloc(gp_EdgeIndexBound(certificate) * sizeof(int))) == NULL)
+         return NOTOK;
+
+     gp_ReinitializeGraph(certificate);
+     first = gp_GetFirstVertex(certificate);
+
+     // Add each edge once, from its lesser endpoint; a loop appears twice
+     for (u = 0; u < N; u++)
+     {
+          numLoopArcs = 0;
+          for (k = offsets[u]; k < offsets[u+1]; k++)
+          {
+               w = neighbors[k];
+               if (w > u || (w == u && numLoopArcs++ % 2 == 0))
+               {
+                   if (gp_AddEdge(certificate, u + first, 0, w + first, 0) != OK)
+                   {
+                       free(arcNext);
+                       return NOTOK;
+                   }
+               }
+          }
+     }
+
+     arcHead = theCache->scratch;
+     for (u = 0; u < N && Result == OK; u++)
+     {
+          e = gp_GetFirstArc(certificate, u + first);
+          while (gp_IsArc(e))
+          {
+              eNext = gp_GetNextArc(certificate, e);
+              w = gp_GetNeighbor(certificate, e) - first;
+              arcNext[e] = arcHead[w];
+              arcHead[w] = e;
+              e = eNext;
+          }
+
+          gp_SetFirstArc(certificate, u + first, NIL);
+          gp_SetLastArc(certificate, u + first, NIL);
+
+          for (k = offsets[u]; k < offsets[u+1]; k++)
+          {
+               w = neighbors[k];
+               if ((e = arcHead[w]) == NIL)
+               {
+                   Result = NOTOK;
+                   break;
+               }
+               arcHead[w] = arcNext[e];
+               gp_AttachArc(certificate, u + first, NIL, 1, e);
+          }
+
+          for (k = offsets[u]; k < offsets[u+1]; k++)
+               arcHead[neighbors[k]] = NIL;
+     }
+
+     free(arcNext);
+
+     // Mark the graph as gp_Embed() would have
+     certificate->embedFlags = theEntry->key->embedFlags;
+     if (theEntry->result == NONEMBEDDABLE)
+         certificate->internalFlags |= FLAGS_OBSTRUCTIONFOUND;
+
+     return Result;
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 1997-2022, John M. Boyer
+All rights reserved.
+See the LICENSE.TXT file for licensing information.
+*/
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A bounded, least recently used cache of gp_Embed() results.
+// Entries are keyed by the edge set of the input graph and the embedFlags.
+// The key hash is a sum of per-edge hashes, so it does not depend on the
+// order in which edges were added or on the direction of each edge, and a
+// hash match is confirmed by an exact comparison of the edge sets in time
+// linear in the size of the graph.
+// Optionally, an entry also stores the resulting embedding or obstruction
+// (the certificate) so that it can be restored into a graph on a hit.
+// A cache is not internally synchronized; callers that share one between
+// threads must serialize access to it.
+
+typedef struct
+{
+        unsigned long long hash;
+        int embedFlags, N, numArcs;
+        int *offsets, *neighbors;
+} resultCacheKey;
+
+typedef resultCacheKey * resultCacheKeyP;
+
+typedef struct resultCacheEntryStruct resultCacheEntry;
+typedef resultCacheEntry * resultCacheEntryP;
+
+typedef struct
+{
+        int capacity, size;
+        int hashMask;
+        resultCacheEntryP *buckets;
+        resultCacheEntryP mostRecent, leastRecent;
+        int *scratch, scratchSize;
+        unsigned long long hits, misses;
+} resultCache;
+
+typedef resultCache * resultCacheP;
+
+resultCacheP rc_New(int capacity);
+void rc_Free(resultCacheP *pCache);
+
+resultCacheKeyP rc_NewKey(graphP theGraph, int embedFlags);
+void rc_FreeKey(resultCacheKeyP *pKey);
+
+int  rc_Lookup(resultCacheP theCache, resultCacheKeyP theKey, int *pResult, graphP certificate);
+int  rc_Store(resultCacheP theCache, resultCacheKeyP *pKey, int result, graphP certificate);
+
+#define rc_GetHits(theCache) ((theCache)->hits)
+#define rc_GetMisses(theCache) ((theCache)->misses)
+#define rc_GetSize(theCache) ((theCache)->size)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESULTCACHE_H */
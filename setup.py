@@ -5,7 +5,11 @@ import setuptools
 from setuptools import setup
 
 from distutils.extension import Extension
+from distutils.ccompiler import new_compiler
+from distutils.errors import CompileError, LinkError
+from distutils.sysconfig import customize_compiler
 from glob import glob
+import tempfile
 
 try:
     from Cython.Build import cythonize
@@ -44,9 +48,43 @@ ext = '.pyx' if USE_CYTHON else '.c'
 sourcefiles = ['planarity/planarity'+ext]
 sourcefiles.extend(glob("planarity/src/*.c"))
 
+def has_library(header, library, call):
+    """Return True if a program calling call from header links with library."""
+    compiler = new_compiler()
+    customize_compiler(compiler)
+    with tempfile.TemporaryDirectory() as tmpdir:
+        source = os.path.join(tmpdir, 'check.c')
+        with open(source, 'w') as f:
+            f.write('#include <%s>\nint main(void) { %s; return 0; }\n'
+                    % (header, call))
+        try:
+            objects = compiler.compile([source], output_dir=tmpdir)
+            compiler.link_executable(objects, os.path.join(tmpdir, 'check'),
+                                     libraries=[library])
+        except (CompileError, LinkError):
+            return False
+    return True
+
+# Module state and heap types let the extension run in subinterpreters
+# with their own GIL
+define_macros = [('CYTHON_USE_MODULE_STATE', '1'),
+                 ('CYTHON_USE_TYPE_SPECS', '1')]
+libraries = []
+
+# Graph files named *.gz or *.zst are read and written compressed if
+# zlib or zstd is found
+if has_library('zlib.h', 'z', 'gzopen("", "rb")'):
+    define_macros.append(('PLANARITY_ZLIB', '1'))
+    libraries.append('z')
+if has_library('zstd.h', 'zstd', 'ZSTD_createDStream()'):
+    define_macros.append(('PLANARITY_ZSTD', '1'))
+    libraries.append('zstd')
+
 extensions = [Extension("planarity.planarity",
                         sourcefiles,
                         include_dirs=['planarity/src/'],
+                        define_macros=define_macros,
+                        libraries=libraries,
                         )]
 
 if USE_CYTHON:
@@ -69,6 +107,12 @@ setup(
     url = 'https://github.com/hagberg/planarity/',
     download_url='https://pypi.python.org/pypi/planarity',
     package_data = {'planarity':['tests/*.py']},
+    entry_points = {
+        'networkx.backends': [
+            'planarity = planarity.planarity_backend:backend_interface'],
+        'networkx.backend_info': [
+            'planarity = planarity.planarity_backend:get_info'],
+    },
     zip_safe = False
     )
 
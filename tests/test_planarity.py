@@ -1,6 +1,10 @@
+import collections
+import gzip
 import os
 import tempfile
 
+import pytest
+
 import planarity
 
 class TestPlanarity:
@@ -121,3 +125,378 @@ class TestPlanarity:
         answer = 'N=2\n1: 2 0\n2: 1 0\n'
         assert d == answer
         os.unlink(fname)
+
+    def test_write_gzip(self):
+        e = ([1,2],)
+        P = planarity.PGraph(e)
+        fname = tempfile.mktemp(suffix='.gz')
+        P.write(fname)
+        if not os.path.exists(fname):
+            pytest.skip('built without zlib')
+        d = gzip.open(fname, 'rt').read()
+        answer = 'N=2\n1: 2 0\n2: 1 0\n'
+        assert d == answer
+        os.unlink(fname)
+
+    def test_edge_array(self):
+        P = planarity.PGraph(self.p4_edgelist)
+        nodes = P.nodes()
+        a = P.edge_array()
+        assert len(a) == 3
+        assert [(nodes[u], nodes[v]) for u, v in a.tolist()] == P.edges()
+
+    def test_rotation_system(self):
+        edges = self.k5_edgelist[1:]
+        P = planarity.PGraph(edges)
+        assert P.is_planar() is True
+        nodes = P.nodes()
+        offsets, neighbors = P.rotation_system()
+        assert len(offsets) == 6
+        assert len(neighbors) == 18
+        for i, n in enumerate(nodes):
+            nbrs = [nodes[j] for j in neighbors[offsets[i]:offsets[i+1]]]
+            assert sorted(nbrs) == sorted([v for u, v in edges if u == n] +
+                                          [u for u, v in edges if v == n])
+
+    def test_faces(self):
+        edges = self.k5_edgelist[1:]
+        P = planarity.PGraph(edges)
+        f = P.faces()
+        offsets, neighbors = P.rotation_system()
+        # Euler's formula for a connected plane graph
+        assert len(f['face_sizes']) == 9 - 5 + 2
+        assert sum(f['face_sizes']) == 18
+        assert sorted(f['face_arcs']) == list(range(18))
+        tail = [u for u in range(5) for k in range(offsets[u], offsets[u+1])]
+        for face in range(len(f['face_sizes'])):
+            arcs = f['face_arcs'][f['face_offsets'][face]:f['face_offsets'][face+1]]
+            for a, b in zip(arcs, list(arcs[1:]) + [arcs[0]]):
+                assert f['arc_face'][a] == face
+                assert neighbors[a] == tail[b]
+        P = planarity.PGraph(self.k5_edgelist)
+        with pytest.raises(RuntimeError):
+            P.faces()
+
+    def test_dual(self):
+        P = planarity.PGraph(self.k5_edgelist[1:])
+        D, arc_dual_arc, dual_arc_arc = P.dual()
+        f = P.faces()
+        assert len(D.nodes()) == len(f['face_sizes'])
+        assert len(D.edges()) == 9
+        assert [dual_arc_arc[a] for a in arc_dual_arc] == list(range(18))
+        # the faces of the dual are the nodes of the graph
+        assert len(D.faces()['face_sizes']) == 5
+        offsets, neighbors = D.rotation_system()
+        for a in range(18):
+            d = arc_dual_arc[a]
+            assert offsets[f['arc_face'][a]] <= d < offsets[f['arc_face'][a]+1]
+        # a tree has one face, and its bridges are loops in the dual
+        D, arc_dual_arc, dual_arc_arc = planarity.PGraph(self.p4_edgelist).dual()
+        assert D.nodes() == [0]
+        assert len(D.rotation_system()[1]) == 2*len(self.p4_edgelist)
+
+    def test_separator(self):
+        n = 20
+        edges = [(i*n + j, i*n + j + 1) for i in range(n) for j in range(n-1)]
+        edges += [(i*n + j, (i+1)*n + j) for i in range(n-1) for j in range(n)]
+        P = planarity.PGraph(edges)
+        sides = dict(zip(P.nodes(), P.separator()))
+        assert sum(1 for s in sides.values() if s < 0) <= 2*n
+        assert all(sides[u] < 0 or sides[v] < 0 or sides[u] == sides[v]
+                   for u, v in edges)
+        for s in (0, 1):
+            assert 3*sum(1 for t in sides.values() if t == s) <= 2*n*n
+        parts = P.partition(4)
+        assert sorted(set(parts)) == [0, 1, 2, 3]
+        assert max(list(parts).count(p) for p in range(4)) <= n*n//2
+        for k in (3, 7):
+            counts = [list(P.partition(k)).count(p) for p in range(k)]
+            assert max(counts) - min(counts) <= 1
+        with pytest.raises(RuntimeError):
+            planarity.PGraph(self.k5_edgelist).separator()
+
+    def test_can_add_edges(self):
+        # K5 minus an edge is a triangulation, and node 5 is isolated
+        P = planarity.PGraph({0: [1, 2, 3, 4], 1: [2, 3, 4], 2: [3, 4],
+                              3: [], 4: [], 5: []})
+        addable, faces = P.can_add_edges([(3, 4), (0, 5), (1, 1)])
+        assert list(addable) == [False, True, False]
+        assert list(faces) == [-1, -1, -1]
+        P = planarity.PGraph([(0, 1), (1, 2), (2, 3), (3, 0)])
+        addable, faces = P.can_add_edges([(0, 2), (1, 3)])
+        assert list(addable) == [True, True]
+        f = P.faces()
+        assert all(0 <= face < len(f['face_sizes']) for face in faces)
+
+    def test_try_add_edge(self):
+        k5 = self.k5_edgelist
+        P = planarity.PGraph(k5[:-1])
+        assert P.try_add_edge(*k5[-1]) is False
+        assert len(P.edges()) == len(k5) - 1
+        P = planarity.PGraph([(0, 1), (1, 2), (2, 3), (3, 4), (4, 5)])
+        P.drawing_arrays()
+        c = P.checkpoint()
+        assert P.try_add_edge(5, 0)
+        assert P.try_add_edge(0, 3)
+        assert P.try_add_edge(1, 4)
+        assert P.try_add_edge(1, 4)
+        assert not P.try_add_edge(2, 5)
+        assert len(P.edges()) == 8
+        assert 6 - 8 + len(P.faces()['face_sizes']) == 2
+        assert len(P.drawing_arrays()['edge_pos']) == 8
+        P.rollback(c)
+        assert len(P.edges()) == 5
+        assert P.is_planar()
+        with pytest.raises(ValueError):
+            P.rollback(c + 1)
+
+    def test_maximal_planar_subgraph(self):
+        k33 = [(u, v) for u in 'abc' for v in 'xyz']
+        for edges in (self.k5_edgelist, k33):
+            P = planarity.PGraph(edges)
+            S, rejected = P.maximal_planar_subgraph()
+            assert len(rejected) == 1
+            assert S.is_planar()
+            assert sorted(S.nodes()) == sorted(P.nodes())
+            assert set(map(frozenset, S.edges() + rejected)) == \
+                set(map(frozenset, edges))
+            assert S.try_add_edge(*rejected[0]) is False
+            assert len(P.edges()) == len(edges)
+        # After the retry no rejected edge fits, so K9 keeps 3n-6 edges
+        k9 = [(u, v) for u in range(9) for v in range(u + 1, 9)]
+        S, rejected = planarity.PGraph(k9).maximal_planar_subgraph()
+        assert len(S.edges()) + len(rejected) == len(k9)
+        S, rejected = planarity.PGraph(k9).maximal_planar_subgraph(retry=True)
+        assert len(S.edges()) == 21 and len(rejected) == 15
+        circulant = [(u, (u + k) % 40) for k in (1, 5, 13) for u in range(40)]
+        S, rejected = planarity.PGraph(circulant).maximal_planar_subgraph(retry=True)
+        assert len(S.edges()) + len(rejected) == len(circulant)
+        for u, v in rejected:
+            assert S.try_add_edge(u, v) is False
+        P = planarity.PGraph(self.k5_edgelist)
+        assert P.is_planar() is False
+        with pytest.raises(RuntimeError):
+            P.maximal_planar_subgraph()
+
+    def test_k5_homeomorph_edges(self):
+        P = planarity.PGraph(self.k5_edgelist)
+        assert set(map(frozenset, P.k5_homeomorph_edges())) == \
+            set(map(frozenset, self.k5_edgelist))
+        assert len(P.edges()) == len(self.k5_edgelist)
+        # A K3,3 beside a K5 whose edges are subdivided
+        k33 = [(u, v) for u in 'abc' for v in 'xyz']
+        pairs = [(u, v) for u in range(5) for v in range(u + 1, 5)]
+        k5 = [(u, (u, v)) for u, v in pairs] + [((u, v), v) for u, v in pairs]
+        P = planarity.PGraph(k33 + k5)
+        assert set(map(frozenset, P.k5_homeomorph_edges())) == \
+            set(map(frozenset, k5))
+        # Only a K3,3 is found, which leaves the answer open
+        assert planarity.PGraph(k33).k5_homeomorph_edges() is None
+        assert planarity.PGraph([(0, 1), (1, 2)]).k5_homeomorph_edges() == []
+
+    def test_surface_embedding(self):
+        def complete(n):
+            return [(u, v) for u in range(n) for v in range(u + 1, n)]
+        k33 = [(u, v) for u in 'abc' for v in 'xyz']
+        k44 = [(u, v) for u in 'abcd' for v in 'wxyz']
+        k37 = [(u, v) for u in 'abc' for v in range(7)]
+        petersen = [(i, (i + 1) % 5) for i in range(5)] + \
+            [(i + 5, (i + 2) % 5 + 5) for i in range(5)] + \
+            [(i, i + 5) for i in range(5)]
+        for edges, pp, torus in [(self.k5_edgelist, True, True),
+                                 (k33, True, True),
+                                 (complete(7), False, True),
+                                 (complete(8), False, False),
+                                 (k44, False, True),
+                                 (k37, False, False),
+                                 (petersen, True, True),
+                                 ([(0, 1), (1, 2)], True, True)]:
+            P = planarity.PGraph(edges)
+            assert P.is_projective_planar() == pp
+            assert P.is_toroidal() == torus
+            assert len(P.edges()) == len(edges)
+
+    def test_triconnected_components(self):
+        # Two K4s sharing the edge 0-1, and a path 2-6-7-3 beside the edge 2-3
+        k4 = [(0, 1), (0, 2), (0, 3), (1, 2), (1, 3), (2, 3)]
+        edges = k4 + [(0, 4), (0, 5), (1, 4), (1, 5), (4, 5), (2, 6), (6, 7), (7, 3)]
+        P = planarity.PGraph(edges)
+        t = P.triconnected_components()
+        assert sorted(t['types']) == ['P', 'P', 'R', 'R', 'S']
+        m = len(P.edge_array())
+        counts = collections.Counter(t['edges'])
+        assert all(counts[k] == 1 for k in range(m))
+        assert all(counts[m + j] == 2 for j in range(len(t['virtual_edges'])))
+        assert sorted(sorted(e) for e in t['virtual_edges']) == \
+            [[0, 1], [0, 1], [2, 3], [2, 3]]
+        assert planarity.PGraph(self.k5_edgelist).triconnected_components()['types'] == ['R']
+        with pytest.raises(ValueError):
+            planarity.PGraph(self.p4_edgelist).triconnected_components()
+        # More than 3n edges are all kept
+        k8 = [(u, v) for u in range(8) for v in range(u+1, 8)]
+        t = planarity.PGraph(k8).triconnected_components()
+        assert t['types'] == ['R'] and len(t['edges']) == 28
+        P = planarity.PGraph(self.k5_edgelist)
+        assert P.is_planar() is False
+        with pytest.raises(RuntimeError):
+            P.triconnected_components()
+
+    def test_drawing_arrays(self):
+        P = planarity.PGraph(self.p4_edgelist)
+        d = P.drawing_arrays()
+        nodes = P.nodes(data=True)
+        edges = P.edges(data=True)
+        for i, (n, data) in enumerate(nodes):
+            assert d['vertex_pos'][i] == data['pos']
+            assert d['vertex_start'][i] == data['start']
+            assert d['vertex_end'][i] == data['end']
+        for k, (u, v, data) in enumerate(edges):
+            assert d['edge_pos'][k] == data['pos']
+            assert d['edge_start'][k] == data['start']
+            assert d['edge_end'][k] == data['end']
+
+    def test_straight_line_drawing(self):
+        def crossing(p, q, r, s):
+            def orient(a, b, c):
+                v = (b[0]-a[0])*(c[1]-a[1]) - (b[1]-a[1])*(c[0]-a[0])
+                return (v > 0) - (v < 0)
+            return orient(p, q, r)*orient(p, q, s) < 0 and \
+                orient(r, s, p)*orient(r, s, q) < 0
+        octahedron = [(0, 1), (0, 2), (0, 3), (0, 4), (5, 1), (5, 2),
+                      (5, 3), (5, 4), (1, 2), (2, 3), (3, 4), (4, 1)]
+        for edges in [self.k5_edgelist[1:], octahedron,
+                      [(0, 1), (1, 2), (2, 3), (3, 4)],
+                      [(0, 1), (1, 2), (2, 0), (3, 4), (5, 6), (6, 7)]]:
+            P = planarity.PGraph(edges)
+            xs, ys = P.straight_line_drawing()
+            n = len(P.nodes())
+            pos = dict(zip(P.nodes(), zip(xs.tolist(), ys.tolist())))
+            assert len(set(pos.values())) == n
+            assert all(0 <= x <= 2*n-4 and 0 <= y <= n-2
+                       for x, y in pos.values())
+            for i, (a, b) in enumerate(edges):
+                for c, d in edges[i+1:]:
+                    if len({a, b, c, d}) == 4:
+                        assert not crossing(pos[a], pos[b], pos[c], pos[d])
+        with pytest.raises(RuntimeError):
+            planarity.PGraph(self.k5_edgelist).straight_line_drawing()
+
+    def test_embedding_file(self):
+        fname = tempfile.mktemp()
+        P = planarity.PGraph(self.k5_edgelist[1:])
+        P.write_embedding(fname)
+        Q = planarity.read_embedding(fname)
+        assert Q.is_planar() is True
+        assert Q.edges() == P.edges()
+        assert [list(a) for a in Q.rotation_system()] == \
+               [list(a) for a in P.rotation_system()]
+        planarity.write_embedding(self.k5_edgelist, fname)
+        Q = planarity.read_embedding(fname)
+        assert Q.is_planar() is False
+        assert len(Q.kuratowski_edges()) == 10
+        # An edge left in use but in no adjacency list is damage, even
+        # when the edge count in the header agrees with the lists
+        planarity.write_embedding([(0, 1), (2, 3)], fname)
+        with open(fname, 'rb') as f:
+            data = bytearray(f.read())
+        data[12:16] = (1).to_bytes(4, 'big')
+        for v in (2, 3):
+            data[28 + 12*v:32 + 12*v] = (-1).to_bytes(4, 'big', signed=True)
+        with open(fname, 'wb') as f:
+            f.write(data)
+        with pytest.raises(IOError):
+            planarity.read_embedding(fname)
+        P = planarity.PGraph(self.p4_edgelist)
+        P.embed_drawplanar()
+        P.write_embedding(fname)
+        Q = planarity.read_embedding(fname)
+        assert Q.nodes(data=True) == P.nodes(data=True)
+        assert Q.edges(data=True) == P.edges(data=True)
+        os.unlink(fname)
+
+    def test_dense_integer_nodes(self):
+        P = planarity.PGraph(self.k5_edgelist)
+        assert P.nodes() == [0, 1, 2, 3, 4]
+        assert P.mapping() == {1: 0, 2: 1, 3: 2, 4: 3, 5: 4}
+        assert P.is_planar() is False
+        P = planarity.PGraph([(0, 3)], dense=True)
+        assert P.nodes() == [0, 1, 2, 3]
+        assert P.edges() == [(0, 3)]
+        adj = {2: [0, 1], 0: [1], 1: []}
+        assert planarity.PGraph(adj).nodes() == [2, 0, 1]
+        assert planarity.PGraph(adj, dense=True).nodes() == [0, 1, 2]
+        P = planarity.PGraph([(True, False)])
+        assert all(type(v) is bool for v in P.nodes())
+        with pytest.raises(ValueError):
+            planarity.PGraph([(True, False)], dense=True)
+
+    def test_dense_parallel_edges(self):
+        import pytest
+        with pytest.warns(UserWarning, match='parallel edge 1-0'):
+            P = planarity.PGraph([(0, 1), (1, 0), (1, 2)])
+        assert P.edges() == [(0, 1), (1, 2)]
+        P = planarity.PGraph(self.k5_adj_symmetric)
+        assert len(P.edges()) == 10
+
+    def test_scipy_sparse_input(self):
+        import pytest
+        sparse = pytest.importorskip('scipy.sparse')
+        rows = [u for u, v in self.k5_edgelist]
+        cols = [v for u, v in self.k5_edgelist]
+        A = sparse.coo_matrix(([1]*10, (rows, cols)), shape=(5, 5))
+        A = A + A.T + sparse.identity(5)
+        for fmt in ('csr', 'csc', 'coo'):
+            P = planarity.PGraph(A.asformat(fmt))
+            assert P.nodes() == [0, 1, 2, 3, 4]
+            assert len(P.edges()) == 10
+            assert P.is_planar() is False
+        A = sparse.csr_matrix(([1]*3, ([0, 1, 2], [1, 2, 3])), shape=(4, 4))
+        P = planarity.PGraph(A)
+        assert P.edges() == [(0, 1), (1, 2), (2, 3)]
+        assert P.is_planar() is True
+
+    def test_shared_pgraph_threads(self):
+        import threading
+        P = planarity.PGraph(self.k5_edgelist)
+        errors = []
+        def work():
+            try:
+                for i in range(50):
+                    assert P.is_planar() is False
+                    assert len(P.kuratowski_edges()) == 10
+                    P.rotation_system()
+            except Exception as e:
+                errors.append(e)
+        threads = [threading.Thread(target=work) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert errors == []
+
+    def test_result_cache(self):
+        cache = planarity.ResultCache(2)
+        P = planarity.PGraph(self.k5_edgelist, cache=cache)
+        kuratowski = P.kuratowski_edges()
+        P = planarity.PGraph([(v, u) for u, v in reversed(self.k5_edgelist)],
+                             cache=cache)
+        assert P.kuratowski_edges() == kuratowski
+        assert (cache.hits, cache.misses, len(cache)) == (1, 1, 1)
+        P = planarity.PGraph([(0, 1), (1, 2), (2, 0), (2, 3)], cache=cache)
+        P.embed_planar()
+        rotation = [list(a) for a in P.rotation_system()]
+        P = planarity.PGraph([(2, 3), (0, 2), (1, 0), (2, 1)], cache=cache)
+        assert P.is_planar() is True
+        assert [list(a) for a in P.rotation_system()] == rotation
+        assert (cache.hits, cache.misses, len(cache)) == (2, 2, 2)
+
+    def test_result_cache_function(self):
+        planarity.enable_cache(16)
+        try:
+            for i in range(3):
+                assert planarity.is_planar(self.k5_edgelist) is False
+            info = planarity.cache_info()
+            assert (info['hits'], info['misses'], info['size']) == (2, 1, 1)
+        finally:
+            planarity.disable_cache()
+        assert planarity.cache_info() is None
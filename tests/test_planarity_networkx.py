@@ -75,3 +75,25 @@ class TestPlanarityNetworkX:
         H=planarity.networkx_graph(P)
         assert frozenset(G.nodes()) == frozenset(H.nodes())
         assert frozenset(frozenset(x) for x in G.edges()) == frozenset(frozenset(x) for x in H.edges())
+
+    def test_planar_embedding(self):
+        G=nx.grid_2d_graph(4,4)
+        E=planarity.planar_embedding(G)
+        E.check_structure()
+        assert frozenset(frozenset(x) for x in G.edges()) == frozenset(frozenset(x) for x in E.to_undirected().edges())
+        assert planarity.planar_embedding(nx.complete_graph(5)) is None
+
+    def test_backend_check_planarity(self):
+        from planarity.planarity_backend import backend_interface as backend
+        for G in self.planar:
+            is_planar, E = backend.check_planarity(backend.convert_from_nx(G))
+            assert is_planar is True
+            E.check_structure()
+            assert E.number_of_edges() == 2*G.number_of_edges()
+        for G in self.non_planar:
+            is_planar, K = backend.check_planarity(backend.convert_from_nx(G),
+                                                   counterexample=True)
+            assert is_planar is False
+            assert frozenset(frozenset(x) for x in G.edges()) == frozenset(frozenset(x) for x in K.edges())
+        G=nx.MultiDiGraph([(0,1),(1,0),(1,1),(1,2)])
+        assert backend.is_planar(backend.convert_from_nx(G)) is True